@@ -29,7 +29,10 @@ typedef enum { ncclFuncBroadcast, ncclFuncReduce, ncclFuncAllGather, ncclFuncRed
 #define NCCL_PROTO_LL128 1
 #define NCCL_PROTO_SIMPLE 2
 
+#define NCCL_ALGO_PROTO_IGNORE -1.0
+
 #include "tuner_v1.h"
 #include "tuner_v2.h"
+#include "tuner_v3.h"
 
 #endif
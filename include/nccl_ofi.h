@@ -126,8 +126,10 @@ extern bool virt_addr_mr;
  * overridden by platform_init().  After init(), this is the protocol
  * that was selected.
  *
- * Valid values are SENDRECV and RDMA; default is SENDRECV (set by the
- * param OFI_NCCL_PROTOCOL)
+ * Valid values are SENDRECV and RDMA. If neither OFI_NCCL_PROTOCOL nor
+ * platform_init() sets the protocol, it is selected from the
+ * capabilities of the provider (see nccl_ofi_capability.h), falling
+ * back to SENDRECV.
  */
 extern const char *nccl_ofi_selected_protocol;
 
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#ifndef NCCL_OFI_BREAKDOWN_H_
+#define NCCL_OFI_BREAKDOWN_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Phase breakdown of request latency
+ *
+ * The latency of a request, from its post to its completion, is split
+ * into consecutive phases by the times of its phase transitions:
+ *
+ *   ctrl       waiting for the control message of the receiver
+ *   pending    waiting in the pending queue of the endpoint after the
+ *              provider returned FI_EAGAIN
+ *   wire       from posting the transfer to its first completion
+ *   last_rail  from the first completion to the last one, i.e., the
+ *              wait for the slowest rail
+ *
+ * A transition that did not happen has the time of the previous one, so
+ * that its phase lasts 0. The total duration of each phase is summed per
+ * size class of the requests. Size classes are powers of 4 from 1 KiB to
+ * 16 MiB, the last class holding all larger requests.
+ *
+ * Requests are recorded with relaxed atomic increments, so that a
+ * breakdown can be updated from any thread without a lock, and read
+ * while it is updated.
+ */
+
+typedef enum nccl_ofi_phase {
+	NCCL_OFI_PHASE_CTRL = 0,
+	NCCL_OFI_PHASE_PENDING,
+	NCCL_OFI_PHASE_WIRE,
+	NCCL_OFI_PHASE_LAST_RAIL,
+	NCCL_OFI_NUM_PHASES
+} nccl_ofi_phase_t;
+
+#define NCCL_OFI_BREAKDOWN_MIN_SIZE_LOG2	(10)
+#define NCCL_OFI_BREAKDOWN_SIZES		(9)
+
+typedef struct nccl_ofi_breakdown_size {
+	/* Number of requests */
+	uint64_t count;
+	/* Total duration of each phase in ns */
+	uint64_t phase_ns[NCCL_OFI_NUM_PHASES];
+} nccl_ofi_breakdown_size_t;
+
+typedef struct nccl_ofi_breakdown {
+	nccl_ofi_breakdown_size_t sizes[NCCL_OFI_BREAKDOWN_SIZES];
+} nccl_ofi_breakdown_t;
+
+/*
+ * @brief	Size class of request size
+ */
+static inline int nccl_ofi_breakdown_size_class(size_t size)
+{
+	int size_log2;
+
+	if (size <= (1ULL << NCCL_OFI_BREAKDOWN_MIN_SIZE_LOG2)) {
+		return 0;
+	}
+
+	/* Round up to the next power of two, then to the next power
+	 * of 4 */
+	size_log2 = 64 - __builtin_clzll((unsigned long long)size - 1);
+	size_log2 -= NCCL_OFI_BREAKDOWN_MIN_SIZE_LOG2;
+	if ((size_log2 + 1) / 2 >= NCCL_OFI_BREAKDOWN_SIZES) {
+		return NCCL_OFI_BREAKDOWN_SIZES - 1;
+	}
+	return (size_log2 + 1) / 2;
+}
+
+/*
+ * @brief	Record request in breakdown
+ *
+ * @param	size
+ *		Size of request
+ * @param	times
+ *		Time of post, time of the end of each phase but the last,
+ *		and time of completion, in ns. Zero times are transitions
+ *		that did not happen.
+ */
+static inline void nccl_ofi_breakdown_record(nccl_ofi_breakdown_t *breakdown, size_t size,
+					     const uint64_t times[NCCL_OFI_NUM_PHASES + 1])
+{
+	nccl_ofi_breakdown_size_t *size_class =
+		&breakdown->sizes[nccl_ofi_breakdown_size_class(size)];
+	uint64_t begin = times[0];
+
+	for (int phase = 0; phase < NCCL_OFI_NUM_PHASES; phase++) {
+		uint64_t end = times[phase + 1];
+
+		/* Transitions may be observed out of order, e.g., the
+		 * data of an eager message arriving before its receive
+		 * was posted */
+		if (end < begin) {
+			end = begin;
+		}
+		__atomic_fetch_add(&size_class->phase_ns[phase], end - begin, __ATOMIC_RELAXED);
+		begin = end;
+	}
+	__atomic_fetch_add(&size_class->count, 1, __ATOMIC_RELAXED);
+}
+
+/*
+ * @brief	Name of phase
+ */
+const char *nccl_ofi_breakdown_phase_name(nccl_ofi_phase_t phase);
+
+/*
+ * @brief	Largest request size of size class, SIZE_MAX for the last
+ *		one
+ */
+size_t nccl_ofi_breakdown_size_class_max(int size_class);
+
+/*
+ * @brief	Copy breakdown of size class that may be updated
+ *		concurrently
+ */
+void nccl_ofi_breakdown_snapshot(const nccl_ofi_breakdown_size_t *size_class,
+				 nccl_ofi_breakdown_size_t *snapshot);
+
+/*
+ * @brief	Phase with the largest total duration of size class
+ */
+nccl_ofi_phase_t nccl_ofi_breakdown_dominant(const nccl_ofi_breakdown_size_t *size_class);
+
+/*
+ * @brief	Format breakdown of size class
+ *
+ * The summary gives the number of requests, the mean duration of each
+ * phase in µs, and the dominant phase with its share of the latency,
+ * e.g., `n=1000 ctrl=2.1 pending=0.0 wire=10.4 last_rail=1.5
+ * dominant=wire(74%)`.
+ *
+ * @return	Number of characters written as with snprintf()
+ */
+int nccl_ofi_breakdown_format(const nccl_ofi_breakdown_size_t *size_class, char *buf, size_t len);
+
+#ifdef _cplusplus
+} // End extern "C"
+#endif
+
+#endif // End NCCL_OFI_BREAKDOWN_H_
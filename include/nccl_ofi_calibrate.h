@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#ifndef NCCL_OFI_CALIBRATE_H_
+#define NCCL_OFI_CALIBRATE_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <rdma/fabric.h>
+#include <rdma/fi_domain.h>
+
+/*
+ * Measured performance of a rail. The rail is modeled as
+ *
+ *	t(m) = latency + m / bandwidth
+ *
+ * for a single message of m bytes, and back-to-back messages can be
+ * issued at most every `overhead` µs.
+ */
+typedef struct nccl_ofi_calibration {
+	/* One-way latency of a minimal message in µs (alpha) */
+	double latency;
+	/* Bandwidth in bytes per µs (inverse of beta) */
+	double bandwidth;
+	/* Gap between back-to-back small messages in µs */
+	double overhead;
+} nccl_ofi_calibration_t;
+
+/*
+ * @brief	Calibrate rails
+ *
+ * Results are looked up in the per-host calibration cache file
+ * `aws-ofi-nccl-calibration-<hostname>.ini` in directory
+ * OFI_NCCL_CALIBRATION_DIR. Rails without cached results are measured
+ * with loopback ping-pong and streaming probes between two endpoints
+ * on the rail's domain, and their results are added to the cache. The
+ * cache file is locked while rails are measured, so that concurrent
+ * processes on the host measure each rail only once. A cache file that
+ * is a symbolic link, not owned by the user or writable by others is
+ * ignored.
+ *
+ * @param	infos
+ *		NIC info of each rail
+ * @param	domains
+ *		Open domain of each rail
+ * @param	num_rails
+ *		Number of rails
+ * @param	results
+ *		Array of `num_rails` results, set on success
+ * @return	0, on success
+ *		negative errno, on error
+ */
+int nccl_ofi_calibrate(struct fi_info **infos, struct fid_domain **domains,
+		       int num_rails, nccl_ofi_calibration_t *results);
+
+/*
+ * @brief	Compute striping threshold of scheduler from calibration
+ *
+ * Sending a message of m bytes on one of n rails costs
+ * `overhead + m / bandwidth`, while striping it across all rails costs
+ * `n * overhead + m / (n * bandwidth)`. Striping pays off for messages
+ * larger than `n * overhead * bandwidth` bytes.
+ *
+ * @param	results
+ *		Calibration results of rails of a device
+ * @param	num_rails
+ *		Number of rails
+ * @param	min_threshold
+ *		Lower bound of returned threshold
+ * @return	Maximum size of a message in bytes before message is
+ *		multiplexed
+ */
+size_t nccl_ofi_calibration_rr_threshold(const nccl_ofi_calibration_t *results,
+					 int num_rails, size_t min_threshold);
+
+/*
+ * @brief	Provide calibration results to the tuner
+ *
+ * Publishes the mean rail bandwidth and latency as tuner hints (see
+ * nccl_ofi_tuner_hints.h).
+ */
+void nccl_ofi_calibration_export(const nccl_ofi_calibration_t *results, int num_rails);
+
+/*
+ * @brief	Provide link properties of rails to the tuner
+ *
+ * Publishes the number of rails of a device and the link speed of the
+ * slowest rail as reported by Libfabric as tuner hints (see
+ * nccl_ofi_tuner_hints.h). Calibration results take precedence in the
+ * tuner.
+ *
+ * @param	infos
+ *		NIC info of each rail
+ * @param	num_rails
+ *		Number of rails
+ */
+void nccl_ofi_calibration_export_link(struct fi_info **infos, int num_rails);
+
+#ifdef _cplusplus
+} // End extern "C"
+#endif
+
+#endif // End NCCL_OFI_CALIBRATE_H_
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#ifndef NCCL_OFI_CAPABILITY_H_
+#define NCCL_OFI_CAPABILITY_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Capabilities of a libfabric provider that are relevant to the
+ * selection of the communication protocol.
+ */
+typedef struct nccl_ofi_capability {
+	/* Provider name */
+	char prov_name[64];
+	/* Number of NICs of the provider */
+	int num_nics;
+	/* Capability bits (FI_MSG, FI_RMA, ...) */
+	uint64_t caps;
+	/* Operational modes required by the provider (FI_CONTEXT, ...) */
+	uint64_t mode;
+	/* Memory registration mode bits (FI_MR_*) */
+	int mr_mode;
+	/* Maximum size of inject operations in bytes */
+	size_t inject_size;
+	/* Maximum message size in bytes */
+	size_t max_msg_size;
+	/* Size of immediate data delivered with remote CQ data in bytes */
+	size_t cq_data_size;
+	/* Memory registration key size in bytes */
+	size_t mr_key_size;
+	/* Message ordering guarantees of transmit context (FI_ORDER_*) */
+	uint64_t msg_order;
+	/* dmabuf memory registration is supported by the Libfabric API */
+	bool dmabuf;
+	/* Results of endpoint probe. Only valid if `ep_probed` is true */
+	bool ep_probed;
+	/* RMA writes are emulated by the provider using send/recv */
+	bool emulated_write;
+	/* Send/recv delivers 128 byte aligned stores in order */
+	bool sendrecv_inorder_128;
+	/* RMA write delivers 128 byte aligned stores in order */
+	bool write_inorder_128;
+} nccl_ofi_capability_t;
+
+/*
+ * @brief	Probe capabilities of provider
+ *
+ * Queries Libfabric for all capabilities of the provider that is
+ * selected by `provider_filter`, the same way protocols select it. If
+ * possible, opens an endpoint on the first NIC of the provider to
+ * query endpoint options.
+ *
+ * @param	provider_filter
+ *		Comma-separated list of provider names, or NULL to select
+ *		the first provider
+ * @param	caps
+ *		Capabilities, set on success
+ * @return	0, on success
+ *		negative errno, on error
+ */
+int nccl_ofi_capability_probe(const char *provider_filter, nccl_ofi_capability_t *caps);
+
+/*
+ * @brief	Log capability report at INFO level
+ */
+void nccl_ofi_capability_log(const nccl_ofi_capability_t *caps);
+
+/*
+ * @brief	Select protocol for capabilities
+ *
+ * Protocols are checked in order of preference against their
+ * requirements in the protocol rule table.
+ *
+ * @return	Protocol name, on success
+ *		NULL, if provider does not support any protocol
+ */
+const char *nccl_ofi_capability_select_protocol(const nccl_ofi_capability_t *caps);
+
+/*
+ * @brief	Apply feature rules for the selected protocol
+ *
+ * Each rule of the feature rule table that applies to the capabilities
+ * and protocol sets the default of a plugin parameter, unless its
+ * environment variable is already set.
+ *
+ * @return	0, on success
+ *		negative errno, on error
+ */
+int nccl_ofi_capability_apply_features(const nccl_ofi_capability_t *caps,
+				       const char *protocol);
+
+#ifdef _cplusplus
+} // End extern "C"
+#endif
+
+#endif // End NCCL_OFI_CAPABILITY_H_
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#ifndef NCCL_OFI_COUNTERS_H_
+#define NCCL_OFI_COUNTERS_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/*
+ * Traffic and error counters of a rail of a device of the RDMA protocol.
+ *
+ * Counters are only updated if OFI_NCCL_RAIL_COUNTERS,
+ * OFI_NCCL_RAIL_COUNTERS_INTERVAL or OFI_NCCL_TELEMETRY is set. They are
+ * shared by all endpoints of the device, start at zero when the plugin
+ * is initialized and are never reset. They are updated with relaxed
+ * atomics, so that a query may miss events counted concurrently.
+ */
+typedef struct nccl_ofi_rail_counters {
+	/* Bytes and operations posted to the network: RDMA writes, eager
+	 * sends, control and connection messages */
+	uint64_t tx_bytes;
+	uint64_t tx_ops;
+	/* Bytes and operations received: remote RDMA writes, eager,
+	 * control and connection messages */
+	uint64_t rx_bytes;
+	uint64_t rx_ops;
+	/* Posts that failed with FI_EAGAIN */
+	uint64_t eagain;
+	/* Completions reported on the CQ error queue */
+	uint64_t err_completions;
+	/* Bounce buffers reposted after their message was consumed */
+	uint64_t bounce_reposts;
+	/* Control messages sent and received */
+	uint64_t ctrl_sent;
+	uint64_t ctrl_recv;
+	/* Eager messages sent and received */
+	uint64_t eager_sent;
+	uint64_t eager_recv;
+} nccl_ofi_rail_counters_t;
+
+/*
+ * @brief	Number of rails of a device
+ *
+ * @return	Number of rails, on success
+ *		-EINVAL, if the device does not exist
+ *		-ENOTSUP, if the RDMA protocol is not in use
+ */
+int nccl_ofi_get_num_rails(int dev_id);
+
+/*
+ * @brief	Copy counters of a rail of a device
+ *
+ * @return	0, on success
+ *		-EINVAL, if the device or rail does not exist
+ *		-ENOTSUP, if the RDMA protocol is not in use or rail
+ *		counters are disabled
+ */
+int nccl_ofi_get_rail_counters(int dev_id, int rail_id, nccl_ofi_rail_counters_t *counters);
+
+#ifdef _cplusplus
+} // End extern "C"
+#endif
+
+#endif // End NCCL_OFI_COUNTERS_H_
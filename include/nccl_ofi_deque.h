@@ -185,6 +185,40 @@ unlock:
 	return ret;
 }
 
+/*
+ * Call function for each element of the deque, from front to back
+ *
+ * The function is called with the mutex held, and must not modify the
+ * deque.
+ *
+ * @return zero on success, non-zero on error
+ */
+static inline int nccl_ofi_deque_for_each(nccl_ofi_deque_t *deque,
+					  void (*fn)(nccl_ofi_deque_elem_t *deque_elem, void *arg),
+					  void *arg)
+{
+	int ret = 0;
+	assert(deque);
+	assert(fn);
+
+	ret = pthread_mutex_lock(&deque->lock);
+	if (ret != 0) {
+		NCCL_OFI_WARN("Failed to lock deque mutex");
+		return -ret;
+	}
+
+	for (nccl_ofi_deque_elem_t *elem = deque->head.next; elem != &deque->head; elem = elem->next) {
+		fn(elem, arg);
+	}
+
+	ret = pthread_mutex_unlock(&deque->lock);
+	if (ret != 0) {
+		NCCL_OFI_WARN("Failed to unlock deque mutex");
+		return -ret;
+	}
+	return ret;
+}
+
 #ifdef _cplusplus
 } // End extern "C"
 #endif
@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#ifndef NCCL_OFI_FLIGHT_RECORDER_H_
+#define NCCL_OFI_FLIGHT_RECORDER_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Flight recorder
+ *
+ * Each endpoint of the RDMA protocol records its recent events, i.e.,
+ * posts, completions, request state changes and EAGAINs, into a ring of
+ * OFI_NCCL_FLIGHT_RECORDER_EVENTS events. Recording is lock-free: a
+ * thread reserves an entry by incrementing the head of the ring, and
+ * publishes the entry by writing its sequence number last. An entry
+ * whose writer was preempted while the ring wrapped around keeps a
+ * stale sequence number, and is skipped by the decoder.
+ *
+ * The rings of all endpoints are written to the dump file
+ * <OFI_NCCL_FLIGHT_RECORDER_DIR>/nccl-ofi-flight-<pid>.bin on errors of
+ * the progress path such as error completions, on
+ * OFI_NCCL_FLIGHT_RECORDER_SIGNAL, and with
+ * OFI_NCCL_FLIGHT_RECORDER_ABORT on SIGABRT. Dumps are async-signal-safe
+ * and write the rings as they are in memory, so that
+ * nccl-ofi-flight-recorder decodes them offline. A dump is written to a
+ * new file only readable by the user of the process, which then
+ * replaces the dump file, so that no file that exists at either path is
+ * ever written through.
+ *
+ * The dump file consists of a nccl_ofi_flight_dump_header_t, followed by
+ * a nccl_ofi_flight_dump_ring_t and its events for each ring.
+ */
+#define NCCL_OFI_FLIGHT_RECORDER_MAGIC		(0x4e43434c464c4954ULL)
+#define NCCL_OFI_FLIGHT_RECORDER_VERSION	(1)
+#define NCCL_OFI_FLIGHT_RECORDER_FILE_PREFIX	"nccl-ofi-flight-"
+
+/* Maximum number of rings of a process */
+#define NCCL_OFI_FLIGHT_RECORDER_MAX_RINGS	(256)
+
+/* Reason of a dump after an error of the progress path */
+#define NCCL_OFI_FLIGHT_DUMP_ERROR	(0)
+
+/* Type of event */
+enum nccl_ofi_flight_event_type {
+	/* Operation posted: value is the return code, arg the size */
+	NCCL_OFI_FLIGHT_POST = 1,
+	/* Completion: value is the length, arg the completion flags */
+	NCCL_OFI_FLIGHT_COMPLETION,
+	/* Error completion: value is the error, arg the provider error */
+	NCCL_OFI_FLIGHT_ERR_COMPLETION,
+	/* Request state change: value is the new state */
+	NCCL_OFI_FLIGHT_STATE,
+};
+
+typedef struct nccl_ofi_flight_event {
+	/* Position of the event in the ring plus one. Written last, so
+	 * that an entry with another position is incomplete or stale. */
+	uint64_t seq;
+	/* CLOCK_MONOTONIC time in ns */
+	uint64_t ts;
+	/* Address of the request, or 0 */
+	uint64_t request;
+	uint64_t arg;
+	int32_t value;
+	/* Local communicator ID, or UINT32_MAX */
+	uint32_t comm_id;
+	/* Enum nccl_ofi_flight_event_type */
+	uint16_t type;
+	/* Rail, or -1 */
+	int16_t rail;
+	uint16_t msg_seq_num;
+	/* Type of the request (nccl_net_ofi_rdma_req_type_t) */
+	uint8_t req_type;
+	uint8_t reserved;
+} nccl_ofi_flight_event_t;
+
+typedef struct nccl_ofi_flight_recorder {
+	/* Number of events recorded */
+	uint64_t head;
+	/* Number of entries of the ring, a power of two */
+	uint32_t num_events;
+	/* Non-zero if the ring is used by an endpoint */
+	uint32_t in_use;
+	int32_t dev_id;
+	/* Index of the ring in the process */
+	uint32_t id;
+	nccl_ofi_flight_event_t events[];
+} nccl_ofi_flight_recorder_t;
+
+typedef struct nccl_ofi_flight_dump_header {
+	uint64_t magic;
+	uint32_t version;
+	/* Size of nccl_ofi_flight_event_t */
+	uint32_t event_size;
+	int32_t pid;
+	/* Signal number, or NCCL_OFI_FLIGHT_DUMP_ERROR */
+	int32_t reason;
+	uint32_t num_rings;
+	uint32_t reserved;
+	/* CLOCK_MONOTONIC time of the dump in ns */
+	uint64_t ts;
+} nccl_ofi_flight_dump_header_t;
+
+typedef struct nccl_ofi_flight_dump_ring {
+	int32_t dev_id;
+	uint32_t id;
+	uint32_t num_events;
+	/* Non-zero if the ring was used by an endpoint at the time of the
+	 * dump, zero if its endpoint was released */
+	uint32_t in_use;
+	uint64_t head;
+} nccl_ofi_flight_dump_ring_t;
+
+/*
+ * @brief	Record event into ring
+ */
+static inline void nccl_ofi_flight_record(nccl_ofi_flight_recorder_t *recorder, uint16_t type,
+					  int rail, const void *request, uint8_t req_type,
+					  uint32_t comm_id, uint16_t msg_seq_num,
+					  int32_t value, uint64_t arg)
+{
+	struct timespec ts;
+	uint64_t index = __atomic_fetch_add(&recorder->head, 1, __ATOMIC_RELAXED);
+	nccl_ofi_flight_event_t *event = &recorder->events[index & (recorder->num_events - 1)];
+
+	/* Mark the entry incomplete while it is written */
+	__atomic_store_n(&event->seq, 0, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	event->ts = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+	event->request = (uint64_t)(uintptr_t)request;
+	event->arg = arg;
+	event->value = value;
+	event->comm_id = comm_id;
+	event->type = type;
+	event->rail = rail;
+	event->msg_seq_num = msg_seq_num;
+	event->req_type = req_type;
+
+	__atomic_store_n(&event->seq, index + 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * @brief	Initialize flight recorder from OFI_NCCL_FLIGHT_RECORDER_*
+ *		parameters and register for its dump signals
+ *
+ * @return	0, on success
+ *		negative errno, on error
+ */
+int nccl_ofi_flight_recorder_init(void);
+
+/*
+ * @brief	Reserve ring of endpoint
+ *
+ * @return	Ring, or NULL if the flight recorder is disabled or all
+ *		rings are in use
+ */
+nccl_ofi_flight_recorder_t *nccl_ofi_flight_recorder_alloc(int dev_id);
+
+/*
+ * @brief	Release ring of endpoint
+ *
+ * The memory of rings is kept for reuse, so that a concurrent dump
+ * never reads freed memory. The events of the ring are dumped until
+ * the ring is reused by another endpoint.
+ */
+void nccl_ofi_flight_recorder_release(nccl_ofi_flight_recorder_t *recorder);
+
+/*
+ * @brief	Write rings in use, and released rings that hold events, to
+ *		the dump file. Async-signal-safe.
+ *
+ * A dump is skipped while another dump is written.
+ *
+ * @param	reason
+ *		Signal number, or NCCL_OFI_FLIGHT_DUMP_ERROR
+ *
+ * @return	0, on success
+ *		-EBUSY, if another dump is written
+ *		negative errno, on error
+ */
+int nccl_ofi_flight_recorder_dump(int reason);
+
+/*
+ * @brief	Path of the dump file, or NULL if the flight recorder is
+ *		disabled
+ */
+const char *nccl_ofi_flight_recorder_path(void);
+
+#ifdef _cplusplus
+} // End extern "C"
+#endif
+
+#endif // End NCCL_OFI_FLIGHT_RECORDER_H_
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#ifndef NCCL_OFI_HISTOGRAM_H_
+#define NCCL_OFI_HISTOGRAM_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "nccl_ofi_signal.h"
+
+/*
+ * Latency histograms with logarithmic buckets. Each power of two of
+ * nanoseconds is split into NCCL_OFI_HISTOGRAM_STEPS linear buckets, so
+ * that the relative width of a bucket is bounded for all latencies, as
+ * in HDR histograms. Latencies below NCCL_OFI_HISTOGRAM_STEPS ns have a
+ * bucket each, and latencies of 2^NCCL_OFI_HISTOGRAM_MAX_LOG2 ns (~69 s)
+ * and above fall into the last bucket.
+ *
+ * Samples are recorded with relaxed atomic increments, so that a
+ * histogram can be updated from any thread without a lock, and read
+ * while it is updated. A read may miss samples recorded concurrently.
+ */
+#define NCCL_OFI_HISTOGRAM_STEPS_LOG2	(2)
+#define NCCL_OFI_HISTOGRAM_STEPS	(1 << NCCL_OFI_HISTOGRAM_STEPS_LOG2)
+#define NCCL_OFI_HISTOGRAM_MAX_LOG2	(36)
+#define NCCL_OFI_HISTOGRAM_BUCKETS	((NCCL_OFI_HISTOGRAM_MAX_LOG2 + 1) * NCCL_OFI_HISTOGRAM_STEPS)
+
+typedef struct nccl_ofi_histogram {
+	/* Number of samples of each bucket */
+	uint64_t counts[NCCL_OFI_HISTOGRAM_BUCKETS];
+	/* Sum of samples in ns */
+	uint64_t sum;
+} nccl_ofi_histogram_t;
+
+/*
+ * @brief	Current time of the monotonic clock in ns
+ *
+ * The monotonic clock is read through the vDSO without a system call,
+ * and unlike the TSC it needs no calibration and is consistent across
+ * cores and architectures.
+ */
+static inline uint64_t nccl_ofi_timestamp_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * @brief	Bucket of a latency
+ */
+static inline int nccl_ofi_histogram_bucket(uint64_t value)
+{
+	int value_log2;
+
+	if (value < NCCL_OFI_HISTOGRAM_STEPS) {
+		return (int)value;
+	}
+
+	value_log2 = 63 - __builtin_clzll(value);
+	if (value_log2 > NCCL_OFI_HISTOGRAM_MAX_LOG2) {
+		return NCCL_OFI_HISTOGRAM_BUCKETS - 1;
+	}
+
+	/* The bits following the most significant bit select the
+	 * bucket within the power of two */
+	return value_log2 * NCCL_OFI_HISTOGRAM_STEPS
+		+ (int)((value >> (value_log2 - NCCL_OFI_HISTOGRAM_STEPS_LOG2))
+			& (NCCL_OFI_HISTOGRAM_STEPS - 1));
+}
+
+/*
+ * @brief	Smallest latency of a bucket
+ */
+static inline uint64_t nccl_ofi_histogram_bucket_value(int bucket)
+{
+	int value_log2 = bucket / NCCL_OFI_HISTOGRAM_STEPS;
+	int step = bucket % NCCL_OFI_HISTOGRAM_STEPS;
+
+	if (value_log2 < NCCL_OFI_HISTOGRAM_STEPS_LOG2) {
+		return (uint64_t)bucket;
+	}
+
+	return ((uint64_t)(NCCL_OFI_HISTOGRAM_STEPS + step) << value_log2)
+		>> NCCL_OFI_HISTOGRAM_STEPS_LOG2;
+}
+
+/*
+ * @brief	Record latency in histogram
+ *
+ * @param	value
+ *		Latency in ns
+ */
+static inline void nccl_ofi_histogram_record(nccl_ofi_histogram_t *histogram, uint64_t value)
+{
+	__atomic_fetch_add(&histogram->counts[nccl_ofi_histogram_bucket(value)], 1,
+			   __ATOMIC_RELAXED);
+	__atomic_fetch_add(&histogram->sum, value, __ATOMIC_RELAXED);
+}
+
+/*
+ * @brief	Record time elapsed between two timestamps in histogram
+ *
+ * Callers that record several latencies ending at the same time read
+ * the clock once and pass it as end.
+ *
+ * @param	start
+ *		Timestamp of nccl_ofi_timestamp_ns()
+ * @param	end
+ *		Timestamp of nccl_ofi_timestamp_ns()
+ */
+static inline void nccl_ofi_histogram_record_interval(nccl_ofi_histogram_t *histogram,
+						      uint64_t start, uint64_t end)
+{
+	nccl_ofi_histogram_record(histogram, end > start ? end - start : 0);
+}
+
+/*
+ * @brief	Record time elapsed since a timestamp in histogram
+ *
+ * @param	start
+ *		Timestamp of nccl_ofi_timestamp_ns()
+ */
+static inline void nccl_ofi_histogram_record_since(nccl_ofi_histogram_t *histogram, uint64_t start)
+{
+	nccl_ofi_histogram_record_interval(histogram, start, nccl_ofi_timestamp_ns());
+}
+
+/*
+ * @brief	Copy histogram that may be updated concurrently
+ */
+void nccl_ofi_histogram_snapshot(const nccl_ofi_histogram_t *histogram,
+				 nccl_ofi_histogram_t *snapshot);
+
+/*
+ * @brief	Number of samples of histogram
+ */
+uint64_t nccl_ofi_histogram_count(const nccl_ofi_histogram_t *histogram);
+
+/*
+ * @brief	Upper bound of a quantile of histogram
+ *
+ * @param	quantile
+ *		Quantile between 0 and 1
+ * @return	Largest latency of the bucket that holds the quantile in ns
+ *		(smallest latency for the last bucket), or 0 if the
+ *		histogram has no samples
+ */
+uint64_t nccl_ofi_histogram_quantile(const nccl_ofi_histogram_t *histogram, double quantile);
+
+/*
+ * @brief	Format summary of histogram
+ *
+ * The summary gives the number of samples, the mean, the median, the
+ * 90th and 99th percentiles and the maximum in µs, with percentiles and
+ * maximum rounded up to the bucket bounds, e.g.,
+ * `n=1000 mean=12.1 p50<=12.0 p90<=14.0 p99<=20.0 max<=32.0`.
+ *
+ * @return	Number of characters written as with snprintf()
+ */
+int nccl_ofi_histogram_format(const nccl_ofi_histogram_t *histogram, char *buf, size_t len);
+
+/*
+ * @brief	Register for signal that requests histogram dumps
+ *
+ * The signal is only counted (see nccl_ofi_signal.h). Users of
+ * histograms compare the count with nccl_ofi_histogram_dump_requests()
+ * from their progress path and log their histograms when it changed.
+ *
+ * @param	signum
+ *		Signal number, or 0 for no signal
+ * @return	0, on success
+ *		negative errno, on error
+ */
+int nccl_ofi_histogram_signal_init(int signum);
+
+/*
+ * @brief	Number of histogram dumps requested by signal
+ */
+static inline unsigned int nccl_ofi_histogram_dump_requests(void)
+{
+	return nccl_ofi_signal_count(NCCL_OFI_SIGNAL_HISTOGRAM);
+}
+
+#ifdef _cplusplus
+} // End extern "C"
+#endif
+
+#endif // End NCCL_OFI_HISTOGRAM_H_
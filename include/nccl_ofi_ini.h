@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#ifndef NCCL_OFI_INI_H_
+#define NCCL_OFI_INI_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Minimal parser for INI-style configuration files.
+ *
+ * Files consist of `[section]` headers followed by `key = value`
+ * lines. Leading and trailing whitespace of section names, keys and
+ * values is removed. Lines starting with `#` or `;` and empty lines
+ * are ignored. Key-value pairs before the first section header
+ * belong to the section with empty name.
+ */
+
+/*
+ * @brief	Callback invoked for each key-value pair
+ *
+ * @param	ctx
+ *		User context passed to the parse function
+ * @param	section
+ *		Name of the enclosing section
+ * @param	key
+ *		Key
+ * @param	value
+ *		Value, possibly empty
+ * @param	lineno
+ *		Line number of the key-value pair, starting at 1
+ * @return	0, to continue parsing
+ *		non-zero, to abort parsing
+ */
+typedef int (*nccl_ofi_ini_handler_t)(void *ctx, const char *section,
+				      const char *key, const char *value,
+				      int lineno);
+
+/*
+ * @brief	Parse INI stream
+ *
+ * @param	stream
+ *		Stream to read from
+ * @param	name
+ *		Name of the stream used in warnings
+ * @param	handler
+ *		Callback invoked for each key-value pair
+ * @param	ctx
+ *		User context passed to callback
+ * @return	0, on success
+ *		-EINVAL, on syntax error or if callback aborted parsing
+ *		-EIO, on read error
+ */
+int nccl_ofi_ini_parse_stream(FILE *stream, const char *name,
+			      nccl_ofi_ini_handler_t handler, void *ctx);
+
+/*
+ * @brief	Parse INI file
+ *
+ * @param	path
+ *		Path of file
+ * @param	handler
+ *		Callback invoked for each key-value pair
+ * @param	ctx
+ *		User context passed to callback
+ * @return	0, on success
+ *		-ENOENT, if file does not exist
+ *		negative errno, on error
+ */
+int nccl_ofi_ini_parse_file(const char *path,
+			    nccl_ofi_ini_handler_t handler, void *ctx);
+
+/*
+ * @brief	Parse signed integer value
+ *
+ * Accepts decimal, octal and hexadecimal notation.
+ *
+ * @return	0, on success
+ *		-EINVAL, if value is not an integer
+ */
+int nccl_ofi_ini_parse_int(const char *value, int64_t *result);
+
+/*
+ * @brief	Parse floating point value
+ *
+ * @return	0, on success
+ *		-EINVAL, if value is not a number
+ */
+int nccl_ofi_ini_parse_double(const char *value, double *result);
+
+/*
+ * @brief	Parse boolean value
+ *
+ * Accepts `1`, `true`, `yes` and `on` as well as `0`, `false`, `no`
+ * and `off`, ignoring case.
+ *
+ * @return	0, on success
+ *		-EINVAL, if value is not a boolean
+ */
+int nccl_ofi_ini_parse_bool(const char *value, bool *result);
+
+#ifdef _cplusplus
+} // End extern "C"
+#endif
+
+#endif // End NCCL_OFI_INI_H_
@@ -183,6 +183,29 @@ nccl_ofi_msgbuff_result_t nccl_ofi_msgbuff_retrieve(nccl_ofi_msgbuff_t *msgbuff,
 nccl_ofi_msgbuff_result_t nccl_ofi_msgbuff_complete(nccl_ofi_msgbuff_t *msgbuff,
 		uint16_t msg_index, nccl_ofi_msgbuff_status_t *msg_idx_status);
 
+/* Function called for each message by nccl_ofi_msgbuff_for_each() */
+typedef void (*nccl_ofi_msgbuff_iter_fn_t)(uint16_t msg_index, nccl_ofi_msgbuff_status_t stat,
+		nccl_ofi_msgbuff_elemtype_t type, void *elem, void *arg);
+
+/**
+ * Call function for each message between msg_last_incomplete and msg_next,
+ * in sequence number order. Messages completed out of order, and messages
+ * skipped by an insert of a higher sequence number, are passed with
+ * status COMPLETED or NOTSTARTED and a NULL element.
+ *
+ * The function is called with the lock of the buffer held, and must not
+ * call other functions of the buffer.
+ *
+ * @param first, output: msg_last_incomplete, may be NULL
+ *   next, output: msg_next, may be NULL
+ *
+ * @return
+ *  NCCL_OFI_MSGBUFF_SUCCESS, success
+ *  NCCL_OFI_MSGBUFF_ERROR, other error
+ */
+nccl_ofi_msgbuff_result_t nccl_ofi_msgbuff_for_each(nccl_ofi_msgbuff_t *msgbuff,
+		nccl_ofi_msgbuff_iter_fn_t fn, void *arg, uint16_t *first, uint16_t *next);
+
 #ifdef _cplusplus
 } // End extern "C"
 #endif
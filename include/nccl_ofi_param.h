@@ -203,6 +203,174 @@ OFI_NCCL_PARAM_INT(net_latency, "NET_LATENCY", -1);
  */
 OFI_NCCL_PARAM_INT(eager_max_size, "EAGER_MAX_SIZE", 8192);
 
+/*
+ * Colon-separated search path of platform files. The first existing
+ * file is loaded and merged with the built-in platform data. See
+ * doc/platform-file.md for the file format. By default, the plugin
+ * searches `${sysconfdir}/aws-ofi-nccl/platform.ini` and
+ * `${pkgdatadir}/platform.ini`.
+ */
+OFI_NCCL_PARAM_STR(platform_file, "PLATFORM_FILE", NULL);
+
+/*
+ * Calibrate latency, bandwidth and per-message overhead of each rail
+ * with loopback probes when the process first creates an endpoint on a
+ * device of the RDMA protocol, so that devices that a process never
+ * uses are not probed. The results determine the round robin threshold
+ * of the scheduler of the device, unless OFI_NCCL_ROUND_ROBIN_THRESHOLD
+ * is set. Results of the first device are provided to tuner contexts
+ * initialized after its first use. Results are cached per host, see
+ * OFI_NCCL_CALIBRATION_DIR. Disabled by default.
+ */
+OFI_NCCL_PARAM_INT(calibrate, "CALIBRATE", 0);
+
+/*
+ * Directory of the calibration cache file
+ * `aws-ofi-nccl-calibration-<hostname>.ini`. Remove the file to
+ * calibrate again. Defaults to the per-user directory
+ * `$XDG_CACHE_HOME/aws-ofi-nccl`, or `$HOME/.cache/aws-ofi-nccl`.
+ */
+OFI_NCCL_PARAM_STR(calibration_dir, "CALIBRATION_DIR", NULL);
+
+/*
+ * Record latency histograms of the RDMA protocol: from posting a send
+ * to receiving its control message and to its completion, from posting
+ * each rail's segment to its completion, and from posting a receive or
+ * flush to its completion. Summaries are logged at INFO level when a
+ * communicator is closed. Recording reads the clock once per post and
+ * once per batch of completions, about 90 ns per single-rail send and
+ * 130 ns per four-rail send. Enabled by default (1).
+ */
+OFI_NCCL_PARAM_INT(latency_histograms, "LATENCY_HISTOGRAMS", 1);
+
+/*
+ * Signal that logs the latency histograms of the communicators, e.g.,
+ * 12 for SIGUSR2. Each communicator logs its histograms the next time a
+ * request of it is tested. Disabled by default (0).
+ */
+OFI_NCCL_PARAM_INT(latency_histogram_signal, "LATENCY_HISTOGRAM_SIGNAL", 0);
+
+/*
+ * Break the latency of sends and receives of the RDMA protocol down into
+ * control message wait, pending queue, wire and last rail phases per
+ * size class (see nccl_ofi_breakdown.h). The breakdowns and the dominant
+ * phase of each size class are logged at INFO level when a communicator
+ * is closed and on OFI_NCCL_LATENCY_HISTOGRAM_SIGNAL. Disabled by
+ * default (0).
+ */
+OFI_NCCL_PARAM_INT(phase_breakdown, "PHASE_BREAKDOWN", 0);
+
+/*
+ * Count traffic and errors of each rail for nccl_ofi_get_rail_counters()
+ * (see nccl_ofi_counters.h). Counting adds atomic updates of counters
+ * shared by the endpoints of a device to each post and completion.
+ * Implied by OFI_NCCL_RAIL_COUNTERS_INTERVAL and OFI_NCCL_TELEMETRY.
+ * Disabled by default (0).
+ */
+OFI_NCCL_PARAM_INT(rail_counters, "RAIL_COUNTERS", 0);
+
+/*
+ * Interval in seconds between INFO log lines of the traffic and error
+ * counters of each rail (see nccl_ofi_counters.h). The counters are
+ * logged from the progress path of the first thread that tests a
+ * request after the interval elapsed. Disabled by default (0).
+ */
+OFI_NCCL_PARAM_INT(rail_counters_interval, "RAIL_COUNTERS_INTERVAL", 0);
+
+/*
+ * Publish counters, gauges and latency histograms in the shared memory
+ * segment /dev/shm/nccl-ofi-<pid> (see nccl_ofi_telemetry.h) for
+ * monitoring agents. The histograms stay empty if
+ * OFI_NCCL_LATENCY_HISTOGRAMS is disabled. Disabled by default.
+ */
+OFI_NCCL_PARAM_INT(telemetry, "TELEMETRY", 0);
+
+/*
+ * Minimum interval in milliseconds between updates of the telemetry
+ * records of an endpoint or communicator.
+ */
+OFI_NCCL_PARAM_INT(telemetry_interval_ms, "TELEMETRY_INTERVAL_MS", 1000);
+
+/*
+ * File that the built-in tracer writes request lifecycles to, in the
+ * Chrome trace event format (see nccl_ofi_tracer.h). "%p" is replaced
+ * with the process ID. The file is written at exit and on
+ * OFI_NCCL_TRACE_SIGNAL. Tracing is disabled without a file.
+ */
+OFI_NCCL_PARAM_STR(trace_file, "TRACE_FILE", NULL);
+
+/*
+ * Number of events that the ring buffer of each thread keeps for the
+ * built-in tracer, rounded up to a power of two. Older events are
+ * overwritten.
+ */
+OFI_NCCL_PARAM_INT(trace_buffer_events, "TRACE_BUFFER_EVENTS", 65536);
+
+/*
+ * Signal that writes the trace file of the built-in tracer, e.g., 10
+ * for SIGUSR1. The file is written the next time a request is tested.
+ * Disabled by default (0).
+ */
+OFI_NCCL_PARAM_INT(trace_signal, "TRACE_SIGNAL", 0);
+
+/*
+ * Number of recent events that the flight recorder keeps for each
+ * endpoint of the RDMA protocol, rounded up to a power of two (see
+ * nccl_ofi_flight_recorder.h). Recording adds a clock read and an
+ * atomic update of the ring to each post and completion. Disabled by
+ * default (0).
+ */
+OFI_NCCL_PARAM_INT(flight_recorder_events, "FLIGHT_RECORDER_EVENTS", 0);
+
+/*
+ * Directory of the flight recorder dump file
+ * `nccl-ofi-flight-<pid>.bin`, decoded with nccl-ofi-flight-recorder.
+ * Defaults to the working directory of the process at initialization.
+ */
+OFI_NCCL_PARAM_STR(flight_recorder_dir, "FLIGHT_RECORDER_DIR", NULL);
+
+/*
+ * Signal that dumps the flight recorder, e.g., 10 for SIGUSR1. Disabled
+ * by default (0).
+ */
+OFI_NCCL_PARAM_INT(flight_recorder_signal, "FLIGHT_RECORDER_SIGNAL", 0);
+
+/*
+ * Dump the flight recorder on SIGABRT before the previous action of
+ * the signal runs. Disabled by default (0).
+ */
+OFI_NCCL_PARAM_INT(flight_recorder_abort, "FLIGHT_RECORDER_ABORT", 0);
+
+/*
+ * Time in seconds after which a send, receive or flush request of the
+ * RDMA protocol that is still outstanding is reported as hanging,
+ * together with the messages and pending requests of its communicator.
+ * Requests are checked from the progress path at most once per timeout
+ * and communicator. Disabled by default (0).
+ */
+OFI_NCCL_PARAM_INT(hang_timeout, "HANG_TIMEOUT", 0);
+
+/*
+ * Profile the phases of plugin initialization and connection
+ * establishment, and log their summary at exit (see
+ * nccl_ofi_startup.h). Disabled by default (0).
+ */
+OFI_NCCL_PARAM_INT(startup_profile, "STARTUP_PROFILE", 0);
+
+/*
+ * File that the startup profile is written to in JSON at exit. "%p" is
+ * replaced with the process ID.
+ */
+OFI_NCCL_PARAM_STR(startup_profile_file, "STARTUP_PROFILE_FILE", NULL);
+
+/*
+ * File that the per-peer traffic of the endpoints of the RDMA protocol
+ * is written to at exit, as rows of the traffic matrix of the job (see
+ * nccl_ofi_traffic.h). "%p" is replaced with the process ID and "%h"
+ * with the host name. Disabled by default (unset).
+ */
+OFI_NCCL_PARAM_STR(traffic_matrix_file, "TRAFFIC_MATRIX_FILE", NULL);
+
 #ifdef _cplusplus
 } // End extern "C"
 #endif
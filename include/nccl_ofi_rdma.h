@@ -19,6 +19,12 @@ extern "C" {
 #include "nccl_ofi_deque.h"
 #include "nccl_ofi_freelist.h"
 #include "nccl_ofi_idpool.h"
+#include "nccl_ofi_breakdown.h"
+#include "nccl_ofi_histogram.h"
+#include "nccl_ofi_counters.h"
+#include "nccl_ofi_telemetry.h"
+#include "nccl_ofi_flight_recorder.h"
+#include "nccl_ofi_traffic.h"
 
 /* Maximum number of rails supported. This defines the size of
  * messages exchanged during connection establishment (linear
@@ -170,6 +176,10 @@ typedef struct {
 	/* Total number of completions. Expect one completion for receiving the
 	 * control message and one completion for each send segment. */
 	int total_num_compls;
+	/* True once the control message of the receiver arrived */
+	bool ctrl_recv;
+	/* Time each rail's segment was posted (latency histograms) */
+	uint64_t xfer_post_time[MAX_NUM_RAILS];
 } rdma_req_send_data_t;
 
 /*
@@ -277,6 +287,18 @@ typedef struct nccl_net_ofi_rdma_req {
 	/* Size of completed request */
 	size_t size;
 
+	/* Time the send, receive or flush was posted (latency histograms
+	 * and hang detection) */
+	uint64_t post_time;
+
+	/* Times of the phase transitions of a send or receive (phase
+	 * breakdown): the control message arrived, the transfer or the
+	 * control message was posted, and the first data completion
+	 * arrived. Zero until the transition happens. */
+	uint64_t ready_time;
+	uint64_t xfer_time;
+	uint64_t first_compl_time;
+
 	/*
 	 * Protect updating critical fields such as size and ncompls when
 	 * network xfer happened over multiple rails
@@ -352,6 +374,10 @@ typedef struct nccl_net_ofi_rdma_send_comm_rail {
 	/* Pointer to libfabric endpoint of corresponding rdma
 	 * endpoint rail */
 	struct fid_ep *local_ep;
+
+	/* Latency from posting an RDMA write or eager send segment on
+	 * the rail to its local completion */
+	nccl_ofi_histogram_t write_hist;
 } nccl_net_ofi_rdma_send_comm_rail_t;
 
 /*
@@ -382,6 +408,9 @@ typedef struct nccl_net_ofi_rdma_send_comm {
 
 	/* Indicates if connection establishment is completed */
 	bool connected;
+	/* Time the current stage of connection establishment began (see
+	 * nccl_ofi_startup.h) */
+	uint64_t conn_stage_begin;
 
 	/* Message struct send connect message and receive connect
 	 * response message */
@@ -394,6 +423,29 @@ typedef struct nccl_net_ofi_rdma_send_comm {
 	/* Number of rails */
 	int num_rails;
 
+	/* Latency from posting a send to receiving its control
+	 * message, and from posting a send to its completion */
+	nccl_ofi_histogram_t ctrl_hist;
+	nccl_ofi_histogram_t send_hist;
+	/* Phase breakdown of send latency */
+	nccl_ofi_breakdown_t send_breakdown;
+	/* Histogram dump requests handled (see
+	 * nccl_ofi_histogram_dump_requests()) */
+	unsigned int hist_dumps;
+
+	/* Record of telemetry segment, NULL if not published */
+	nccl_ofi_telemetry_comm_t *telemetry;
+	/* Time of next update of telemetry record in ns */
+	uint64_t next_telemetry;
+
+	/* Time of next check for hanging requests in ns (see
+	 * OFI_NCCL_HANG_TIMEOUT) */
+	uint64_t next_hang_check;
+
+	/* Traffic matrix entry of the remote endpoint, NULL if not
+	 * counted */
+	nccl_ofi_traffic_peer_t *traffic_peer;
+
 	/* Number of initialized rails. The function
 	 * `create_send_comm()' creates a send communicator with one
 	 * initialized rail and sets `num_init_rails=0' after the
@@ -465,6 +517,28 @@ typedef struct nccl_net_ofi_rdma_recv_comm {
 	/* Free list to track control buffers, for sending RDMA control messages */
 	nccl_ofi_freelist_t *ctrl_buff_fl;
 
+	/* Latency from posting a receive or a flush to its completion */
+	nccl_ofi_histogram_t recv_hist;
+	nccl_ofi_histogram_t flush_hist;
+	/* Phase breakdown of receive latency */
+	nccl_ofi_breakdown_t recv_breakdown;
+	/* Histogram dump requests handled (see
+	 * nccl_ofi_histogram_dump_requests()) */
+	unsigned int hist_dumps;
+
+	/* Record of telemetry segment, NULL if not published */
+	nccl_ofi_telemetry_comm_t *telemetry;
+	/* Time of next update of telemetry record in ns */
+	uint64_t next_telemetry;
+
+	/* Time of next check for hanging requests in ns (see
+	 * OFI_NCCL_HANG_TIMEOUT) */
+	uint64_t next_hang_check;
+
+	/* Traffic matrix entry of the remote endpoint, NULL if not
+	 * counted */
+	nccl_ofi_traffic_peer_t *traffic_peer;
+
 	/* Number of rails */
 	int num_rails;
 
@@ -490,6 +564,8 @@ typedef struct nccl_net_ofi_rdma_listen_comm {
 
 	/* Stage of connection establishment on listen side */
 	nccl_ofi_comm_stage_t stage;
+	/* Time the current stage began (see nccl_ofi_startup.h) */
+	uint64_t stage_begin;
 
 	/* Message struct send connect message and receive connect
 	 * response message */
@@ -575,6 +651,24 @@ struct nccl_net_ofi_rdma_ep {
 
 	/* Pending requests queue */
 	nccl_ofi_deque_t *pending_reqs_queue;
+	/* Number of requests in pending requests queue */
+	size_t num_pending_reqs;
+	/* High-water mark of num_pending_reqs, if rail counters are
+	 * enabled. The queue is shared by the rails of the endpoint, so
+	 * that its depth is not attributed to a rail. */
+	size_t max_pending_reqs;
+
+	/* Record of telemetry segment, NULL if not published */
+	nccl_ofi_telemetry_ep_t *telemetry;
+	/* Time of next update of telemetry record in ns */
+	uint64_t next_telemetry;
+
+	/* Ring of recent events, NULL if the flight recorder is disabled */
+	nccl_ofi_flight_recorder_t *flight_recorder;
+
+	/* Per-peer traffic of the communicators, NULL if the traffic
+	 * matrix is disabled */
+	nccl_ofi_traffic_row_t *traffic;
 
 	/* Free list of bounce buffers */
 	nccl_ofi_freelist_t *bounce_buff_fl;
@@ -599,6 +693,9 @@ typedef struct nccl_net_ofi_rdma_device_rail {
 
 	/* Access domain handles */
 	struct fid_domain *domain;
+
+	/* Traffic and error counters of the rail */
+	nccl_ofi_rail_counters_t counters;
 } nccl_net_ofi_rdma_device_rail_t;
 
 /*
@@ -631,6 +728,10 @@ typedef struct nccl_net_ofi_rdma_device {
 	/* Message scheduler */
 	nccl_net_ofi_scheduler_t *scheduler;
 
+	/* Whether the rails were calibrated on first use of the device,
+	 * protected by `ep_lock` (see OFI_NCCL_CALIBRATE) */
+	bool calibrated;
+
 	/* Thread-specific data key to manage thread-local pointers to
 	 * rdma endpoints.  Every service thread maintains its own
 	 * endpoint associated with this device.  The endpoint
@@ -659,6 +760,10 @@ typedef struct nccl_net_ofi_rdma_device {
 
 	/* Memory registration key pool */
 	nccl_ofi_idpool_t key_pool;
+
+	/* Time of next log line of rail counters in ns (see
+	 * OFI_NCCL_RAIL_COUNTERS_INTERVAL) */
+	uint64_t next_counters_log;
 } nccl_net_ofi_rdma_device_t;
 
 /*
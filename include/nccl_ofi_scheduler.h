@@ -121,6 +121,17 @@ int nccl_net_ofi_threshold_scheduler_init(int num_rails,
 					  size_t rr_threshold,
 					  nccl_net_ofi_scheduler_t **scheduler);
 
+/*
+ * brief	Set round robin threshold of a threshold scheduler
+ *
+ * Must not be called while schedules are requested concurrently.
+ *
+ * @param	rr_threshold
+ *		Maximum size of a message in bytes before message is multiplexed
+ */
+void nccl_net_ofi_threshold_scheduler_set_threshold(nccl_net_ofi_scheduler_t *scheduler,
+						    size_t rr_threshold);
+
 /*
  * Internal: Set schedule that multiplexes messages to all rails.
  *
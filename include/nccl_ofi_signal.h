@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#ifndef NCCL_OFI_SIGNAL_H_
+#define NCCL_OFI_SIGNAL_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+/*
+ * Dump signals
+ *
+ * Latency histograms, the tracer and the flight recorder dump their
+ * state on signals that the user selects. Several of them may share a
+ * signal, so that the plugin installs a single dispatcher per signal.
+ * The dispatcher counts the signal for each consumer registered for
+ * it, calls the async-signal-safe handlers of the consumers, and then
+ * chains to the action of the signal before the plugin registered it.
+ *
+ * A previous handler function is always called. The default action is
+ * only run again for SIGABRT, which the plugin observes on its way to
+ * terminate the process; other dump signals would terminate the
+ * process by default.
+ */
+
+/* Consumers of dump signals */
+enum nccl_ofi_signal_consumer {
+	NCCL_OFI_SIGNAL_HISTOGRAM = 0,
+	NCCL_OFI_SIGNAL_TRACER,
+	NCCL_OFI_SIGNAL_FLIGHT_RECORDER,
+	NCCL_OFI_SIGNAL_NUM_CONSUMERS
+};
+
+/* Handler of a consumer, called from the dispatcher */
+typedef void (*nccl_ofi_signal_handler_fn_t)(int signum);
+
+/*
+ * @brief	Register consumer of a dump signal
+ *
+ * The dispatcher is installed when the first consumer registers for the
+ * signal. A consumer may register for several signals.
+ *
+ * @param	signum
+ *		Signal number
+ * @param	consumer
+ *		Consumer
+ * @param	handler
+ *		Async-signal-safe handler of the consumer, or NULL if the
+ *		consumer only polls nccl_ofi_signal_count()
+ * @return	0, on success
+ *		negative errno, on error
+ */
+int nccl_ofi_signal_register(int signum, enum nccl_ofi_signal_consumer consumer,
+			     nccl_ofi_signal_handler_fn_t handler);
+
+/* Number of signals received by each consumer */
+extern unsigned int nccl_ofi_signal_counts[NCCL_OFI_SIGNAL_NUM_CONSUMERS];
+
+/*
+ * @brief	Number of signals received by consumer
+ *
+ * Consumers compare the count with the count they last handled from
+ * their progress path.
+ */
+static inline unsigned int nccl_ofi_signal_count(enum nccl_ofi_signal_consumer consumer)
+{
+	return __atomic_load_n(&nccl_ofi_signal_counts[consumer], __ATOMIC_RELAXED);
+}
+
+#ifdef _cplusplus
+} // End extern "C"
+#endif
+
+#endif // End NCCL_OFI_SIGNAL_H_
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#ifndef NCCL_OFI_STARTUP_H_
+#define NCCL_OFI_STARTUP_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "nccl_ofi_histogram.h"
+
+/*
+ * Startup phase profiler
+ *
+ * With OFI_NCCL_STARTUP_PROFILE set, the plugin times the phases of its
+ * initialization and of connection establishment. Each phase accumulates
+ * its number of occurrences, their total and maximum duration, and its
+ * wall time, i.e., the time from the beginning of its first occurrence to
+ * the end of its last one. Occurrences of a phase on concurrent threads
+ * make its total exceed its wall time.
+ *
+ * The summary of the process is logged at exit, and written in JSON to
+ * OFI_NCCL_STARTUP_PROFILE_FILE if set.
+ */
+
+/* Phase of startup */
+typedef enum nccl_ofi_startup_phase {
+	/* nccl_net_ofi_create_plugin(), which contains the other
+	 * initialization phases */
+	NCCL_OFI_STARTUP_PLUGIN_INIT = 0,
+	/* fi_getinfo() of providers */
+	NCCL_OFI_STARTUP_PROVIDERS,
+	/* Topology creation with hwloc and grouping of NICs */
+	NCCL_OFI_STARTUP_TOPO,
+	/* Fabric and domain creation */
+	NCCL_OFI_STARTUP_DOMAIN,
+	/* Endpoint, CQ and AV creation, binding and enabling, which
+	 * contains the AV phase */
+	NCCL_OFI_STARTUP_ENDPOINT,
+	/* Address vector creation */
+	NCCL_OFI_STARTUP_AV,
+	/* Memory registration of a buffer on all rails */
+	NCCL_OFI_STARTUP_MR_REG,
+	/* Allocation and initial posting of bounce buffers of an
+	 * endpoint, which contains their MR_REG phases */
+	NCCL_OFI_STARTUP_BOUNCE_POST,
+	/* connect(): creation of send communicator */
+	NCCL_OFI_STARTUP_CONNECT_CREATE,
+	/* connect(): connect message posted until it was sent */
+	NCCL_OFI_STARTUP_CONNECT_SEND,
+	/* connect(): connect message sent until the connect response arrived */
+	NCCL_OFI_STARTUP_CONNECT_RESP,
+	/* accept(): first call until the connect message arrived */
+	NCCL_OFI_STARTUP_ACCEPT_WAIT,
+	/* accept(): creation of receive communicator */
+	NCCL_OFI_STARTUP_ACCEPT_CREATE,
+	/* accept(): connect response posted until it was sent */
+	NCCL_OFI_STARTUP_ACCEPT_RESP,
+	NCCL_OFI_STARTUP_NUM_PHASES
+} nccl_ofi_startup_phase_t;
+
+typedef struct nccl_ofi_startup_stats {
+	/* Number of occurrences */
+	uint64_t count;
+	/* Total and maximum duration in ns */
+	uint64_t total_ns;
+	uint64_t max_ns;
+	/* Time the first occurrence began and the last occurrence ended,
+	 * 0 without occurrence */
+	uint64_t first_begin;
+	uint64_t last_end;
+} nccl_ofi_startup_stats_t;
+
+/* Non-zero if the profiler is enabled */
+extern int nccl_ofi_startup_enabled;
+
+/*
+ * @brief	Begin occurrence of a phase
+ *
+ * @return	Timestamp to pass to nccl_ofi_startup_end(), 0 if the
+ *		profiler is disabled
+ */
+static inline uint64_t nccl_ofi_startup_begin(void)
+{
+	if (__builtin_expect(nccl_ofi_startup_enabled, 0)) {
+		return nccl_ofi_timestamp_ns();
+	}
+	return 0;
+}
+
+/*
+ * @brief	End occurrence of phase that began at `begin`. Occurrences
+ *		with a zero `begin` are ignored.
+ */
+void nccl_ofi_startup_end(nccl_ofi_startup_phase_t phase, uint64_t begin);
+
+/*
+ * @brief	Enable profiler from OFI_NCCL_STARTUP_PROFILE* parameters
+ *		and register the report at exit
+ *
+ * @return	0, on success
+ *		negative errno, on error
+ */
+int nccl_ofi_startup_init(void);
+
+/*
+ * @brief	Name of phase
+ */
+const char *nccl_ofi_startup_phase_name(nccl_ofi_startup_phase_t phase);
+
+/*
+ * @brief	Copy statistics of all phases
+ *
+ * @param	stats
+ *		Array of NCCL_OFI_STARTUP_NUM_PHASES statistics
+ */
+void nccl_ofi_startup_snapshot(nccl_ofi_startup_stats_t *stats);
+
+/*
+ * @brief	Log summary of phases, and write it to the profile file if
+ *		set
+ *
+ * @return	0, on success
+ *		negative errno, on error
+ */
+int nccl_ofi_startup_report(void);
+
+#ifdef _cplusplus
+} // End extern "C"
+#endif
+
+#endif // End NCCL_OFI_STARTUP_H_
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#ifndef NCCL_OFI_TELEMETRY_H_
+#define NCCL_OFI_TELEMETRY_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "nccl_ofi_counters.h"
+#include "nccl_ofi_histogram.h"
+
+/*
+ * Telemetry segment
+ *
+ * The plugin publishes counters and gauges of its devices, endpoints and
+ * communicators into a shared memory segment at
+ * NCCL_OFI_TELEMETRY_PATH_PREFIX<pid>, so that monitoring agents can
+ * read them without parsing logs (see nccl-ofi-telemetry). The segment
+ * is written from the progress path of the plugin, at most once per
+ * OFI_NCCL_TELEMETRY_INTERVAL_MS for each endpoint and communicator.
+ *
+ * Each record of the segment is protected by a sequence lock. A writer
+ * makes the sequence number odd while it updates the record and even
+ * again when done. A reader copies the record, and retries if the
+ * sequence number was odd or changed during the copy.
+ *
+ * The layout is fixed for a version, and any change of the layout
+ * increments NCCL_OFI_TELEMETRY_VERSION. Readers must check magic,
+ * version and size before use.
+ */
+#define NCCL_OFI_TELEMETRY_PATH_PREFIX	"/dev/shm/nccl-ofi-"
+#define NCCL_OFI_TELEMETRY_MAGIC	(0x4e43434c4f464954ULL)
+#define NCCL_OFI_TELEMETRY_VERSION	(2)
+
+#define NCCL_OFI_TELEMETRY_MAX_DEVS	(32)
+#define NCCL_OFI_TELEMETRY_MAX_RAILS	(4)
+#define NCCL_OFI_TELEMETRY_MAX_EPS	(128)
+#define NCCL_OFI_TELEMETRY_MAX_COMMS	(512)
+
+/* Type of communicator record */
+enum nccl_ofi_telemetry_comm_type {
+	NCCL_OFI_TELEMETRY_SEND_COMM = 1,
+	NCCL_OFI_TELEMETRY_RECV_COMM = 2,
+};
+
+/* Counters of a rail of a device */
+typedef struct nccl_ofi_telemetry_rail {
+	uint64_t seq;
+	nccl_ofi_rail_counters_t counters;
+} nccl_ofi_telemetry_rail_t;
+
+/* Gauges of an endpoint */
+typedef struct nccl_ofi_telemetry_ep {
+	uint64_t seq;
+	/* Non-zero if the record is used by an endpoint */
+	uint32_t in_use;
+	int32_t dev_id;
+	int32_t num_rails;
+	uint32_t reserved;
+	/* Requests in pending requests queue, and its high-water mark */
+	uint64_t pending_reqs;
+	uint64_t pending_max;
+	/* Bounce buffers posted on each rail */
+	uint64_t bounce_posted[NCCL_OFI_TELEMETRY_MAX_RAILS];
+	/* Entries allocated by bounce buffer freelists */
+	uint64_t bounce_fl_entries;
+	uint64_t bounce_reqs_fl_entries;
+} nccl_ofi_telemetry_ep_t;
+
+/* Gauges and latency histograms of a communicator */
+typedef struct nccl_ofi_telemetry_comm {
+	uint64_t seq;
+	/* Non-zero if the record is used by a communicator */
+	uint32_t in_use;
+	int32_t dev_id;
+	/* Enum nccl_ofi_telemetry_comm_type */
+	uint32_t type;
+	uint32_t comm_id;
+	/* Requests posted by NCCL and not yet completed */
+	uint64_t inflight_reqs;
+	/* Entries allocated by request freelist */
+	uint64_t reqs_fl_entries;
+	/* Send or receive request latency */
+	nccl_ofi_histogram_t req_hist;
+	/* Control message wait of sends, flush latency of receives */
+	nccl_ofi_histogram_t wait_hist;
+	/* Segment latency on each rail (send communicators only) */
+	nccl_ofi_histogram_t rail_hist[NCCL_OFI_TELEMETRY_MAX_RAILS];
+} nccl_ofi_telemetry_comm_t;
+
+typedef struct nccl_ofi_telemetry_segment {
+	uint64_t magic;
+	uint32_t version;
+	/* Size of the segment in bytes */
+	uint32_t size;
+	int32_t pid;
+	int32_t num_devs;
+	int32_t num_rails;
+	uint32_t max_eps;
+	uint32_t max_comms;
+	uint32_t reserved;
+	/* CLOCK_MONOTONIC time of the last update in ns */
+	uint64_t update_ns;
+
+	nccl_ofi_telemetry_rail_t rails[NCCL_OFI_TELEMETRY_MAX_DEVS][NCCL_OFI_TELEMETRY_MAX_RAILS];
+	nccl_ofi_telemetry_ep_t eps[NCCL_OFI_TELEMETRY_MAX_EPS];
+	nccl_ofi_telemetry_comm_t comms[NCCL_OFI_TELEMETRY_MAX_COMMS];
+} nccl_ofi_telemetry_segment_t;
+
+/*
+ * @brief	Start update of record protected by sequence number `seq`
+ *
+ * @return	true, if the caller is the only writer of the record
+ *		false, if another writer is updating the record
+ */
+static inline bool nccl_ofi_telemetry_write_begin(uint64_t *seq)
+{
+	uint64_t value = __atomic_load_n(seq, __ATOMIC_RELAXED);
+
+	if (value & 1) {
+		return false;
+	}
+	if (!__atomic_compare_exchange_n(seq, &value, value + 1, false,
+					 __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+		return false;
+	}
+	/* Order the odd sequence number before the updates */
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	return true;
+}
+
+/*
+ * @brief	Finish update of record started with
+ *		nccl_ofi_telemetry_write_begin()
+ */
+static inline void nccl_ofi_telemetry_write_end(uint64_t *seq)
+{
+	__atomic_fetch_add(seq, 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * @brief	Start read of record protected by sequence number `seq`
+ *
+ * @return	Sequence number to pass to nccl_ofi_telemetry_read_retry()
+ */
+static inline uint64_t nccl_ofi_telemetry_read_begin(const uint64_t *seq)
+{
+	return __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * @brief	Check whether a writer updated the record during the read
+ *
+ * Readers should bound their retries, since the writer may have
+ * exited in the middle of an update.
+ *
+ * @return	true, if the copy of the record must be discarded
+ */
+static inline bool nccl_ofi_telemetry_read_retry(const uint64_t *seq, uint64_t begin)
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return (begin & 1) || __atomic_load_n(seq, __ATOMIC_RELAXED) != begin;
+}
+
+/*
+ * @brief	Create telemetry segment of the process
+ *
+ * The segment is only readable by the user of the process, and is
+ * removed when the process exits.
+ *
+ * @return	0, on success
+ *		negative errno, on error
+ */
+int nccl_ofi_telemetry_init(int num_devs, int num_rails);
+
+/*
+ * @brief	Telemetry segment of the process, or NULL if it was not
+ *		created
+ */
+nccl_ofi_telemetry_segment_t *nccl_ofi_telemetry_get(void);
+
+/*
+ * @brief	Reserve endpoint record
+ *
+ * @return	Record, or NULL if there is no segment or all records are
+ *		in use
+ */
+nccl_ofi_telemetry_ep_t *nccl_ofi_telemetry_alloc_ep(int dev_id);
+
+/*
+ * @brief	Reserve communicator record
+ *
+ * @return	Record, or NULL if there is no segment or all records are
+ *		in use
+ */
+nccl_ofi_telemetry_comm_t *nccl_ofi_telemetry_alloc_comm(int dev_id, uint32_t type,
+							 uint32_t comm_id);
+
+/*
+ * @brief	Release endpoint or communicator record
+ *
+ * @param	seq
+ *		Sequence number of the record
+ * @param	in_use
+ *		In-use flag of the record
+ */
+void nccl_ofi_telemetry_release(uint64_t *seq, uint32_t *in_use);
+
+/*
+ * @brief	Set time of the last update of the segment
+ */
+void nccl_ofi_telemetry_touch(void);
+
+#ifdef _cplusplus
+} // End extern "C"
+#endif
+
+#endif // End NCCL_OFI_TELEMETRY_H_
@@ -42,8 +42,8 @@ typedef struct nccl_ofi_topo_data {
 	 * while grouping algorithm is executed. */
 	int num_groups;
 
-	/* One of the GPU topology nodes that is the closest to the
-	 * NICs in `info_list` */
+	/* Accelerator topology node that the NICs in `info_list`
+	 * are assigned to */
 	hwloc_obj_t gpu_group_node;
 
 	/* Temporary data for grouping algorithm. Indicates whether
@@ -134,12 +134,18 @@ void nccl_ofi_topo_free(nccl_ofi_topo_t *topo);
  * user data, search towards the root for a node with 'num_groups' > 0.
  * If such a node has been found, move the list to that node.
  * 4. For each topology node with a libfabric NIC info list and 'num_groups > 0',
- * split the list into 'num_groups' sub-lists (groups) and add the
- * groups to the topology nodes corresponding to their leaders (first
- * NIC info of the list). If the length of the list is not a
- * multiple of 'num_groups', distribute the members evenly to the
- * groups with the exception that the first groups get assigned an
- * additional member.
+ * split the list into 'num_groups' sub-lists (groups), one for each
+ * accelerator that contributed to 'num_groups'. If the length of the
+ * list is not a multiple of 'num_groups', distribute the members
+ * evenly to the groups with the exception that the first groups get
+ * assigned an additional member.
+ * 5. Reassign NICs among all groups such that the minimum aggregate
+ * NIC bandwidth per accelerator is maximized. The PCIe link bandwidth
+ * of a NIC is scaled down if traffic between NIC and accelerator
+ * crosses a PCIe switch, a NUMA node, or a socket. Reassignment
+ * preserves the number of groups and the group sizes. Finally, add
+ * the groups to the topology nodes corresponding to their leaders
+ * (NIC info closest to the accelerator, first in the list).
  *
  * 
  * The example below shows a schematic representation of the topology
@@ -261,6 +267,22 @@ int nccl_ofi_topo_group(nccl_ofi_topo_t *topo);
  */
 nccl_ofi_topo_t *nccl_ofi_topo_create(struct fi_info *info_list);
 
+/*
+ * @brief	Allocate and initialize nccl_ofi_topo_t struct from hwloc XML
+ *
+ * Same as nccl_ofi_topo_create(), except that the hardware topology
+ * is loaded from an hwloc XML description instead of being
+ * discovered from the running system.
+ *
+ * @param	info_list
+ *		List of libfabric NIC info structs
+ * @param	xml
+ *		Null-terminated hwloc XML topology
+ * @return	NCCL OFI hardware topology, on success
+ *		NULL, on others
+ */
+nccl_ofi_topo_t *nccl_ofi_topo_create_from_xml(struct fi_info *info_list, const char *xml);
+
 /*
  * @brief	Write NCCL topology file based on NCCL OFI topology
  *
@@ -273,6 +295,21 @@ nccl_ofi_topo_t *nccl_ofi_topo_create(struct fi_info *info_list);
  */
 int nccl_ofi_topo_write(nccl_ofi_topo_t *topo, FILE *file);
 
+/*
+ * @brief	Set directory that PCI link speeds and widths are read from
+ *
+ * The directory is expected to contain one subdirectory per PCI
+ * device, named by PCI bus ID, as `/sys/bus/pci/devices` does. This
+ * allows writing NCCL topology files for topologies that are loaded
+ * from hwloc XML and do not describe the running system.
+ *
+ * @param	path
+ *		Directory path, or NULL to restore the default
+ *		`/sys/bus/pci/devices`. The string is not copied and
+ *		must stay valid while topologies are written.
+ */
+void nccl_ofi_topo_set_pci_sysfs_path(const char *path);
+
 /*
  * @brief	Return number of topology nodes that store a libfabric NIC info
  *		list
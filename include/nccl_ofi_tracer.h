@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#ifndef NCCL_OFI_TRACER_H_
+#define NCCL_OFI_TRACER_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Built-in tracer
+ *
+ * The tracer records the request lifecycle events of the tracepoints of
+ * tracepoint.h without LTTng. Each thread records its events into its
+ * own ring buffer, which keeps the latest OFI_NCCL_TRACE_BUFFER_EVENTS
+ * events. At exit, and on OFI_NCCL_TRACE_SIGNAL, the events are written
+ * to OFI_NCCL_TRACE_FILE in the Chrome trace event format, which
+ * ui.perfetto.dev and chrome://tracing load.
+ *
+ * Sends, receives and flushes are written as spans from their post to
+ * their completion on a track of their communicator, and the segments
+ * of RDMA writes as spans on a track of their rail. Control and eager
+ * messages and receive segments are written as instant events. A track
+ * is split into lanes when its spans overlap.
+ */
+
+/* Type of tracer event */
+enum nccl_ofi_tracer_event_type {
+	NCCL_OFI_TRACER_SEND = 1,
+	NCCL_OFI_TRACER_SEND_CTRL_RECV,
+	NCCL_OFI_TRACER_SEND_WRITE_SEG_START,
+	NCCL_OFI_TRACER_SEND_WRITE_SEG_COMPLETE,
+	NCCL_OFI_TRACER_RECV,
+	NCCL_OFI_TRACER_RECV_CTRL_SEND_COMPLETE,
+	NCCL_OFI_TRACER_RECV_SEGMENT_COMPLETE,
+	NCCL_OFI_TRACER_EAGER_RECV,
+	NCCL_OFI_TRACER_FLUSH,
+	NCCL_OFI_TRACER_COMPLETE,
+};
+
+typedef struct nccl_ofi_tracer_event {
+	/* CLOCK_MONOTONIC time in ns */
+	uint64_t ts;
+	const void *comm;
+	const void *request;
+	uint64_t size;
+	int32_t dev;
+	/* Rail of the event, or -1 */
+	int16_t rail;
+	/* Enum nccl_ofi_tracer_event_type */
+	uint16_t type;
+	/* Message sequence number, or local communicator ID of receives */
+	uint32_t id;
+} nccl_ofi_tracer_event_t;
+
+/* Non-zero if events are recorded */
+extern int nccl_ofi_tracer_enabled;
+
+/*
+ * @brief	Record event into the ring buffer of the calling thread
+ */
+void nccl_ofi_tracer_record(uint16_t type, int dev, int rail, const void *comm,
+			    uint32_t id, const void *request, uint64_t size);
+
+#define NCCL_OFI_TRACER_RECORD(type, dev, rail, comm, id, request, size)	\
+	do {									\
+		if (__builtin_expect(nccl_ofi_tracer_enabled, 0)) {		\
+			nccl_ofi_tracer_record(type, dev, rail, comm, id,	\
+					       request, size);			\
+		}								\
+	} while (0)
+
+/*
+ * @brief	Initialize tracer from OFI_NCCL_TRACE_FILE,
+ *		OFI_NCCL_TRACE_BUFFER_EVENTS and OFI_NCCL_TRACE_SIGNAL
+ *
+ * The tracer stays disabled without a trace file.
+ *
+ * @return	0, on success
+ *		negative errno, on error
+ */
+int nccl_ofi_tracer_init(void);
+
+/*
+ * @brief	Copy the events of all threads
+ *
+ * Events that threads overwrite during the copy are dropped.
+ *
+ * @param	events
+ *		Array of events, allocated by the function and freed
+ *		by the caller
+ * @param	num_events
+ *		Number of events of the array
+ *
+ * @return	0, on success
+ *		-ENOMEM, on allocation failure
+ */
+int nccl_ofi_tracer_snapshot(nccl_ofi_tracer_event_t **events, size_t *num_events);
+
+/*
+ * @brief	Write events in the Chrome trace event format
+ *
+ * @param	events
+ *		Events, sorted by time
+ *
+ * @return	0, on success
+ *		negative errno, on error
+ */
+int nccl_ofi_tracer_write_events(const nccl_ofi_tracer_event_t *events, size_t num_events,
+				 const char *path);
+
+/*
+ * @brief	Write the events of all threads to the trace file
+ *
+ * @return	0, on success
+ *		negative errno, on error
+ */
+int nccl_ofi_tracer_flush(void);
+
+/*
+ * @brief	Flush the trace file if the trace signal was received
+ *		since the last call. Called from the progress path.
+ */
+void nccl_ofi_tracer_check_signal(void);
+
+#ifdef _cplusplus
+} // End extern "C"
+#endif
+
+#endif // End NCCL_OFI_TRACER_H_
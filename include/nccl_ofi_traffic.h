@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#ifndef NCCL_OFI_TRAFFIC_H_
+#define NCCL_OFI_TRAFFIC_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+#include <pthread.h>
+#include <stdint.h>
+
+/*
+ * Traffic matrix
+ *
+ * With OFI_NCCL_TRAFFIC_MATRIX_FILE set, each endpoint of the RDMA
+ * protocol counts the bytes and messages of the completed sends and
+ * receives of all its communicators per remote peer, keyed by the
+ * peer's fi_addr in the address vector of the endpoint's first rail.
+ * The counters of an endpoint form one row of the traffic matrix of the
+ * job. The rows of the process are written to the file at exit, and
+ * nccl-ofi-traffic-matrix merges the files of all ranks into the full
+ * matrix and its heatmap.
+ *
+ * Fabric addresses are only meaningful within an address vector, so
+ * that rows and peers are identified in the file by their address
+ * string (fi_av_straddr()) as well.
+ *
+ * The file consists of lines of space-separated key=value fields, one
+ * line per endpoint followed by one line per peer of that endpoint:
+ *
+ *   endpoint addr=<addr> host=<hostname> pid=<pid> rank=<rank> dev=<dev>
+ *   peer addr=<addr> fi_addr=<fi_addr> tx_bytes=<n> tx_msgs=<n> rx_bytes=<n> rx_msgs=<n>
+ *
+ * The rank is read from the environment of common launchers, and is -1
+ * if unknown.
+ */
+
+#define NCCL_OFI_TRAFFIC_VERSION	(1)
+
+/* Maximum number of rows of a process */
+#define NCCL_OFI_TRAFFIC_MAX_ROWS	(256)
+
+/* Maximum length of an address string */
+#define NCCL_OFI_TRAFFIC_ADDR_LEN	(128)
+
+typedef struct nccl_ofi_traffic_peer {
+	struct nccl_ofi_traffic_peer *next;
+	/* Address of the peer in the address vector of the endpoint */
+	uint64_t fi_addr;
+	char addr[NCCL_OFI_TRAFFIC_ADDR_LEN];
+	/* Bytes and messages of completed sends to the peer and of
+	 * completed receives from the peer */
+	uint64_t tx_bytes;
+	uint64_t tx_msgs;
+	uint64_t rx_bytes;
+	uint64_t rx_msgs;
+} nccl_ofi_traffic_peer_t;
+
+typedef struct nccl_ofi_traffic_row {
+	/* Serializes insertions of peers */
+	pthread_mutex_t lock;
+	/* List of peers, which are never removed */
+	nccl_ofi_traffic_peer_t *peers;
+	int dev_id;
+	/* Address of the endpoint */
+	char addr[NCCL_OFI_TRAFFIC_ADDR_LEN];
+} nccl_ofi_traffic_row_t;
+
+/*
+ * @brief	Allocate row of endpoint
+ *
+ * Rows are never freed, so that the traffic of endpoints that were
+ * released is still written at exit.
+ *
+ * @param	addr
+ *		Address string of the endpoint
+ * @return	Row, or NULL if the traffic matrix is disabled or all rows
+ *		are in use
+ */
+nccl_ofi_traffic_row_t *nccl_ofi_traffic_alloc(int dev_id, const char *addr);
+
+/*
+ * @brief	Peer of row, added if new
+ *
+ * Communicators look their peer up once when they are created, and
+ * count their traffic on it.
+ *
+ * @param	fi_addr
+ *		Address of the peer in the address vector of the endpoint
+ * @param	addr
+ *		Address string of the peer
+ * @return	Peer, or NULL if the allocation failed
+ */
+nccl_ofi_traffic_peer_t *nccl_ofi_traffic_get_peer(nccl_ofi_traffic_row_t *row,
+						   uint64_t fi_addr, const char *addr);
+
+/*
+ * @brief	Count completed send to peer
+ */
+static inline void nccl_ofi_traffic_record_tx(nccl_ofi_traffic_peer_t *peer, uint64_t bytes)
+{
+	__atomic_fetch_add(&peer->tx_bytes, bytes, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&peer->tx_msgs, 1, __ATOMIC_RELAXED);
+}
+
+/*
+ * @brief	Count completed receive from peer
+ */
+static inline void nccl_ofi_traffic_record_rx(nccl_ofi_traffic_peer_t *peer, uint64_t bytes)
+{
+	__atomic_fetch_add(&peer->rx_bytes, bytes, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&peer->rx_msgs, 1, __ATOMIC_RELAXED);
+}
+
+/*
+ * @brief	Enable traffic matrix from OFI_NCCL_TRAFFIC_MATRIX_FILE and
+ *		register the write of the rows at exit
+ *
+ * @return	0, on success
+ *		negative errno, on error
+ */
+int nccl_ofi_traffic_init(void);
+
+/*
+ * @brief	Write rows of the process to the traffic matrix file
+ *
+ * @return	0, on success
+ *		negative errno, on error
+ */
+int nccl_ofi_traffic_write(void);
+
+#ifdef _cplusplus
+} // End extern "C"
+#endif
+
+#endif // End NCCL_OFI_TRAFFIC_H_
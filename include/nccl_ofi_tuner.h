@@ -3,36 +3,162 @@
 
 #include <linux/limits.h>
 #include <float.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
 #include "nccl-headers/nvidia/tuner.h"
 #include "nccl_ofi_param.h"
 
 /*
- * The plugin interface lets us tune the number of channels as well, but that
- * can come later (once a proto+algo combination is chosen, we can compute the
- * cost with different channel count and optimize for it.
+ * Maximum number of channels chosen by the tuner. For each algorithm and
+ * protocol, the cost is computed for the powers of two below this count
+ * and for the count itself, and the best channel count is returned to
+ * NCCL along with the algorithm and protocol.
  */
 OFI_NCCL_PARAM_INT(tuner_num_channels, "TUNER_NUM_CHANNELS", 8);
 
+/*
+ * Fixed overhead of each channel for each pipelined operation in nsecs,
+ * for launching and synchronizing the channel's work.
+ */
+OFI_NCCL_PARAM_INT(tuner_channel_overhead_ns, "TUNER_CHANNEL_OVERHEAD_NS", 200);
+
+/*
+ * Cost of the SM occupied by each channel in nsecs per collective. This
+ * accounts for the compute that overlapping kernels lose to additional
+ * channels, and favors fewer channels where they barely help.
+ */
+OFI_NCCL_PARAM_INT(tuner_sm_cost_ns, "TUNER_SM_COST_NS", 100);
+
 /*
  * Latency in µsecs. Note, this is currently different from the network plugin's param for
  * net latency by design. When we merge with the platform_data values, we will
  * need to do some additional testing on the base case where a tuner is not
  * loaded to make sure the same defaykts make sense across both paths, and
  * combine the parameters. This parameter is meant for internal testing only and
- * is not meant to be documented for users.
+ * is not meant to be documented for users. Unless set, the one-way latency
+ * calibrated by the network plugin takes precedence over the default.
  */
 OFI_NCCL_PARAM_INT(tuner_net_latency, "TUNER_NET_LATENCY", 20);
 
 /*
  * With EFA, we expect a ~2µsec cost in the device and ~1µsec cost to write that
- * completion up to the host stack.
+ * completion up to the host stack. Unless set, the gap between back-to-back
+ * small messages calibrated by the network plugin takes precedence over the
+ * default.
  */
 OFI_NCCL_PARAM_INT(tuner_net_comp_overhead, "TUNER_NET_COMP_OVERHEAD", 3);
 
-/* EFA unidirectional network bandwidth */
+/*
+ * Cost model of the tuner: "hockney" (latency plus size over bandwidth)
+ * or "loggp" (per-message overhead and gap on each rail).
+ */
+OFI_NCCL_PARAM_STR(tuner_model, "TUNER_MODEL", "hockney");
+
+/*
+ * LogGP per-message overhead (o) and gap between messages (g) of a rail
+ * in nsecs. The gap per byte (G) is the inverse of the rail bandwidth.
+ */
+OFI_NCCL_PARAM_INT(tuner_loggp_o_ns, "TUNER_LOGGP_O_NS", 1000);
+OFI_NCCL_PARAM_INT(tuner_loggp_g_ns, "TUNER_LOGGP_G_NS", 500);
+
+/*
+ * Unidirectional network bandwidth per rail in bytes per µsec. The
+ * default of 0 selects the bandwidth calibrated by the network plugin
+ * (OFI_NCCL_CALIBRATE), or the link speed of its rails (see
+ * nccl_ofi_tuner_hints.h), or NCCL_OFI_TUNER_INTERNODE_BW.
+ */
+OFI_NCCL_PARAM_INT(tuner_internode_bw, "TUNER_INTERNODE_BW", 0);
+
+/*
+ * Number of rails available to each GPU. The default of 0 selects the
+ * size of the NIC groups of the local topology as provided by the
+ * network plugin, or NCCL_OFI_TUNER_NET_NUM_RAILS. Jobs mixing instance
+ * types need to set the smallest rail count of the job on all ranks, so
+ * that all ranks cost the worst-case node and make the same decisions.
+ */
+OFI_NCCL_PARAM_INT(tuner_num_rails, "TUNER_NUM_RAILS", 0);
+
+/*
+ * Unidirectional intranode bandwidth per channel in bytes per µsec. The
+ * default of 0 selects the value of the platform data as provided by
+ * the network plugin, or NCCL_OFI_TUNER_INTRANODE_BW.
+ */
+OFI_NCCL_PARAM_INT(tuner_intranode_bw, "TUNER_INTRANODE_BW", 0);
+
+/*
+ * Intranode latency of a ring hop with the Simple protocol in nsecs. The
+ * intranode latencies of all algorithms and protocols (nccl_nvlink_lat)
+ * are scaled by the ratio to NCCL's NVLink value. The default of 0
+ * selects the value of the platform data as provided by the network
+ * plugin, or keeps NCCL's NVLink latencies.
+ */
+OFI_NCCL_PARAM_INT(tuner_intranode_latency_ns, "TUNER_INTRANODE_LATENCY_NS", 0);
+
+/*
+ * Ranks on the nodes with the most and the fewest ranks of the job. The
+ * tuner only learns the rank and node counts of a communicator, and
+ * assumes the most even placement by default (0). Set both for jobs that
+ * place ranks unevenly. Communicators whose rank and node counts can
+ * not have these local rank counts, e.g., of a subset of the ranks,
+ * assume the most even placement.
+ */
+OFI_NCCL_PARAM_INT(tuner_max_local_ranks, "TUNER_MAX_LOCAL_RANKS", 0);
+OFI_NCCL_PARAM_INT(tuner_min_local_ranks, "TUNER_MIN_LOCAL_RANKS", 0);
+
+/*
+ * Parameter file with model parameters, e.g., fitted to measurements by
+ * nccl-ofi-tuner-fit. Values of the file take precedence over the
+ * environment variables of the parameters.
+ */
+OFI_NCCL_PARAM_STR(tuner_param_file, "TUNER_PARAM_FILE", NULL);
+
+/*
+ * By default, getCollInfo looks up the decision precomputed at
+ * initialization for the size bucket of the message. If set, the costs
+ * of all algorithms and protocols are computed for each call instead,
+ * and calls where the decision table differs are logged. This is meant
+ * for validating the decision table and is not meant to be documented
+ * for users.
+ */
+OFI_NCCL_PARAM_INT(tuner_exact_cost, "TUNER_EXACT_COST", 0);
+
+/*
+ * Refine decisions with measured times of collectives recorded through
+ * nccl_ofi_tuner_record_feedback(). Off by default, as the tuner API has
+ * no way to report times and the caller needs to record them.
+ */
+OFI_NCCL_PARAM_INT(tuner_feedback, "TUNER_FEEDBACK", 0);
+
+/*
+ * Feedback policy: every EXPLORE_PERIOD-th call of a size bucket, the
+ * choice is revised from the recorded times, and an alternative choice
+ * whose modeled cost is within MARGIN_PCT percent of the lowest cost is
+ * explored until EXPLORE_COUNT times are recorded for it (and at most
+ * four times as often).
+ */
+OFI_NCCL_PARAM_INT(tuner_feedback_explore_period, "TUNER_FEEDBACK_EXPLORE_PERIOD", 64);
+OFI_NCCL_PARAM_INT(tuner_feedback_explore_count, "TUNER_FEEDBACK_EXPLORE_COUNT", 4);
+OFI_NCCL_PARAM_INT(tuner_feedback_margin_pct, "TUNER_FEEDBACK_MARGIN_PCT", 50);
+
+/*
+ * EFA unidirectional network bandwidth and rails of P5, used unless the
+ * network plugin provides the values of the platform.
+ */
 #define NCCL_OFI_TUNER_INTERNODE_BW	(12.5 * 1024 * 1024 * 1024 * 1e-6) /* per rail */
 #define NCCL_OFI_TUNER_NET_NUM_RAILS	(4) /* Available to each GPU */
 
+/*
+ * Network bandwidth a single channel drives in bytes per µsec. The
+ * transfers of a channel are processed by one SM and one network
+ * connection, which reach about the bandwidth of one rail, so the rails
+ * of a GPU saturate with as many channels as rails.
+ */
+#define NCCL_OFI_TUNER_CHANNEL_BW	(12.5 * 1024 * 1024 * 1024 * 1e-6)
+
+/* Upper bound of OFI_NCCL_TUNER_NUM_CHANNELS (MAXCHANNELS in NCCL) */
+#define NCCL_OFI_TUNER_MAX_CHANNELS	(32)
+
 /*
  * For Hopper GPUs on P5, all intranode communication goes over NVLink, so use
  * the bandwidth for SM90 architecture in NCCL (SM90_NVLINK_BW).
@@ -41,8 +167,8 @@ OFI_NCCL_PARAM_INT(tuner_net_comp_overhead, "TUNER_NET_COMP_OVERHEAD", 3);
  * platform, with 18 NVLinks in total. NCCL considers a 20% protocol overhead,
  * leaving 20GB/s bandwidth per link).
  *
- * TODO: When extending to P4/other platforms, include these values in
- * platform_data and fetch from it for the tuner. Value as defined in Bytes/µsec.
+ * Used unless the platform data of the network plugin provides the value
+ * (OFI_NCCL_TUNER_INTRANODE_BW). Value as defined in Bytes/µsec.
  */
 #define NCCL_OFI_TUNER_INTRANODE_BW	(20.0 * 1024 * 1024 * 1024 * 1e-6)
 
@@ -77,28 +203,385 @@ static const float nccl_base_lat[NCCL_NUM_ALGORITHMS][NCCL_NUM_PROTOCOLS] = {
 };
 
 struct nccl_ofi_tuner_model_params {
+	/* Latency of a network hop in µsecs */
 	float net_lat;
+	/* Completion overhead of a network hop with the Simple protocol in µsecs */
+	float net_comp_overhead;
+	/* Latency of each algorithm and protocol not captured by the hops */
+	float base_lat[NCCL_NUM_ALGORITHMS][NCCL_NUM_PROTOCOLS];
 	float internode_bw;
 	float intranode_bw;
+	/* Scale of NCCL's NVLink latencies (nccl_nvlink_lat) */
+	float intranode_lat_scale;
 	int num_rails;
+	/* Per-channel overhead per pipelined operation in µsecs */
+	float channel_overhead;
+	/* Per-channel SM cost in µsecs */
+	float sm_cost;
+	/* Maximum number of channels */
+	int max_channels;
+	/* LogGP per-message overhead of a rail in µsecs */
+	float loggp_o;
+	/* LogGP gap between messages on a rail in µsecs */
+	float loggp_g;
+	/* LogGP gap per byte of a rail in µsecs (inverse of internode_bw) */
+	float loggp_G;
 };
 
 struct nccl_ofi_tuner_model_dims {
 	/* communicator size */
 	int num_ranks;
 	int num_nodes;
+	/*
+	 * Ranks on the nodes with the most and the fewest ranks. Ranks may
+	 * be spread unevenly over the nodes; the model costs the worst-case
+	 * node, i.e., the longest intranode chains and the fewest ranks
+	 * sharing the network traffic of a node.
+	 */
+	int max_local_ranks;
+	int min_local_ranks;
+};
+
+/*
+ * @brief	Set communicator dimensions
+ *
+ * @param	max_local_ranks, min_local_ranks
+ *		Ranks on the nodes with the most and the fewest ranks, or 0
+ *		for the most even placement of the ranks
+ * @return	0, on success
+ *		-EINVAL, if the local rank counts do not fit the
+ *		communicator (the most even placement is set)
+ */
+int nccl_ofi_tuner_init_dims(struct nccl_ofi_tuner_model_dims *dims, int num_ranks, int num_nodes,
+			     int max_local_ranks, int min_local_ranks);
+
+/*
+ * Shape of an algorithm for a collective, independent of the cost
+ * model: the hops of the critical path that fill the pipeline, and how
+ * much data each rank moves and how fast.
+ */
+struct nccl_ofi_tuner_shape {
+	/* Network hops of the critical path */
+	float net_steps;
+	/* Latency of NVLink hops of the critical path in µsecs */
+	float p2p_latency;
+	/* Fraction of the message each rank moves on its busiest link */
+	float data_ratio;
+	/* Bandwidth at which each rank moves data_ratio in bytes per µsec */
+	float bw;
+	/* Fraction of the message each rank sends over the network */
+	float net_ratio;
+	/* Number of steps in which each channel sends its network data */
+	float net_pieces;
+};
+
+/*
+ * @brief	Compute shape of algorithm
+ *
+ * @return	0, on success
+ *		-1, if the combination has no model
+ */
+int nccl_ofi_tuner_compute_shape(struct nccl_ofi_tuner_model_params *params,
+				 struct nccl_ofi_tuner_model_dims *dims,
+				 ncclFunc_t func, int algo, int proto, int channels,
+				 struct nccl_ofi_tuner_shape *shape);
+
+/*
+ * Decision table dimensions. Message sizes up to
+ * 2^NCCL_OFI_TUNER_TABLE_MAX_SIZE_LOG2 bytes are split into
+ * NCCL_OFI_TUNER_TABLE_SIZE_STEPS log-spaced buckets per power of two,
+ * and the decision of a bucket is computed for its smallest size. Calls
+ * with larger messages or more than NCCL_OFI_TUNER_TABLE_PIPE_OPS
+ * pipelined operations are computed exactly.
+ */
+#define NCCL_OFI_TUNER_TABLE_SIZE_STEPS_LOG2	(2)
+#define NCCL_OFI_TUNER_TABLE_SIZE_STEPS		(1 << NCCL_OFI_TUNER_TABLE_SIZE_STEPS_LOG2)
+#define NCCL_OFI_TUNER_TABLE_MAX_SIZE_LOG2	(40)
+#define NCCL_OFI_TUNER_TABLE_SIZE_BUCKETS	\
+	((NCCL_OFI_TUNER_TABLE_MAX_SIZE_LOG2 + 1) * NCCL_OFI_TUNER_TABLE_SIZE_STEPS)
+#define NCCL_OFI_TUNER_TABLE_PIPE_OPS		(8)
+
+struct nccl_ofi_tuner_decision {
+	/* NCCL_ALGO_UNDEF if NCCL's selection is used */
+	int8_t algo;
+	int8_t proto;
+	int8_t channels;
+};
+
+/*
+ * Costs of all algorithms and protocols for a call, reported to NCCL
+ * through the v3 tuner interface
+ */
+struct nccl_ofi_tuner_costs {
+	/* Cost in µsecs at the lowest-cost channel count, or
+	 * NCCL_ALGO_PROTO_IGNORE if the tuner does not consider the
+	 * algorithm and protocol */
+	float cost[NCCL_NUM_ALGORITHMS][NCCL_NUM_PROTOCOLS];
+	int8_t channels[NCCL_NUM_ALGORITHMS][NCCL_NUM_PROTOCOLS];
 };
 
+/*
+ * Cost model. Computes the cost in µsecs of a collective with an
+ * algorithm, protocol and channel count, or a negative value if the
+ * combination has no model.
+ */
+struct nccl_ofi_tuner_model {
+	const char *name;
+	double (*compute_cost)(struct nccl_ofi_tuner_model_params *params,
+			       struct nccl_ofi_tuner_model_dims *dims,
+			       ncclFunc_t func, int algo, int proto, int pipe_ops,
+			       int channels, size_t size);
+};
+
+/* Registry of cost models, terminated by an entry without name */
+extern const struct nccl_ofi_tuner_model nccl_ofi_tuner_models[];
+
+/*
+ * @brief	Look up cost model by name
+ *
+ * @return	Model, or NULL if no model has the name
+ */
+const struct nccl_ofi_tuner_model *nccl_ofi_tuner_find_model(const char *name);
+
 struct nccl_ofi_tuner_context {
-    struct nccl_ofi_tuner_model_dims dims;
+	struct nccl_ofi_tuner_model_dims dims;
 	struct nccl_ofi_tuner_model_params model_params;
+	const struct nccl_ofi_tuner_model *model;
+
+	/* Decisions by collective, NVLS support, pipelined operations - 1
+	 * and size bucket */
+	struct nccl_ofi_tuner_decision table[NCCL_NUM_FUNCTIONS][2][NCCL_OFI_TUNER_TABLE_PIPE_OPS]
+					    [NCCL_OFI_TUNER_TABLE_SIZE_BUCKETS];
+
+	/* Recorded feedback, NULL unless OFI_NCCL_TUNER_FEEDBACK is set */
+	struct nccl_ofi_tuner_feedback *feedback;
 
-	float base_costs[NCCL_NUM_FUNCTIONS][NCCL_NUM_ALGORITHMS][NCCL_NUM_PROTOCOLS];
+	/* Costs by collective and size bucket of calls with a single
+	 * pipelined operation, NULL unless initialized through the v3
+	 * tuner interface */
+	struct nccl_ofi_tuner_costs (*cost_table)[NCCL_OFI_TUNER_TABLE_SIZE_BUCKETS];
 };
 
-/* Modeling functions */
-void nccl_ofi_tuner_model_costs(struct nccl_ofi_tuner_context *ctx);
-float nccl_ofi_tuner_compute_cost(struct nccl_ofi_tuner_model_params *params, struct nccl_ofi_tuner_model_dims *dims,
-                                  ncclFunc_t func, int algo, int proto, int pipe_ops, size_t size);
+/* Names of collectives, algorithms and protocols in parameter files */
+extern const char *const nccl_ofi_tuner_func_names[NCCL_NUM_FUNCTIONS];
+extern const char *const nccl_ofi_tuner_algo_names[NCCL_NUM_ALGORITHMS];
+extern const char *const nccl_ofi_tuner_proto_names[NCCL_NUM_PROTOCOLS];
+
+/*
+ * @brief	Set model parameters from the environment and defaults
+ */
+void nccl_ofi_tuner_default_params(struct nccl_ofi_tuner_model_params *params);
+
+/*
+ * @brief	Load model parameters from parameter file
+ *
+ * The file uses INI syntax. Section `model` sets scalar parameters, and
+ * section `base_latency` sets the base latency of an algorithm and
+ * protocol with keys `<algorithm>.<protocol>`. Parameters not set by
+ * the file keep their value.
+ *
+ * @return	0, on success
+ *		negative errno, on error (params unchanged)
+ */
+int nccl_ofi_tuner_load_params(const char *path, struct nccl_ofi_tuner_model_params *params);
+
+/*
+ * Grid of calls for which a decision map lists the tuner's choices.
+ * Message sizes are the powers of two from min_size to max_size.
+ */
+struct nccl_ofi_tuner_map_grid {
+	/* Bitmask of collectives by ncclFunc_t */
+	unsigned int funcs;
+	size_t min_size;
+	size_t max_size;
+	int min_pipe_ops;
+	int max_pipe_ops;
+	/* List calls with and without NVLS support, else only without */
+	bool nvls_support;
+};
+
+/*
+ * @brief	Write the header line of a CSV decision map
+ */
+void nccl_ofi_tuner_map_write_header(FILE *stream);
+
+/*
+ * @brief	Write the choices of the tuner over a grid of calls as
+ *		CSV decision map
+ *
+ * Each line gives the algorithm, protocol and channel count returned by
+ * the tuner's getCollInfo for a call of the grid, and the cost of that
+ * choice in the tuner's model. Calls left to NCCL's own selection are
+ * listed with algorithm `nccl` and no protocol, channels or cost.
+ *
+ * @param	context
+ *		Context returned by the tuner's init
+ * @return	0, on success
+ *		-EIO, on write error
+ */
+int nccl_ofi_tuner_map_write(FILE *stream, void *context,
+			     const struct nccl_ofi_tuner_map_grid *grid);
+
+/*
+ * @brief	Compute the algorithm, protocol and channel count with the
+ *		lowest cost
+ *
+ * @return	Lowest cost in µsecs, or a negative value if no algorithm
+ *		and protocol has a model (algo, proto and channels are not
+ *		set)
+ */
+double nccl_ofi_tuner_compute_decision(struct nccl_ofi_tuner_context *ctx, ncclFunc_t func,
+				       int nvls_support, int pipe_ops, size_t size,
+				       int *algo, int *proto, int *channels);
+
+/*
+ * @brief	Rank the algorithms and protocols by cost
+ *
+ * Fills choices with the lowest-cost channel count of each supported
+ * algorithm and protocol, sorted by cost, and costs with their costs.
+ *
+ * @return	Number of choices, at most max_choices
+ */
+int nccl_ofi_tuner_rank_choices(struct nccl_ofi_tuner_context *ctx, ncclFunc_t func,
+				int nvls_support, int pipe_ops, size_t size,
+				struct nccl_ofi_tuner_decision *choices, double *costs,
+				int max_choices);
+
+/*
+ * @brief	Precompute the decision table of the context
+ */
+void nccl_ofi_tuner_build_table(struct nccl_ofi_tuner_context *ctx);
+
+/*
+ * @brief	Compute the costs of all algorithms and protocols
+ *
+ * Algorithms and protocols are considered as with NVLS support, since
+ * NCCL marks the combinations it does not support in its cost table.
+ */
+void nccl_ofi_tuner_compute_costs(struct nccl_ofi_tuner_context *ctx, ncclFunc_t func,
+				  int pipe_ops, size_t size, struct nccl_ofi_tuner_costs *costs);
+
+/*
+ * @brief	Precompute the cost table of the context
+ *
+ * @return	0, on success
+ *		-ENOMEM, on allocation failure
+ */
+int nccl_ofi_tuner_build_cost_table(struct nccl_ofi_tuner_context *ctx);
+
+/*
+ * Online feedback. Decisions of calls with a single pipelined operation
+ * and a message within the decision table are refined with measured
+ * times. The policy is a deterministic function of the sequence of
+ * getCollInfo calls and recorded times, so ranks make the same
+ * decisions if they record the same times, e.g., the maximum time
+ * across ranks, before the same call.
+ */
+
+/* Alternatives to the modeled choice considered for each size bucket */
+#define NCCL_OFI_TUNER_FEEDBACK_CHOICES		(4)
+
+/*
+ * @brief	Allocate feedback state of context if enabled
+ *
+ * @return	0, on success
+ *		-ENOMEM, on allocation failure
+ */
+int nccl_ofi_tuner_feedback_init(struct nccl_ofi_tuner_context *ctx);
+
+/*
+ * @brief	Free feedback state of context
+ */
+void nccl_ofi_tuner_feedback_fini(struct nccl_ofi_tuner_context *ctx);
+
+/*
+ * @brief	Choose algorithm, protocol and channel count from feedback
+ *
+ * @return	true, if the choice is set
+ *		false, if the call is not refined with feedback
+ */
+bool nccl_ofi_tuner_feedback_choose(struct nccl_ofi_tuner_context *ctx, ncclFunc_t func,
+				    int nvls_support, int pipe_ops, size_t size,
+				    int *algo, int *proto, int *channels);
+
+/*
+ * @brief	Record measured time of a collective
+ *
+ * @param	context
+ *		Context returned by the tuner's init
+ * @param	time
+ *		Time of the collective in µsecs
+ * @return	0, on success
+ *		-EINVAL, if the arguments are invalid
+ *		-ENOENT, if the call is not refined with feedback or the
+ *		choice is not considered for it
+ */
+int nccl_ofi_tuner_record_feedback(void *context, ncclFunc_t func, size_t size,
+				   int nvls_support, int algo, int proto, int channels,
+				   double time);
+
+/*
+ * @brief	Size bucket of a message in the decision table
+ *
+ * @return	Bucket, or -1 if the message is larger than the table
+ */
+static inline int nccl_ofi_tuner_size_bucket(size_t size)
+{
+	int size_log2, bucket;
+
+	if (size == 0) {
+		return 0;
+	}
+
+	size_log2 = 63 - __builtin_clzll(size);
+	if (size_log2 > NCCL_OFI_TUNER_TABLE_MAX_SIZE_LOG2) {
+		return -1;
+	}
+	/* The bits following the most significant bit select the
+	 * bucket within the power of two */
+	if (size_log2 >= NCCL_OFI_TUNER_TABLE_SIZE_STEPS_LOG2) {
+		bucket = (size >> (size_log2 - NCCL_OFI_TUNER_TABLE_SIZE_STEPS_LOG2));
+	} else {
+		bucket = (size << (NCCL_OFI_TUNER_TABLE_SIZE_STEPS_LOG2 - size_log2));
+	}
+	return size_log2 * NCCL_OFI_TUNER_TABLE_SIZE_STEPS
+		+ (bucket & (NCCL_OFI_TUNER_TABLE_SIZE_STEPS - 1));
+}
+
+/*
+ * @brief	Smallest message size of a size bucket
+ */
+static inline size_t nccl_ofi_tuner_bucket_size(int bucket)
+{
+	int size_log2 = bucket / NCCL_OFI_TUNER_TABLE_SIZE_STEPS;
+	int step = bucket % NCCL_OFI_TUNER_TABLE_SIZE_STEPS;
+
+	return ((size_t)(NCCL_OFI_TUNER_TABLE_SIZE_STEPS + step) << size_log2)
+		>> NCCL_OFI_TUNER_TABLE_SIZE_STEPS_LOG2;
+}
+
+/*
+ * @brief	Look up the decision for a message in the decision table
+ *
+ * @return	Decision, or NULL if the message is outside of the table
+ */
+static inline const struct nccl_ofi_tuner_decision *
+nccl_ofi_tuner_lookup_decision(const struct nccl_ofi_tuner_context *ctx, ncclFunc_t func,
+			       int nvls_support, int pipe_ops, size_t size)
+{
+	int bucket;
+
+	if (func < 0 || func >= NCCL_NUM_FUNCTIONS ||
+	    pipe_ops < 1 || pipe_ops > NCCL_OFI_TUNER_TABLE_PIPE_OPS) {
+		return NULL;
+	}
+
+	bucket = nccl_ofi_tuner_size_bucket(size);
+	if (bucket < 0) {
+		return NULL;
+	}
+
+	return &ctx->table[func][nvls_support ? 1 : 0][pipe_ops - 1][bucket];
+}
 
 #endif /* NCCL_OFI_TUNER_H_ */
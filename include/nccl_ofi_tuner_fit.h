@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#ifndef NCCL_OFI_TUNER_FIT_H_
+#define NCCL_OFI_TUNER_FIT_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "nccl_ofi_tuner.h"
+
+/*
+ * Offline fitting of the Hockney model parameters to measured
+ * collective times, e.g., of nccl-tests runs with fixed algorithm,
+ * protocol and channel count. The fitted parameters are written as a
+ * parameter file for OFI_NCCL_TUNER_PARAM_FILE.
+ */
+
+/*
+ * Measured time of a collective
+ */
+typedef struct nccl_ofi_tuner_sample {
+	ncclFunc_t func;
+	int algo;
+	int proto;
+	int num_ranks;
+	int num_nodes;
+	int channels;
+	size_t size;
+	/* Measured time in µsecs */
+	double time;
+} nccl_ofi_tuner_sample_t;
+
+/*
+ * Fitted parameters. Parameters that the samples do not determine, e.g.,
+ * the network latency if all samples have the same node count, keep
+ * their initial value.
+ */
+enum nccl_ofi_tuner_fit_param {
+	NCCL_OFI_TUNER_FIT_NET_LATENCY,
+	NCCL_OFI_TUNER_FIT_NET_COMP_OVERHEAD,
+	NCCL_OFI_TUNER_FIT_INTERNODE_BW,
+	NCCL_OFI_TUNER_FIT_CHANNEL_OVERHEAD,
+	NCCL_OFI_TUNER_FIT_BASE_LATENCY,
+	NCCL_OFI_TUNER_FIT_MAX = NCCL_OFI_TUNER_FIT_BASE_LATENCY
+				 + NCCL_NUM_ALGORITHMS * NCCL_NUM_PROTOCOLS,
+};
+
+typedef struct nccl_ofi_tuner_fit_result {
+	/* Fitted parameters, initial values for parameters not fitted */
+	struct nccl_ofi_tuner_model_params params;
+	/* Parameters determined by the samples */
+	bool fitted[NCCL_OFI_TUNER_FIT_MAX];
+	/* Number of samples with a model */
+	size_t num_samples;
+	/* Root mean square of residuals in µsecs */
+	double rms_residual;
+	/* Largest residual relative to the measured time */
+	double max_rel_residual;
+} nccl_ofi_tuner_fit_result_t;
+
+/*
+ * @brief	Read samples from CSV stream
+ *
+ * The first line that is not a comment (starting with `#`) names the
+ * columns. Columns `collective`, `algorithm`, `protocol`, `ranks`,
+ * `nodes`, `channels`, `size` (bytes) and `time` (µsecs) are required,
+ * in any order, and other columns are ignored. Names of collectives,
+ * algorithms and protocols are matched ignoring case and underscores.
+ * Samples are appended to the array, which is reallocated as needed.
+ *
+ * @return	0, on success
+ *		negative errno, on error
+ */
+int nccl_ofi_tuner_fit_read_csv(FILE *stream, const char *name,
+				nccl_ofi_tuner_sample_t **samples, size_t *num_samples);
+
+/*
+ * @brief	Fit model parameters to samples by least squares
+ *
+ * Fits the network latency, completion overhead and bandwidth, the
+ * channel overhead and the base latency of each algorithm and protocol
+ * to minimize the squared residuals of the Hockney model relative to the
+ * measured times. Other parameters, e.g., the rail count and intranode
+ * bandwidth, are inputs.
+ *
+ * @param	initial
+ *		Initial parameters
+ * @return	0, on success
+ *		-EINVAL, if no sample has a model
+ */
+int nccl_ofi_tuner_fit(const nccl_ofi_tuner_sample_t *samples, size_t num_samples,
+		       const struct nccl_ofi_tuner_model_params *initial,
+		       nccl_ofi_tuner_fit_result_t *result);
+
+/*
+ * @brief	Write fitted parameters as parameter file
+ *
+ * Only fitted parameters are written, so that the tuner keeps its
+ * defaults for others.
+ */
+int nccl_ofi_tuner_fit_write(FILE *stream, const nccl_ofi_tuner_fit_result_t *result);
+
+#ifdef _cplusplus
+} // End extern "C"
+#endif
+
+#endif // End NCCL_OFI_TUNER_FIT_H_
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#ifndef NCCL_OFI_TUNER_HINTS_H_
+#define NCCL_OFI_TUNER_HINTS_H_
+
+#ifdef _cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/*
+ * Tuner hints
+ *
+ * Model inputs that the network plugin learns during its
+ * initialization, published for the tuner. NCCL loads the network
+ * plugin and the tuner as separate libraries with local symbol scope,
+ * so that the tuner looks nccl_ofi_tuner_hints_get() up by name among
+ * the loaded objects, and reads the hints each time it initializes the
+ * context of a communicator. Hints never override environment
+ * variables of the tuner.
+ */
+
+/* Name of nccl_ofi_tuner_hints_get() in the network plugin */
+#define NCCL_OFI_TUNER_HINTS_GET_SYMBOL	"nccl_ofi_tuner_hints_get"
+
+typedef struct nccl_ofi_tuner_hints {
+	/* Mean calibrated bandwidth of the rails in bytes per µsec, 0 if
+	 * the rails were not calibrated */
+	double calibrated_bw;
+	/* Mean calibrated one-way latency of a minimal message on the
+	 * rails in µsec, 0 if the rails were not calibrated */
+	double calibrated_latency;
+	/* Number of rails of each GPU, 0 if unknown */
+	int num_rails;
+	/* Link speed of the slowest rail in bytes per µsec, 0 if unknown */
+	double link_bw;
+	/* Intranode bandwidth per channel in bytes per µsec of the
+	 * platform, 0 if unknown */
+	double intranode_bw;
+	/* Intranode latency of a ring hop in nsecs of the platform, 0 if
+	 * unknown */
+	double intranode_latency_ns;
+	/* Mean calibrated gap between back-to-back small messages on the
+	 * rails in µsec, 0 if the rails were not calibrated */
+	double calibrated_overhead;
+} nccl_ofi_tuner_hints_t;
+
+typedef int (*nccl_ofi_tuner_hints_get_fn_t)(nccl_ofi_tuner_hints_t *hints, size_t size);
+
+/*
+ * @brief	Publish calibration results of the rails of a device
+ *
+ * @param	bandwidth
+ *		Mean bandwidth in bytes per µsec
+ * @param	latency
+ *		Mean one-way latency of a minimal message in µsec
+ * @param	overhead
+ *		Mean gap between back-to-back small messages in µsec
+ */
+void nccl_ofi_tuner_hints_set_calibration(double bandwidth, double latency, double overhead);
+
+/*
+ * @brief	Publish rail count and link speed of the rails of a device
+ *
+ * @param	link_bw
+ *		Link speed of the slowest rail in bytes per µsec, 0 if
+ *		unknown
+ */
+void nccl_ofi_tuner_hints_set_link(int num_rails, double link_bw);
+
+/*
+ * @brief	Publish intranode characteristics of the platform
+ *
+ * @param	bandwidth
+ *		Bandwidth per channel in bytes per µsec, 0 if unknown
+ * @param	latency_ns
+ *		Latency of a ring hop in nsecs, 0 if unknown
+ */
+void nccl_ofi_tuner_hints_set_intranode(double bandwidth, double latency_ns);
+
+/*
+ * @brief	Copy published hints
+ *
+ * @param	hints
+ *		Hints, unknown values are 0
+ * @param	size
+ *		Size of `hints` in the caller's build; fields beyond it are
+ *		not copied
+ * @return	0, on success
+ */
+int nccl_ofi_tuner_hints_get(nccl_ofi_tuner_hints_t *hints, size_t size);
+
+#ifdef _cplusplus
+} // End extern "C"
+#endif
+
+#endif // End NCCL_OFI_TUNER_HINTS_H_
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#ifndef NCCL_OFI_USDT_H_
+#define NCCL_OFI_USDT_H_
+
+/*
+ * USDT probes
+ *
+ * With --enable-usdt, the tracepoints of tracepoint.h are emitted as
+ * SystemTap/USDT probes of provider nccl_ofi, which bpftrace, perf and
+ * SystemTap attach to at runtime, e.g.,
+ *
+ *   bpftrace -e 'usdt:/path/to/libnccl-net.so:nccl_ofi:send { ... }'
+ *
+ * A probe that no tool is attached to is a single nop instruction, and
+ * the build does not depend on any library. The arguments of each probe
+ * are listed next to it, and tools/bpftrace contains sample scripts.
+ */
+
+#if ENABLE_USDT
+
+#include <stdint.h>
+#include <sys/sdt.h>
+
+/* dev, size, comm, msg_seq_num, request, nccl_req */
+#define NCCL_OFI_USDT_TRACE_SEND(dev, size, comm, msg_seq_num, request, nccl_req) \
+	DTRACE_PROBE6(nccl_ofi, send, (int)(dev), (int)(size), (uintptr_t)(comm), \
+		      (uint16_t)(msg_seq_num), (uintptr_t)(request), (uintptr_t)(nccl_req))
+
+/* dev, rail_id, comm, msg_seq_num */
+#define NCCL_OFI_USDT_TRACE_SEND_CTRL_RECV(dev, rail_id, comm, msg_seq_num) \
+	DTRACE_PROBE4(nccl_ofi, send_ctrl_recv, (int)(dev), (int)(rail_id), \
+		      (uintptr_t)(comm), (uint16_t)(msg_seq_num))
+
+/* dev, rail_id, size, comm, msg_seq_num, request */
+#define NCCL_OFI_USDT_TRACE_SEND_WRITE_SEG_START(dev, rail_id, size, comm, msg_seq_num, request) \
+	DTRACE_PROBE6(nccl_ofi, send_write_seg_start, (int)(dev), (int)(rail_id), \
+		      (uint64_t)(size), (uintptr_t)(comm), (uint16_t)(msg_seq_num), \
+		      (uintptr_t)(request))
+
+/* dev, rail_id, comm, msg_seq_num, request */
+#define NCCL_OFI_USDT_TRACE_SEND_WRITE_SEG_COMPLETE(dev, rail_id, comm, msg_seq_num, request) \
+	DTRACE_PROBE5(nccl_ofi, send_write_seg_complete, (int)(dev), (int)(rail_id), \
+		      (uintptr_t)(comm), (uint16_t)(msg_seq_num), (uintptr_t)(request))
+
+/* dev, comm_id, comm, size, request, nccl_req */
+#define NCCL_OFI_USDT_TRACE_RECV(dev, comm_id, comm, size, request, nccl_req) \
+	DTRACE_PROBE6(nccl_ofi, recv, (int)(dev), (int)(comm_id), (uintptr_t)(comm), \
+		      (int)(size), (uintptr_t)(request), (uintptr_t)(nccl_req))
+
+/* request */
+#define NCCL_OFI_USDT_TRACE_RECV_CTRL_SEND_COMPLETE(request) \
+	DTRACE_PROBE1(nccl_ofi, recv_ctrl_send_complete, (uintptr_t)(request))
+
+/* dev, rail_id, size, request */
+#define NCCL_OFI_USDT_TRACE_RECV_SEGMENT_COMPLETE(dev, rail_id, size, request) \
+	DTRACE_PROBE4(nccl_ofi, recv_segment_complete, (int)(dev), (int)(rail_id), \
+		      (uint64_t)(size), (uintptr_t)(request))
+
+/* dev, rail_id, comm, msg_seq_num */
+#define NCCL_OFI_USDT_TRACE_EAGER_RECV(dev, rail_id, comm, msg_seq_num) \
+	DTRACE_PROBE4(nccl_ofi, eager_recv, (int)(dev), (int)(rail_id), \
+		      (uintptr_t)(comm), (uint16_t)(msg_seq_num))
+
+/* request, ctx */
+#define NCCL_OFI_USDT_TRACE_COMPLETIONS(request, ctx) \
+	DTRACE_PROBE2(nccl_ofi, completion, (uintptr_t)(request), (uintptr_t)(ctx))
+
+/* dev, comm, request, nccl_req */
+#define NCCL_OFI_USDT_TRACE_FLUSH(dev, comm, request, nccl_req) \
+	DTRACE_PROBE4(nccl_ofi, flush, (int)(dev), (uintptr_t)(comm), \
+		      (uintptr_t)(request), (uintptr_t)(nccl_req))
+
+/* request */
+#define NCCL_OFI_USDT_TRACE_PENDING_INSERT(request) \
+	DTRACE_PROBE1(nccl_ofi, pending_insert, (uintptr_t)(request))
+
+/* request */
+#define NCCL_OFI_USDT_TRACE_PENDING_REMOVE(request) \
+	DTRACE_PROBE1(nccl_ofi, pending_remove, (uintptr_t)(request))
+
+/* rail_id, request, size, rc: rc is 0 or the negative error of fi_recv() */
+#define NCCL_OFI_USDT_TRACE_BOUNCE_POST(rail_id, request, size, rc) \
+	DTRACE_PROBE4(nccl_ofi, bounce_post, (int)(rail_id), (uintptr_t)(request), \
+		      (uint64_t)(size), (int)(rc))
+
+/* rail_id, request, msg_type, size */
+#define NCCL_OFI_USDT_TRACE_BOUNCE_RECV(rail_id, request, msg_type, size) \
+	DTRACE_PROBE4(nccl_ofi, bounce_recv, (int)(rail_id), (uintptr_t)(request), \
+		      (int)(msg_type), (uint64_t)(size))
+
+/* rail_id, num_entries: number of entries of one fi_cq_read() */
+#define NCCL_OFI_USDT_TRACE_CQ_READ(rail_id, num_entries) \
+	DTRACE_PROBE2(nccl_ofi, cq_read, (int)(rail_id), (int)(num_entries))
+
+/* rail_id, request, err, prov_errno */
+#define NCCL_OFI_USDT_TRACE_CQ_ERROR(rail_id, request, err, prov_errno) \
+	DTRACE_PROBE4(nccl_ofi, cq_error, (int)(rail_id), (uintptr_t)(request), \
+		      (int)(err), (int)(prov_errno))
+
+#else
+
+#define NCCL_OFI_USDT_TRACE_SEND(...)
+#define NCCL_OFI_USDT_TRACE_SEND_CTRL_RECV(...)
+#define NCCL_OFI_USDT_TRACE_SEND_WRITE_SEG_START(...)
+#define NCCL_OFI_USDT_TRACE_SEND_WRITE_SEG_COMPLETE(...)
+#define NCCL_OFI_USDT_TRACE_RECV(...)
+#define NCCL_OFI_USDT_TRACE_RECV_CTRL_SEND_COMPLETE(...)
+#define NCCL_OFI_USDT_TRACE_RECV_SEGMENT_COMPLETE(...)
+#define NCCL_OFI_USDT_TRACE_EAGER_RECV(...)
+#define NCCL_OFI_USDT_TRACE_COMPLETIONS(...)
+#define NCCL_OFI_USDT_TRACE_FLUSH(...)
+#define NCCL_OFI_USDT_TRACE_PENDING_INSERT(...)
+#define NCCL_OFI_USDT_TRACE_PENDING_REMOVE(...)
+#define NCCL_OFI_USDT_TRACE_BOUNCE_POST(...)
+#define NCCL_OFI_USDT_TRACE_BOUNCE_RECV(...)
+#define NCCL_OFI_USDT_TRACE_CQ_READ(...)
+#define NCCL_OFI_USDT_TRACE_CQ_ERROR(...)
+
+#endif // ENABLE_USDT
+
+#endif // End NCCL_OFI_USDT_H_
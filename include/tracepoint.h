@@ -64,7 +64,7 @@ LTTNG_UST_TRACEPOINT_EVENT(
             lttng_ust_field_integer_hex(uint64_t, nccl_req, (uint64_t)nccl_req)
     )
 )
-#define NCCL_OFI_TRACE_SEND(dev, size, comm, msg_seq_num, request, nccl_req) \
+#define NCCL_OFI_LTTNG_TRACE_SEND(dev, size, comm, msg_seq_num, request, nccl_req) \
 	lttng_ust_tracepoint(nccl_ofi_plugin, Send, dev, size, comm, msg_seq_num, request, nccl_req)
 
 LTTNG_UST_TRACEPOINT_EVENT(
@@ -83,7 +83,7 @@ LTTNG_UST_TRACEPOINT_EVENT(
             lttng_ust_field_integer(uint16_t, msg_seq_num, msg_seq_num)
     )
 )
-#define NCCL_OFI_TRACE_SEND_CTRL_RECV(dev, rail_id, comm, msg_seq_num) \
+#define NCCL_OFI_LTTNG_TRACE_SEND_CTRL_RECV(dev, rail_id, comm, msg_seq_num) \
 	lttng_ust_tracepoint(nccl_ofi_plugin, Send_ctrl_recv, dev, rail_id, comm, msg_seq_num)
 
 LTTNG_UST_TRACEPOINT_EVENT(
@@ -106,7 +106,7 @@ LTTNG_UST_TRACEPOINT_EVENT(
             lttng_ust_field_integer_hex(uint64_t, request, (uint64_t)request)
     )
 )
-#define NCCL_OFI_TRACE_SEND_WRITE_SEG_START(dev, rail_id, size, comm, msg_seq_num, request) \
+#define NCCL_OFI_LTTNG_TRACE_SEND_WRITE_SEG_START(dev, rail_id, size, comm, msg_seq_num, request) \
 	lttng_ust_tracepoint(nccl_ofi_plugin, Send_write_segment_start, dev, rail_id, size, comm, msg_seq_num, request)
 
 LTTNG_UST_TRACEPOINT_EVENT(
@@ -127,7 +127,7 @@ LTTNG_UST_TRACEPOINT_EVENT(
             lttng_ust_field_integer_hex(uint64_t, request, (uint64_t)request)
     )
 )
-#define NCCL_OFI_TRACE_SEND_WRITE_SEG_COMPLETE(dev, rail_id, comm, msg_seq_num, request) \
+#define NCCL_OFI_LTTNG_TRACE_SEND_WRITE_SEG_COMPLETE(dev, rail_id, comm, msg_seq_num, request) \
 	lttng_ust_tracepoint(nccl_ofi_plugin, Send_write_segment_complete, dev, rail_id, comm, msg_seq_num, request)
 
 LTTNG_UST_TRACEPOINT_EVENT(
@@ -148,7 +148,7 @@ LTTNG_UST_TRACEPOINT_EVENT(
             lttng_ust_field_integer_hex(uint64_t, nccl_req, (uint64_t)nccl_req)
     )
 )
-#define NCCL_OFI_TRACE_RECV(dev, comm_id, size, request, nccl_req) \
+#define NCCL_OFI_LTTNG_TRACE_RECV(dev, comm_id, size, request, nccl_req) \
 	lttng_ust_tracepoint(nccl_ofi_plugin, Recv, dev, comm_id, size, request, nccl_req)
 
 LTTNG_UST_TRACEPOINT_EVENT(
@@ -161,7 +161,7 @@ LTTNG_UST_TRACEPOINT_EVENT(
             lttng_ust_field_integer_hex(uint64_t, request, (uint64_t)request)
     )
 )
-#define NCCL_OFI_TRACE_RECV_CTRL_SEND_COMPLETE(request) \
+#define NCCL_OFI_LTTNG_TRACE_RECV_CTRL_SEND_COMPLETE(request) \
 	lttng_ust_tracepoint(nccl_ofi_plugin, Recv_ctrl_send_complete, request)
 
 LTTNG_UST_TRACEPOINT_EVENT(
@@ -180,7 +180,7 @@ LTTNG_UST_TRACEPOINT_EVENT(
             lttng_ust_field_integer_hex(uint64_t, request, (uint64_t)request)
     )
 )
-#define NCCL_OFI_TRACE_RECV_SEGMENT_COMPLETE(dev, rail_id, size, request) \
+#define NCCL_OFI_LTTNG_TRACE_RECV_SEGMENT_COMPLETE(dev, rail_id, size, request) \
 	lttng_ust_tracepoint(nccl_ofi_plugin, Recv_segment_complete, dev, rail_id, size, request)
 
 LTTNG_UST_TRACEPOINT_EVENT(
@@ -199,7 +199,7 @@ LTTNG_UST_TRACEPOINT_EVENT(
             lttng_ust_field_integer(uint16_t, msg_seq_num, msg_seq_num)
     )
 )
-#define NCCL_OFI_TRACE_EAGER_RECV(dev, rail_id, comm, msg_seq_num) \
+#define NCCL_OFI_LTTNG_TRACE_EAGER_RECV(dev, rail_id, comm, msg_seq_num) \
 	lttng_ust_tracepoint(nccl_ofi_plugin, Eager_recv, dev, rail_id, comm, msg_seq_num)
 
 LTTNG_UST_TRACEPOINT_EVENT(
@@ -214,7 +214,7 @@ LTTNG_UST_TRACEPOINT_EVENT(
             lttng_ust_field_integer(uint64_t, ctx, (uint64_t)ctx)
     )
 )
-#define NCCL_OFI_TRACE_COMPLETIONS(request,ctx) \
+#define NCCL_OFI_LTTNG_TRACE_COMPLETIONS(request,ctx) \
 	lttng_ust_tracepoint(nccl_ofi_plugin, ProcessCompletions, request,ctx)
 
 LTTNG_UST_TRACEPOINT_EVENT(
@@ -229,7 +229,7 @@ LTTNG_UST_TRACEPOINT_EVENT(
             lttng_ust_field_integer_hex(uint64_t, nccl_req, (uint64_t)nccl_req)
     )
 )
-#define NCCL_OFI_TRACE_FLUSH(request, nccl_req) \
+#define NCCL_OFI_LTTNG_TRACE_FLUSH(request, nccl_req) \
 	lttng_ust_tracepoint(nccl_ofi_plugin, Flush, request, nccl_req)
 
 LTTNG_UST_TRACEPOINT_EVENT(
@@ -242,7 +242,7 @@ LTTNG_UST_TRACEPOINT_EVENT(
             lttng_ust_field_integer_hex(uint64_t, request, (uint64_t)request)
     )
 )
-#define NCCL_OFI_TRACE_PENDING_INSERT(request) \
+#define NCCL_OFI_LTTNG_TRACE_PENDING_INSERT(request) \
 	lttng_ust_tracepoint(nccl_ofi_plugin, Pending_queue_insert, request)
 
 LTTNG_UST_TRACEPOINT_EVENT(
@@ -255,7 +255,7 @@ LTTNG_UST_TRACEPOINT_EVENT(
             lttng_ust_field_integer_hex(uint64_t, request, (uint64_t)request)
     )
 )
-#define NCCL_OFI_TRACE_PENDING_REMOVE(request) \
+#define NCCL_OFI_LTTNG_TRACE_PENDING_REMOVE(request) \
 	lttng_ust_tracepoint(nccl_ofi_plugin, Pending_queue_remove, request)
 
 #endif /* NCCL_OFI_TRACEPOINT_H */
@@ -264,17 +264,110 @@ LTTNG_UST_TRACEPOINT_EVENT(
 
 #else
 
-#define NCCL_OFI_TRACE_SEND(...)
-#define NCCL_OFI_TRACE_SEND_CTRL_RECV(...)
-#define NCCL_OFI_TRACE_SEND_WRITE_SEG_START(...)
-#define NCCL_OFI_TRACE_SEND_WRITE_SEG_COMPLETE(...)
-#define NCCL_OFI_TRACE_RECV(...)
-#define NCCL_OFI_TRACE_RECV_CTRL_SEND_COMPLETE(...)
-#define NCCL_OFI_TRACE_RECV_SEGMENT_COMPLETE(...)
-#define NCCL_OFI_TRACE_EAGER_RECV(...)
-#define NCCL_OFI_TRACE_FLUSH(...)
-#define NCCL_OFI_TRACE_PENDING_INSERT(...)
-#define NCCL_OFI_TRACE_PENDING_REMOVE(...)
-#define NCCL_OFI_TRACE_COMPLETIONS(...)
+#define NCCL_OFI_LTTNG_TRACE_SEND(...)
+#define NCCL_OFI_LTTNG_TRACE_SEND_CTRL_RECV(...)
+#define NCCL_OFI_LTTNG_TRACE_SEND_WRITE_SEG_START(...)
+#define NCCL_OFI_LTTNG_TRACE_SEND_WRITE_SEG_COMPLETE(...)
+#define NCCL_OFI_LTTNG_TRACE_RECV(...)
+#define NCCL_OFI_LTTNG_TRACE_RECV_CTRL_SEND_COMPLETE(...)
+#define NCCL_OFI_LTTNG_TRACE_RECV_SEGMENT_COMPLETE(...)
+#define NCCL_OFI_LTTNG_TRACE_EAGER_RECV(...)
+#define NCCL_OFI_LTTNG_TRACE_FLUSH(...)
+#define NCCL_OFI_LTTNG_TRACE_PENDING_INSERT(...)
+#define NCCL_OFI_LTTNG_TRACE_PENDING_REMOVE(...)
+#define NCCL_OFI_LTTNG_TRACE_COMPLETIONS(...)
 
 #endif // HAVE_LIBLTTNG_UST
+
+/*
+ * Each tracepoint is reported to the tracing backend selected at
+ * configure time, LTTng or the USDT probes of nccl_ofi_usdt.h, and to the
+ * built-in tracer of nccl_ofi_tracer.h when OFI_NCCL_TRACE_FILE is set.
+ * The bounce buffer and CQ tracepoints are only USDT probes.
+ */
+#ifndef NCCL_OFI_TRACEPOINT_DISPATCH_H
+#define NCCL_OFI_TRACEPOINT_DISPATCH_H
+
+#include "nccl_ofi_tracer.h"
+#include "nccl_ofi_usdt.h"
+
+#define NCCL_OFI_TRACE_SEND(dev, size, comm, msg_seq_num, request, nccl_req) do { \
+	NCCL_OFI_LTTNG_TRACE_SEND(dev, size, comm, msg_seq_num, request, nccl_req); \
+	NCCL_OFI_USDT_TRACE_SEND(dev, size, comm, msg_seq_num, request, nccl_req); \
+	NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_SEND, dev, -1, comm, msg_seq_num, request, size); \
+} while (0)
+
+#define NCCL_OFI_TRACE_SEND_CTRL_RECV(dev, rail_id, comm, msg_seq_num) do { \
+	NCCL_OFI_LTTNG_TRACE_SEND_CTRL_RECV(dev, rail_id, comm, msg_seq_num); \
+	NCCL_OFI_USDT_TRACE_SEND_CTRL_RECV(dev, rail_id, comm, msg_seq_num); \
+	NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_SEND_CTRL_RECV, dev, rail_id, comm, msg_seq_num, NULL, 0); \
+} while (0)
+
+#define NCCL_OFI_TRACE_SEND_WRITE_SEG_START(dev, rail_id, size, comm, msg_seq_num, request) do { \
+	NCCL_OFI_LTTNG_TRACE_SEND_WRITE_SEG_START(dev, rail_id, size, comm, msg_seq_num, request); \
+	NCCL_OFI_USDT_TRACE_SEND_WRITE_SEG_START(dev, rail_id, size, comm, msg_seq_num, request); \
+	NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_SEND_WRITE_SEG_START, dev, rail_id, comm, msg_seq_num, request, size); \
+} while (0)
+
+#define NCCL_OFI_TRACE_SEND_WRITE_SEG_COMPLETE(dev, rail_id, comm, msg_seq_num, request) do { \
+	NCCL_OFI_LTTNG_TRACE_SEND_WRITE_SEG_COMPLETE(dev, rail_id, comm, msg_seq_num, request); \
+	NCCL_OFI_USDT_TRACE_SEND_WRITE_SEG_COMPLETE(dev, rail_id, comm, msg_seq_num, request); \
+	NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_SEND_WRITE_SEG_COMPLETE, dev, rail_id, comm, msg_seq_num, request, 0); \
+} while (0)
+
+#define NCCL_OFI_TRACE_RECV(dev, comm_id, comm, size, request, nccl_req) do { \
+	NCCL_OFI_LTTNG_TRACE_RECV(dev, comm_id, size, request, nccl_req); \
+	NCCL_OFI_USDT_TRACE_RECV(dev, comm_id, comm, size, request, nccl_req); \
+	NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_RECV, dev, -1, comm, comm_id, request, size); \
+} while (0)
+
+#define NCCL_OFI_TRACE_RECV_CTRL_SEND_COMPLETE(request) do { \
+	NCCL_OFI_LTTNG_TRACE_RECV_CTRL_SEND_COMPLETE(request); \
+	NCCL_OFI_USDT_TRACE_RECV_CTRL_SEND_COMPLETE(request); \
+	NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_RECV_CTRL_SEND_COMPLETE, -1, -1, NULL, 0, request, 0); \
+} while (0)
+
+#define NCCL_OFI_TRACE_RECV_SEGMENT_COMPLETE(dev, rail_id, size, request) do { \
+	NCCL_OFI_LTTNG_TRACE_RECV_SEGMENT_COMPLETE(dev, rail_id, size, request); \
+	NCCL_OFI_USDT_TRACE_RECV_SEGMENT_COMPLETE(dev, rail_id, size, request); \
+	NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_RECV_SEGMENT_COMPLETE, dev, rail_id, NULL, 0, request, size); \
+} while (0)
+
+#define NCCL_OFI_TRACE_EAGER_RECV(dev, rail_id, comm, msg_seq_num) do { \
+	NCCL_OFI_LTTNG_TRACE_EAGER_RECV(dev, rail_id, comm, msg_seq_num); \
+	NCCL_OFI_USDT_TRACE_EAGER_RECV(dev, rail_id, comm, msg_seq_num); \
+	NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_EAGER_RECV, dev, rail_id, comm, msg_seq_num, NULL, 0); \
+} while (0)
+
+#define NCCL_OFI_TRACE_COMPLETIONS(request, ctx) do { \
+	NCCL_OFI_LTTNG_TRACE_COMPLETIONS(request, ctx); \
+	NCCL_OFI_USDT_TRACE_COMPLETIONS(request, ctx); \
+	NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_COMPLETE, -1, -1, NULL, 0, request, 0); \
+} while (0)
+
+#define NCCL_OFI_TRACE_FLUSH(dev, comm, request, nccl_req) do { \
+	NCCL_OFI_LTTNG_TRACE_FLUSH(request, nccl_req); \
+	NCCL_OFI_USDT_TRACE_FLUSH(dev, comm, request, nccl_req); \
+	NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_FLUSH, dev, -1, comm, 0, request, 0); \
+} while (0)
+
+#define NCCL_OFI_TRACE_PENDING_INSERT(request) do { \
+	NCCL_OFI_LTTNG_TRACE_PENDING_INSERT(request); \
+	NCCL_OFI_USDT_TRACE_PENDING_INSERT(request); \
+} while (0)
+
+#define NCCL_OFI_TRACE_PENDING_REMOVE(request) do { \
+	NCCL_OFI_LTTNG_TRACE_PENDING_REMOVE(request); \
+	NCCL_OFI_USDT_TRACE_PENDING_REMOVE(request); \
+} while (0)
+
+#define NCCL_OFI_TRACE_BOUNCE_POST(rail_id, request, size, rc) \
+	NCCL_OFI_USDT_TRACE_BOUNCE_POST(rail_id, request, size, rc)
+#define NCCL_OFI_TRACE_BOUNCE_RECV(rail_id, request, msg_type, size) \
+	NCCL_OFI_USDT_TRACE_BOUNCE_RECV(rail_id, request, msg_type, size)
+#define NCCL_OFI_TRACE_CQ_READ(rail_id, num_entries) \
+	NCCL_OFI_USDT_TRACE_CQ_READ(rail_id, num_entries)
+#define NCCL_OFI_TRACE_CQ_ERROR(rail_id, request, err, prov_errno) \
+	NCCL_OFI_USDT_TRACE_CQ_ERROR(rail_id, request, err, prov_errno)
+
+#endif // NCCL_OFI_TRACEPOINT_DISPATCH_H
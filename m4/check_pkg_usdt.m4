@@ -0,0 +1,26 @@
+# -*- autoconf -*-
+#
+# Copyright (c) 2024      Amazon.com, Inc. or its affiliates. All rights reserved.
+#
+# See LICENSE.txt for license information
+#
+
+AC_DEFUN([CHECK_PKG_USDT], [
+  usdt_enabled=0
+
+  AC_ARG_ENABLE([usdt],
+                [AS_HELP_STRING([--enable-usdt], [Enable tracing with SystemTap/USDT probes of sys/sdt.h instead of LTTNG @<:@default=no@:>@])],
+                [AS_IF([test "${enable_usdt}" != "no"], [usdt_enabled=1])])
+
+  AC_MSG_CHECKING([whether to enable USDT probes])
+  AS_IF([test "${usdt_enabled}" = "1"],
+        [AC_MSG_RESULT([yes])],
+        [AC_MSG_RESULT([no])])
+
+  AS_IF([test "${usdt_enabled}" = "1"],
+        [AC_CHECK_HEADERS([sys/sdt.h],
+                          [],
+                          [AC_MSG_ERROR([sys/sdt.h not found. Install the SystemTap SDT headers (systemtap-sdt-devel or systemtap-sdt-dev).])])])
+
+  AC_DEFINE_UNQUOTED([ENABLE_USDT], [${usdt_enabled}], [Defined to 1 if USDT probes are enabled])
+])
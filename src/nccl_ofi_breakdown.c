@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "nccl_ofi_breakdown.h"
+
+static const char *phase_names[NCCL_OFI_NUM_PHASES] = {
+	[NCCL_OFI_PHASE_CTRL] = "ctrl",
+	[NCCL_OFI_PHASE_PENDING] = "pending",
+	[NCCL_OFI_PHASE_WIRE] = "wire",
+	[NCCL_OFI_PHASE_LAST_RAIL] = "last_rail",
+};
+
+const char *nccl_ofi_breakdown_phase_name(nccl_ofi_phase_t phase)
+{
+	if ((unsigned int)phase >= NCCL_OFI_NUM_PHASES) {
+		return "unknown";
+	}
+	return phase_names[phase];
+}
+
+size_t nccl_ofi_breakdown_size_class_max(int size_class)
+{
+	if (size_class >= NCCL_OFI_BREAKDOWN_SIZES - 1) {
+		return SIZE_MAX;
+	}
+	return (size_t)1 << (NCCL_OFI_BREAKDOWN_MIN_SIZE_LOG2 + 2 * size_class);
+}
+
+void nccl_ofi_breakdown_snapshot(const nccl_ofi_breakdown_size_t *size_class,
+				 nccl_ofi_breakdown_size_t *snapshot)
+{
+	snapshot->count = __atomic_load_n(&size_class->count, __ATOMIC_RELAXED);
+	for (int phase = 0; phase < NCCL_OFI_NUM_PHASES; phase++) {
+		snapshot->phase_ns[phase] = __atomic_load_n(&size_class->phase_ns[phase],
+							    __ATOMIC_RELAXED);
+	}
+}
+
+nccl_ofi_phase_t nccl_ofi_breakdown_dominant(const nccl_ofi_breakdown_size_t *size_class)
+{
+	nccl_ofi_phase_t dominant = NCCL_OFI_PHASE_CTRL;
+
+	for (int phase = 1; phase < NCCL_OFI_NUM_PHASES; phase++) {
+		if (size_class->phase_ns[phase] > size_class->phase_ns[dominant]) {
+			dominant = phase;
+		}
+	}
+
+	return dominant;
+}
+
+int nccl_ofi_breakdown_format(const nccl_ofi_breakdown_size_t *size_class, char *buf, size_t len)
+{
+	nccl_ofi_breakdown_size_t snapshot;
+	nccl_ofi_phase_t dominant;
+	uint64_t total = 0;
+
+	nccl_ofi_breakdown_snapshot(size_class, &snapshot);
+	if (snapshot.count == 0) {
+		return snprintf(buf, len, "n=0");
+	}
+
+	for (int phase = 0; phase < NCCL_OFI_NUM_PHASES; phase++) {
+		total += snapshot.phase_ns[phase];
+	}
+	dominant = nccl_ofi_breakdown_dominant(&snapshot);
+
+	return snprintf(buf, len, "n=%lu %s=%.1f %s=%.1f %s=%.1f %s=%.1f dominant=%s(%.0f%%)",
+			snapshot.count,
+			phase_names[NCCL_OFI_PHASE_CTRL],
+			snapshot.phase_ns[NCCL_OFI_PHASE_CTRL] * 1e-3 / snapshot.count,
+			phase_names[NCCL_OFI_PHASE_PENDING],
+			snapshot.phase_ns[NCCL_OFI_PHASE_PENDING] * 1e-3 / snapshot.count,
+			phase_names[NCCL_OFI_PHASE_WIRE],
+			snapshot.phase_ns[NCCL_OFI_PHASE_WIRE] * 1e-3 / snapshot.count,
+			phase_names[NCCL_OFI_PHASE_LAST_RAIL],
+			snapshot.phase_ns[NCCL_OFI_PHASE_LAST_RAIL] * 1e-3 / snapshot.count,
+			phase_names[dominant],
+			total ? 100.0 * snapshot.phase_ns[dominant] / total : 0.0);
+}
@@ -0,0 +1,683 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "nccl_ofi.h"
+#include "nccl_ofi_calibrate.h"
+#include "nccl_ofi_ini.h"
+#include "nccl_ofi_log.h"
+#include "nccl_ofi_math.h"
+#include "nccl_ofi_ofiutils.h"
+#include "nccl_ofi_param.h"
+#include "nccl_ofi_tuner_hints.h"
+
+/* Size of messages used to measure latency and overhead */
+#define CALIBRATION_SMALL_SIZE		(8)
+/* Upper bound of size of messages used to measure bandwidth */
+#define CALIBRATION_LARGE_SIZE		(1 << 20)
+/* Number of ping-pong round trips used to measure latency */
+#define CALIBRATION_PINGPONG_ITERS	(1000)
+/* Number of messages in flight while streaming */
+#define CALIBRATION_WINDOW		(16)
+/* Number of windows of small messages used to measure overhead */
+#define CALIBRATION_SMALL_ROUNDS	(64)
+/* Number of windows of large messages used to measure bandwidth */
+#define CALIBRATION_LARGE_ROUNDS	(8)
+/* Number of untimed iterations preceding each measurement */
+#define CALIBRATION_WARMUP_ITERS	(16)
+
+/*
+ * Pair of endpoints on the same domain. Endpoint 0 sends from the
+ * first half of the buffer, endpoint 1 receives into the second half
+ * and vice versa.
+ */
+struct probe {
+	struct fid_ep *ep[2];
+	struct fid_av *av[2];
+	struct fid_cq *cq[2];
+	/* Address of the other endpoint in each endpoint's AV */
+	fi_addr_t peer[2];
+	/* Number of outstanding operations per endpoint */
+	int pending[2];
+	char *buf;
+	size_t buf_size;
+	struct fid_mr *mr;
+	void *desc;
+};
+
+static inline double now_us(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+}
+
+/*
+ * @brief	Read completions of both endpoints once
+ *
+ * @return	0, on success
+ *		-EIO, on completion error
+ *		negative errno, on other error
+ */
+static int probe_progress(struct probe *probe)
+{
+	struct fi_cq_data_entry entries[CALIBRATION_WINDOW];
+
+	for (int i = 0; i < 2; ++i) {
+		ssize_t rc = fi_cq_read(probe->cq[i], entries, CALIBRATION_WINDOW);
+		if (rc > 0) {
+			probe->pending[i] -= rc;
+		} else if (rc == -FI_EAVAIL) {
+			struct fi_cq_err_entry err_entry = { 0 };
+			rc = fi_cq_readerr(probe->cq[i], &err_entry, 0);
+			if (rc == -FI_EAGAIN) {
+				continue;
+			}
+			NCCL_OFI_WARN("Calibration operation completed with error. RC: %d. Error: %s",
+				      err_entry.err,
+				      fi_cq_strerror(probe->cq[i], err_entry.prov_errno,
+						     err_entry.err_data, NULL, 0));
+			return -EIO;
+		} else if (rc != -FI_EAGAIN) {
+			NCCL_OFI_WARN("Unable to read from CQ. RC: %zd. Error: %s",
+				      rc, fi_strerror((int)-rc));
+			return (int)rc;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * @brief	Wait until all operations of endpoint `idx` completed
+ */
+static int probe_wait(struct probe *probe, int idx)
+{
+	int ret = 0;
+
+	while (ret == 0 && probe->pending[idx] > 0) {
+		ret = probe_progress(probe);
+	}
+
+	return ret;
+}
+
+static int probe_wait_all(struct probe *probe)
+{
+	int ret = probe_wait(probe, 0);
+	if (ret == 0) {
+		ret = probe_wait(probe, 1);
+	}
+	return ret;
+}
+
+static int probe_post_send(struct probe *probe, int idx, size_t size)
+{
+	ssize_t rc;
+	char *buf = probe->buf + idx * (probe->buf_size / 2);
+
+	while ((rc = fi_send(probe->ep[idx], buf, size, probe->desc,
+			     probe->peer[idx], NULL)) == -FI_EAGAIN) {
+		int ret = probe_progress(probe);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+	if (rc != 0) {
+		NCCL_OFI_WARN("Unable to post calibration send. RC: %zd. Error: %s",
+			      rc, fi_strerror((int)-rc));
+		return (int)rc;
+	}
+
+	probe->pending[idx]++;
+	return 0;
+}
+
+static int probe_post_recv(struct probe *probe, int idx, size_t size)
+{
+	ssize_t rc;
+	char *buf = probe->buf + (1 - idx) * (probe->buf_size / 2);
+
+	while ((rc = fi_recv(probe->ep[idx], buf, size, probe->desc,
+			     FI_ADDR_UNSPEC, NULL)) == -FI_EAGAIN) {
+		int ret = probe_progress(probe);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+	if (rc != 0) {
+		NCCL_OFI_WARN("Unable to post calibration receive. RC: %zd. Error: %s",
+			      rc, fi_strerror((int)-rc));
+		return (int)rc;
+	}
+
+	probe->pending[idx]++;
+	return 0;
+}
+
+static void probe_release(struct probe *probe)
+{
+	for (int i = 0; i < 2; ++i) {
+		nccl_ofi_ofiutils_ep_release(probe->ep[i], probe->av[i], probe->cq[i], -1);
+	}
+	if (probe->mr) {
+		fi_close(&probe->mr->fid);
+	}
+	free(probe->buf);
+}
+
+static int probe_init(struct probe *probe, struct fi_info *info, struct fid_domain *domain)
+{
+	int ret = 0;
+	char names[2][MAX_EP_ADDR];
+
+	probe->buf_size = 2 * NCCL_OFI_MIN(CALIBRATION_LARGE_SIZE, info->ep_attr->max_msg_size);
+	probe->buf = calloc(1, probe->buf_size);
+	if (!probe->buf) {
+		NCCL_OFI_WARN("Unable to allocate calibration buffer");
+		return -ENOMEM;
+	}
+
+	if (info->domain_attr->mr_mode & FI_MR_LOCAL) {
+		ret = fi_mr_reg(domain, probe->buf, probe->buf_size, FI_SEND | FI_RECV,
+				0, 0, 0, &probe->mr, NULL);
+		if (ret != 0) {
+			NCCL_OFI_WARN("Unable to register calibration buffer. RC: %d, Error: %s",
+				      ret, fi_strerror(-ret));
+			goto error;
+		}
+		probe->desc = fi_mr_desc(probe->mr);
+	}
+
+	for (int i = 0; i < 2; ++i) {
+		size_t namelen = MAX_EP_ADDR;
+
+		ret = nccl_ofi_ofiutils_init_connection(FI_VERSION(1, 18), info, domain,
+							&probe->ep[i], &probe->av[i],
+							&probe->cq[i]);
+		if (ret != 0) {
+			goto error;
+		}
+
+		ret = fi_getname(&probe->ep[i]->fid, names[i], &namelen);
+		if (ret != 0) {
+			NCCL_OFI_WARN("Call to fi_getname() failed with RC: %d, ERROR: %s",
+				      ret, fi_strerror(-ret));
+			goto error;
+		}
+	}
+
+	for (int i = 0; i < 2; ++i) {
+		ret = fi_av_insert(probe->av[i], names[1 - i], 1, &probe->peer[i], 0, NULL);
+		if (ret != 1) {
+			NCCL_OFI_WARN("Unable to insert calibration peer address. RC: %d", ret);
+			ret = -EINVAL;
+			goto error;
+		}
+	}
+
+	return 0;
+
+ error:
+	probe_release(probe);
+	return ret;
+}
+
+/*
+ * @brief	Measure one-way latency with ping-pong between both endpoints
+ */
+static int probe_latency(struct probe *probe, size_t size, int iters, double *latency)
+{
+	int ret = 0;
+	double start = 0.0;
+
+	for (int i = 0; i < iters + CALIBRATION_WARMUP_ITERS; ++i) {
+		if (i == CALIBRATION_WARMUP_ITERS) {
+			start = now_us();
+		}
+
+		if ((ret = probe_post_recv(probe, 1, size)) ||
+		    (ret = probe_post_recv(probe, 0, size)) ||
+		    (ret = probe_post_send(probe, 0, size)) ||
+		    (ret = probe_wait(probe, 1)) ||
+		    (ret = probe_post_send(probe, 1, size)) ||
+		    (ret = probe_wait_all(probe))) {
+			return ret;
+		}
+	}
+
+	*latency = (now_us() - start) / (2.0 * iters);
+	return 0;
+}
+
+/*
+ * @brief	Measure time per message while streaming windows of
+ *		messages from endpoint 0 to endpoint 1
+ */
+static int probe_stream(struct probe *probe, size_t size, int rounds, double *time_per_msg)
+{
+	int ret = 0;
+	double start = 0.0;
+
+	for (int r = 0; r < rounds + 1; ++r) {
+		/* First round warms up */
+		if (r == 1) {
+			start = now_us();
+		}
+
+		for (int i = 0; i < CALIBRATION_WINDOW; ++i) {
+			ret = probe_post_recv(probe, 1, size);
+			if (ret != 0) {
+				return ret;
+			}
+		}
+		for (int i = 0; i < CALIBRATION_WINDOW; ++i) {
+			ret = probe_post_send(probe, 0, size);
+			if (ret != 0) {
+				return ret;
+			}
+		}
+		ret = probe_wait_all(probe);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+
+	*time_per_msg = (now_us() - start) / ((double)rounds * CALIBRATION_WINDOW);
+	return 0;
+}
+
+/*
+ * @brief	Measure a single rail
+ */
+static int calibrate_rail(struct fi_info *info, struct fid_domain *domain,
+			  nccl_ofi_calibration_t *result)
+{
+	int ret;
+	struct probe probe = { 0 };
+	size_t large_size;
+	double time_per_msg;
+
+	ret = probe_init(&probe, info, domain);
+	if (ret != 0) {
+		return ret;
+	}
+	large_size = probe.buf_size / 2;
+
+	ret = probe_latency(&probe, CALIBRATION_SMALL_SIZE, CALIBRATION_PINGPONG_ITERS,
+			    &result->latency);
+	if (ret != 0) {
+		goto exit;
+	}
+
+	ret = probe_stream(&probe, CALIBRATION_SMALL_SIZE, CALIBRATION_SMALL_ROUNDS,
+			   &result->overhead);
+	if (ret != 0) {
+		goto exit;
+	}
+
+	ret = probe_stream(&probe, large_size, CALIBRATION_LARGE_ROUNDS, &time_per_msg);
+	if (ret != 0) {
+		goto exit;
+	}
+	result->bandwidth = large_size / time_per_msg;
+
+ exit:
+	probe_release(&probe);
+	return ret;
+}
+
+/*
+ * @brief	Name of rail in calibration cache
+ */
+static void rail_key(struct fi_info *info, char *key, size_t len)
+{
+	snprintf(key, len, "%s:%s", info->fabric_attr->prov_name, info->domain_attr->name);
+}
+
+struct cache_ctx {
+	struct fi_info **infos;
+	int num_rails;
+	nccl_ofi_calibration_t *results;
+	/* Bitmask of keys found for each rail */
+	unsigned int *found;
+};
+
+#define CACHE_KEY_LATENCY	(1 << 0)
+#define CACHE_KEY_BANDWIDTH	(1 << 1)
+#define CACHE_KEY_OVERHEAD	(1 << 2)
+#define CACHE_KEY_ALL		(CACHE_KEY_LATENCY | CACHE_KEY_BANDWIDTH | CACHE_KEY_OVERHEAD)
+
+static int cache_handler(void *ctx_, const char *section, const char *key,
+			 const char *value, int lineno)
+{
+	struct cache_ctx *ctx = ctx_;
+	char name[256];
+	double v;
+
+	for (int i = 0; i < ctx->num_rails; ++i) {
+		rail_key(ctx->infos[i], name, sizeof(name));
+		if (strcmp(section, name) != 0) {
+			continue;
+		}
+
+		/* Ignore invalid entries; the rail is measured again */
+		if (nccl_ofi_ini_parse_double(value, &v) != 0 || !(v > 0.0)) {
+			return 0;
+		}
+
+		if (strcmp(key, "latency") == 0) {
+			ctx->results[i].latency = v;
+			ctx->found[i] |= CACHE_KEY_LATENCY;
+		} else if (strcmp(key, "bandwidth") == 0) {
+			ctx->results[i].bandwidth = v;
+			ctx->found[i] |= CACHE_KEY_BANDWIDTH;
+		} else if (strcmp(key, "overhead") == 0) {
+			ctx->results[i].overhead = v;
+			ctx->found[i] |= CACHE_KEY_OVERHEAD;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * @brief	Directory of the calibration cache file
+ *
+ * OFI_NCCL_CALIBRATION_DIR if set, otherwise the per-user directory
+ * `$XDG_CACHE_HOME/aws-ofi-nccl` or `$HOME/.cache/aws-ofi-nccl`, which is
+ * created if missing.
+ *
+ * @return	0, on success
+ *		negative errno, on error
+ */
+static int cache_dir(char *dir, size_t len)
+{
+	const char *base = getenv("XDG_CACHE_HOME");
+	size_t base_len;
+	int ret;
+
+	if (ofi_nccl_calibration_dir() != NULL) {
+		ret = snprintf(dir, len, "%s", ofi_nccl_calibration_dir());
+		return (ret < 0 || ret >= len) ? -ENAMETOOLONG : 0;
+	}
+
+	if (base != NULL && base[0] == '/') {
+		ret = snprintf(dir, len, "%s", base);
+	} else if ((base = getenv("HOME")) != NULL && base[0] == '/') {
+		ret = snprintf(dir, len, "%s/.cache", base);
+	} else {
+		return -ENOENT;
+	}
+	if (ret < 0 || ret >= len) {
+		return -ENAMETOOLONG;
+	}
+	if (mkdir(dir, 0700) != 0 && errno != EEXIST) {
+		return -errno;
+	}
+
+	base_len = ret;
+	ret = snprintf(dir + base_len, len - base_len, "/aws-ofi-nccl");
+	if (ret < 0 || ret >= len - base_len) {
+		return -ENAMETOOLONG;
+	}
+	if (mkdir(dir, 0700) != 0 && errno != EEXIST) {
+		return -errno;
+	}
+
+	return 0;
+}
+
+/*
+ * @brief	Open and lock calibration cache file of this host
+ *
+ * The results of the file tune the scheduler and the tuner, so that
+ * only a regular file that is owned by the user and not writable by
+ * others is used.
+ *
+ * @return	file descriptor, on success
+ *		negative errno, on error
+ */
+static int cache_open(char *path, size_t len)
+{
+	char hostname[HOST_NAME_MAX + 1] = "";
+	char dir[PATH_MAX];
+	struct stat st;
+	int fd;
+	int ret;
+
+	if (gethostname(hostname, sizeof(hostname)) != 0) {
+		ret = -errno;
+		NCCL_OFI_WARN("Unable to get hostname: %s", strerror(errno));
+		return ret;
+	}
+	hostname[HOST_NAME_MAX] = '\0';
+
+	ret = cache_dir(dir, sizeof(dir));
+	if (ret != 0) {
+		NCCL_OFI_INFO(NCCL_INIT | NCCL_NET,
+			      "No calibration cache directory (%s), calibration results are not cached",
+			      strerror(-ret));
+		return ret;
+	}
+
+	ret = snprintf(path, len, "%s/aws-ofi-nccl-calibration-%s.ini", dir, hostname);
+	if (ret < 0 || ret >= len) {
+		NCCL_OFI_WARN("Calibration cache file path is too long");
+		return -ENAMETOOLONG;
+	}
+
+	fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC | O_NOFOLLOW, 0600);
+	if (fd < 0) {
+		ret = -errno;
+		NCCL_OFI_WARN("Unable to open calibration cache file %s: %s",
+			      path, strerror(errno));
+		return ret;
+	}
+
+	if (fstat(fd, &st) != 0) {
+		ret = -errno;
+		NCCL_OFI_WARN("Unable to stat calibration cache file %s: %s",
+			      path, strerror(errno));
+		close(fd);
+		return ret;
+	}
+	if (!S_ISREG(st.st_mode) || st.st_uid != geteuid() ||
+	    (st.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+		NCCL_OFI_WARN("Ignoring calibration cache file %s, which is not a regular file owned and only writable by the user",
+			      path);
+		close(fd);
+		return -EPERM;
+	}
+
+	if (flock(fd, LOCK_EX) != 0) {
+		ret = -errno;
+		NCCL_OFI_WARN("Unable to lock calibration cache file %s: %s",
+			      path, strerror(errno));
+		close(fd);
+		return ret;
+	}
+
+	return fd;
+}
+
+static void cache_load(int fd, const char *path, struct cache_ctx *ctx)
+{
+	FILE *file;
+	int dup_fd = dup(fd);
+
+	if (dup_fd < 0 || !(file = fdopen(dup_fd, "r"))) {
+		NCCL_OFI_WARN("Unable to read calibration cache file %s", path);
+		if (dup_fd >= 0) {
+			close(dup_fd);
+		}
+		return;
+	}
+
+	if (nccl_ofi_ini_parse_stream(file, path, cache_handler, ctx) != 0) {
+		NCCL_OFI_WARN("Ignoring malformed calibration cache file %s", path);
+		memset(ctx->found, 0, ctx->num_rails * sizeof(*ctx->found));
+	}
+
+	fclose(file);
+}
+
+/*
+ * @brief	Append results of rail to calibration cache file
+ *
+ * Later entries of a rail override earlier ones on load.
+ */
+static int cache_append(int fd, struct fi_info *info, const nccl_ofi_calibration_t *result)
+{
+	char name[256];
+	char entry[512];
+	int len;
+
+	rail_key(info, name, sizeof(name));
+	len = snprintf(entry, sizeof(entry),
+		       "[%s]\nlatency = %.6g\nbandwidth = %.6g\noverhead = %.6g\n",
+		       name, result->latency, result->bandwidth, result->overhead);
+	if (len < 0 || len >= sizeof(entry)) {
+		return -ENAMETOOLONG;
+	}
+
+	if (lseek(fd, 0, SEEK_END) < 0 || write(fd, entry, len) != len) {
+		return -errno;
+	}
+
+	return 0;
+}
+
+int nccl_ofi_calibrate(struct fi_info **infos, struct fid_domain **domains,
+		       int num_rails, nccl_ofi_calibration_t *results)
+{
+	int ret = 0;
+	int fd;
+	char path[PATH_MAX];
+	unsigned int found[num_rails];
+	struct cache_ctx ctx = {
+		.infos = infos,
+		.num_rails = num_rails,
+		.results = results,
+		.found = found,
+	};
+
+	memset(found, 0, sizeof(found));
+
+	fd = cache_open(path, sizeof(path));
+	if (fd >= 0) {
+		cache_load(fd, path, &ctx);
+	}
+
+	for (int i = 0; i < num_rails; ++i) {
+		char name[256];
+		bool cached = (found[i] == CACHE_KEY_ALL);
+
+		rail_key(infos[i], name, sizeof(name));
+
+		if (!cached) {
+			NCCL_OFI_TRACE(NCCL_INIT | NCCL_NET, "Calibrating rail %s", name);
+
+			ret = calibrate_rail(infos[i], domains[i], &results[i]);
+			if (ret != 0) {
+				NCCL_OFI_WARN("Calibration of rail %s failed", name);
+				goto exit;
+			}
+
+			if (fd >= 0 && cache_append(fd, infos[i], &results[i]) != 0) {
+				NCCL_OFI_WARN("Unable to write calibration cache file %s", path);
+			}
+		}
+
+		NCCL_OFI_INFO(NCCL_INIT | NCCL_NET,
+			      "Rail %s: latency %.2f us, bandwidth %.2f GB/s, overhead %.2f us (%s)",
+			      name, results[i].latency, results[i].bandwidth * 1e-3,
+			      results[i].overhead, cached ? "cached" : "measured");
+	}
+
+ exit:
+	if (fd >= 0) {
+		flock(fd, LOCK_UN);
+		close(fd);
+	}
+	return ret;
+}
+
+size_t nccl_ofi_calibration_rr_threshold(const nccl_ofi_calibration_t *results,
+					 int num_rails, size_t min_threshold)
+{
+	double overhead = 0.0;
+	double bandwidth = 0.0;
+	double threshold;
+
+	for (int i = 0; i < num_rails; ++i) {
+		overhead += results[i].overhead / num_rails;
+		bandwidth += results[i].bandwidth / num_rails;
+	}
+
+	threshold = num_rails * overhead * bandwidth;
+	if (threshold < min_threshold) {
+		return min_threshold;
+	}
+	if (threshold > (double)SIZE_MAX / 2) {
+		return SIZE_MAX / 2;
+	}
+
+	return (size_t)threshold;
+}
+
+void nccl_ofi_calibration_export(const nccl_ofi_calibration_t *results, int num_rails)
+{
+	double latency = 0.0;
+	double bandwidth = 0.0;
+	double overhead = 0.0;
+
+	for (int i = 0; i < num_rails; ++i) {
+		latency += results[i].latency / num_rails;
+		bandwidth += results[i].bandwidth / num_rails;
+		overhead += results[i].overhead / num_rails;
+	}
+
+	NCCL_OFI_INFO(NCCL_INIT | NCCL_NET,
+		      "Providing calibrated bandwidth %.0f B/us, latency %.2f us and overhead %.2f us to the tuner",
+		      bandwidth, latency, overhead);
+	nccl_ofi_tuner_hints_set_calibration(bandwidth, latency, overhead);
+}
+
+void nccl_ofi_calibration_export_link(struct fi_info **infos, int num_rails)
+{
+	uint64_t speed = 0;
+
+	/* Slowest link of the rails, in bits per second */
+	for (int i = 0; i < num_rails; ++i) {
+		if (!infos[i]->nic || !infos[i]->nic->link_attr ||
+		    infos[i]->nic->link_attr->speed == 0) {
+			NCCL_OFI_TRACE(NCCL_INIT | NCCL_NET, "Link speed of rail %d unknown", i);
+			speed = 0;
+			break;
+		}
+		if (speed == 0 || infos[i]->nic->link_attr->speed < speed) {
+			speed = infos[i]->nic->link_attr->speed;
+		}
+	}
+
+	NCCL_OFI_INFO(NCCL_INIT | NCCL_NET,
+		      "Providing %d rails with link speed %" PRIu64 " B/us to the tuner",
+		      num_rails, speed / 8 / 1000000);
+	/* Bits per second to bytes per µsec */
+	nccl_ofi_tuner_hints_set_link(num_rails, (double)(speed / 8 / 1000000));
+}
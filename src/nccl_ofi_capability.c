@@ -0,0 +1,414 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <rdma/fabric.h>
+#include <rdma/fi_domain.h>
+#include <rdma/fi_endpoint.h>
+#ifdef HAVE_RDMA_FI_EXT_H
+#include <rdma/fi_ext.h>
+#endif
+
+#include "nccl_ofi.h"
+#include "nccl_ofi_capability.h"
+#include "nccl_ofi_log.h"
+#include "nccl_ofi_ofiutils.h"
+#include "nccl_ofi_param.h"
+
+/* Libfabric API version used by the protocols */
+#define CAPABILITY_API_VERSION		FI_VERSION(1, 18)
+/* Immediate data width required by the RDMA protocol in bytes */
+#define CAPABILITY_RDMA_CQ_DATA_SIZE	(4)
+/* Default of OFI_NCCL_EAGER_MAX_SIZE */
+#define CAPABILITY_EAGER_MAX_SIZE	(8192)
+
+/*
+ * Capabilities that are probed individually, since providers do not
+ * necessarily report secondary capabilities that were not requested.
+ */
+static const struct {
+	uint64_t cap;
+	const char *name;
+} probed_caps[] = {
+	{ FI_MSG, "FI_MSG" },
+	{ FI_TAGGED, "FI_TAGGED" },
+	{ FI_RMA, "FI_RMA" },
+	{ FI_READ, "FI_READ" },
+	{ FI_WRITE, "FI_WRITE" },
+	{ FI_HMEM, "FI_HMEM" },
+	{ FI_MULTI_RECV, "FI_MULTI_RECV" },
+};
+
+/*
+ * Protocol rule table. Protocols are listed in order of preference; the
+ * first protocol whose requirements are met by the provider is
+ * selected.
+ */
+static const struct protocol_rule {
+	const char *protocol;
+	/* Required capability bits */
+	uint64_t caps;
+	/* Modes that the protocol does not support */
+	uint64_t unsupported_mode;
+	/* Memory registration modes that the protocol does not support */
+	int unsupported_mr_mode;
+	/* Minimum immediate data width in bytes */
+	size_t min_cq_data_size;
+	/* Protocol requires RMA writes that are not emulated */
+	bool native_write;
+} protocol_rules[] = {
+	{
+		.protocol = "RDMA",
+		.caps = FI_MSG | FI_RMA | FI_HMEM,
+		.unsupported_mode = FI_CONTEXT | FI_CONTEXT2,
+		.unsupported_mr_mode = FI_MR_ENDPOINT,
+		.min_cq_data_size = CAPABILITY_RDMA_CQ_DATA_SIZE,
+		.native_write = true,
+	},
+	{
+		.protocol = "SENDRECV",
+		.caps = FI_MSG | FI_TAGGED,
+	},
+};
+
+/*
+ * Feature rules. Each rule returns true and sets `value` if it applies
+ * to the provider and protocol.
+ */
+#if HAVE_CUDA
+static bool rule_cuda_flush(const nccl_ofi_capability_t *caps, const char *protocol,
+			    long long *value)
+{
+	/* Without RMA reads, GPUDirect RDMA writes must be flushed
+	 * through CUDA instead of a read from the GPU buffer. */
+	*value = 1;
+	return (caps->caps & FI_HMEM) && !(caps->caps & FI_READ);
+}
+#endif
+
+static bool rule_eager_max_size(const nccl_ofi_capability_t *caps, const char *protocol,
+				long long *value)
+{
+	/* Eager messages must fit a single message */
+	*value = (long long)caps->max_msg_size;
+	return strcasecmp(protocol, "RDMA") == 0 &&
+		caps->max_msg_size < CAPABILITY_EAGER_MAX_SIZE;
+}
+
+static const struct feature_rule {
+	const char *name;
+	const char *env;
+	bool (*applies)(const nccl_ofi_capability_t *caps, const char *protocol,
+			long long *value);
+} feature_rules[] = {
+#if HAVE_CUDA
+	{ "CUDA flush", "OFI_NCCL_CUDA_FLUSH_ENABLE", rule_cuda_flush },
+#endif
+	{ "eager message size", "OFI_NCCL_EAGER_MAX_SIZE", rule_eager_max_size },
+};
+
+
+static void get_hints(struct fi_info *hints)
+{
+	/* Request as little as possible so that the reported
+	 * attributes are the limits of the provider */
+	hints->mode = FI_CONTEXT | FI_CONTEXT2;
+	hints->ep_attr->type = FI_EP_RDM;
+	hints->domain_attr->mr_mode = FI_MR_LOCAL | FI_MR_HMEM | FI_MR_VIRT_ADDR |
+		FI_MR_ALLOCATED | FI_MR_PROV_KEY | FI_MR_ENDPOINT;
+	hints->domain_attr->threading = FI_THREAD_SAFE;
+	hints->domain_attr->control_progress = FI_PROGRESS_UNSPEC;
+	hints->domain_attr->data_progress = FI_PROGRESS_UNSPEC;
+}
+
+
+/*
+ * @brief	Check whether provider supports capability
+ *
+ * @return	true, if fi_getinfo() returns any NIC of the provider
+ *		for the capability
+ */
+static bool probe_cap(const char *prov_name, uint64_t cap)
+{
+	struct fi_info *hints = NULL, *info = NULL;
+	bool supported = false;
+
+	hints = fi_allocinfo();
+	if (hints == NULL) {
+		return false;
+	}
+	get_hints(hints);
+	hints->caps = cap;
+	hints->fabric_attr->prov_name = strdup(prov_name);
+	if (hints->fabric_attr->prov_name == NULL) {
+		goto exit;
+	}
+
+	if (fi_getinfo(CAPABILITY_API_VERSION, NULL, NULL, 0ULL, hints, &info) == 0 &&
+	    info != NULL) {
+		supported = true;
+	}
+
+ exit:
+	if (info) {
+		fi_freeinfo(info);
+	}
+	fi_freeinfo(hints);
+	return supported;
+}
+
+
+#if HAVE_DECL_FI_OPT_EFA_SENDRECV_IN_ORDER_ALIGNED_128_BYTES || HAVE_DECL_FI_OPT_EFA_WRITE_IN_ORDER_ALIGNED_128_BYTES
+static bool probe_ep_inorder(struct fid_ep *ep, int optname)
+{
+	bool optval = true;
+
+	return fi_setopt(&ep->fid, FI_OPT_ENDPOINT, optname, &optval, sizeof(optval)) == 0;
+}
+#endif
+
+
+/*
+ * @brief	Query endpoint options of NIC
+ *
+ * Endpoint options are queried on an endpoint that is never enabled,
+ * so no address vector or completion queue is needed.
+ */
+static int probe_ep(struct fi_info *info, nccl_ofi_capability_t *caps)
+{
+	int ret = 0;
+	struct fid_fabric *fabric = NULL;
+	struct fid_domain *domain = NULL;
+	struct fid_ep *ep = NULL;
+
+	ret = fi_fabric(info->fabric_attr, &fabric, NULL);
+	if (ret != 0) {
+		NCCL_OFI_INFO(NCCL_INIT | NCCL_NET, "Couldn't open fabric for capability probe. RC: %d, ERROR: %s",
+			      ret, fi_strerror(-ret));
+		goto exit;
+	}
+
+	ret = fi_domain(fabric, info, &domain, NULL);
+	if (ret != 0) {
+		NCCL_OFI_INFO(NCCL_INIT | NCCL_NET, "Couldn't open domain for capability probe. RC: %d, ERROR: %s",
+			      ret, fi_strerror(-ret));
+		goto exit;
+	}
+
+	ret = fi_endpoint(domain, info, &ep, NULL);
+	if (ret != 0) {
+		NCCL_OFI_INFO(NCCL_INIT | NCCL_NET, "Couldn't open endpoint for capability probe. RC: %d, ERROR: %s",
+			      ret, fi_strerror(-ret));
+		goto exit;
+	}
+
+#if HAVE_DECL_FI_OPT_EFA_EMULATED_WRITE
+	bool optval = false;
+	size_t optlen = sizeof(optval);
+	if (fi_getopt(&ep->fid, FI_OPT_ENDPOINT, FI_OPT_EFA_EMULATED_WRITE,
+		      &optval, &optlen) == 0 && optlen == sizeof(optval)) {
+		caps->emulated_write = optval;
+	}
+#endif
+#if HAVE_DECL_FI_OPT_EFA_SENDRECV_IN_ORDER_ALIGNED_128_BYTES
+	caps->sendrecv_inorder_128 =
+		probe_ep_inorder(ep, FI_OPT_EFA_SENDRECV_IN_ORDER_ALIGNED_128_BYTES);
+#endif
+#if HAVE_DECL_FI_OPT_EFA_WRITE_IN_ORDER_ALIGNED_128_BYTES
+	caps->write_inorder_128 =
+		probe_ep_inorder(ep, FI_OPT_EFA_WRITE_IN_ORDER_ALIGNED_128_BYTES);
+#endif
+	caps->ep_probed = true;
+
+ exit:
+	if (ep) {
+		fi_close(&ep->fid);
+	}
+	if (domain) {
+		fi_close(&domain->fid);
+	}
+	if (fabric) {
+		fi_close(&fabric->fid);
+	}
+	return ret;
+}
+
+
+int nccl_ofi_capability_probe(const char *provider_filter, nccl_ofi_capability_t *caps)
+{
+	int ret = 0;
+	struct fi_info *hints = NULL;
+	struct fi_info *provider_list = NULL;
+	unsigned int num_providers = 0;
+	struct fi_info *info;
+
+	memset(caps, 0, sizeof(*caps));
+
+	hints = fi_allocinfo();
+	if (hints == NULL) {
+		NCCL_OFI_WARN("Unable to allocate hints");
+		return -FI_ENOMEM;
+	}
+	get_hints(hints);
+
+	ret = nccl_ofi_ofiutils_get_providers(provider_filter, CAPABILITY_API_VERSION,
+					      hints, &provider_list, &num_providers);
+	if (ret != 0) {
+		NCCL_OFI_INFO(NCCL_INIT | NCCL_NET, "No provider found for capability probe. RC: %d",
+			      ret);
+		goto exit;
+	}
+
+	info = provider_list;
+	snprintf(caps->prov_name, sizeof(caps->prov_name), "%s",
+		 info->fabric_attr->prov_name);
+	caps->num_nics = num_providers;
+	caps->mode = info->mode;
+	caps->mr_mode = info->domain_attr->mr_mode;
+	caps->inject_size = info->tx_attr->inject_size;
+	caps->max_msg_size = info->ep_attr->max_msg_size;
+	caps->cq_data_size = info->domain_attr->cq_data_size;
+	caps->mr_key_size = info->domain_attr->mr_key_size;
+	caps->msg_order = info->tx_attr->msg_order;
+
+	for (size_t i = 0; i < sizeof(probed_caps) / sizeof(probed_caps[0]); i++) {
+		if (probe_cap(caps->prov_name, probed_caps[i].cap)) {
+			caps->caps |= probed_caps[i].cap;
+		}
+	}
+
+#ifdef FI_MR_DMABUF
+	caps->dmabuf = (caps->caps & FI_HMEM) != 0;
+#endif
+
+	/* Failure to open an endpoint leaves the endpoint options
+	 * unknown, but the capabilities are still valid */
+	(void)probe_ep(info, caps);
+	ret = 0;
+
+ exit:
+	if (provider_list) {
+		fi_freeinfo(provider_list);
+	}
+	fi_freeinfo(hints);
+	return ret;
+}
+
+
+void nccl_ofi_capability_log(const nccl_ofi_capability_t *caps)
+{
+	char cap_names[256] = "";
+	size_t len = 0;
+
+	for (size_t i = 0; i < sizeof(probed_caps) / sizeof(probed_caps[0]); i++) {
+		if ((caps->caps & probed_caps[i].cap) && len < sizeof(cap_names)) {
+			len += snprintf(cap_names + len, sizeof(cap_names) - len, "%s%s",
+					len ? "|" : "", probed_caps[i].name);
+		}
+	}
+
+	NCCL_OFI_INFO(NCCL_INIT | NCCL_NET, "Capabilities of provider %s (%d NICs): caps %s",
+		      caps->prov_name, caps->num_nics, cap_names);
+	NCCL_OFI_INFO(NCCL_INIT | NCCL_NET,
+		      "Capabilities of provider %s: mode 0x%" PRIx64 ", mr_mode 0x%x, mr_key_size %zu, dmabuf %d",
+		      caps->prov_name, caps->mode, caps->mr_mode, caps->mr_key_size, caps->dmabuf);
+	NCCL_OFI_INFO(NCCL_INIT | NCCL_NET,
+		      "Capabilities of provider %s: inject_size %zu, max_msg_size %zu, cq_data_size %zu, msg_order 0x%" PRIx64,
+		      caps->prov_name, caps->inject_size, caps->max_msg_size,
+		      caps->cq_data_size, caps->msg_order);
+	if (caps->ep_probed) {
+		NCCL_OFI_INFO(NCCL_INIT | NCCL_NET,
+			      "Capabilities of provider %s: emulated_write %d, sendrecv_inorder_128 %d, write_inorder_128 %d",
+			      caps->prov_name, caps->emulated_write,
+			      caps->sendrecv_inorder_128, caps->write_inorder_128);
+	} else {
+		NCCL_OFI_INFO(NCCL_INIT | NCCL_NET,
+			      "Capabilities of provider %s: endpoint options unknown",
+			      caps->prov_name);
+	}
+}
+
+
+/*
+ * @brief	Check requirements of protocol rule
+ *
+ * @return	NULL, if requirements are met
+ *		description of first unmet requirement, otherwise
+ */
+static const char *check_protocol_rule(const struct protocol_rule *rule,
+				       const nccl_ofi_capability_t *caps)
+{
+	if ((caps->caps & rule->caps) != rule->caps) {
+		return "missing capabilities";
+	}
+	if (caps->mode & rule->unsupported_mode) {
+		return "unsupported mode";
+	}
+	if (caps->mr_mode & rule->unsupported_mr_mode) {
+		return "unsupported memory registration mode";
+	}
+	if (caps->cq_data_size < rule->min_cq_data_size) {
+		return "immediate data too small";
+	}
+	if (rule->native_write && caps->emulated_write &&
+	    ofi_nccl_disable_native_rdma_check() == 0) {
+		return "RMA writes are emulated";
+	}
+	return NULL;
+}
+
+
+const char *nccl_ofi_capability_select_protocol(const nccl_ofi_capability_t *caps)
+{
+	for (size_t i = 0; i < sizeof(protocol_rules) / sizeof(protocol_rules[0]); i++) {
+		const char *reason = check_protocol_rule(&protocol_rules[i], caps);
+		if (reason == NULL) {
+			return protocol_rules[i].protocol;
+		}
+		NCCL_OFI_INFO(NCCL_INIT | NCCL_NET, "Provider %s does not support protocol %s: %s",
+			      caps->prov_name, protocol_rules[i].protocol, reason);
+	}
+
+	return NULL;
+}
+
+
+int nccl_ofi_capability_apply_features(const nccl_ofi_capability_t *caps,
+				       const char *protocol)
+{
+	char str[32];
+	long long value;
+
+	for (size_t i = 0; i < sizeof(feature_rules) / sizeof(feature_rules[0]); i++) {
+		const struct feature_rule *rule = &feature_rules[i];
+
+		if (!rule->applies(caps, protocol, &value)) {
+			continue;
+		}
+		if (getenv(rule->env)) {
+			NCCL_OFI_INFO(NCCL_INIT | NCCL_NET,
+				      "Not adjusting %s for provider %s; %s is set",
+				      rule->name, caps->prov_name, rule->env);
+			continue;
+		}
+
+		snprintf(str, sizeof(str), "%lld", value);
+		NCCL_OFI_INFO(NCCL_INIT | NCCL_NET,
+			      "Setting %s environment variable to %s for %s of provider %s",
+			      rule->env, str, rule->name, caps->prov_name);
+		if (setenv(rule->env, str, 0) != 0) {
+			NCCL_OFI_WARN("Unable to set %s", rule->env);
+			return -errno;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "nccl_ofi_flight_recorder.h"
+#include "nccl_ofi_log.h"
+#include "nccl_ofi_param.h"
+#include "nccl_ofi_signal.h"
+
+/* Rings of the process. A ring is allocated when its slot is first
+ * used and never freed. */
+static nccl_ofi_flight_recorder_t *rings[NCCL_OFI_FLIGHT_RECORDER_MAX_RINGS];
+
+/* Number of entries of each ring, zero if the recorder is disabled */
+static uint32_t ring_events = 0;
+
+/* Path of the dump file */
+static char dump_path[PATH_MAX];
+
+/* Path of the dump file while it is written */
+static char tmp_path[PATH_MAX];
+
+/* Non-zero while a dump is written */
+static int dumping = 0;
+
+nccl_ofi_flight_recorder_t *nccl_ofi_flight_recorder_alloc(int dev_id)
+{
+	nccl_ofi_flight_recorder_t *recorder;
+	size_t size;
+
+	if (ring_events == 0) {
+		return NULL;
+	}
+
+	/* Reuse a released ring */
+	for (int i = 0; i < NCCL_OFI_FLIGHT_RECORDER_MAX_RINGS; i++) {
+		uint32_t expected = 0;
+
+		recorder = __atomic_load_n(&rings[i], __ATOMIC_ACQUIRE);
+		if (recorder == NULL) {
+			break;
+		}
+		if (__atomic_load_n(&recorder->in_use, __ATOMIC_RELAXED) == 0 &&
+		    __atomic_compare_exchange_n(&recorder->in_use, &expected, 1, false,
+						__ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+			recorder->dev_id = dev_id;
+			return recorder;
+		}
+	}
+
+	size = sizeof(nccl_ofi_flight_recorder_t) + ring_events * sizeof(nccl_ofi_flight_event_t);
+	recorder = calloc(1, size);
+	if (!recorder) {
+		NCCL_OFI_WARN("Unable to allocate flight recorder of %u events", ring_events);
+		return NULL;
+	}
+	recorder->num_events = ring_events;
+	recorder->in_use = 1;
+	recorder->dev_id = dev_id;
+
+	for (int i = 0; i < NCCL_OFI_FLIGHT_RECORDER_MAX_RINGS; i++) {
+		nccl_ofi_flight_recorder_t *expected = NULL;
+
+		recorder->id = i;
+		if (__atomic_compare_exchange_n(&rings[i], &expected, recorder, false,
+						__ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+			return recorder;
+		}
+	}
+
+	NCCL_OFI_INFO(NCCL_NET, "All %d flight recorder rings are in use",
+		      NCCL_OFI_FLIGHT_RECORDER_MAX_RINGS);
+	free(recorder);
+	return NULL;
+}
+
+void nccl_ofi_flight_recorder_release(nccl_ofi_flight_recorder_t *recorder)
+{
+	/* Events of the released ring stay visible to dumps until the
+	 * ring is reused */
+	__atomic_store_n(&recorder->in_use, 0, __ATOMIC_RELEASE);
+}
+
+/*
+ * @brief	Write buffer to file descriptor. Async-signal-safe.
+ */
+static int write_all(int fd, const void *buf, size_t len)
+{
+	const char *pos = buf;
+
+	while (len > 0) {
+		ssize_t written = write(fd, pos, len);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -errno;
+		}
+		pos += written;
+		len -= written;
+	}
+
+	return 0;
+}
+
+int nccl_ofi_flight_recorder_dump(int reason)
+{
+	nccl_ofi_flight_dump_header_t header;
+	struct timespec ts;
+	int saved_errno = errno;
+	int ret = 0;
+	int fd;
+
+	if (ring_events == 0) {
+		return 0;
+	}
+	if (__atomic_exchange_n(&dumping, 1, __ATOMIC_ACQUIRE)) {
+		return -EBUSY;
+	}
+
+	/* Remove the file of an interrupted dump */
+	unlink(tmp_path);
+	fd = open(tmp_path, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW, 0600);
+	if (fd < 0) {
+		ret = -errno;
+		goto exit;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	memset(&header, 0, sizeof(header));
+	header.magic = NCCL_OFI_FLIGHT_RECORDER_MAGIC;
+	header.version = NCCL_OFI_FLIGHT_RECORDER_VERSION;
+	header.event_size = sizeof(nccl_ofi_flight_event_t);
+	header.pid = (int32_t)getpid();
+	header.reason = reason;
+	header.ts = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+
+	/* The number of rings is known once they are written */
+	ret = write_all(fd, &header, sizeof(header));
+	if (ret != 0) {
+		goto close;
+	}
+
+	for (int i = 0; i < NCCL_OFI_FLIGHT_RECORDER_MAX_RINGS; i++) {
+		nccl_ofi_flight_recorder_t *recorder = __atomic_load_n(&rings[i], __ATOMIC_ACQUIRE);
+		nccl_ofi_flight_dump_ring_t ring;
+
+		if (recorder == NULL) {
+			break;
+		}
+
+		memset(&ring, 0, sizeof(ring));
+		ring.dev_id = recorder->dev_id;
+		ring.id = recorder->id;
+		ring.num_events = recorder->num_events;
+		ring.in_use = __atomic_load_n(&recorder->in_use, __ATOMIC_RELAXED);
+		ring.head = __atomic_load_n(&recorder->head, __ATOMIC_ACQUIRE);
+
+		/* Events of torn down endpoints matter to post-mortems,
+		 * empty released rings do not */
+		if (!ring.in_use && ring.head == 0) {
+			continue;
+		}
+
+		ret = write_all(fd, &ring, sizeof(ring));
+		if (ret == 0) {
+			ret = write_all(fd, recorder->events,
+					recorder->num_events * sizeof(nccl_ofi_flight_event_t));
+		}
+		if (ret != 0) {
+			goto close;
+		}
+		header.num_rings++;
+	}
+
+	if (lseek(fd, 0, SEEK_SET) != 0) {
+		ret = -errno;
+		goto close;
+	}
+	ret = write_all(fd, &header, sizeof(header));
+
+ close:
+	close(fd);
+	if (ret == 0 && rename(tmp_path, dump_path) != 0) {
+		ret = -errno;
+	}
+	if (ret != 0) {
+		unlink(tmp_path);
+	}
+ exit:
+	__atomic_store_n(&dumping, 0, __ATOMIC_RELEASE);
+	errno = saved_errno;
+	return ret;
+}
+
+const char *nccl_ofi_flight_recorder_path(void)
+{
+	return ring_events ? dump_path : NULL;
+}
+
+static void dump_signal_handler(int signum)
+{
+	nccl_ofi_flight_recorder_dump(signum);
+}
+
+int nccl_ofi_flight_recorder_init(void)
+{
+	int64_t num_events = ofi_nccl_flight_recorder_events();
+	int signum = (int)ofi_nccl_flight_recorder_signal();
+	const char *dir = ofi_nccl_flight_recorder_dir();
+	char cwd[PATH_MAX];
+	uint32_t size = 1;
+	int ret;
+
+	if (ring_events != 0 || num_events == 0) {
+		return 0;
+	}
+	if (num_events < 0 || num_events > (1 << 20)) {
+		NCCL_OFI_WARN("Invalid flight recorder size of %" PRId64 " events", num_events);
+		return -EINVAL;
+	}
+
+	/* The working directory is resolved now, as the process may
+	 * change it before a dump */
+	if (dir == NULL) {
+		if (getcwd(cwd, sizeof(cwd)) == NULL) {
+			ret = -errno;
+			NCCL_OFI_WARN("Unable to get working directory for flight recorder: %s",
+				      strerror(-ret));
+			return ret;
+		}
+		dir = cwd;
+	}
+
+	ret = snprintf(dump_path, sizeof(dump_path), "%s/%s%d.bin", dir,
+		       NCCL_OFI_FLIGHT_RECORDER_FILE_PREFIX, (int)getpid());
+	if (ret < 0 || (size_t)ret >= sizeof(dump_path)) {
+		NCCL_OFI_WARN("Flight recorder directory %s is too long", dir);
+		return -ENAMETOOLONG;
+	}
+	ret = snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", dump_path);
+	if (ret < 0 || (size_t)ret >= sizeof(tmp_path)) {
+		NCCL_OFI_WARN("Flight recorder directory %s is too long", dir);
+		return -ENAMETOOLONG;
+	}
+
+	while (size < (uint64_t)num_events) {
+		size *= 2;
+	}
+	ring_events = size;
+
+	if (signum != 0) {
+		ret = nccl_ofi_signal_register(signum, NCCL_OFI_SIGNAL_FLIGHT_RECORDER,
+					       dump_signal_handler);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+	if (ofi_nccl_flight_recorder_abort()) {
+		/* The dispatcher chains to the previous action, which
+		 * terminates the process */
+		ret = nccl_ofi_signal_register(SIGABRT, NCCL_OFI_SIGNAL_FLIGHT_RECORDER,
+					       dump_signal_handler);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+
+	NCCL_OFI_INFO(NCCL_INIT | NCCL_NET, "Flight recorder keeps %u events per endpoint, dumped to %s",
+		      ring_events, dump_path);
+
+	return 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include "nccl_ofi_histogram.h"
+#include "nccl_ofi_log.h"
+
+
+void nccl_ofi_histogram_snapshot(const nccl_ofi_histogram_t *histogram,
+				 nccl_ofi_histogram_t *snapshot)
+{
+	for (int bucket = 0; bucket < NCCL_OFI_HISTOGRAM_BUCKETS; bucket++) {
+		snapshot->counts[bucket] = __atomic_load_n(&histogram->counts[bucket],
+							   __ATOMIC_RELAXED);
+	}
+	snapshot->sum = __atomic_load_n(&histogram->sum, __ATOMIC_RELAXED);
+}
+
+uint64_t nccl_ofi_histogram_count(const nccl_ofi_histogram_t *histogram)
+{
+	uint64_t count = 0;
+
+	for (int bucket = 0; bucket < NCCL_OFI_HISTOGRAM_BUCKETS; bucket++) {
+		count += __atomic_load_n(&histogram->counts[bucket], __ATOMIC_RELAXED);
+	}
+
+	return count;
+}
+
+/*
+ * @brief	Largest latency of a bucket, or smallest latency of the last
+ *		bucket, which has no bound
+ */
+static uint64_t bucket_max_value(int bucket)
+{
+	if (bucket == NCCL_OFI_HISTOGRAM_BUCKETS - 1) {
+		return nccl_ofi_histogram_bucket_value(bucket);
+	}
+	return nccl_ofi_histogram_bucket_value(bucket + 1) - 1;
+}
+
+uint64_t nccl_ofi_histogram_quantile(const nccl_ofi_histogram_t *histogram, double quantile)
+{
+	nccl_ofi_histogram_t snapshot;
+	uint64_t count, rank, seen = 0;
+
+	nccl_ofi_histogram_snapshot(histogram, &snapshot);
+	count = nccl_ofi_histogram_count(&snapshot);
+	if (count == 0) {
+		return 0;
+	}
+
+	/* Rank of the sample of the quantile, starting at 1 */
+	if (quantile <= 0.0) {
+		rank = 1;
+	} else if (quantile >= 1.0) {
+		rank = count;
+	} else {
+		rank = (uint64_t)(quantile * count);
+		if (rank < quantile * count || rank == 0) {
+			rank++;
+		}
+	}
+
+	for (int bucket = 0; bucket < NCCL_OFI_HISTOGRAM_BUCKETS; bucket++) {
+		seen += snapshot.counts[bucket];
+		if (seen >= rank) {
+			return bucket_max_value(bucket);
+		}
+	}
+
+	return bucket_max_value(NCCL_OFI_HISTOGRAM_BUCKETS - 1);
+}
+
+int nccl_ofi_histogram_format(const nccl_ofi_histogram_t *histogram, char *buf, size_t len)
+{
+	nccl_ofi_histogram_t snapshot;
+	uint64_t count;
+
+	nccl_ofi_histogram_snapshot(histogram, &snapshot);
+	count = nccl_ofi_histogram_count(&snapshot);
+	if (count == 0) {
+		return snprintf(buf, len, "n=0");
+	}
+
+	return snprintf(buf, len, "n=%lu mean=%.1f p50<=%.1f p90<=%.1f p99<=%.1f max<=%.1f",
+			count, snapshot.sum * 1e-3 / count,
+			nccl_ofi_histogram_quantile(&snapshot, 0.5) * 1e-3,
+			nccl_ofi_histogram_quantile(&snapshot, 0.9) * 1e-3,
+			nccl_ofi_histogram_quantile(&snapshot, 0.99) * 1e-3,
+			nccl_ofi_histogram_quantile(&snapshot, 1.0) * 1e-3);
+}
+
+int nccl_ofi_histogram_signal_init(int signum)
+{
+	int ret;
+
+	if (signum == 0) {
+		return 0;
+	}
+
+	ret = nccl_ofi_signal_register(signum, NCCL_OFI_SIGNAL_HISTOGRAM, NULL);
+	if (ret != 0) {
+		return ret;
+	}
+
+	NCCL_OFI_INFO(NCCL_INIT | NCCL_NET, "Latency histograms are logged on signal %d", signum);
+	return 0;
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "nccl_ofi_ini.h"
+#include "nccl_ofi_log.h"
+
+/*
+ * @brief	Remove leading and trailing whitespace in place
+ *
+ * @return	Pointer to first non-whitespace character of `str`
+ */
+static char *strip(char *str)
+{
+	char *end;
+
+	while (isspace((unsigned char)*str)) {
+		++str;
+	}
+
+	end = str + strlen(str);
+	while (end > str && isspace((unsigned char)end[-1])) {
+		--end;
+	}
+	*end = '\0';
+
+	return str;
+}
+
+int nccl_ofi_ini_parse_stream(FILE *stream, const char *name,
+			      nccl_ofi_ini_handler_t handler, void *ctx)
+{
+	int ret = 0;
+	int lineno = 0;
+	char *line = NULL;
+	size_t line_cap = 0;
+	char *section = strdup("");
+
+	if (!section) {
+		NCCL_OFI_WARN("Unable to allocate INI section name");
+		return -ENOMEM;
+	}
+
+	while (getline(&line, &line_cap, stream) >= 0) {
+		char *str = strip(line);
+		++lineno;
+
+		if (*str == '\0' || *str == '#' || *str == ';') {
+			continue;
+		}
+
+		if (*str == '[') {
+			char *end = strchr(str, ']');
+			if (!end || *strip(end + 1) != '\0') {
+				NCCL_OFI_WARN("%s:%d: Malformed section header", name, lineno);
+				ret = -EINVAL;
+				goto exit;
+			}
+			*end = '\0';
+
+			free(section);
+			section = strdup(strip(str + 1));
+			if (!section) {
+				NCCL_OFI_WARN("Unable to allocate INI section name");
+				ret = -ENOMEM;
+				goto exit;
+			}
+			continue;
+		}
+
+		char *eq = strchr(str, '=');
+		if (!eq) {
+			NCCL_OFI_WARN("%s:%d: Expected `key = value`", name, lineno);
+			ret = -EINVAL;
+			goto exit;
+		}
+		*eq = '\0';
+
+		char *key = strip(str);
+		if (*key == '\0') {
+			NCCL_OFI_WARN("%s:%d: Empty key", name, lineno);
+			ret = -EINVAL;
+			goto exit;
+		}
+
+		if (handler(ctx, section, key, strip(eq + 1), lineno) != 0) {
+			ret = -EINVAL;
+			goto exit;
+		}
+	}
+
+	if (ferror(stream)) {
+		NCCL_OFI_WARN("%s: Error reading file", name);
+		ret = -EIO;
+	}
+
+ exit:
+	free(line);
+	free(section);
+	return ret;
+}
+
+int nccl_ofi_ini_parse_file(const char *path,
+			    nccl_ofi_ini_handler_t handler, void *ctx)
+{
+	int ret;
+	FILE *file = fopen(path, "r");
+
+	if (!file) {
+		return -errno;
+	}
+
+	ret = nccl_ofi_ini_parse_stream(file, path, handler, ctx);
+	fclose(file);
+
+	return ret;
+}
+
+int nccl_ofi_ini_parse_int(const char *value, int64_t *result)
+{
+	char *end;
+	long long v;
+
+	errno = 0;
+	v = strtoll(value, &end, 0);
+	if (errno || end == value || *end != '\0') {
+		return -EINVAL;
+	}
+
+	*result = v;
+	return 0;
+}
+
+int nccl_ofi_ini_parse_double(const char *value, double *result)
+{
+	char *end;
+	double v;
+
+	errno = 0;
+	v = strtod(value, &end);
+	if (errno || end == value || *end != '\0') {
+		return -EINVAL;
+	}
+
+	*result = v;
+	return 0;
+}
+
+int nccl_ofi_ini_parse_bool(const char *value, bool *result)
+{
+	static const char *true_values[] = {"1", "true", "yes", "on"};
+	static const char *false_values[] = {"0", "false", "no", "off"};
+
+	for (size_t i = 0; i < sizeof(true_values) / sizeof(true_values[0]); ++i) {
+		if (strcasecmp(value, true_values[i]) == 0) {
+			*result = true;
+			return 0;
+		}
+		if (strcasecmp(value, false_values[i]) == 0) {
+			*result = false;
+			return 0;
+		}
+	}
+
+	return -EINVAL;
+}
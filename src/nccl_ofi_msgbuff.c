@@ -269,3 +269,33 @@ nccl_ofi_msgbuff_result_t nccl_ofi_msgbuff_complete(nccl_ofi_msgbuff_t *msgbuff,
 	}
 	return ret;
 }
+
+nccl_ofi_msgbuff_result_t nccl_ofi_msgbuff_for_each(nccl_ofi_msgbuff_t *msgbuff,
+		nccl_ofi_msgbuff_iter_fn_t fn, void *arg, uint16_t *first, uint16_t *next)
+{
+	assert(msgbuff);
+
+	if (pthread_mutex_lock(&msgbuff->lock)) {
+		NCCL_OFI_WARN("Error locking mutex");
+		return NCCL_OFI_MSGBUFF_ERROR;
+	}
+
+	if (first) {
+		*first = msgbuff->msg_last_incomplete;
+	}
+	if (next) {
+		*next = msgbuff->msg_next;
+	}
+
+	for (uint16_t msg_index = msgbuff->msg_last_incomplete; msg_index != msgbuff->msg_next;
+	     msg_index = (msg_index + 1) & msgbuff->field_mask) {
+		nccl_ofi_msgbuff_elem_t *elem = buff_idx(msgbuff, msg_index);
+		fn(msg_index, elem->stat, elem->type, elem->elem, arg);
+	}
+
+	if (pthread_mutex_unlock(&msgbuff->lock)) {
+		NCCL_OFI_WARN("Error unlocking mutex");
+		return NCCL_OFI_MSGBUFF_ERROR;
+	}
+	return NCCL_OFI_MSGBUFF_SUCCESS;
+}
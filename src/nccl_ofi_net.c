@@ -17,6 +17,7 @@
 
 #include "nccl_ofi.h"
 #include "nccl_ofi_param.h"
+#include "nccl_ofi_capability.h"
 #include "tracepoint.h"
 #if HAVE_CUDA
 #include "nccl_ofi_cuda.h"
@@ -26,6 +27,7 @@
 #include "nccl_ofi_topo.h"
 #include "nccl_ofi_math.h"
 #include "nccl_ofi_idpool.h"
+#include "nccl_ofi_startup.h"
 
 /* Indicates if GPUDirect is supported by libfabric provider */
 enum gdr_support_level_t support_gdr = GDR_UNKNOWN;
@@ -58,7 +60,7 @@ bool endpoint_mr = false;
 bool virt_addr_mr = false;
 
 /* Selected communication protocol. */
-const char *nccl_ofi_selected_protocol = "SENDRECV";
+const char *nccl_ofi_selected_protocol = NULL;
 
 /* Internode network latency. */
 float net_latency = .0;
@@ -131,9 +133,14 @@ int nccl_net_ofi_create_plugin(nccl_net_ofi_plugin_t **plugin_p)
 {
 	int ret = 0;
 	const char *provider_filter = NULL;
+	uint64_t init_begin;
 
 	NCCL_OFI_INFO(NCCL_INIT | NCCL_NET, "Initializing " PACKAGE_STRING);
 
+	/* The startup profiler is optional, so a failure only disables it */
+	nccl_ofi_startup_init();
+	init_begin = nccl_ofi_startup_begin();
+
 	/* Print Libfabric version */
 	uint32_t fab_version = fi_version();
 	NCCL_OFI_INFO(NCCL_INIT | NCCL_NET, "Using Libfabric version %u.%u", FI_MAJOR(fab_version),
@@ -163,15 +170,6 @@ int nccl_net_ofi_create_plugin(nccl_net_ofi_plugin_t **plugin_p)
 	}
 
 	NCCL_OFI_INFO(NCCL_INIT | NCCL_NET, "Using CUDA driver version %d", cuda_version);
-	if (ofi_nccl_cuda_flush_enable()) {
-		if (nccl_net_ofi_cuFlushGPUDirectRDMAWrites == NULL) {
-			NCCL_OFI_WARN("CUDA flush requested, but cuFlushGPUDirectRDMAWrites not found.");
-			cuda_flush = false;
-		} else {
-			NCCL_OFI_WARN("CUDA flush enabled");
-			cuda_flush = true;
-		}
-	}
 #endif
 
 	/* configuration parameters */
@@ -179,25 +177,68 @@ int nccl_net_ofi_create_plugin(nccl_net_ofi_plugin_t **plugin_p)
 	net_latency = (float)ofi_nccl_net_latency();
 	cq_read_count = ofi_nccl_cq_read_count();
 
+	/* The tracer is optional, so a failure only disables it */
+	nccl_ofi_tracer_init();
+
 	if (platform_init) {
 		ret = platform_init(&provider_filter);
 		if (ret != 0)
 			goto exit;
 	}
 
+	/* Probe the capabilities of the provider that the protocols
+	 * will select. A failed probe is not fatal; the protocol
+	 * initialization reports a missing provider. */
+	nccl_ofi_capability_t caps;
+	bool have_caps = (nccl_ofi_capability_probe(provider_filter, &caps) == 0);
+	if (have_caps) {
+		nccl_ofi_capability_log(&caps);
+	}
+
 	/* Select and initialize protocol data structure.
 	 * platform_init() may change the default, so this must occur
-	 * after the platform init call.
+	 * after the platform init call. Without a user or platform
+	 * choice, the protocol is selected by the capability rule
+	 * table.
 	 */
 	if (ofi_nccl_protocol()) {
 		nccl_ofi_selected_protocol = ofi_nccl_protocol();
 		NCCL_OFI_INFO(NCCL_INIT | NCCL_NET, "Using transport protocol %s (user set)",
 			      nccl_ofi_selected_protocol);
+	} else if (nccl_ofi_selected_protocol) {
+		NCCL_OFI_INFO(NCCL_INIT | NCCL_NET, "Using transport protocol %s (platform set)",
+			      nccl_ofi_selected_protocol);
 	} else {
+		if (have_caps) {
+			nccl_ofi_selected_protocol = nccl_ofi_capability_select_protocol(&caps);
+		}
+		if (nccl_ofi_selected_protocol == NULL) {
+			nccl_ofi_selected_protocol = "SENDRECV";
+		}
 		NCCL_OFI_INFO(NCCL_INIT | NCCL_NET, "Using transport protocol %s",
 			      nccl_ofi_selected_protocol);
 	}
 
+	if (have_caps) {
+		ret = nccl_ofi_capability_apply_features(&caps, nccl_ofi_selected_protocol);
+		if (ret != 0)
+			goto exit;
+	}
+
+#if HAVE_CUDA
+	/* The capability rules may enable CUDA flush, so this must
+	 * occur after they are applied. */
+	if (ofi_nccl_cuda_flush_enable()) {
+		if (nccl_net_ofi_cuFlushGPUDirectRDMAWrites == NULL) {
+			NCCL_OFI_WARN("CUDA flush requested, but cuFlushGPUDirectRDMAWrites not found.");
+			cuda_flush = false;
+		} else {
+			NCCL_OFI_WARN("CUDA flush enabled");
+			cuda_flush = true;
+		}
+	}
+#endif
+
 	if (0 == strcasecmp(nccl_ofi_selected_protocol, "SENDRECV")) {
 		ret = nccl_net_ofi_sendrecv_init(provider_filter, plugin_p);
 		if (ret != 0) {
@@ -256,6 +297,7 @@ int nccl_net_ofi_create_plugin(nccl_net_ofi_plugin_t **plugin_p)
 	if (ret != 0) {
 		NCCL_OFI_WARN(PACKAGE_NAME " initialization failed");
 	}
+	nccl_ofi_startup_end(NCCL_OFI_STARTUP_PLUGIN_INIT, init_begin);
 	return ret;
 }
 
@@ -23,6 +23,7 @@
 #endif
 #include "nccl_ofi_math.h"
 #include "nccl_ofi_ofiutils.h"
+#include "nccl_ofi_startup.h"
 
 #define EFA_PROVIDER_NAME "efa"
 #define IS_EFA_PROVIDER(NAME) (strcmp((NAME), EFA_PROVIDER_NAME)==0)
@@ -166,8 +167,10 @@ int nccl_ofi_ofiutils_get_providers(const char *prov_include,
 	int rc = 0;
 	struct fi_info *providers = NULL, *prov = NULL, *last_prov;
 	char *selected_prov_name = NULL;
+	uint64_t begin = nccl_ofi_startup_begin();
 
 	rc = fi_getinfo(required_version, NULL, NULL, 0ULL, hints, &providers);
+	nccl_ofi_startup_end(NCCL_OFI_STARTUP_PROVIDERS, begin);
 	if (rc != 0)
 		goto error;
 
@@ -250,6 +253,8 @@ int nccl_ofi_ofiutils_init_connection(int api_version, struct fi_info *info, str
 	int ret = 0;
  	struct fi_av_attr av_attr = {0};
 	struct fi_cq_attr cq_attr = {0};
+	uint64_t begin = nccl_ofi_startup_begin();
+	uint64_t av_begin;
 
 	/* Create transport level communication endpoint(s) */
 	ret = fi_endpoint(domain, info, ep, NULL);
@@ -273,7 +278,9 @@ int nccl_ofi_ofiutils_init_connection(int api_version, struct fi_info *info, str
 	}
 
 	/* Open AV */
+	av_begin = nccl_ofi_startup_begin();
 	ret = fi_av_open(domain, &av_attr, av, NULL);
+	nccl_ofi_startup_end(NCCL_OFI_STARTUP_AV, av_begin);
 	if (OFI_UNLIKELY(ret != 0)) {
 		NCCL_OFI_WARN("Couldn't open AV. RC: %d, ERROR: %s",
 			      ret, fi_strerror(-ret));
@@ -361,6 +368,7 @@ int nccl_ofi_ofiutils_init_connection(int api_version, struct fi_info *info, str
 		goto error;
 	}
 
+	nccl_ofi_startup_end(NCCL_OFI_STARTUP_ENDPOINT, begin);
 	return ret;
  error:
 	if (*ep) {
@@ -23,6 +23,8 @@
 #include "nccl_ofi_topo.h"
 #include "nccl_ofi_memcheck.h"
 #include "nccl_ofi_ofiutils.h"
+#include "nccl_ofi_calibrate.h"
+#include "nccl_ofi_startup.h"
 
 /* Template path used to write temporary NCCL topology file */
 static const char *topo_file_template = "/tmp/aws-ofi-nccl-topo-XXXXXX";
@@ -114,6 +116,38 @@ static pthread_mutex_t topo_file_lock = PTHREAD_MUTEX_INITIALIZER;
 /* Maximum size of an eager message (see OFI_NCCL_EAGER_MAX_SIZE) */
 static size_t eager_max_size = 0;
 
+/* Record latency histograms (see OFI_NCCL_LATENCY_HISTOGRAMS) */
+static bool latency_histograms = false;
+
+/* Time at which the thread read the completion batch it processes, 0
+ * outside of process_completions(). Latencies of a batch all end at
+ * this time, so that recording them does not read the clock per
+ * completion. */
+static __thread uint64_t batch_completion_time = 0;
+
+/* Record phase breakdowns of latency (see OFI_NCCL_PHASE_BREAKDOWN) */
+static bool phase_breakdown = false;
+
+/* Interval between log lines of rail counters in ns, 0 if not logged
+ * (see OFI_NCCL_RAIL_COUNTERS_INTERVAL) */
+static uint64_t rail_counters_interval = 0;
+
+/* Count rail traffic and errors (see OFI_NCCL_RAIL_COUNTERS) */
+static bool rail_counters = false;
+
+/* Minimum interval between updates of telemetry records in ns, 0 if
+ * telemetry is not published (see OFI_NCCL_TELEMETRY) */
+static uint64_t telemetry_interval = 0;
+
+/* Time in ns after which an outstanding request is reported as
+ * hanging, 0 if disabled (see OFI_NCCL_HANG_TIMEOUT) */
+static uint64_t hang_timeout = 0;
+
+/* Plugin whose devices are queried by nccl_ofi_get_rail_counters().
+ * The plugin is only freed on initialization errors, which reset the
+ * pointer before the devices are freed. */
+static nccl_net_ofi_plugin_t *counters_plugin = NULL;
+
 /* Function prototypes */
 static int send_progress(nccl_net_ofi_rdma_req_t *req);
 
@@ -249,6 +283,135 @@ static inline nccl_net_ofi_ep_rail_t *get_rail(nccl_net_ofi_rdma_ep_t *ep,
 	return &ep->rails[rail_id];
 }
 
+/*
+ * @brief Return counters of rail with index `rail_id` of the device of
+ * endpoint `ep`
+ */
+static inline nccl_ofi_rail_counters_t *get_rail_counters(nccl_net_ofi_rdma_ep_t *ep,
+							  int rail_id)
+{
+	nccl_net_ofi_rdma_device_t *device = (nccl_net_ofi_rdma_device_t *)ep->base.device;
+	return &get_device_rail(device, rail_id)->counters;
+}
+
+/*
+ * @brief	Add value to rail counter, if rail counters are enabled
+ */
+static inline void counter_add(uint64_t *counter, uint64_t value)
+{
+	if (rail_counters)
+		__atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+}
+
+/*
+ * @brief	Count post to rail `rail_id` of endpoint that failed with
+ *		FI_EAGAIN
+ */
+static inline void count_eagain(nccl_net_ofi_rdma_ep_t *ep, int rail_id)
+{
+	counter_add(&get_rail_counters(ep, rail_id)->eagain, 1);
+}
+
+/*
+ * @brief	Count network operation posted to rail `rail_id` of
+ *		endpoint with return code `rc`
+ */
+static inline void count_post(nccl_net_ofi_rdma_ep_t *ep, int rail_id, ssize_t rc, size_t bytes)
+{
+	if (!rail_counters)
+		return;
+
+	if (rc == 0) {
+		nccl_ofi_rail_counters_t *counters = get_rail_counters(ep, rail_id);
+		__atomic_fetch_add(&counters->tx_ops, 1, __ATOMIC_RELAXED);
+		__atomic_fetch_add(&counters->tx_bytes, bytes, __ATOMIC_RELAXED);
+	} else if (rc == -FI_EAGAIN) {
+		count_eagain(ep, rail_id);
+	}
+}
+
+/*
+ * @brief	Count request inserted into pending requests queue of
+ *		endpoint and update high-water mark of the queue
+ */
+static inline void count_pending_insert(nccl_net_ofi_rdma_ep_t *ep)
+{
+	size_t depth = __atomic_add_fetch(&ep->num_pending_reqs, 1, __ATOMIC_RELAXED);
+	size_t max;
+
+	if (!rail_counters)
+		return;
+
+	max = __atomic_load_n(&ep->max_pending_reqs, __ATOMIC_RELAXED);
+	while (depth > max &&
+	       !__atomic_compare_exchange_n(&ep->max_pending_reqs, &max, depth, true,
+					    __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+/*
+ * @brief	Count request removed from pending requests queue of endpoint
+ */
+static inline void count_pending_remove(nccl_net_ofi_rdma_ep_t *ep)
+{
+	__atomic_sub_fetch(&ep->num_pending_reqs, 1, __ATOMIC_RELAXED);
+}
+
+/*
+ * @brief	Local communicator ID of request, or UINT32_MAX if the
+ *		request has no send or receive communicator
+ */
+static inline uint32_t get_req_comm_id(nccl_net_ofi_rdma_req_t *req)
+{
+	if (req == NULL || req->comm == NULL) {
+		return UINT32_MAX;
+	}
+	if (req->comm->type == NCCL_NET_OFI_SEND_COMM) {
+		return ((nccl_net_ofi_rdma_send_comm_t *)req->comm)->local_comm_id;
+	}
+	if (req->comm->type == NCCL_NET_OFI_RECV_COMM) {
+		return ((nccl_net_ofi_rdma_recv_comm_t *)req->comm)->local_comm_id;
+	}
+	return UINT32_MAX;
+}
+
+/*
+ * @brief	Record event of request into flight recorder of endpoint
+ */
+static inline void flight_record(nccl_net_ofi_rdma_ep_t *ep, uint16_t type, int rail_id,
+				 nccl_net_ofi_rdma_req_t *req, int64_t value, uint64_t arg)
+{
+	if (ep == NULL || ep->flight_recorder == NULL) {
+		return;
+	}
+
+	nccl_ofi_flight_record(ep->flight_recorder, type, rail_id, req,
+			       req ? (uint8_t)req->type : 0, get_req_comm_id(req),
+			       req ? req->msg_seq_num : 0, (int32_t)value, arg);
+}
+
+/*
+ * @brief	Record state change of request with a communicator
+ */
+static inline void flight_record_state(nccl_net_ofi_rdma_req_t *req)
+{
+	if (req->comm != NULL) {
+		flight_record((nccl_net_ofi_rdma_ep_t *)req->comm->ep, NCCL_OFI_FLIGHT_STATE, -1,
+			      req, req->state, 0);
+	}
+}
+
+/*
+ * @brief	Dump flight recorder after a fatal error of the progress path
+ */
+static void dump_flight_recorder(void)
+{
+	const char *path = nccl_ofi_flight_recorder_path();
+
+	if (path && nccl_ofi_flight_recorder_dump(NCCL_OFI_FLIGHT_DUMP_ERROR) == 0) {
+		NCCL_OFI_WARN("Recent events of the endpoints written to %s", path);
+	}
+}
+
 /*
  * @brief	Unlink temporary NCCL topology file written by `write_topo_file()`
  *
@@ -618,6 +781,7 @@ static inline rdma_req_flush_data_t *get_flush_data(nccl_net_ofi_rdma_req_t *req
 static inline void set_request_state_to_error(nccl_net_ofi_rdma_req_t *req)
 {
 	req->state = NCCL_OFI_RDMA_REQ_ERROR;
+	flight_record_state(req);
 
 	/* Set state of parent requests to error as well */
 	if (req->type == NCCL_OFI_RDMA_SEND_CTRL) {
@@ -629,6 +793,102 @@ static inline void set_request_state_to_error(nccl_net_ofi_rdma_req_t *req)
 	}
 }
 
+/*
+ * @brief	Time of the completion being processed
+ *
+ * @return	Time of the thread's completion batch, or the current time
+ *		outside of completion processing
+ */
+static inline uint64_t completion_time(void)
+{
+	return OFI_LIKELY(batch_completion_time != 0) ? batch_completion_time : nccl_ofi_timestamp_ns();
+}
+
+/*
+ * @brief	Record latency of completed send, receive or flush request
+ */
+static inline void record_req_latency(nccl_net_ofi_rdma_req_t *req)
+{
+	if (req->type == NCCL_OFI_RDMA_SEND) {
+		nccl_net_ofi_rdma_send_comm_t *s_comm = (nccl_net_ofi_rdma_send_comm_t *)req->comm;
+		nccl_ofi_histogram_record_interval(&s_comm->send_hist, req->post_time, completion_time());
+	} else if (req->type == NCCL_OFI_RDMA_RECV) {
+		nccl_net_ofi_rdma_recv_comm_t *r_comm = (nccl_net_ofi_rdma_recv_comm_t *)req->comm;
+		nccl_ofi_histogram_record_interval(&r_comm->recv_hist, req->post_time, completion_time());
+	} else if (req->type == NCCL_OFI_RDMA_FLUSH) {
+		nccl_net_ofi_rdma_recv_comm_t *r_comm = (nccl_net_ofi_rdma_recv_comm_t *)req->comm;
+		nccl_ofi_histogram_record_interval(&r_comm->flush_hist, req->post_time, completion_time());
+	}
+}
+
+/*
+ * @brief	Record latency of segment of send request on rail
+ */
+static inline void record_xfer_latency(nccl_net_ofi_rdma_req_t *req, int rail_id)
+{
+	nccl_net_ofi_rdma_send_comm_t *s_comm = (nccl_net_ofi_rdma_send_comm_t *)req->comm;
+
+	nccl_ofi_histogram_record_interval(&s_comm->rails[rail_id].write_hist,
+					   get_send_data(req)->xfer_post_time[rail_id],
+					   completion_time());
+}
+
+/*
+ * @brief	Count completed send or receive request in the traffic
+ *		matrix of the endpoint, if its peer is counted
+ */
+static inline void record_req_traffic(nccl_net_ofi_rdma_req_t *req)
+{
+	if (req->type == NCCL_OFI_RDMA_SEND) {
+		nccl_net_ofi_rdma_send_comm_t *s_comm = (nccl_net_ofi_rdma_send_comm_t *)req->comm;
+		if (s_comm->traffic_peer)
+			nccl_ofi_traffic_record_tx(s_comm->traffic_peer, req->size);
+	} else if (req->type == NCCL_OFI_RDMA_RECV) {
+		nccl_net_ofi_rdma_recv_comm_t *r_comm = (nccl_net_ofi_rdma_recv_comm_t *)req->comm;
+		if (r_comm->traffic_peer)
+			nccl_ofi_traffic_record_rx(r_comm->traffic_peer, req->size);
+	}
+}
+
+/*
+ * @brief	Set time of phase transition of request to now, unless the
+ *		transition already happened
+ *
+ * Transitions of a receive may be observed by the completions of
+ * different subrequests, so that the time is only set once atomically.
+ */
+static inline void set_phase_time(uint64_t *time)
+{
+	uint64_t unset = 0;
+
+	if (__atomic_load_n(time, __ATOMIC_RELAXED) != 0)
+		return;
+	__atomic_compare_exchange_n(time, &unset, nccl_ofi_timestamp_ns(), false,
+				    __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+/*
+ * @brief	Record phase breakdown of completed send or receive request
+ */
+static inline void record_req_breakdown(nccl_net_ofi_rdma_req_t *req)
+{
+	uint64_t times[NCCL_OFI_NUM_PHASES + 1] = {
+		req->post_time,
+		__atomic_load_n(&req->ready_time, __ATOMIC_RELAXED),
+		__atomic_load_n(&req->xfer_time, __ATOMIC_RELAXED),
+		__atomic_load_n(&req->first_compl_time, __ATOMIC_RELAXED),
+		nccl_ofi_timestamp_ns()
+	};
+
+	if (req->type == NCCL_OFI_RDMA_SEND) {
+		nccl_net_ofi_rdma_send_comm_t *s_comm = (nccl_net_ofi_rdma_send_comm_t *)req->comm;
+		nccl_ofi_breakdown_record(&s_comm->send_breakdown, req->size, times);
+	} else if (req->type == NCCL_OFI_RDMA_RECV) {
+		nccl_net_ofi_rdma_recv_comm_t *r_comm = (nccl_net_ofi_rdma_recv_comm_t *)req->comm;
+		nccl_ofi_breakdown_record(&r_comm->recv_breakdown, req->size, times);
+	}
+}
+
 /*
  * @brief 	Increment request completions of main requests and set request
  *		state to completed if total number of completions is reached
@@ -668,7 +928,15 @@ static inline int inc_req_completion(nccl_net_ofi_rdma_req_t *req,
 	 * overriding the state in case of previs errors */
 	if (ncompls == total_ncompls &&
 	    OFI_LIKELY(req->state != NCCL_OFI_RDMA_REQ_ERROR)) {
+		/* Record before the request can be freed by test() */
+		if (latency_histograms)
+			record_req_latency(req);
+		if (phase_breakdown)
+			record_req_breakdown(req);
+		record_req_traffic(req);
+
 		req->state = NCCL_OFI_RDMA_REQ_COMPLETED;
+		flight_record_state(req);
 
 		/* Trace this completion */
 		NCCL_OFI_TRACE_COMPLETIONS(req, req);
@@ -896,6 +1164,9 @@ static inline int repost_bounce_buff(nccl_net_ofi_rdma_ep_t *ep,
 				     nccl_net_ofi_rdma_req_t *bounce_req)
 {
 	int ret = 0;
+	rdma_req_bounce_data_t *bounce_data = get_bounce_data(bounce_req);
+
+	counter_add(&get_rail_counters(ep, bounce_data->rail->rail_id)->bounce_reposts, 1);
 
 	/* First, repost this bounce buffer */
 	ret = send_progress(bounce_req);
@@ -906,6 +1177,7 @@ static inline int repost_bounce_buff(nccl_net_ofi_rdma_ep_t *ep,
 			NCCL_OFI_WARN("Failed to nccl_ofi_deque_insert_back: %d", ret);
 			return ret;
 		}
+		count_pending_insert(ep);
 		NCCL_OFI_TRACE_PENDING_INSERT(bounce_req);
 
 		return ret;
@@ -913,8 +1185,6 @@ static inline int repost_bounce_buff(nccl_net_ofi_rdma_ep_t *ep,
 		return ret;
 	}
 
-	rdma_req_bounce_data_t *bounce_data = get_bounce_data(bounce_req);
-
 	/* Next, check the posted count and post more buffers if needed. */
 	return check_post_bounce_buffers_rail(ep, bounce_data->rail);
 }
@@ -981,6 +1251,12 @@ static inline int handle_ctrl_recv(nccl_net_ofi_rdma_send_comm_t *s_comm,
 	}
 	nccl_net_ofi_rdma_req_t *req = elem;
 	rdma_req_send_data_t *send_data = get_send_data(req);
+	send_data->ctrl_recv = true;
+
+	if (latency_histograms)
+		nccl_ofi_histogram_record_interval(&s_comm->ctrl_hist, req->post_time, completion_time());
+	if (phase_breakdown)
+		set_phase_time(&req->ready_time);
 
 	if (!send_data->eager) {
 		copy_ctrl_data(bounce_req, req);
@@ -1004,6 +1280,7 @@ static inline int handle_ctrl_recv(nccl_net_ofi_rdma_send_comm_t *s_comm,
 				NCCL_OFI_WARN("Failed to nccl_ofi_deque_insert_back: %d", ret);
 				return ret;
 			}
+			count_pending_insert(ep);
 			NCCL_OFI_TRACE_PENDING_INSERT(req);
 		}
 		else if (OFI_UNLIKELY(ret != 0)) {
@@ -1165,6 +1442,7 @@ static inline int handle_bounce_recv(nccl_ofi_rdma_msg_type_t msg_type, nccl_net
 		NCCL_OFI_WARN("Invalid non-bounce request as ctx!");
 		return -EINVAL;
 	}
+	NCCL_OFI_TRACE_BOUNCE_RECV(rail_id, bounce_req, msg_type, cq_entry->len);
 
 	bounce_data = get_bounce_data(bounce_req);
 	bounce_data->recv_len = cq_entry->len;
@@ -1312,6 +1590,9 @@ static inline int handle_write_comp(struct fi_cq_data_entry *cq_entry, nccl_net_
 
 	uint64_t total_segms = GET_NUM_SEG_FROM_IMM(cq_entry->data);
 
+	if (phase_breakdown)
+		set_phase_time(&req->first_compl_time);
+
 	ret = inc_recv_seg_completion(recv_segms_req, cq_entry->len, total_segms);
 	if (OFI_UNLIKELY(ret != 0)) {
 		return ret;
@@ -1402,6 +1683,10 @@ static inline int process_completions(struct fi_cq_data_entry *cq_entry, uint64_
 
 	rdma_req_send_data_t *send_data = NULL;
 	uint16_t *msg_type = NULL;
+	nccl_ofi_rail_counters_t *counters = NULL;
+
+	if (latency_histograms)
+		batch_completion_time = nccl_ofi_timestamp_ns();
 
 	for (comp_idx = 0; comp_idx < num_cqes; comp_idx++) {
 		/* The context for these operations is req.
@@ -1409,6 +1694,9 @@ static inline int process_completions(struct fi_cq_data_entry *cq_entry, uint64_
 		req = cq_entry[comp_idx].op_context;
 		comp_flags = cq_entry[comp_idx].flags;
 		assert(NULL != req || (comp_flags & FI_REMOTE_WRITE));
+		flight_record(ep, NCCL_OFI_FLIGHT_COMPLETION, rail->rail_id,
+			      (comp_flags & FI_REMOTE_WRITE) ? NULL : req,
+			      cq_entry[comp_idx].len, comp_flags);
 
 		/**
 		 * Types of completions:
@@ -1434,6 +1722,10 @@ static inline int process_completions(struct fi_cq_data_entry *cq_entry, uint64_
 				/* Eager message send completion */
 				send_data = get_send_data(req);
 				assert(send_data->eager);
+				if (latency_histograms)
+					record_xfer_latency(req, rail->rail_id);
+				if (phase_breakdown)
+					set_phase_time(&req->first_compl_time);
 				ret = inc_req_completion(req, 0, send_data->total_num_compls);
 
 			} else {
@@ -1442,19 +1734,29 @@ static inline int process_completions(struct fi_cq_data_entry *cq_entry, uint64_
 			}
 		} else if (comp_flags & FI_RECV) {
 			/* Receive completions */
+			counters = get_rail_counters(ep, rail->rail_id);
+			counter_add(&counters->rx_ops, 1);
+			counter_add(&counters->rx_bytes, cq_entry[comp_idx].len);
 
 			if (!(comp_flags & FI_REMOTE_CQ_DATA)) {
 				/* CONN, CONN_RESP, or CTRL message */
 				msg_type = (uint16_t *)cq_entry[comp_idx].buf;
+				if (*msg_type == NCCL_OFI_RDMA_MSG_CTRL)
+					counter_add(&counters->ctrl_recv, 1);
 				ret = handle_bounce_recv(*msg_type, ep, rail->rail_id, &cq_entry[comp_idx], req);
 
 			} else {
 				/* Eager message receive completion */
+				counter_add(&counters->eager_recv, 1);
 				ret = handle_bounce_recv(NCCL_OFI_RDMA_MSG_EAGER, ep, rail->rail_id,
 							 &cq_entry[comp_idx], req);
 			}
 		} else if (comp_flags & FI_REMOTE_WRITE) {
 			/* Remote-initiated write is complete */
+			counters = get_rail_counters(ep, rail->rail_id);
+			counter_add(&counters->rx_ops, 1);
+			counter_add(&counters->rx_bytes, cq_entry[comp_idx].len);
+
 			ret = handle_write_comp(&cq_entry[comp_idx], ep, rail->rail_id);
 
 		} else if (comp_flags & FI_WRITE) {
@@ -1463,6 +1765,10 @@ static inline int process_completions(struct fi_cq_data_entry *cq_entry, uint64_
 							       req);
 
 			send_data = get_send_data(req);
+			if (latency_histograms)
+				record_xfer_latency(req, rail->rail_id);
+			if (phase_breakdown)
+				set_phase_time(&req->first_compl_time);
 			ret = inc_req_completion(req, 0, send_data->total_num_compls);
 
 		} else if (comp_flags & FI_READ) {
@@ -1492,6 +1798,7 @@ static inline int process_completions(struct fi_cq_data_entry *cq_entry, uint64_
 		}
 	}
 exit:
+	batch_completion_time = 0;
 	return ret;
 }
 
@@ -1521,6 +1828,8 @@ static inline int process_err_completion(nccl_net_ofi_rdma_ep_t *ep,
 		goto exit;
 	}
 
+	counter_add(&get_rail_counters(ep, rail->rail_id)->err_completions, 1);
+
 	if (err_entry.flags & FI_REMOTE_WRITE) {
 		req = get_req_from_imm_data(ep, err_entry.data);
 		if (!req) {
@@ -1542,6 +1851,9 @@ static inline int process_err_completion(nccl_net_ofi_rdma_ep_t *ep,
 		      req, err_entry.err,
 		      fi_cq_strerror(rail->cq, err_entry.prov_errno, err_entry.err_data, NULL, 0),
 		      (long)err_entry.len, nccl_net_ofi_req_str(req));
+	flight_record(ep, NCCL_OFI_FLIGHT_ERR_COMPLETION, rail->rail_id, req, err_entry.err,
+		      err_entry.prov_errno);
+	NCCL_OFI_TRACE_CQ_ERROR(rail->rail_id, req, err_entry.err, err_entry.prov_errno);
 	if (req->type == NCCL_OFI_RDMA_BOUNCE) {
 		/* A bounce buffer receive failed -- this is an internal error so bail out */
 		NCCL_OFI_WARN("Fatal: Bounce buffer recv completed with error");
@@ -1559,6 +1871,7 @@ static inline int process_err_completion(nccl_net_ofi_rdma_ep_t *ep,
 	 */
 	ret = -err_entry.err;
 exit:
+	dump_flight_recorder();
 	return ret;
 }
 
@@ -1604,6 +1917,7 @@ static int receive_progress(nccl_net_ofi_rdma_req_t *req, bool add_to_pending)
 			rc = 0;
 		}
 
+		count_pending_insert(ep);
 		NCCL_OFI_TRACE_PENDING_INSERT(req);
 	}
 
@@ -1664,6 +1978,7 @@ static int process_pending_reqs(nccl_net_ofi_rdma_ep_t *ep)
 			}
 			break;
 		}
+		count_pending_remove(ep);
 		NCCL_OFI_TRACE_PENDING_REMOVE(req);
 	}
 	return rc;
@@ -1679,9 +1994,12 @@ static int ofi_process_cq_rail(nccl_net_ofi_rdma_ep_t *ep, nccl_net_ofi_ep_rail_
 		/* Receive completions for the given endpoint */
 		rc = fi_cq_read(rail->cq, cqe_buffers, cq_read_count);
 		if (rc > 0) {
+			NCCL_OFI_TRACE_CQ_READ(rail->rail_id, rc);
 			ret = process_completions(cqe_buffers, rc, ep, rail);
-			if (OFI_UNLIKELY(ret != 0))
+			if (OFI_UNLIKELY(ret != 0)) {
+				dump_flight_recorder();
 				goto exit;
+			}
 		} else if (OFI_UNLIKELY(rc == -FI_EAVAIL)) {
 			ret = process_err_completion(ep, rail);
 			if (ret == 0)
@@ -1695,6 +2013,7 @@ static int ofi_process_cq_rail(nccl_net_ofi_rdma_ep_t *ep, nccl_net_ofi_ep_rail_
 		} else {
 			NCCL_OFI_WARN("Unable to retrieve completion queue entries. RC: %zd, ERROR: %s",
 				      rc, fi_strerror(-rc));
+			dump_flight_recorder();
 			ret = -EINVAL;
 			goto exit;
 		}
@@ -1744,6 +2063,10 @@ static inline void zero_nccl_ofi_req(nccl_net_ofi_rdma_req_t *req)
 	req->dev_id = -1;
 	req->size = 0;
 
+	req->ready_time = 0;
+	req->xfer_time = 0;
+	req->first_compl_time = 0;
+
 	req->state = NCCL_OFI_RDMA_REQ_CREATED;
 
 	/* Mrail zero-out */
@@ -2002,6 +2325,7 @@ static inline int handle_bounce_eagain(nccl_net_ofi_rdma_ep_t *ep,
 		NCCL_OFI_WARN("Failed to nccl_ofi_deque_insert_back: %d", ret);
 		return ret;
 	}
+	count_pending_insert(ep);
 	NCCL_OFI_TRACE_PENDING_INSERT(req);
 
 	ret = pthread_mutex_lock(&rail->bounce_mutex);
@@ -2229,12 +2553,516 @@ static int finish_connect(nccl_net_ofi_rdma_send_comm_t *s_comm)
 	 * is finalized */
 	__sync_synchronize();
 	s_comm->connected = true;
+	nccl_ofi_startup_end(NCCL_OFI_STARTUP_CONNECT_RESP, s_comm->conn_stage_begin);
 
 	return ret;
 }
 
 #define __compiler_barrier() do { asm volatile ("" : : : "memory"); } while(0)
 
+/*
+ * @brief	Log summary of latency histogram, if it has samples
+ */
+static void log_histogram(nccl_net_ofi_comm_t *comm, uint32_t comm_id, const char *name,
+			  int rail_id, const nccl_ofi_histogram_t *histogram)
+{
+	char summary[128];
+
+	if (nccl_ofi_histogram_count(histogram) == 0)
+		return;
+
+	nccl_ofi_histogram_format(histogram, summary, sizeof(summary));
+	if (rail_id < 0) {
+		NCCL_OFI_INFO(NCCL_NET, "Latency (us) of dev %d %s comm %u: %s %s",
+			      comm->dev_id, comm->type == NCCL_NET_OFI_SEND_COMM ? "send" : "recv",
+			      comm_id, name, summary);
+	} else {
+		NCCL_OFI_INFO(NCCL_NET, "Latency (us) of dev %d %s comm %u rail %d: %s %s",
+			      comm->dev_id, comm->type == NCCL_NET_OFI_SEND_COMM ? "send" : "recv",
+			      comm_id, rail_id, name, summary);
+	}
+}
+
+/*
+ * @brief	Log latency histograms of send or receive communicator
+ */
+static void log_comm_histograms(nccl_net_ofi_comm_t *comm)
+{
+	if (comm->type == NCCL_NET_OFI_SEND_COMM) {
+		nccl_net_ofi_rdma_send_comm_t *s_comm = (nccl_net_ofi_rdma_send_comm_t *)comm;
+
+		log_histogram(comm, s_comm->local_comm_id, "send", -1, &s_comm->send_hist);
+		log_histogram(comm, s_comm->local_comm_id, "ctrl", -1, &s_comm->ctrl_hist);
+		for (int rail_id = 0; rail_id < s_comm->num_rails; rail_id++) {
+			log_histogram(comm, s_comm->local_comm_id, "write", rail_id,
+				      &s_comm->rails[rail_id].write_hist);
+		}
+	} else if (comm->type == NCCL_NET_OFI_RECV_COMM) {
+		nccl_net_ofi_rdma_recv_comm_t *r_comm = (nccl_net_ofi_rdma_recv_comm_t *)comm;
+
+		log_histogram(comm, r_comm->local_comm_id, "recv", -1, &r_comm->recv_hist);
+		log_histogram(comm, r_comm->local_comm_id, "flush", -1, &r_comm->flush_hist);
+	}
+}
+
+/*
+ * @brief	Log phase breakdown of each size class of send or receive
+ *		communicator that has requests
+ */
+static void log_comm_breakdown(nccl_net_ofi_comm_t *comm)
+{
+	const nccl_ofi_breakdown_t *breakdown;
+	uint32_t comm_id;
+	char summary[160];
+
+	if (comm->type == NCCL_NET_OFI_SEND_COMM) {
+		nccl_net_ofi_rdma_send_comm_t *s_comm = (nccl_net_ofi_rdma_send_comm_t *)comm;
+		breakdown = &s_comm->send_breakdown;
+		comm_id = s_comm->local_comm_id;
+	} else if (comm->type == NCCL_NET_OFI_RECV_COMM) {
+		nccl_net_ofi_rdma_recv_comm_t *r_comm = (nccl_net_ofi_rdma_recv_comm_t *)comm;
+		breakdown = &r_comm->recv_breakdown;
+		comm_id = r_comm->local_comm_id;
+	} else {
+		return;
+	}
+
+	for (int size_class = 0; size_class < NCCL_OFI_BREAKDOWN_SIZES; size_class++) {
+		size_t max_size = nccl_ofi_breakdown_size_class_max(size_class);
+
+		if (__atomic_load_n(&breakdown->sizes[size_class].count, __ATOMIC_RELAXED) == 0)
+			continue;
+
+		nccl_ofi_breakdown_format(&breakdown->sizes[size_class], summary, sizeof(summary));
+		if (max_size == SIZE_MAX) {
+			NCCL_OFI_INFO(NCCL_NET, "Phases (us) of dev %d %s comm %u size >%zuKiB: %s",
+				      comm->dev_id, comm->type == NCCL_NET_OFI_SEND_COMM ? "send" : "recv",
+				      comm_id, nccl_ofi_breakdown_size_class_max(size_class - 1) >> 10,
+				      summary);
+		} else {
+			NCCL_OFI_INFO(NCCL_NET, "Phases (us) of dev %d %s comm %u size <=%zuKiB: %s",
+				      comm->dev_id, comm->type == NCCL_NET_OFI_SEND_COMM ? "send" : "recv",
+				      comm_id, max_size >> 10, summary);
+		}
+	}
+}
+
+/*
+ * @brief	Log latency histograms and phase breakdowns of
+ *		communicator if a dump was requested by signal since the
+ *		last check
+ */
+static inline void check_histogram_dump(nccl_net_ofi_comm_t *comm)
+{
+	unsigned int requests = nccl_ofi_histogram_dump_requests();
+	unsigned int *dumps = (comm->type == NCCL_NET_OFI_SEND_COMM)
+			      ? &((nccl_net_ofi_rdma_send_comm_t *)comm)->hist_dumps
+			      : &((nccl_net_ofi_rdma_recv_comm_t *)comm)->hist_dumps;
+
+	if (OFI_LIKELY(*dumps == requests))
+		return;
+
+	*dumps = requests;
+	if (latency_histograms)
+		log_comm_histograms(comm);
+	if (phase_breakdown)
+		log_comm_breakdown(comm);
+}
+
+/*
+ * @brief	Log rail counters of device
+ */
+static void log_rail_counters(nccl_net_ofi_rdma_device_t *device)
+{
+	for (int rail_id = 0; rail_id < device->num_rails; rail_id++) {
+		nccl_ofi_rail_counters_t counters;
+
+		nccl_ofi_get_rail_counters(device->base.dev_id, rail_id, &counters);
+		NCCL_OFI_INFO(NCCL_NET, "Counters of dev %d rail %d: tx %" PRIu64 " ops %" PRIu64 " B, "
+			      "rx %" PRIu64 " ops %" PRIu64 " B, ctrl tx %" PRIu64 " rx %" PRIu64 ", "
+			      "eager tx %" PRIu64 " rx %" PRIu64 ", eagain %" PRIu64 ", errors %" PRIu64 ", "
+			      "bounce reposts %" PRIu64,
+			      device->base.dev_id, rail_id,
+			      counters.tx_ops, counters.tx_bytes, counters.rx_ops, counters.rx_bytes,
+			      counters.ctrl_sent, counters.ctrl_recv, counters.eager_sent,
+			      counters.eager_recv, counters.eagain, counters.err_completions,
+			      counters.bounce_reposts);
+	}
+}
+
+/*
+ * @brief	Log rail counters of device if the logging interval elapsed
+ *		since the last log line
+ *
+ * Only the thread that advances the time of the next log line logs.
+ */
+static inline void check_rail_counters_log(nccl_net_ofi_rdma_device_t *device)
+{
+	uint64_t now = nccl_ofi_timestamp_ns();
+	uint64_t next = __atomic_load_n(&device->next_counters_log, __ATOMIC_RELAXED);
+
+	if (OFI_LIKELY(now < next))
+		return;
+
+	if (!__atomic_compare_exchange_n(&device->next_counters_log, &next,
+					 now + rail_counters_interval, false,
+					 __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		return;
+
+	/* The first check only starts the interval */
+	if (next != 0)
+		log_rail_counters(device);
+}
+
+/*
+ * @brief	Update telemetry records of endpoint and of the rails of its
+ *		device
+ */
+static void publish_ep_telemetry(nccl_net_ofi_rdma_ep_t *ep)
+{
+	nccl_net_ofi_rdma_device_t *device = (nccl_net_ofi_rdma_device_t *)ep->base.device;
+	nccl_ofi_telemetry_segment_t *segment = nccl_ofi_telemetry_get();
+	nccl_ofi_telemetry_ep_t *record = ep->telemetry;
+
+	if (record && nccl_ofi_telemetry_write_begin(&record->seq)) {
+		record->num_rails = ep->num_rails;
+		record->pending_reqs = __atomic_load_n(&ep->num_pending_reqs, __ATOMIC_RELAXED);
+		record->pending_max = __atomic_load_n(&ep->max_pending_reqs, __ATOMIC_RELAXED);
+		for (int rail_id = 0; rail_id < ep->num_rails; rail_id++) {
+			record->bounce_posted[rail_id] = get_rail(ep, rail_id)->num_bounce_posted;
+		}
+		record->bounce_fl_entries = ep->bounce_buff_fl->num_allocated_entries;
+		record->bounce_reqs_fl_entries = ep->bounce_buff_reqs_fl->num_allocated_entries;
+		nccl_ofi_telemetry_write_end(&record->seq);
+	}
+
+	for (int rail_id = 0; rail_id < device->num_rails; rail_id++) {
+		nccl_ofi_telemetry_rail_t *rail_record = &segment->rails[device->base.dev_id][rail_id];
+
+		/* Another endpoint of the device is updating the record */
+		if (!nccl_ofi_telemetry_write_begin(&rail_record->seq))
+			continue;
+		nccl_ofi_get_rail_counters(device->base.dev_id, rail_id, &rail_record->counters);
+		nccl_ofi_telemetry_write_end(&rail_record->seq);
+	}
+
+	nccl_ofi_telemetry_touch();
+}
+
+/*
+ * @brief	Update telemetry record of send or receive communicator
+ */
+static void publish_comm_telemetry(nccl_net_ofi_comm_t *comm, nccl_ofi_telemetry_comm_t *record)
+{
+	if (!nccl_ofi_telemetry_write_begin(&record->seq))
+		return;
+
+	if (comm->type == NCCL_NET_OFI_SEND_COMM) {
+		nccl_net_ofi_rdma_send_comm_t *s_comm = (nccl_net_ofi_rdma_send_comm_t *)comm;
+
+		record->inflight_reqs = s_comm->num_inflight_reqs;
+		record->reqs_fl_entries = s_comm->nccl_ofi_reqs_fl->num_allocated_entries;
+		nccl_ofi_histogram_snapshot(&s_comm->send_hist, &record->req_hist);
+		nccl_ofi_histogram_snapshot(&s_comm->ctrl_hist, &record->wait_hist);
+		for (int rail_id = 0; rail_id < s_comm->num_rails; rail_id++) {
+			nccl_ofi_histogram_snapshot(&s_comm->rails[rail_id].write_hist,
+						    &record->rail_hist[rail_id]);
+		}
+	} else {
+		nccl_net_ofi_rdma_recv_comm_t *r_comm = (nccl_net_ofi_rdma_recv_comm_t *)comm;
+
+		record->inflight_reqs = r_comm->num_inflight_reqs;
+		record->reqs_fl_entries = r_comm->nccl_ofi_reqs_fl->num_allocated_entries;
+		nccl_ofi_histogram_snapshot(&r_comm->recv_hist, &record->req_hist);
+		nccl_ofi_histogram_snapshot(&r_comm->flush_hist, &record->wait_hist);
+	}
+
+	nccl_ofi_telemetry_write_end(&record->seq);
+}
+
+/*
+ * @brief	Update telemetry records of endpoint and communicator if the
+ *		update interval elapsed since their last update
+ *
+ * Records are reserved on the first update. An endpoint or communicator
+ * without record when all records are in use is not published.
+ */
+static void check_telemetry_publish(nccl_net_ofi_rdma_ep_t *ep, nccl_net_ofi_comm_t *comm)
+{
+	uint64_t now = nccl_ofi_timestamp_ns();
+	nccl_ofi_telemetry_comm_t **comm_record;
+	uint64_t *comm_next;
+
+	if (comm->type == NCCL_NET_OFI_SEND_COMM) {
+		nccl_net_ofi_rdma_send_comm_t *s_comm = (nccl_net_ofi_rdma_send_comm_t *)comm;
+		comm_record = &s_comm->telemetry;
+		comm_next = &s_comm->next_telemetry;
+	} else {
+		nccl_net_ofi_rdma_recv_comm_t *r_comm = (nccl_net_ofi_rdma_recv_comm_t *)comm;
+		comm_record = &r_comm->telemetry;
+		comm_next = &r_comm->next_telemetry;
+	}
+
+	if (now >= ep->next_telemetry) {
+		if (ep->next_telemetry == 0)
+			ep->telemetry = nccl_ofi_telemetry_alloc_ep(comm->dev_id);
+		ep->next_telemetry = now + telemetry_interval;
+		publish_ep_telemetry(ep);
+	}
+
+	if (now >= *comm_next) {
+		if (*comm_next == 0) {
+			uint32_t comm_id = (comm->type == NCCL_NET_OFI_SEND_COMM)
+				? ((nccl_net_ofi_rdma_send_comm_t *)comm)->local_comm_id
+				: ((nccl_net_ofi_rdma_recv_comm_t *)comm)->local_comm_id;
+			*comm_record = nccl_ofi_telemetry_alloc_comm(comm->dev_id,
+					(comm->type == NCCL_NET_OFI_SEND_COMM)
+					? NCCL_OFI_TELEMETRY_SEND_COMM : NCCL_OFI_TELEMETRY_RECV_COMM,
+					comm_id);
+		}
+		*comm_next = now + telemetry_interval;
+		if (*comm_record)
+			publish_comm_telemetry(comm, *comm_record);
+	}
+}
+
+/* State of a check for hanging requests of a communicator */
+typedef struct {
+	nccl_net_ofi_comm_t *comm;
+	uint64_t now;
+	/* Number of hanging requests */
+	int num_hanging;
+	/* Log messages of the communicator */
+	bool log;
+} hang_check_t;
+
+/*
+ * @brief	True if request has been outstanding for longer than the hang
+ *		timeout
+ */
+static inline bool is_req_hanging(nccl_net_ofi_rdma_req_t *req, uint64_t now)
+{
+	return req->post_time != 0 && req->state != NCCL_OFI_RDMA_REQ_COMPLETED &&
+		now - req->post_time >= hang_timeout;
+}
+
+/*
+ * @brief	Format events of send, receive or flush request into `buf`,
+ *		marking the events that have not arrived yet as MISSING
+ */
+static void format_req_events(nccl_net_ofi_rdma_req_t *req, char *buf, size_t len)
+{
+	if (req->type == NCCL_OFI_RDMA_SEND) {
+		rdma_req_send_data_t *send_data = get_send_data(req);
+		int num_segms = send_data->schedule->num_xfer_infos;
+		/* The control message is counted as a completion unless it
+		 * arrived before the send was posted */
+		int ctrl_compls = send_data->ctrl_recv ? send_data->total_num_compls - num_segms : 0;
+
+		snprintf(buf, len, "ctrl from receiver %s, segments posted %" PRIu64 "/%d, completed %d/%d%s",
+			 send_data->ctrl_recv ? "received" : "MISSING",
+			 send_data->xferred_rail_id, num_segms,
+			 req->ncompls - ctrl_compls, num_segms,
+			 req->ncompls - ctrl_compls < num_segms ? " (MISSING)" : "");
+	} else if (req->type == NCCL_OFI_RDMA_RECV) {
+		rdma_req_recv_data_t *recv_data = get_recv_data(req);
+		nccl_net_ofi_rdma_req_t *send_ctrl_req = recv_data->send_ctrl_req;
+		int written;
+
+		written = snprintf(buf, len, "ctrl to sender %s",
+				   send_ctrl_req->state == NCCL_OFI_RDMA_REQ_COMPLETED ? "completed"
+				   : send_ctrl_req->state == NCCL_OFI_RDMA_REQ_PENDING ? "posted, completion MISSING"
+				   : "not posted (MISSING)");
+		if (written < 0 || (size_t)written >= len)
+			return;
+
+		if (recv_data->eager_copy_req) {
+			snprintf(buf + written, len - written, ", eager copy %s",
+				 recv_data->eager_copy_req->state == NCCL_OFI_RDMA_REQ_COMPLETED
+				 ? "completed" : "completion MISSING");
+		} else {
+			nccl_net_ofi_rdma_req_t *recv_segms_req = recv_data->recv_segms_req;
+
+			snprintf(buf + written, len - written, ", segments %s (%d arrived)",
+				 recv_segms_req->state == NCCL_OFI_RDMA_REQ_COMPLETED
+				 ? "completed" : "MISSING", recv_segms_req->ncompls);
+		}
+	} else if (req->type == NCCL_OFI_RDMA_FLUSH) {
+		snprintf(buf, len, "flush read completion MISSING");
+	} else {
+		buf[0] = '\0';
+	}
+}
+
+/*
+ * @brief	Log request of communicator, with its missing events if it
+ *		is hanging
+ */
+static void log_comm_req(const char *where, nccl_net_ofi_rdma_req_t *req, uint64_t now)
+{
+	char events[192];
+
+	if (!is_req_hanging(req, now)) {
+		NCCL_OFI_WARN("  %s msg %hu: %s req %p %s, outstanding", where, req->msg_seq_num,
+			      req_type_str(req->type), req, req_state_str(req->state));
+		return;
+	}
+
+	format_req_events(req, events, sizeof(events));
+	NCCL_OFI_WARN("  %s msg %hu: %s req %p %s, size %zu, HANGING for %.1f s: %s", where,
+		      req->msg_seq_num, req_type_str(req->type), req, req_state_str(req->state),
+		      req->size, (double)(now - req->post_time) * 1e-9, events);
+}
+
+/*
+ * @brief	Count or log message of message buffer of communicator
+ */
+static void hang_check_msg(uint16_t msg_index, nccl_ofi_msgbuff_status_t stat,
+			   nccl_ofi_msgbuff_elemtype_t type, void *elem, void *arg)
+{
+	hang_check_t *check = arg;
+
+	if (stat != NCCL_OFI_MSGBUFF_INPROGRESS) {
+		if (check->log)
+			NCCL_OFI_WARN("  msgbuff msg %hu: %s", msg_index,
+				      stat == NCCL_OFI_MSGBUFF_COMPLETED ? "completed" : "not posted");
+		return;
+	}
+
+	if (type == NCCL_OFI_MSGBUFF_BUFF) {
+		/* A message of the peer arrived before its local request
+		 * was posted */
+		if (check->log)
+			NCCL_OFI_WARN("  msgbuff msg %hu: %s message received, %s not posted",
+				      msg_index,
+				      check->comm->type == NCCL_NET_OFI_SEND_COMM ? "ctrl" : "eager",
+				      check->comm->type == NCCL_NET_OFI_SEND_COMM ? "send" : "receive");
+		return;
+	}
+
+	if (check->log)
+		log_comm_req("msgbuff", elem, check->now);
+	else if (is_req_hanging(elem, check->now))
+		check->num_hanging++;
+}
+
+/*
+ * @brief	Log request of pending requests queue if it belongs to the
+ *		communicator
+ */
+static void hang_check_pending(nccl_ofi_deque_elem_t *deque_elem, void *arg)
+{
+	hang_check_t *check = arg;
+	nccl_net_ofi_rdma_req_t *req = container_of(deque_elem, nccl_net_ofi_rdma_req_t,
+						    pending_reqs_elem);
+
+	if (req->comm == check->comm) {
+		NCCL_OFI_WARN("  pending %s req %p %s, msg %hu", req_type_str(req->type), req,
+			      req_state_str(req->state), req->msg_seq_num);
+	}
+}
+
+/*
+ * @brief	Format string address of peer of communicator rail into `buf`
+ */
+static const char *peer_addr_str(nccl_net_ofi_ep_rail_t *rail, fi_addr_t addr, char *buf, size_t len)
+{
+	char name[MAX_EP_ADDR];
+	size_t name_len = sizeof(name);
+
+	if (fi_av_lookup(rail->av, addr, name, &name_len) != 0 || name_len > sizeof(name)) {
+		snprintf(buf, len, "unknown");
+		return buf;
+	}
+	return fi_av_straddr(rail->av, name, buf, &len);
+}
+
+/*
+ * @brief	Traffic matrix entry of remote endpoint, whose address is
+ *		`addr` in the address vector of the first rail of `ep`
+ *
+ * @return	Entry, or NULL if the traffic matrix is disabled
+ */
+static nccl_ofi_traffic_peer_t *get_traffic_peer(nccl_net_ofi_rdma_ep_t *ep, fi_addr_t addr)
+{
+	char peer[NCCL_OFI_TRAFFIC_ADDR_LEN];
+
+	if (!ep->traffic)
+		return NULL;
+
+	return nccl_ofi_traffic_get_peer(ep->traffic, addr,
+					 peer_addr_str(get_rail(ep, 0), addr, peer, sizeof(peer)));
+}
+
+/*
+ * @brief	Report hanging requests of communicator with the messages of
+ *		its message buffer and its pending requests
+ *
+ * The check runs at most once per hang timeout and communicator, so that
+ * a request is reported within twice the timeout. The flight recorder is
+ * dumped along with the report.
+ */
+static void check_hang(nccl_net_ofi_rdma_ep_t *ep, nccl_net_ofi_comm_t *comm,
+		       nccl_net_ofi_rdma_req_t *req)
+{
+	hang_check_t check = { .comm = comm, .now = nccl_ofi_timestamp_ns(), .num_hanging = 0,
+			       .log = false };
+	nccl_ofi_msgbuff_t *msgbuff;
+	uint64_t *next_check;
+	uint32_t local_comm_id, remote_comm_id;
+	uint64_t num_inflight_reqs;
+	fi_addr_t remote_addr;
+	uint16_t first, next;
+	char peer[128];
+
+	if (comm->type == NCCL_NET_OFI_SEND_COMM) {
+		nccl_net_ofi_rdma_send_comm_t *s_comm = (nccl_net_ofi_rdma_send_comm_t *)comm;
+		next_check = &s_comm->next_hang_check;
+		msgbuff = s_comm->msgbuff;
+		local_comm_id = s_comm->local_comm_id;
+		remote_comm_id = s_comm->remote_comm_id;
+		num_inflight_reqs = s_comm->num_inflight_reqs;
+		remote_addr = s_comm->rails[0].remote_addr;
+	} else {
+		nccl_net_ofi_rdma_recv_comm_t *r_comm = (nccl_net_ofi_rdma_recv_comm_t *)comm;
+		next_check = &r_comm->next_hang_check;
+		msgbuff = r_comm->msgbuff;
+		local_comm_id = r_comm->local_comm_id;
+		remote_comm_id = r_comm->remote_comm_id;
+		num_inflight_reqs = r_comm->num_inflight_reqs;
+		remote_addr = r_comm->rails[0].remote_addr;
+	}
+
+	if (OFI_LIKELY(check.now < *next_check))
+		return;
+	*next_check = check.now + hang_timeout;
+
+	/* Flush requests are not tracked by the message buffer */
+	if (req->type == NCCL_OFI_RDMA_FLUSH && is_req_hanging(req, check.now))
+		check.num_hanging++;
+	nccl_ofi_msgbuff_for_each(msgbuff, hang_check_msg, &check, NULL, NULL);
+	if (check.num_hanging == 0)
+		return;
+
+	NCCL_OFI_WARN("%d requests of %s comm %u on dev %d outstanding for more than %" PRIu64 " s: "
+		      "remote comm %u, peer fi_addr %" PRIu64 " (%s), %" PRIu64 " inflight requests",
+		      check.num_hanging, comm->type == NCCL_NET_OFI_SEND_COMM ? "send" : "recv",
+		      local_comm_id, comm->dev_id, hang_timeout / 1000000000ULL,
+		      remote_comm_id, (uint64_t)remote_addr,
+		      peer_addr_str(get_rail(ep, 0), remote_addr, peer, sizeof(peer)),
+		      num_inflight_reqs);
+
+	check.log = true;
+	if (req->type == NCCL_OFI_RDMA_FLUSH)
+		log_comm_req("flush", req, check.now);
+	nccl_ofi_msgbuff_for_each(msgbuff, hang_check_msg, &check, &first, &next);
+	NCCL_OFI_WARN("  msgbuff msgs %hu to %hu outstanding, %zu requests pending on endpoint",
+		      first, next, __atomic_load_n(&ep->num_pending_reqs, __ATOMIC_RELAXED));
+	nccl_ofi_deque_for_each(ep->pending_reqs_queue, hang_check_pending, &check);
+
+	dump_flight_recorder();
+}
+
 static int test(nccl_net_ofi_req_t *base_req, int *done, int *size)
 {
 	int ret = 0;
@@ -2252,6 +3080,17 @@ static int test(nccl_net_ofi_req_t *base_req, int *done, int *size)
 	nccl_net_ofi_rdma_ep_t *ep = (nccl_net_ofi_rdma_ep_t *)base_comm->ep;
 	assert(ep != NULL);
 
+	if (latency_histograms || phase_breakdown)
+		check_histogram_dump(base_comm);
+	if (rail_counters_interval)
+		check_rail_counters_log((nccl_net_ofi_rdma_device_t *)ep->base.device);
+	if (telemetry_interval)
+		check_telemetry_publish(ep, base_comm);
+	if (OFI_UNLIKELY(nccl_ofi_tracer_enabled))
+		nccl_ofi_tracer_check_signal();
+	if (hang_timeout)
+		check_hang(ep, base_comm, req);
+
 	/* Process more completions unless the current request is
 	 * completed */
 	if (req->state != NCCL_OFI_RDMA_REQ_COMPLETED
@@ -2459,6 +3298,7 @@ static int reg_mr_ep(nccl_net_ofi_rdma_ep_t *ep, void *data,
 	}
 
 	/* Register memory on each rail */
+	uint64_t begin = nccl_ofi_startup_begin();
 	ret_handle->num_rails = num_rails;
 	for (int rail_id = 0; rail_id != num_rails; ++rail_id) {
 		nccl_net_ofi_rdma_device_rail_t *dev_rail = get_device_rail(device, rail_id);
@@ -2474,6 +3314,8 @@ static int reg_mr_ep(nccl_net_ofi_rdma_ep_t *ep, void *data,
 			break;
 		}
 	}
+	if (ret == 0)
+		nccl_ofi_startup_end(NCCL_OFI_STARTUP_MR_REG, begin);
 
  exit:
 	*mhandle = ret_handle;
@@ -3009,6 +3851,12 @@ static int recv(nccl_net_ofi_recv_comm_t *recv_comm, int n, void **buffers,
 		goto error;
 	}
 
+	if (latency_histograms || hang_timeout || phase_breakdown)
+		req->post_time = nccl_ofi_timestamp_ns();
+	/* Receives do not wait for a control message */
+	if (phase_breakdown)
+		req->ready_time = req->post_time;
+
 	rdma_req_recv_data_t *recv_data = get_recv_data(req);
 
 	if (eager) {
@@ -3041,7 +3889,7 @@ static int recv(nccl_net_ofi_recv_comm_t *recv_comm, int n, void **buffers,
 	/* At this point, we've successfully inserted a new request, so update the num inflight. */
 	(r_comm->num_inflight_reqs)++;
 
-	NCCL_OFI_TRACE_RECV(dev_id, r_comm->local_comm_id, sizes[0], req, base_req);
+	NCCL_OFI_TRACE_RECV(dev_id, r_comm->local_comm_id, r_comm, sizes[0], req, base_req);
 
 	ret = receive_progress(recv_data->send_ctrl_req, true);
 	if (OFI_UNLIKELY(ret != 0)) {
@@ -3203,6 +4051,14 @@ static int recv_close(nccl_net_ofi_recv_comm_t *recv_comm)
 		goto exit;
 	}
 
+	if (latency_histograms)
+		log_comm_histograms(&r_comm->base.base);
+	if (phase_breakdown)
+		log_comm_breakdown(&r_comm->base.base);
+
+	if (r_comm->telemetry)
+		nccl_ofi_telemetry_release(&r_comm->telemetry->seq, &r_comm->telemetry->in_use);
+
 	if (is_flush_buff_enabled()) {
 		ret = dealloc_and_dereg_flush_buff(r_comm, device);
 		if (ret != 0) {
@@ -3360,7 +4216,10 @@ static int flush(nccl_net_ofi_recv_comm_t *recv_comm, int n, void **buffers,
 		goto error;
 	}
 
-	NCCL_OFI_TRACE_FLUSH(req, base_req);
+	if (latency_histograms || hang_timeout)
+		req->post_time = nccl_ofi_timestamp_ns();
+
+	NCCL_OFI_TRACE_FLUSH(req->dev_id, r_comm, req, base_req);
 
 	if (!network_busy) {
 		rc = receive_progress(req, true);
@@ -3376,6 +4235,7 @@ static int flush(nccl_net_ofi_recv_comm_t *recv_comm, int n, void **buffers,
 			NCCL_OFI_WARN("Failed to nccl_ofi_deque_insert_back: %d", ret);
 			goto error;
 		}
+		count_pending_insert(ep);
 		NCCL_OFI_TRACE_PENDING_INSERT(req);
 	}
 
@@ -3507,6 +4367,7 @@ static nccl_net_ofi_rdma_recv_comm_t *prepare_recv_comm(nccl_net_ofi_rdma_device
 			goto error;
 		}
 	}
+	r_comm->traffic_peer = get_traffic_peer(ep, r_comm->rails[0].remote_addr);
 
 	/* Allocate request freelist */
 	/* Maximum freelist entries is 4*NCCL_OFI_MAX_REQUESTS because each receive request
@@ -3643,6 +4504,8 @@ static int post_send_conn_resp(nccl_net_ofi_rdma_recv_comm_t *r_comm,
 	req->state = NCCL_OFI_RDMA_REQ_PENDING;
 	rc = fi_send(comm_rail->local_ep, (void *)conn_resp, sizeof(nccl_ofi_rdma_connection_info_t), NULL,
 		     comm_rail->remote_addr, req);
+	count_post(ep, 0, rc, sizeof(nccl_ofi_rdma_connection_info_t));
+	flight_record(ep, NCCL_OFI_FLIGHT_POST, 0, req, rc, sizeof(nccl_ofi_rdma_connection_info_t));
 
 	if (rc == -FI_EAGAIN) {
 		req->state = NCCL_OFI_RDMA_REQ_CREATED;
@@ -3734,6 +4597,7 @@ static int accept(nccl_net_ofi_listen_comm_t *listen_comm,
 	case COMM_CREATE_START:
 		/* COMM_CREATE_START:Allocate data required for the accept function */
 
+		l_comm->stage_begin = nccl_ofi_startup_begin();
 		l_comm->stage = COMM_RECV_CONN;
 
 	case COMM_RECV_CONN:
@@ -3779,7 +4643,10 @@ static int accept(nccl_net_ofi_listen_comm_t *listen_comm,
 			goto exit;
 		}
 
+		nccl_ofi_startup_end(NCCL_OFI_STARTUP_ACCEPT_WAIT, l_comm->stage_begin);
+
 		/* Prepare receive communicator object for the received peer connection */
+		l_comm->stage_begin = nccl_ofi_startup_begin();
 		r_comm = prepare_recv_comm(device, ep, conn_msg);
 		if (OFI_UNLIKELY(r_comm == NULL)) {
 			ret = -EINVAL;
@@ -3790,6 +4657,8 @@ static int accept(nccl_net_ofi_listen_comm_t *listen_comm,
 		/* Reset request state for connect response message */
 		prepare_send_conn_resp_req(l_comm);
 
+		nccl_ofi_startup_end(NCCL_OFI_STARTUP_ACCEPT_CREATE, l_comm->stage_begin);
+		l_comm->stage_begin = nccl_ofi_startup_begin();
 		l_comm->stage = COMM_SEND_CONN;
 
 	case COMM_SEND_CONN:
@@ -3866,6 +4735,7 @@ static int accept(nccl_net_ofi_listen_comm_t *listen_comm,
 		 * deallocates the receive communicator */
 		l_comm->r_comm = NULL;
 
+		nccl_ofi_startup_end(NCCL_OFI_STARTUP_ACCEPT_RESP, l_comm->stage_begin);
 		l_comm->stage = COMM_CONNECTED;
 
 		break;
@@ -4054,6 +4924,7 @@ static int alloc_rdma_send_req(nccl_net_ofi_rdma_send_comm_t *s_comm,
 	assert((!eager) || (send_data->schedule->num_xfer_infos == 1));
 	/* Set expected number of completions. If ctrl msg is outsanding then add one more. */
 	send_data->total_num_compls = (have_ctrl ? 0 : 1) + send_data->schedule->num_xfer_infos;
+	send_data->ctrl_recv = have_ctrl;
 
 	send_data->wdata = GET_RDMA_WRITE_IMM_DATA(s_comm->remote_comm_id,
 						   req->msg_seq_num,
@@ -4118,18 +4989,24 @@ static int post_rdma_write(nccl_net_ofi_rdma_req_t *req,
 	void *desc = fi_mr_desc(rail_mr_handle);
 
 	ssize_t rc;
+
 	/* Post RDMA write */
 	rc = fi_writedata(comm_rail->local_ep, send_data->buff + xfer_info->offset,
 				xfer_info->msg_size, desc, send_data->wdata,
 				comm_rail->remote_addr,
 				send_data->remote_buff + xfer_info->offset,
 				send_data->remote_mr_key[rail_id], req);
+	count_post((nccl_net_ofi_rdma_ep_t *)req->comm->ep, rail_id, rc, xfer_info->msg_size);
+	flight_record((nccl_net_ofi_rdma_ep_t *)req->comm->ep, NCCL_OFI_FLIGHT_POST, rail_id, req,
+		      rc, xfer_info->msg_size);
 
 	if ((rc != 0) && (rc != -FI_EAGAIN)) {
 		NCCL_OFI_WARN("fi_writedata failed; RC: %zd, Error: %s",
 			      rc, fi_strerror(-rc));
 	} else if (rc == 0) {
 		NCCL_OFI_TRACE_SEND_WRITE_SEG_START(req->dev_id, rail_id, xfer_info->msg_size, req->comm, req->msg_seq_num, req);
+		if (phase_breakdown)
+			set_phase_time(&req->xfer_time);
 	}
 
 	return rc;
@@ -4146,15 +5023,24 @@ static int post_rdma_eager_send(nccl_net_ofi_rdma_req_t *req,
 	void *desc = fi_mr_desc(rail_mr_handle);
 
 	ssize_t rc;
+
 	/* Post eager send */
 	rc = fi_senddata(comm_rail->local_ep, send_data->buff + xfer_info->offset, xfer_info->msg_size, desc,
 			 send_data->wdata, comm_rail->remote_addr, req);
+	count_post((nccl_net_ofi_rdma_ep_t *)req->comm->ep, rail_id, rc, xfer_info->msg_size);
+	if (rc == 0)
+		counter_add(&get_rail_counters((nccl_net_ofi_rdma_ep_t *)req->comm->ep,
+					       rail_id)->eager_sent, 1);
+	flight_record((nccl_net_ofi_rdma_ep_t *)req->comm->ep, NCCL_OFI_FLIGHT_POST, rail_id, req,
+		      rc, xfer_info->msg_size);
 
 	if ((rc != 0) && (rc != -FI_EAGAIN)) {
 		NCCL_OFI_WARN("fi_senddata failed; RC: %zd, Error: %s", rc, fi_strerror(-rc));
 	} else if (rc == 0) {
 		/* TODO: use a better trace for eager send? */
 		NCCL_OFI_TRACE_SEND_WRITE_SEG_START(req->dev_id, rail_id, xfer_info->msg_size, req->comm, req->msg_seq_num, req);
+		if (phase_breakdown)
+			set_phase_time(&req->xfer_time);
 	}
 
 	return rc;
@@ -4178,6 +5064,14 @@ static int post_bounce_buffer(nccl_net_ofi_rdma_req_t *req,
 	req->state = NCCL_OFI_RDMA_REQ_CREATED;
 	ssize_t rc =
 		fi_recv(ep_rail->ofi_ep, &bounce_fl_item->bounce_msg, bounce_data->buff_len, desc, FI_ADDR_UNSPEC, req);
+	NCCL_OFI_TRACE_BOUNCE_POST(ep_rail->rail_id, req, bounce_data->buff_len, rc);
+	if (rc == -FI_EAGAIN)
+		count_eagain(ep, ep_rail->rail_id);
+	/* Successful posts follow each receive completion, so that only
+	 * failed posts are recorded */
+	if (rc != 0)
+		flight_record(ep, NCCL_OFI_FLIGHT_POST, ep_rail->rail_id, req, rc,
+			      bounce_data->buff_len);
 	if ((rc != 0) && (rc != -FI_EAGAIN)) {
 		NCCL_OFI_WARN("Error posting bounce buffer. RC: %zd, Error: %s",
 			      rc, fi_strerror(-rc));
@@ -4205,6 +5099,8 @@ static int send_progress(nccl_net_ofi_rdma_req_t *req)
 
 	if (req->type == NCCL_OFI_RDMA_SEND) { // Post RDMA write
 		rdma_req_send_data_t *send_data = get_send_data(req);
+		/* Segments posted by one call share their post time */
+		uint64_t xfer_post_time = latency_histograms ? nccl_ofi_timestamp_ns() : 0;
 
 		// Get Schedule
 		nccl_net_ofi_schedule_t *schedule = send_data->schedule;
@@ -4225,6 +5121,7 @@ static int send_progress(nccl_net_ofi_rdma_req_t *req)
 			nccl_net_ofi_rdma_send_comm_rail_t *comm_rail =
 				get_send_comm_rail(s_comm, xfer_info->rail_id);
 
+			send_data->xfer_post_time[xfer_info->rail_id] = xfer_post_time;
 			ret = post_rdma_eager_send(req, comm_rail, xfer_info);
 		} else {
 			for (int rail_it = send_data->xferred_rail_id;
@@ -4235,6 +5132,7 @@ static int send_progress(nccl_net_ofi_rdma_req_t *req)
 				nccl_net_ofi_rdma_send_comm_rail_t *comm_rail =
 					get_send_comm_rail(s_comm, xfer_info->rail_id);
 
+				send_data->xfer_post_time[xfer_info->rail_id] = xfer_post_time;
 				ret = post_rdma_write(req, comm_rail, xfer_info);
 
 				if (ret == 0) // Successfully sent the xfer with this rail
@@ -4284,10 +5182,19 @@ static int post_rdma_ctrl(nccl_net_ofi_rdma_req_t *req)
 
 	ssize_t rc = fi_send(comm_rail->local_ep, &ctrl_fl_item->ctrl_msg, sizeof(nccl_net_ofi_rdma_ctrl_msg_t), desc,
 			     comm_rail->remote_addr, req);
+	count_post((nccl_net_ofi_rdma_ep_t *)r_comm->base.base.ep, xfer_info->rail_id, rc,
+		   sizeof(nccl_net_ofi_rdma_ctrl_msg_t));
+	if (rc == 0)
+		counter_add(&get_rail_counters((nccl_net_ofi_rdma_ep_t *)r_comm->base.base.ep,
+					       xfer_info->rail_id)->ctrl_sent, 1);
+	flight_record((nccl_net_ofi_rdma_ep_t *)r_comm->base.base.ep, NCCL_OFI_FLIGHT_POST,
+		      xfer_info->rail_id, req, rc, sizeof(nccl_net_ofi_rdma_ctrl_msg_t));
 
 	if ((rc != 0) && (rc != -FI_EAGAIN)) {
 		NCCL_OFI_WARN("Error posting RDMA ctrl request. RC: %zd, Error: %s",
 			      rc, fi_strerror(-rc));
+	} else if (rc == 0 && phase_breakdown) {
+		set_phase_time(&send_ctrl_data->recv_req->xfer_time);
 	}
 
 	return rc;
@@ -4331,6 +5238,13 @@ static int post_eager_copy(nccl_net_ofi_rdma_req_t *req)
 	ssize_t rc = fi_read(comm_rail->local_ep, recv_data->dst_buff,
 			     bounce_data->recv_len, desc, comm_rail->local_addr,
 			     (uint64_t)bounce_buff, bounce_key, req);
+	if (rc == -FI_EAGAIN)
+		count_eagain((nccl_net_ofi_rdma_ep_t *)r_comm->base.base.ep, bounce_rail_id);
+	flight_record((nccl_net_ofi_rdma_ep_t *)r_comm->base.base.ep, NCCL_OFI_FLIGHT_POST,
+		      bounce_rail_id, req, rc, bounce_data->recv_len);
+	/* The eager data arrived, and its last phase is the local copy */
+	if (rc == 0 && phase_breakdown)
+		set_phase_time(&eager_copy_data->recv_req->first_compl_time);
 
 	if ((rc != 0) && (rc != -FI_EAGAIN)) {
 		NCCL_OFI_WARN("Error posting RDMA ctrl request. RC: %zd, Error: %s",
@@ -4378,6 +5292,10 @@ static int post_flush_req(nccl_net_ofi_rdma_req_t *req)
 			     xfer_info->msg_size, desc, comm_rail->local_addr,
 			     (uint64_t)(virt_addr_mr ? flush_data->data : 0),
 			     cuda_key, req);
+	if (rc == -FI_EAGAIN)
+		count_eagain((nccl_net_ofi_rdma_ep_t *)r_comm->base.base.ep, xfer_info->rail_id);
+	flight_record((nccl_net_ofi_rdma_ep_t *)r_comm->base.base.ep, NCCL_OFI_FLIGHT_POST,
+		      xfer_info->rail_id, req, rc, xfer_info->msg_size);
 	if ((rc != 0) && (rc != -FI_EAGAIN)) {
 		NCCL_OFI_WARN("Error posting flush request. RC: %zd, Error: %s",
 			      rc, fi_strerror(-rc));
@@ -4422,6 +5340,7 @@ static inline int check_post_bounce_req(nccl_net_ofi_rdma_req_t *bounce_req)
 				NCCL_OFI_WARN("Failed to nccl_ofi_deque_insert_back: %d", ret);
 				return ret;
 			}
+			count_pending_insert(ep);
 			NCCL_OFI_TRACE_PENDING_INSERT(bounce_req);
 			return ret;
 		} else if (OFI_UNLIKELY(ret != 0)) {
@@ -4562,6 +5481,15 @@ static int send(nccl_net_ofi_send_comm_t *send_comm, void *data, int size, int t
 		goto error;
 	}
 
+	if (latency_histograms || hang_timeout || phase_breakdown)
+		req->post_time = nccl_ofi_timestamp_ns();
+	/* The control message arrived before the send */
+	if (latency_histograms && have_ctrl)
+		nccl_ofi_histogram_record(&s_comm->ctrl_hist, 0);
+	/* Eager sends do not wait for the control message */
+	if (phase_breakdown && (have_ctrl || eager))
+		req->ready_time = req->post_time;
+
 	if (have_ctrl) {
 		/*
 		 * For already received RDMA control message, populate
@@ -4601,6 +5529,7 @@ static int send(nccl_net_ofi_send_comm_t *send_comm, void *data, int size, int t
 				NCCL_OFI_WARN("Failed to nccl_ofi_deque_insert_back: %d", ret);
 				goto error;
 			}
+			count_pending_insert(ep);
 			NCCL_OFI_TRACE_PENDING_INSERT(req);
 		} else if (OFI_UNLIKELY(ret != 0)) {
 			/* TODO: Remove req from message buffer */
@@ -4636,6 +5565,14 @@ static int send_close(nccl_net_ofi_rdma_send_comm_t *s_comm)
 		goto exit;
 	}
 
+	if (latency_histograms)
+		log_comm_histograms(&s_comm->base.base);
+	if (phase_breakdown)
+		log_comm_breakdown(&s_comm->base.base);
+
+	if (s_comm->telemetry)
+		nccl_ofi_telemetry_release(&s_comm->telemetry->seq, &s_comm->telemetry->in_use);
+
 	/* Release connect response request if available */
 	if (s_comm->conn_resp_req) {
 		nccl_net_ofi_rdma_req_t *req = s_comm->conn_resp_req;
@@ -4943,6 +5880,7 @@ static inline int create_send_comm(nccl_net_ofi_conn_handle_t *handle,
 
 	/* Store remote address of first rail in communicator */
 	ret_s_comm->rails[0].remote_addr = remote_addr;
+	ret_s_comm->traffic_peer = get_traffic_peer(ep, remote_addr);
 
 	/* Store local libfabric endpoint of first rail */
 	ret_s_comm->rails[0].local_ep = first_rail->ofi_ep;
@@ -5064,6 +6002,8 @@ static int post_send_conn(nccl_net_ofi_rdma_send_comm_t *s_comm,
 	 */
 	rc = fi_send(comm_rail->local_ep, (void *)&s_comm->conn_msg, sizeof(nccl_ofi_rdma_connection_info_t), NULL,
 		     comm_rail->remote_addr, req);
+	count_post(ep, 0, rc, sizeof(nccl_ofi_rdma_connection_info_t));
+	flight_record(ep, NCCL_OFI_FLIGHT_POST, 0, req, rc, sizeof(nccl_ofi_rdma_connection_info_t));
 
 	if (rc == -FI_EAGAIN) {
 		/*
@@ -5145,6 +6085,7 @@ static int connect(nccl_net_ofi_ep_t *base_ep,
 		assert(s_comm == NULL);
 
 		/* Build send communicator with one comm rail */
+		uint64_t create_begin = nccl_ofi_startup_begin();
 		ret = create_send_comm(handle, ep, &s_comm);
 		if (OFI_UNLIKELY(ret != 0)) {
 			return ret;
@@ -5159,6 +6100,8 @@ static int connect(nccl_net_ofi_ep_t *base_ep,
 		}
 		comm_state->req = &req->base;
 
+		nccl_ofi_startup_end(NCCL_OFI_STARTUP_CONNECT_CREATE, create_begin);
+		s_comm->conn_stage_begin = nccl_ofi_startup_begin();
 		comm_state->stage = COMM_SEND_CONN;
 
 	case COMM_SEND_CONN:
@@ -5220,6 +6163,8 @@ static int connect(nccl_net_ofi_ep_t *base_ep,
 		comm_state->req = NULL;
 		req = NULL;
 
+		nccl_ofi_startup_end(NCCL_OFI_STARTUP_CONNECT_SEND, s_comm->conn_stage_begin);
+		s_comm->conn_stage_begin = nccl_ofi_startup_begin();
 		comm_state->stage = COMM_RECV_CONN;
 
 	case COMM_RECV_CONN:
@@ -5431,6 +6376,22 @@ static int release_ep(nccl_net_ofi_ep_t *base_ep)
 		}
 		free(ep->rails);
 		ep->rails = NULL;
+
+		if (ep->telemetry) {
+			nccl_ofi_telemetry_release(&ep->telemetry->seq, &ep->telemetry->in_use);
+			ep->telemetry = NULL;
+		}
+		ep->next_telemetry = 0;
+
+		if (ep->flight_recorder) {
+			nccl_ofi_flight_recorder_release(ep->flight_recorder);
+			ep->flight_recorder = NULL;
+		}
+
+		/* The row is kept for the traffic matrix file, and a new
+		 * one is allocated with the new address vector of the
+		 * endpoint */
+		ep->traffic = NULL;
 	}
 
  unlock:
@@ -5444,6 +6405,50 @@ static int release_ep(nccl_net_ofi_ep_t *base_ep)
 	return ret;
 }
 
+/*
+ * @brief	Calibrate rails of device
+ *
+ * Called on the first endpoint creation of the device with `ep_lock`
+ * held, so that no communicator uses the scheduler of the device yet.
+ * Unless OFI_NCCL_ROUND_ROBIN_THRESHOLD is set, the round robin
+ * threshold of the scheduler is derived from the calibration results.
+ * Results of the first device are provided to the tuner. Calibration
+ * failures are not fatal; the configured threshold is kept.
+ */
+static void calibrate_device(nccl_net_ofi_rdma_device_t *device)
+{
+	int ret;
+	size_t rr_threshold;
+	struct fi_info *infos[MAX_NUM_RAILS];
+	struct fid_domain *domains[MAX_NUM_RAILS];
+	nccl_ofi_calibration_t results[MAX_NUM_RAILS];
+
+	for (int rail_id = 0; rail_id < device->num_rails; ++rail_id) {
+		infos[rail_id] = device->device_rails[rail_id].info;
+		domains[rail_id] = device->device_rails[rail_id].domain;
+	}
+
+	ret = nccl_ofi_calibrate(infos, domains, device->num_rails, results);
+	if (ret != 0) {
+		NCCL_OFI_WARN("Calibration of device %d failed, keeping configured round robin threshold",
+			      device->base.dev_id);
+		return;
+	}
+
+	if (device->base.dev_id == 0) {
+		nccl_ofi_calibration_export(results, device->num_rails);
+	}
+
+	if (getenv("OFI_NCCL_ROUND_ROBIN_THRESHOLD") == NULL && device->num_rails > 1) {
+		rr_threshold = nccl_ofi_calibration_rr_threshold(results, device->num_rails,
+								 eager_max_size);
+		nccl_net_ofi_threshold_scheduler_set_threshold(device->scheduler, rr_threshold);
+		NCCL_OFI_INFO(NCCL_INIT | NCCL_NET,
+			      "Using calibrated round robin threshold of %zu for device %d",
+			      rr_threshold, device->base.dev_id);
+	}
+}
+
 static int get_ep(nccl_net_ofi_device_t *base_dev,
 				    nccl_net_ofi_ep_t **base_ep)
 {
@@ -5461,6 +6466,13 @@ static int get_ep(nccl_net_ofi_device_t *base_dev,
 	/* Obtain lock */
 	pthread_mutex_lock(&device->ep_lock);
 
+	/* Calibrate rails on first use of the device. Other threads wait
+	 * for the calibration on the lock. */
+	if (ofi_nccl_calibrate() && !device->calibrated) {
+		calibrate_device(device);
+		device->calibrated = true;
+	}
+
 	/* Obtain thread-local rdma endpoint. Allocate and
 	 * initialize endpoint if necessary. */
 	nccl_net_ofi_rdma_ep_t *ep = pthread_getspecific(device->ep_key);
@@ -5537,11 +6549,25 @@ static int get_ep(nccl_net_ofi_device_t *base_dev,
 			goto unlock;
 		}
 
+		/* Record from the first posted bounce buffer on */
+		if (!ep->flight_recorder) {
+			ep->flight_recorder = nccl_ofi_flight_recorder_alloc(device->base.dev_id);
+		}
+
 		ret = init_rail_ofi_resources(device, ep);
 		if (ret != 0) {
 			goto unlock;
 		}
 
+		char local_addr[NCCL_OFI_TRAFFIC_ADDR_LEN];
+		size_t local_addr_len = sizeof(local_addr);
+		nccl_net_ofi_ep_rail_t *first_rail = get_rail(ep, 0);
+		ep->traffic = nccl_ofi_traffic_alloc(device->base.dev_id,
+						     fi_av_straddr(first_rail->av,
+								   first_rail->local_ep_name,
+								   local_addr, &local_addr_len));
+
+		uint64_t bounce_begin = nccl_ofi_startup_begin();
 		ret = init_bounce_buffers(ep);
 		if (ret != 0) {
 			NCCL_OFI_WARN("Preparation of bounce buffers failed");
@@ -5554,6 +6580,7 @@ static int get_ep(nccl_net_ofi_device_t *base_dev,
 			NCCL_OFI_WARN("Posting of bounce buffers failed!");
 			goto unlock;
 		}
+		nccl_ofi_startup_end(NCCL_OFI_STARTUP_BOUNCE_POST, bounce_begin);
 	}
 
 	ep->ref_cnt++;
@@ -5573,6 +6600,7 @@ static int get_ep(nccl_net_ofi_device_t *base_dev,
 static int init_device_rail_ofi_resources(nccl_net_ofi_rdma_device_rail_t *rail_dev)
 {
 	int ret = 0;
+	uint64_t begin = nccl_ofi_startup_begin();
 
 	/* Create fabric */
 	ret = fi_fabric(rail_dev->info->fabric_attr, &rail_dev->fabric, NULL);
@@ -5591,6 +6619,7 @@ static int init_device_rail_ofi_resources(nccl_net_ofi_rdma_device_rail_t *rail_
 		goto error;
 	}
 
+	nccl_ofi_startup_end(NCCL_OFI_STARTUP_DOMAIN, begin);
 	return ret;
  error:
 	if (rail_dev->domain) {
@@ -5726,6 +6755,20 @@ error:
 }
 
 
+/*
+ * @brief	Provide rail count and link speed of device to the tuner
+ */
+static void export_tuner_link(nccl_net_ofi_rdma_device_t *device)
+{
+	struct fi_info *infos[MAX_NUM_RAILS];
+
+	for (int rail_id = 0; rail_id < device->num_rails; ++rail_id) {
+		infos[rail_id] = device->device_rails[rail_id].info;
+	}
+
+	nccl_ofi_calibration_export_link(infos, device->num_rails);
+}
+
 static void get_hints(struct fi_info *hints)
 {
 	hints->caps = 0;
@@ -5762,6 +6805,64 @@ static void get_hints(struct fi_info *hints)
 	hints->domain_attr->data_progress = FI_PROGRESS_UNSPEC;
 }
 
+/*
+ * @brief	Return device of the RDMA plugin with index `dev_id`, or NULL
+ */
+static nccl_net_ofi_rdma_device_t *get_counters_device(int dev_id)
+{
+	if (dev_id < 0 || dev_id >= counters_plugin->num_devs) {
+		return NULL;
+	}
+	return (nccl_net_ofi_rdma_device_t *)counters_plugin->devs[dev_id];
+}
+
+int nccl_ofi_get_num_rails(int dev_id)
+{
+	nccl_net_ofi_rdma_device_t *device;
+
+	if (!counters_plugin) {
+		return -ENOTSUP;
+	}
+
+	device = get_counters_device(dev_id);
+	if (!device) {
+		return -EINVAL;
+	}
+
+	return device->num_rails;
+}
+
+int nccl_ofi_get_rail_counters(int dev_id, int rail_id, nccl_ofi_rail_counters_t *counters)
+{
+	nccl_net_ofi_rdma_device_t *device;
+	nccl_ofi_rail_counters_t *source;
+
+	if (!counters_plugin || !rail_counters) {
+		return -ENOTSUP;
+	}
+
+	device = get_counters_device(dev_id);
+	if (!device || rail_id < 0 || rail_id >= device->num_rails) {
+		return -EINVAL;
+	}
+
+	source = &get_device_rail(device, rail_id)->counters;
+	counters->tx_bytes = __atomic_load_n(&source->tx_bytes, __ATOMIC_RELAXED);
+	counters->tx_ops = __atomic_load_n(&source->tx_ops, __ATOMIC_RELAXED);
+	counters->rx_bytes = __atomic_load_n(&source->rx_bytes, __ATOMIC_RELAXED);
+	counters->rx_ops = __atomic_load_n(&source->rx_ops, __ATOMIC_RELAXED);
+	counters->eagain = __atomic_load_n(&source->eagain, __ATOMIC_RELAXED);
+	counters->err_completions = __atomic_load_n(&source->err_completions,
+						    __ATOMIC_RELAXED);
+	counters->bounce_reposts = __atomic_load_n(&source->bounce_reposts,
+						   __ATOMIC_RELAXED);
+	counters->ctrl_sent = __atomic_load_n(&source->ctrl_sent, __ATOMIC_RELAXED);
+	counters->ctrl_recv = __atomic_load_n(&source->ctrl_recv, __ATOMIC_RELAXED);
+	counters->eager_sent = __atomic_load_n(&source->eager_sent, __ATOMIC_RELAXED);
+	counters->eager_recv = __atomic_load_n(&source->eager_recv, __ATOMIC_RELAXED);
+
+	return 0;
+}
 
 int nccl_net_ofi_rdma_init(const char *provider_filter,
 			   nccl_net_ofi_plugin_t **plugin_p)
@@ -5823,6 +6924,26 @@ int nccl_net_ofi_rdma_init(const char *provider_filter,
 	}
 	eager_max_size = (size_t) ofi_nccl_eager_max_size();
 
+	latency_histograms = ofi_nccl_latency_histograms() != 0;
+	phase_breakdown = ofi_nccl_phase_breakdown() != 0;
+	if (latency_histograms || phase_breakdown) {
+		/* Histograms are still logged on close without the handler */
+		nccl_ofi_histogram_signal_init(ofi_nccl_latency_histogram_signal());
+	}
+
+	if (ofi_nccl_rail_counters_interval() > 0) {
+		rail_counters_interval = (uint64_t)ofi_nccl_rail_counters_interval() * 1000000000ULL;
+	}
+
+	if (ofi_nccl_hang_timeout() > 0) {
+		hang_timeout = (uint64_t)ofi_nccl_hang_timeout() * 1000000000ULL;
+	}
+
+	/* The flight recorder is optional, so a failure only disables it */
+	nccl_ofi_flight_recorder_init();
+	/* The traffic matrix is optional, so a failure only disables it */
+	nccl_ofi_traffic_init();
+
 	plugin = malloc(sizeof(nccl_net_ofi_plugin_t));
 	if (!plugin) {
 		NCCL_OFI_WARN("Unable to allocate nccl_net_ofi_plugin_t");
@@ -5831,6 +6952,7 @@ int nccl_net_ofi_rdma_init(const char *provider_filter,
 	}
 
 	/* Create NCCL OFI topology */
+	uint64_t topo_begin = nccl_ofi_startup_begin();
 	topo = nccl_ofi_topo_create(provider_list);
 	if (!topo) {
 		NCCL_OFI_WARN("Failed to create NCCL OFI topology");
@@ -5843,6 +6965,7 @@ int nccl_net_ofi_rdma_init(const char *provider_filter,
 		NCCL_OFI_WARN("Failed to group NICs");
 		goto error;
 	}
+	nccl_ofi_startup_end(NCCL_OFI_STARTUP_TOPO, topo_begin);
 
 	if (topo->max_group_size > MAX_NUM_RAILS) {
 		NCCL_OFI_WARN("Unexpected topo group size of %d (maximum %d)",
@@ -5992,9 +7115,27 @@ int nccl_net_ofi_rdma_init(const char *provider_filter,
 		}
 	}
 
+	/*
+	 * Provide rails and link speed of the first device to the tuner.
+	 * The tuner prefers calibration results over the link speed.
+	 */
+	export_tuner_link((nccl_net_ofi_rdma_device_t *)base_devs[0]);
+
+	counters_plugin = plugin;
+
+	/* Telemetry is optional, the plugin works without segment */
+	if (ofi_nccl_telemetry() &&
+	    nccl_ofi_telemetry_init(num_devs, topo->max_group_size) == 0) {
+		telemetry_interval = (uint64_t)NCCL_OFI_MAX(ofi_nccl_telemetry_interval_ms(), 1) * 1000000ULL;
+	}
+
+	/* The log lines and the telemetry segment read the rail counters */
+	rail_counters = ofi_nccl_rail_counters() || rail_counters_interval || telemetry_interval;
+
 	goto exit;
 
  error:
+	counters_plugin = NULL;
 	if (base_devs) {
 		for (nccl_net_ofi_device_t **base_dev = base_devs; base_dev != base_devs + num_devs; ++base_dev) {
 			nccl_net_ofi_rdma_device_t *device =
@@ -280,3 +280,12 @@ int nccl_net_ofi_threshold_scheduler_init(int num_rails,
 
 	return ret;
 }
+
+void nccl_net_ofi_threshold_scheduler_set_threshold(nccl_net_ofi_scheduler_t *scheduler_p,
+						    size_t rr_threshold)
+{
+	nccl_net_ofi_threshold_scheduler_t *scheduler =
+		(nccl_net_ofi_threshold_scheduler_t *)scheduler_p;
+
+	scheduler->rr_threshold = rr_threshold;
+}
@@ -20,6 +20,7 @@
 #include "nccl_ofi_ofiutils.h"
 #include "tracepoint.h"
 #include "nccl_ofi_math.h"
+#include "nccl_ofi_startup.h"
 
 
 static int selected_api_version = 0;
@@ -367,6 +368,9 @@ static int test(nccl_net_ofi_req_t *base_req, int *done, int *size)
 		goto exit;
 	}
 
+	if (OFI_UNLIKELY(nccl_ofi_tracer_enabled))
+		nccl_ofi_tracer_check_signal();
+
 	/* Process more completions unless the current request is completed */
 	if (req->state != NCCL_OFI_SENDRECV_REQ_COMPLETED) {
 		ret = ofi_process_cq(ep->cq, device->max_tag);
@@ -549,8 +553,10 @@ static int register_mr_buffers(struct fid_domain *domain, struct fid_ep *ep,
 		mr_attr.requested_key = (uint64_t)key;
 	}
 
+	uint64_t begin = nccl_ofi_startup_begin();
 	ret = fi_mr_regattr(domain,
 			   &mr_attr, 0, mr_handle);
+	nccl_ofi_startup_end(NCCL_OFI_STARTUP_MR_REG, begin);
 	if (OFI_UNLIKELY(ret != 0)) {
 		NCCL_OFI_WARN("Unable to register memory (type = %d) for device %d. RC: %d, Error: %s",
 			      type, dev_id, ret, fi_strerror(-ret));
@@ -854,7 +860,7 @@ static int recv(nccl_net_ofi_recv_comm_t *recv_comm, int n, void **buffers,
 			desc = fi_mr_desc(mr_handles[recv_n]);
 		}
 
-		NCCL_OFI_TRACE_RECV(dev_id, r_comm->tag, sizes[recv_n], req, base_req);
+		NCCL_OFI_TRACE_RECV(dev_id, r_comm->tag, r_comm, sizes[recv_n], req, base_req);
 
 		/*
 		 * TODO: Use NCCL provided tags when plugin supports grouped
@@ -1035,7 +1041,7 @@ static int flush(nccl_net_ofi_recv_comm_t *recv_comm, int n, void **buffers,
 		}
 	}
 
-	NCCL_OFI_TRACE_FLUSH(req, base_req);
+	NCCL_OFI_TRACE_FLUSH(req->dev_id, r_comm, req, base_req);
 
 	/* Issue RDMA read */
 	do {
@@ -2130,6 +2136,7 @@ static int device_prepare_for_connection(nccl_net_ofi_sendrecv_device_t *device)
 {
 	int ret = 0;
 	int ofi_tag_leading_zeroes = 0, ofi_tag_bits_for_ring_id = 64;
+	uint64_t begin = nccl_ofi_startup_begin();
 
 	/* Determine if any tag bits are used by provider */
 	while (!((device->info->ep_attr->mem_tag_format << ofi_tag_leading_zeroes++) &
@@ -2167,6 +2174,7 @@ static int device_prepare_for_connection(nccl_net_ofi_sendrecv_device_t *device)
 		goto error;
 	}
 
+	nccl_ofi_startup_end(NCCL_OFI_STARTUP_DOMAIN, begin);
 	return ret;
  error:
 	if (device->domain)
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+
+#include "nccl_ofi_log.h"
+#include "nccl_ofi_signal.h"
+
+unsigned int nccl_ofi_signal_counts[NCCL_OFI_SIGNAL_NUM_CONSUMERS];
+
+/* Handlers of consumers, set before the consumer is added to a mask */
+static nccl_ofi_signal_handler_fn_t handlers[NCCL_OFI_SIGNAL_NUM_CONSUMERS];
+
+/* Mask of consumers registered for each signal, 0 if the dispatcher of
+ * the signal is not installed */
+static unsigned int consumers[NSIG];
+
+/* Action of each signal before its dispatcher was installed */
+static struct sigaction prev_actions[NSIG];
+
+/* Serializes registrations */
+static pthread_mutex_t register_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * @brief	Notify consumers of signal, then chain to its previous action
+ */
+static void dispatch(int signum, siginfo_t *info, void *context)
+{
+	unsigned int mask = __atomic_load_n(&consumers[signum], __ATOMIC_ACQUIRE);
+	struct sigaction *prev = &prev_actions[signum];
+	int saved_errno = errno;
+
+	for (int consumer = 0; consumer < NCCL_OFI_SIGNAL_NUM_CONSUMERS; consumer++) {
+		if (!(mask & (1U << consumer))) {
+			continue;
+		}
+		__atomic_fetch_add(&nccl_ofi_signal_counts[consumer], 1, __ATOMIC_RELAXED);
+		if (handlers[consumer]) {
+			handlers[consumer](signum);
+		}
+	}
+	errno = saved_errno;
+
+	if (prev->sa_flags & SA_SIGINFO) {
+		prev->sa_sigaction(signum, info, context);
+	} else if (prev->sa_handler != SIG_DFL && prev->sa_handler != SIG_IGN) {
+		prev->sa_handler(signum);
+	} else if (prev->sa_handler == SIG_DFL && signum == SIGABRT) {
+		/* SIGABRT is blocked in the dispatcher, so that it is
+		 * delivered to the default action once the dispatcher
+		 * returns */
+		sigaction(SIGABRT, prev, NULL);
+		raise(SIGABRT);
+	}
+}
+
+int nccl_ofi_signal_register(int signum, enum nccl_ofi_signal_consumer consumer,
+			     nccl_ofi_signal_handler_fn_t handler)
+{
+	struct sigaction action;
+	int ret = 0;
+
+	if (signum <= 0 || signum >= NSIG) {
+		NCCL_OFI_WARN("Invalid dump signal %d", signum);
+		return -EINVAL;
+	}
+
+	pthread_mutex_lock(&register_lock);
+
+	handlers[consumer] = handler;
+
+	if (consumers[signum] != 0) {
+		__atomic_fetch_or(&consumers[signum], 1U << consumer, __ATOMIC_RELEASE);
+		goto exit;
+	}
+
+	__atomic_store_n(&consumers[signum], 1U << consumer, __ATOMIC_RELEASE);
+
+	memset(&action, 0, sizeof(action));
+	action.sa_sigaction = dispatch;
+	action.sa_flags = SA_SIGINFO | SA_RESTART;
+	sigemptyset(&action.sa_mask);
+
+	if (sigaction(signum, &action, &prev_actions[signum]) != 0) {
+		ret = -errno;
+		NCCL_OFI_WARN("Unable to install dispatcher of signal %d: %s",
+			      signum, strerror(-ret));
+		__atomic_store_n(&consumers[signum], 0, __ATOMIC_RELAXED);
+	}
+
+ exit:
+	pthread_mutex_unlock(&register_lock);
+	return ret;
+}
@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "nccl_ofi_log.h"
+#include "nccl_ofi_param.h"
+#include "nccl_ofi_startup.h"
+
+int nccl_ofi_startup_enabled = 0;
+
+static nccl_ofi_startup_stats_t phases[NCCL_OFI_STARTUP_NUM_PHASES];
+
+/* JSON file with the process ID substituted, empty if not written */
+static char profile_path[PATH_MAX];
+
+static const char *phase_names[NCCL_OFI_STARTUP_NUM_PHASES] = {
+	[NCCL_OFI_STARTUP_PLUGIN_INIT] = "plugin_init",
+	[NCCL_OFI_STARTUP_PROVIDERS] = "providers",
+	[NCCL_OFI_STARTUP_TOPO] = "topology",
+	[NCCL_OFI_STARTUP_DOMAIN] = "domain",
+	[NCCL_OFI_STARTUP_ENDPOINT] = "endpoint",
+	[NCCL_OFI_STARTUP_AV] = "av",
+	[NCCL_OFI_STARTUP_MR_REG] = "mr_reg",
+	[NCCL_OFI_STARTUP_BOUNCE_POST] = "bounce_post",
+	[NCCL_OFI_STARTUP_CONNECT_CREATE] = "connect_create",
+	[NCCL_OFI_STARTUP_CONNECT_SEND] = "connect_send",
+	[NCCL_OFI_STARTUP_CONNECT_RESP] = "connect_resp",
+	[NCCL_OFI_STARTUP_ACCEPT_WAIT] = "accept_wait",
+	[NCCL_OFI_STARTUP_ACCEPT_CREATE] = "accept_create",
+	[NCCL_OFI_STARTUP_ACCEPT_RESP] = "accept_resp",
+};
+
+const char *nccl_ofi_startup_phase_name(nccl_ofi_startup_phase_t phase)
+{
+	if ((unsigned int)phase >= NCCL_OFI_STARTUP_NUM_PHASES) {
+		return "unknown";
+	}
+	return phase_names[phase];
+}
+
+/*
+ * @brief	Atomically lower `value` to `min` if `min` is smaller or
+ *		`value` is unset
+ */
+static inline void atomic_min_nonzero(uint64_t *value, uint64_t min)
+{
+	uint64_t cur = __atomic_load_n(value, __ATOMIC_RELAXED);
+
+	while ((cur == 0 || min < cur) &&
+	       !__atomic_compare_exchange_n(value, &cur, min, true,
+					    __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+static inline void atomic_max(uint64_t *value, uint64_t max)
+{
+	uint64_t cur = __atomic_load_n(value, __ATOMIC_RELAXED);
+
+	while (max > cur &&
+	       !__atomic_compare_exchange_n(value, &cur, max, true,
+					    __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+void nccl_ofi_startup_end(nccl_ofi_startup_phase_t phase, uint64_t begin)
+{
+	nccl_ofi_startup_stats_t *stats = &phases[phase];
+	uint64_t end;
+
+	if (begin == 0) {
+		return;
+	}
+
+	end = nccl_ofi_timestamp_ns();
+	__atomic_fetch_add(&stats->count, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&stats->total_ns, end - begin, __ATOMIC_RELAXED);
+	atomic_max(&stats->max_ns, end - begin);
+	atomic_min_nonzero(&stats->first_begin, begin);
+	atomic_max(&stats->last_end, end);
+}
+
+void nccl_ofi_startup_snapshot(nccl_ofi_startup_stats_t *stats)
+{
+	for (int i = 0; i < NCCL_OFI_STARTUP_NUM_PHASES; i++) {
+		stats[i].count = __atomic_load_n(&phases[i].count, __ATOMIC_RELAXED);
+		stats[i].total_ns = __atomic_load_n(&phases[i].total_ns, __ATOMIC_RELAXED);
+		stats[i].max_ns = __atomic_load_n(&phases[i].max_ns, __ATOMIC_RELAXED);
+		stats[i].first_begin = __atomic_load_n(&phases[i].first_begin, __ATOMIC_RELAXED);
+		stats[i].last_end = __atomic_load_n(&phases[i].last_end, __ATOMIC_RELAXED);
+	}
+}
+
+static inline double ns_to_ms(uint64_t ns)
+{
+	return (double)ns * 1e-6;
+}
+
+/*
+ * @brief	Write statistics of phases to JSON file
+ *
+ * Times are in ms, and the beginning of each phase is relative to the
+ * beginning of the plugin initialization.
+ */
+static int write_json(const char *path, const nccl_ofi_startup_stats_t *stats)
+{
+	uint64_t origin = stats[NCCL_OFI_STARTUP_PLUGIN_INIT].first_begin;
+	char tmp_path[PATH_MAX + 8];
+	bool first = true;
+	FILE *file;
+	int ret;
+
+	/* Replace the file atomically, so that readers never see a
+	 * partial profile */
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	file = fopen(tmp_path, "w");
+	if (!file) {
+		ret = -errno;
+		NCCL_OFI_WARN("Unable to open startup profile %s: %s", tmp_path, strerror(-ret));
+		return ret;
+	}
+
+	fprintf(file, "{\"pid\":%d,\"phases\":{", (int)getpid());
+	for (int i = 0; i < NCCL_OFI_STARTUP_NUM_PHASES; i++) {
+		if (stats[i].count == 0) {
+			continue;
+		}
+		fprintf(file, "%s\n\"%s\":{\"count\":%" PRIu64 ",\"total_ms\":%.3f,"
+			"\"max_ms\":%.3f,\"wall_ms\":%.3f,\"begin_ms\":%.3f}",
+			first ? "" : ",", phase_names[i], stats[i].count,
+			ns_to_ms(stats[i].total_ns), ns_to_ms(stats[i].max_ns),
+			ns_to_ms(stats[i].last_end - stats[i].first_begin),
+			origin ? ns_to_ms(stats[i].first_begin - origin) : 0.0);
+		first = false;
+	}
+	fprintf(file, "\n}}\n");
+
+	if (fclose(file) != 0) {
+		ret = -errno;
+		NCCL_OFI_WARN("Unable to write startup profile %s: %s", tmp_path, strerror(-ret));
+		unlink(tmp_path);
+		return ret;
+	}
+	if (rename(tmp_path, path) != 0) {
+		ret = -errno;
+		NCCL_OFI_WARN("Unable to rename startup profile %s to %s: %s",
+			      tmp_path, path, strerror(-ret));
+		unlink(tmp_path);
+		return ret;
+	}
+
+	return 0;
+}
+
+int nccl_ofi_startup_report(void)
+{
+	nccl_ofi_startup_stats_t stats[NCCL_OFI_STARTUP_NUM_PHASES];
+
+	if (!nccl_ofi_startup_enabled) {
+		return 0;
+	}
+
+	nccl_ofi_startup_snapshot(stats);
+
+	NCCL_OFI_INFO(NCCL_INIT, "Startup profile of process %d:", (int)getpid());
+	for (int i = 0; i < NCCL_OFI_STARTUP_NUM_PHASES; i++) {
+		if (stats[i].count == 0) {
+			continue;
+		}
+		NCCL_OFI_INFO(NCCL_INIT, "  %-15s %6" PRIu64 " times, total %10.3f ms, "
+			      "max %9.3f ms, wall %10.3f ms",
+			      phase_names[i], stats[i].count, ns_to_ms(stats[i].total_ns),
+			      ns_to_ms(stats[i].max_ns),
+			      ns_to_ms(stats[i].last_end - stats[i].first_begin));
+	}
+
+	if (profile_path[0] == '\0') {
+		return 0;
+	}
+	return write_json(profile_path, stats);
+}
+
+static void report_at_exit(void)
+{
+	nccl_ofi_startup_report();
+}
+
+/*
+ * @brief	Copy profile file to profile_path, replacing "%p" with the
+ *		process ID
+ */
+static int expand_profile_path(const char *file)
+{
+	size_t len = 0;
+
+	for (const char *c = file; *c; c++) {
+		int written;
+
+		if (c[0] == '%' && c[1] == 'p') {
+			written = snprintf(&profile_path[len], sizeof(profile_path) - len, "%d",
+					   (int)getpid());
+			c++;
+		} else {
+			written = snprintf(&profile_path[len], sizeof(profile_path) - len, "%c", *c);
+		}
+		if (written < 0 || (size_t)written >= sizeof(profile_path) - len) {
+			profile_path[0] = '\0';
+			return -ENAMETOOLONG;
+		}
+		len += written;
+	}
+
+	return 0;
+}
+
+int nccl_ofi_startup_init(void)
+{
+	const char *file = ofi_nccl_startup_profile_file();
+	int ret;
+
+	if (nccl_ofi_startup_enabled || !ofi_nccl_startup_profile()) {
+		return 0;
+	}
+
+	if (file && file[0] != '\0') {
+		ret = expand_profile_path(file);
+		if (ret != 0) {
+			NCCL_OFI_WARN("Startup profile file name %s is too long", file);
+			return ret;
+		}
+	}
+
+	atexit(report_at_exit);
+	__atomic_store_n(&nccl_ofi_startup_enabled, 1, __ATOMIC_RELEASE);
+
+	NCCL_OFI_INFO(NCCL_INIT, "Profiling startup phases%s%s",
+		      profile_path[0] ? ", written to " : "", profile_path);
+
+	return 0;
+}
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "nccl_ofi_log.h"
+#include "nccl_ofi_telemetry.h"
+
+/* Segment of the process, NULL if not created */
+static nccl_ofi_telemetry_segment_t *segment = NULL;
+
+/* Path of the segment of the process */
+static char segment_path[PATH_MAX];
+
+_Static_assert(sizeof(nccl_ofi_telemetry_segment_t) <= UINT32_MAX,
+	       "Telemetry segment size does not fit the size field");
+
+/*
+ * @brief	Remove segment of the process at exit
+ */
+static void remove_segment(void)
+{
+	unlink(segment_path);
+}
+
+int nccl_ofi_telemetry_init(int num_devs, int num_rails)
+{
+	int fd;
+	int ret = 0;
+	void *addr;
+
+	if (segment) {
+		return 0;
+	}
+
+	if (num_devs > NCCL_OFI_TELEMETRY_MAX_DEVS || num_rails > NCCL_OFI_TELEMETRY_MAX_RAILS) {
+		NCCL_OFI_WARN("Telemetry segment supports up to %d devices of %d rails, not %d devices of %d rails",
+			      NCCL_OFI_TELEMETRY_MAX_DEVS, NCCL_OFI_TELEMETRY_MAX_RAILS,
+			      num_devs, num_rails);
+		return -EINVAL;
+	}
+
+	snprintf(segment_path, sizeof(segment_path), "%s%d",
+		 NCCL_OFI_TELEMETRY_PATH_PREFIX, (int)getpid());
+
+	/*
+	 * Remove the segment of an earlier process with the same PID, and
+	 * create a new one, so that a file that another user placed at the
+	 * path, e.g. a symbolic link, is never written
+	 */
+	if (unlink(segment_path) != 0 && errno != ENOENT) {
+		ret = -errno;
+		NCCL_OFI_WARN("Unable to remove stale telemetry segment %s: %s",
+			      segment_path, strerror(-ret));
+		return ret;
+	}
+	fd = open(segment_path, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW, 0600);
+	if (fd < 0) {
+		ret = -errno;
+		NCCL_OFI_WARN("Unable to create telemetry segment %s: %s",
+			      segment_path, strerror(-ret));
+		return ret;
+	}
+
+	if (ftruncate(fd, sizeof(nccl_ofi_telemetry_segment_t)) != 0) {
+		ret = -errno;
+		NCCL_OFI_WARN("Unable to size telemetry segment %s: %s",
+			      segment_path, strerror(-ret));
+		goto error;
+	}
+
+	addr = mmap(NULL, sizeof(nccl_ofi_telemetry_segment_t), PROT_READ | PROT_WRITE,
+		    MAP_SHARED, fd, 0);
+	if (addr == MAP_FAILED) {
+		ret = -errno;
+		NCCL_OFI_WARN("Unable to map telemetry segment %s: %s",
+			      segment_path, strerror(-ret));
+		goto error;
+	}
+	close(fd);
+
+	segment = addr;
+	segment->version = NCCL_OFI_TELEMETRY_VERSION;
+	segment->size = sizeof(nccl_ofi_telemetry_segment_t);
+	segment->pid = (int32_t)getpid();
+	segment->num_devs = num_devs;
+	segment->num_rails = num_rails;
+	segment->max_eps = NCCL_OFI_TELEMETRY_MAX_EPS;
+	segment->max_comms = NCCL_OFI_TELEMETRY_MAX_COMMS;
+	/* Readers may use the segment once the magic is set */
+	__atomic_store_n(&segment->magic, NCCL_OFI_TELEMETRY_MAGIC, __ATOMIC_RELEASE);
+
+	atexit(remove_segment);
+
+	NCCL_OFI_INFO(NCCL_INIT | NCCL_NET, "Publishing telemetry in %s", segment_path);
+
+	return 0;
+
+ error:
+	close(fd);
+	unlink(segment_path);
+	return ret;
+}
+
+nccl_ofi_telemetry_segment_t *nccl_ofi_telemetry_get(void)
+{
+	return segment;
+}
+
+/*
+ * @brief	Reserve record of array with in-use flags at `in_use_offset`
+ *
+ * @return	Index of record, or -1 if all records are in use
+ */
+static int reserve_record(void *records, size_t record_size, size_t in_use_offset, int num_records)
+{
+	for (int i = 0; i < num_records; i++) {
+		uint32_t *in_use = (uint32_t *)((char *)records + i * record_size + in_use_offset);
+		uint32_t expected = 0;
+
+		if (__atomic_load_n(in_use, __ATOMIC_RELAXED) == 0 &&
+		    __atomic_compare_exchange_n(in_use, &expected, 1, false,
+						__ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/*
+ * @brief	Start update of a record that the caller owns, waiting for
+ *		a concurrent update of another thread to finish
+ */
+static void write_begin_owned(uint64_t *seq)
+{
+	while (!nccl_ofi_telemetry_write_begin(seq)) {
+		/* Another thread is updating the record */
+	}
+}
+
+nccl_ofi_telemetry_ep_t *nccl_ofi_telemetry_alloc_ep(int dev_id)
+{
+	nccl_ofi_telemetry_ep_t *record;
+	int index;
+
+	if (!segment) {
+		return NULL;
+	}
+
+	index = reserve_record(segment->eps, sizeof(segment->eps[0]),
+			       offsetof(nccl_ofi_telemetry_ep_t, in_use), NCCL_OFI_TELEMETRY_MAX_EPS);
+	if (index < 0) {
+		NCCL_OFI_INFO(NCCL_NET, "All %d endpoint records of the telemetry segment are in use",
+			      NCCL_OFI_TELEMETRY_MAX_EPS);
+		return NULL;
+	}
+
+	record = &segment->eps[index];
+	write_begin_owned(&record->seq);
+	memset((char *)record + offsetof(nccl_ofi_telemetry_ep_t, dev_id), 0,
+	       sizeof(*record) - offsetof(nccl_ofi_telemetry_ep_t, dev_id));
+	record->dev_id = dev_id;
+	nccl_ofi_telemetry_write_end(&record->seq);
+
+	return record;
+}
+
+nccl_ofi_telemetry_comm_t *nccl_ofi_telemetry_alloc_comm(int dev_id, uint32_t type,
+							 uint32_t comm_id)
+{
+	nccl_ofi_telemetry_comm_t *record;
+	int index;
+
+	if (!segment) {
+		return NULL;
+	}
+
+	index = reserve_record(segment->comms, sizeof(segment->comms[0]),
+			       offsetof(nccl_ofi_telemetry_comm_t, in_use), NCCL_OFI_TELEMETRY_MAX_COMMS);
+	if (index < 0) {
+		NCCL_OFI_INFO(NCCL_NET, "All %d communicator records of the telemetry segment are in use",
+			      NCCL_OFI_TELEMETRY_MAX_COMMS);
+		return NULL;
+	}
+
+	record = &segment->comms[index];
+	write_begin_owned(&record->seq);
+	memset((char *)record + offsetof(nccl_ofi_telemetry_comm_t, dev_id), 0,
+	       sizeof(*record) - offsetof(nccl_ofi_telemetry_comm_t, dev_id));
+	record->dev_id = dev_id;
+	record->type = type;
+	record->comm_id = comm_id;
+	nccl_ofi_telemetry_write_end(&record->seq);
+
+	return record;
+}
+
+void nccl_ofi_telemetry_release(uint64_t *seq, uint32_t *in_use)
+{
+	write_begin_owned(seq);
+	__atomic_store_n(in_use, 0, __ATOMIC_RELEASE);
+	nccl_ofi_telemetry_write_end(seq);
+}
+
+void nccl_ofi_telemetry_touch(void)
+{
+	if (segment) {
+		__atomic_store_n(&segment->update_ns, nccl_ofi_timestamp_ns(), __ATOMIC_RELAXED);
+	}
+}
@@ -33,9 +33,26 @@ static const unsigned short target_vendor_id = 0x1d0f;	/* Amazon */
 const char *speed_name = "max_link_speed";
 const char *width_name = "max_link_width";
 
+/* Directory that PCI device properties are read from */
+static const char *pci_sysfs_path = "/sys/bus/pci/devices";
+
 /* `pcie_gen[i]` defines the speed of a PCIe lane of PCIe generation `i+1` */
 const char *pcie_gen[] = {"2.5", "5", "8", "16", "32", "64"};
 
+/* Fraction of the bandwidth of a NIC that accounts towards an
+ * accelerator, depending on the locality of both devices. See
+ * get_locality_factor(). */
+#define LOCALITY_FACTOR_SAME_SWITCH 1.0
+#define LOCALITY_FACTOR_CROSS_SWITCH 0.5
+#define LOCALITY_FACTOR_CROSS_NUMA 0.25
+#define LOCALITY_FACTOR_CROSS_SOCKET 0.125
+
+/* Maximum number of improvement steps of the NIC assignment */
+#define MAX_ASSIGNMENT_STEPS 1024
+
+static int get_pci_device_min_speed(hwloc_obj_t node, bool is_nic, size_t *speed_idx,
+				    size_t *width);
+
 /*
  * @brief Create vector of nccl_ofi_topo_data_t structs
  *
@@ -550,7 +567,18 @@ static int set_user_data(nccl_ofi_topo_t *ofi_topo,
 	return 0;
 }
 
-nccl_ofi_topo_t *nccl_ofi_topo_create(struct fi_info *info_list)
+/*
+ * @brief	Allocate and initialize nccl_ofi_topo_t struct
+ *
+ * @param	info_list
+ *		List of libfabric NIC info structs
+ * @param	xml
+ *		Hwloc XML topology to load. If NULL, the topology of
+ *		the running system is discovered.
+ * @return	NCCL OFI hardware topology, on success
+ *		NULL, on others
+ */
+static nccl_ofi_topo_t *topo_create(struct fi_info *info_list, const char *xml)
 {
 	int ret = 0;
 
@@ -570,6 +598,12 @@ nccl_ofi_topo_t *nccl_ofi_topo_create(struct fi_info *info_list)
 		goto error;
 	}
 
+	if (xml && hwloc_topology_set_xmlbuffer(ofi_topo->topo, xml, strlen(xml) + 1) != 0) {
+		NCCL_OFI_WARN("Unable to set XML hardware topology. ERROR: %s",
+			      strerror(errno));
+		goto error;
+	}
+
 	/* Prepare hardware topology ready to load IO nodes as well */
 	enable_hwloc_io_types(ofi_topo->topo);
 	if (hwloc_topology_load(ofi_topo->topo) != 0) {
@@ -593,6 +627,21 @@ nccl_ofi_topo_t *nccl_ofi_topo_create(struct fi_info *info_list)
 	return NULL;
 }
 
+nccl_ofi_topo_t *nccl_ofi_topo_create(struct fi_info *info_list)
+{
+	return topo_create(info_list, NULL);
+}
+
+nccl_ofi_topo_t *nccl_ofi_topo_create_from_xml(struct fi_info *info_list, const char *xml)
+{
+	if (!xml) {
+		NCCL_OFI_WARN("Invalid XML hardware topology");
+		return NULL;
+	}
+
+	return topo_create(info_list, xml);
+}
+
 /*
  * @brief	Mark all topology nodes that store a libfabric NIC info
  *		struct in their subtrees
@@ -770,147 +819,559 @@ static int lift_up_ofi_infos(nccl_ofi_topo_t *topo)
 }
 
 /*
- * @brief	Split NIC info list into 'num_groups' and add each group to the
- *		topology node corresponding to its leader (first NIC of the list).
+ * @brief	NIC candidate of the cost-based NIC assignment
+ */
+typedef struct nic_candidate {
+	/* Libfabric NIC info struct */
+	struct fi_info *info;
+
+	/* Topology node of the NIC */
+	hwloc_obj_t node;
+
+	/* Bandwidth of the PCIe link of the NIC in GB/s */
+	double bw;
+
+	/* Index of the group the NIC is assigned to */
+	int group;
+
+	/* Whether the NIC has been added to the list of its group */
+	bool attached;
+} nic_candidate_t;
+
+/*
+ * @brief	NIC group of the cost-based NIC assignment
+ */
+typedef struct nic_group {
+	/* Accelerator topology node that the NICs of the group are
+	 * assigned to */
+	hwloc_obj_t accel;
+
+	/* Number of NICs in the group */
+	int size;
+} nic_group_t;
+
+/*
+ * @brief	Return the topology node that the group count of
+ *		accelerator topology node `accel_node` has been
+ *		propagated to
+ *
+ * @return	First topology node towards the root that has a
+ *		libfabric NIC info struct in its subtree, if found
+ *		NULL, otherwise
+ */
+static hwloc_obj_t get_accel_group_node(hwloc_obj_t accel_node)
+{
+	hwloc_obj_t node = accel_node;
+
+	while (node) {
+		nccl_ofi_topo_data_t *userdata = (nccl_ofi_topo_data_t *)node->userdata;
+		if (userdata && userdata->is_nic_subtree) {
+			return node;
+		}
+		node = node->parent;
+	}
+
+	return NULL;
+}
+
+/*
+ * @brief	Return bandwidth of the PCIe link of a NIC in GB/s
+ *
+ * If the topology describes the running system, the link speed and
+ * width are read from the file system, which yields the minimum of
+ * the NIC and its upstream port. Otherwise, e.g., for topologies
+ * loaded from XML, or if reading fails, the link speed reported by
+ * hwloc is used. If neither is available, all NICs are weighted
+ * equally.
  *
  * @param	topo
- *		The topology
- * @param	info_list
- *		Libfabric NIC info list
- * @param	num_infos
- *		Length of `info_list`
- * @param	gpu_group_node
- *		One GPU topology node that is the closest to the NICs in `info_list`
- * @param	num_group
- *		Number of groups to create
+ *		Hwloc topology
+ * @param	node
+ *		NIC topology node
+ */
+static double get_nic_bandwidth(hwloc_topology_t topo, hwloc_obj_t node)
+{
+	size_t speed_idx;
+	size_t width;
+
+	if (hwloc_topology_is_thissystem(topo) &&
+	    get_pci_device_min_speed(node, true, &speed_idx, &width) == 0) {
+		/* PCIe generations 1 and 2 use 8b/10b encoding, later
+		 * generations use 128b/130b encoding */
+		double encoding = (speed_idx < 2) ? (8.0 / 10.0) : (128.0 / 130.0);
+		return strtod(pcie_gen[speed_idx], NULL) * width * encoding / 8.0;
+	}
+
+	if (node->attr->pcidev.linkspeed > 0) {
+		return node->attr->pcidev.linkspeed;
+	}
+
+	return 1.0;
+}
+
+/*
+ * @brief	Return closest common ancestor of two topology nodes
+ *
+ * In contrast to hwloc_get_common_ancestor_obj(), this function also
+ * supports I/O topology nodes.
+ */
+static hwloc_obj_t get_common_ancestor(hwloc_obj_t node_a, hwloc_obj_t node_b)
+{
+	for (hwloc_obj_t a = node_a; a; a = a->parent) {
+		for (hwloc_obj_t b = node_b; b; b = b->parent) {
+			if (a == b) return a;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * @brief	Return package topology node of a non-I/O topology node
+ *
+ * @return	Package topology node, if `node` is a package or a descendant of a package
+ *		NULL, otherwise
+ */
+static hwloc_obj_t get_package(hwloc_obj_t node)
+{
+	while (node && node->type != HWLOC_OBJ_PACKAGE) {
+		node = node->parent;
+	}
+
+	return node;
+}
+
+/*
+ * @brief	Return the fraction of the NIC bandwidth that accounts
+ *		towards an accelerator
+ *
+ * Traffic between a NIC and an accelerator behind the same PCIe
+ * switch stays within the switch. Otherwise, the traffic crosses the
+ * root complex, and potentially the interconnect between NUMA nodes
+ * or sockets, which is penalized by a smaller locality factor.
+ *
+ * @param	topo
+ *		Hwloc topology
+ * @param	nic_node
+ *		NIC topology node
+ * @param	accel_node
+ *		Accelerator topology node
+ * @return	Locality factor in (0, 1]
+ */
+static double get_locality_factor(hwloc_topology_t topo,
+				  hwloc_obj_t nic_node,
+				  hwloc_obj_t accel_node)
+{
+	hwloc_obj_t common = get_common_ancestor(nic_node, accel_node);
+	if (common && common->type == HWLOC_OBJ_BRIDGE &&
+	    common->attr->bridge.upstream_type == HWLOC_OBJ_BRIDGE_PCI) {
+		return LOCALITY_FACTOR_SAME_SWITCH;
+	}
+
+	hwloc_obj_t nic_local = hwloc_get_non_io_ancestor_obj(topo, nic_node);
+	hwloc_obj_t accel_local = hwloc_get_non_io_ancestor_obj(topo, accel_node);
+	if (!nic_local || !accel_local || !nic_local->nodeset || !accel_local->nodeset ||
+	    hwloc_bitmap_isequal(nic_local->nodeset, accel_local->nodeset)) {
+		return LOCALITY_FACTOR_CROSS_SWITCH;
+	}
+
+	if (get_package(nic_local) == get_package(accel_local)) {
+		return LOCALITY_FACTOR_CROSS_NUMA;
+	}
+
+	return LOCALITY_FACTOR_CROSS_SOCKET;
+}
+
+/*
+ * @brief	Evaluate NIC assignment
+ *
+ * The effective bandwidth of a group is the sum of the bandwidths of
+ * its NICs, each scaled by the locality factor between the NIC and
+ * the accelerator of the group.
+ *
+ * @param	group_bw
+ *		Scratch array of `num_groups` elements
+ * @return	Minimum effective bandwidth of all groups
+ * @return	Sum of effective bandwidth of all groups
+ */
+static void eval_assignment(nic_candidate_t *nics, int num_nics,
+			    const double *factors, int num_groups,
+			    double *group_bw, double *min_bw, double *sum_bw)
+{
+	for (int group = 0; group < num_groups; ++group) {
+		group_bw[group] = 0.0;
+	}
+
+	for (int nic = 0; nic < num_nics; ++nic) {
+		int group = nics[nic].group;
+		group_bw[group] += nics[nic].bw * factors[nic * num_groups + group];
+	}
+
+	*min_bw = group_bw[0];
+	*sum_bw = 0.0;
+	for (int group = 0; group < num_groups; ++group) {
+		*min_bw = NCCL_OFI_MIN(*min_bw, group_bw[group]);
+		*sum_bw += group_bw[group];
+	}
+}
+
+/*
+ * @brief	Return whether an assignment with minimum and sum of
+ *		effective group bandwidth (`min_bw`, `sum_bw`) is
+ *		better than (`best_min_bw`, `best_sum_bw`)
+ *
+ * The minimum effective bandwidth is maximized first since the
+ * slowest accelerator bounds collective performance. Ties are broken
+ * by the sum of effective bandwidths, which prefers local NICs.
+ */
+static bool is_better_assignment(double min_bw, double sum_bw,
+				 double best_min_bw, double best_sum_bw)
+{
+	const double eps = 1e-9;
+
+	if (min_bw > best_min_bw + eps) return true;
+	if (min_bw < best_min_bw - eps) return false;
+	return sum_bw > best_sum_bw + eps;
+}
+
+/*
+ * @brief	Improve NIC assignment by local search
+ *
+ * Repeatedly swap two NICs of different groups, or move a NIC from a
+ * group to a group with one member less, as long as the assignment
+ * improves. Both operations preserve the multiset of group sizes,
+ * and thus, the number of rails per group.
+ */
+static void optimize_assignment(nic_candidate_t *nics, int num_nics,
+				nic_group_t *groups, int num_groups,
+				const double *factors, double *group_bw)
+{
+	double best_min_bw, best_sum_bw;
+	double min_bw, sum_bw;
+	bool improved = true;
+
+	eval_assignment(nics, num_nics, factors, num_groups, group_bw,
+			&best_min_bw, &best_sum_bw);
+
+	for (int step = 0; improved && step < MAX_ASSIGNMENT_STEPS; ++step) {
+		improved = false;
+
+		/* Swap NICs */
+		for (int i = 0; i < num_nics && !improved; ++i) {
+			for (int j = i + 1; j < num_nics && !improved; ++j) {
+				int group_i = nics[i].group;
+				int group_j = nics[j].group;
+				if (group_i == group_j) continue;
+
+				nics[i].group = group_j;
+				nics[j].group = group_i;
+				eval_assignment(nics, num_nics, factors, num_groups,
+						group_bw, &min_bw, &sum_bw);
+				if (is_better_assignment(min_bw, sum_bw, best_min_bw, best_sum_bw)) {
+					best_min_bw = min_bw;
+					best_sum_bw = sum_bw;
+					improved = true;
+				} else {
+					nics[i].group = group_i;
+					nics[j].group = group_j;
+				}
+			}
+		}
+
+		/* Move NICs */
+		for (int i = 0; i < num_nics && !improved; ++i) {
+			for (int group = 0; group < num_groups && !improved; ++group) {
+				int src = nics[i].group;
+				if (groups[group].size != groups[src].size - 1) continue;
+
+				nics[i].group = group;
+				eval_assignment(nics, num_nics, factors, num_groups,
+						group_bw, &min_bw, &sum_bw);
+				if (is_better_assignment(min_bw, sum_bw, best_min_bw, best_sum_bw)) {
+					best_min_bw = min_bw;
+					best_sum_bw = sum_bw;
+					groups[src].size--;
+					groups[group].size++;
+					improved = true;
+				} else {
+					nics[i].group = src;
+				}
+			}
+		}
+	}
+}
+
+/*
+ * @brief	Collect NIC candidates and groups from the libfabric NIC
+ *		info lists of topology nodes with 'num_groups' > 0
+ *
+ * Each list is split into min('num_groups', list length) groups of
+ * balanced size, and the groups are associated with the accelerators
+ * whose group counts have been propagated to the topology node. The
+ * NICs are initially assigned to the groups in list order.
+ *
+ * If `nics` and `groups` are NULL, only count NICs and groups.
  *
  * @return	0, on success
- * 		-EINVAL, on others
+ *		-EINVAL, on others
  */
-static int create_groups_from_info_list(nccl_ofi_topo_t *topo,
-						 struct fi_info **info_list,
-						 int num_infos,
-						 hwloc_obj_t gpu_group_node,
-						 int num_groups)
+static int collect_nics_and_groups(nccl_ofi_topo_t *topo,
+				   nic_candidate_t *nics, int *num_nics,
+				   nic_group_t *groups, int *num_groups)
 {
 	int ret = 0;
-	int group_idx = 0;
+	nccl_ofi_topo_data_t *data = NULL;
+	nccl_ofi_topo_data_iterator_t data_iter;
 
-	/* Adjust number of groups if input list does not provide enough members */
-	num_groups = NCCL_OFI_MIN(num_groups, num_infos);
-	/* Number of groups with one additional member. Handles the
-	 * case where list size is not a multiple of number of
-	 * groups */
-	const int num_large_groups = num_infos % num_groups;
-	int group_size = num_infos / num_groups + 1;
-
-	for (; group_idx < num_groups; ++group_idx) {
-		hwloc_obj_t obj;
-		/* If the number of NIC infos is not a multiple of
-		 * group size, latter candidates have one candidate
-		 * less. */
-		if (group_idx == num_large_groups) --group_size;
-		if (group_size == 0) break;
-
-		/* Retrieve topology node of leader */
-		ret = get_hwloc_pcidev_by_fi_info(topo->topo, *info_list, &obj);
-		if (ret != 0) {
-			NCCL_OFI_WARN("Retrieval of topology node corresponding to libfabric NIC failed with error");
-			break;
-		}
-		if (!obj) {
-			NCCL_OFI_WARN("hwloc failed detecting PCI NIC info.");
-			ret = -EINVAL;
-			break;
+	*num_nics = 0;
+	*num_groups = 0;
+
+	nccl_ofi_topo_set_to_begin(topo, &data_iter);
+	while ((data = nccl_ofi_get_user_data(&data_iter))) {
+		nccl_ofi_inc_user_data_iter(&data_iter);
+		if (!data->info_list || data->num_groups == 0) {
+			continue;
 		}
 
-		nccl_ofi_topo_data_t *user_data = (nccl_ofi_topo_data_t *)obj->userdata;
-		if (!user_data) {
-			NCCL_OFI_WARN("Invalid user data pointer");
-			return -EINVAL;
+		/* Adjust number of groups if list does not provide enough members */
+		int list_groups = NCCL_OFI_MIN(data->num_groups, data->info_list_len);
+		/* Number of groups with one additional member. Handles the
+		 * case where list size is not a multiple of number of
+		 * groups */
+		int num_large_groups = data->info_list_len % list_groups;
+		int group_size = data->info_list_len / list_groups + 1;
+
+		if (!groups) {
+			*num_nics += data->info_list_len;
+			*num_groups += list_groups;
+			continue;
 		}
 
-		if (user_data->info_list == *info_list) {
-			if (group_idx + 1 == num_groups) {
-				break;
-			} else {
-				NCCL_OFI_WARN("Invalid state of topology. "
-					      "This state should not be reached.");
-				return -EINVAL;
+		/* Associate groups with accelerators */
+		int group_idx = 0;
+		hwloc_obj_t obj = NULL;
+		while (group_idx < list_groups &&
+		       (obj = hwloc_get_next_pcidev(topo->topo, obj))) {
+			bool is_accel = false;
+			ret = is_accelerator_dev(obj, &is_accel);
+			if (ret != 0) {
+				NCCL_OFI_WARN("Error while checking whether hwloc topology node is an accelerator");
+				return ret;
+			}
+			if (!is_accel || get_accel_group_node(obj) != data->node) {
+				continue;
 			}
-		}
 
-		/* Add list topology node */
-		user_data->info_list = *info_list;
-		user_data->info_list_len = group_size;
-		user_data->gpu_group_node = gpu_group_node;
+			if (group_idx == num_large_groups) --group_size;
+			groups[*num_groups + group_idx].accel = obj;
+			groups[*num_groups + group_idx].size = group_size;
+			++group_idx;
+		}
+		if (group_idx != list_groups) {
+			NCCL_OFI_WARN("Found %d accelerators for %d NIC groups. "
+				      "This state should not be reached.",
+				      group_idx, list_groups);
+			return -EINVAL;
+		}
 
-		/* Track maximum group size */
-		topo->max_group_size = NCCL_OFI_MAX(topo->max_group_size, group_size);
+		/* Assign NICs to groups in list order */
+		struct fi_info *info = data->info_list;
+		for (group_idx = 0; group_idx < list_groups; ++group_idx) {
+			for (int i = 0; i < groups[*num_groups + group_idx].size; ++i) {
+				nic_candidate_t *nic = &nics[*num_nics];
+
+				ret = get_hwloc_pcidev_by_fi_info(topo->topo, info, &nic->node);
+				if (ret != 0) {
+					NCCL_OFI_WARN("Retrieval of topology node corresponding to libfabric NIC failed with error");
+					return ret;
+				}
+				if (!nic->node) {
+					NCCL_OFI_WARN("hwloc failed detecting PCI NIC info.");
+					return -EINVAL;
+				}
 
-		/* Cut list into two lists after group size list elements */
-		struct fi_info *end = user_data->info_list;
-		int i = 1;
-		for (; i < group_size; ++i) {
-			end = end->next;
+				nic->info = info;
+				nic->bw = get_nic_bandwidth(topo->topo, nic->node);
+				nic->group = *num_groups + group_idx;
+				++(*num_nics);
+				info = info->next;
+			}
 		}
 
-		/* Move list remainder to input list */
-		*info_list = end->next;
-		end->next = NULL;
+		*num_groups += list_groups;
 	}
 
-	return ret;
+	return 0;
 }
 
 /*
- * @brief	Split libfabric NIC info lists of topology nodes with 'num_groups' > 0
- *		into 'num_groups' lists (groups) and add these lists
- *		to the corresponding topology nodes of their leaders (first
- *		NIC of the list).
+ * @brief	Attach NIC groups to the topology nodes of their leaders
+ *
+ * The NICs of a group are ordered by decreasing locality to the
+ * accelerator of the group, then by decreasing bandwidth. The leader
+ * is the first NIC of the group.
  *
  * @return	0, on success
- * 		-errno code, on others
+ *		-EINVAL, on others
  */
-static int create_groups_from_info_lists(nccl_ofi_topo_t *topo)
+static int attach_groups(nccl_ofi_topo_t *topo,
+			 nic_candidate_t *nics, int num_nics,
+			 nic_group_t *groups, int num_groups,
+			 const double *factors, const double *group_bw)
 {
 	nccl_ofi_topo_data_t *data = NULL;
-
-	/* Iterate over user data of topology nodes */
 	nccl_ofi_topo_data_iterator_t data_iter;
+
+	/* Verify that no leader stores a list already */
+	for (int nic = 0; nic < num_nics; ++nic) {
+		data = (nccl_ofi_topo_data_t *)nics[nic].node->userdata;
+		if (!data) {
+			NCCL_OFI_WARN("Invalid user data pointer");
+			return -EINVAL;
+		}
+		if (data->info_list && data->num_groups == 0) {
+			NCCL_OFI_WARN("Invalid state of topology. "
+				      "This state should not be reached.");
+			return -EINVAL;
+		}
+	}
+
+	/* Detach lists from topology nodes with 'num_groups' > 0 */
 	nccl_ofi_topo_set_to_begin(topo, &data_iter);
 	while ((data = nccl_ofi_get_user_data(&data_iter))) {
 		nccl_ofi_inc_user_data_iter(&data_iter);
-		if (!data->info_list) {
+		if (!data->info_list || data->num_groups == 0) {
 			continue;
 		}
-
-		if (data->num_groups == 0) {
-			continue;
-		}
-
-		struct fi_info *info_list = data->info_list;
 		data->info_list = NULL;
-		int info_list_len = data->info_list_len;
 		data->info_list_len = 0;
-		int num_groups = data->num_groups;
 		data->num_groups = 0;
+	}
 
-		/* Create groups from list */
-		int ret = create_groups_from_info_list(topo,
-								&info_list,
-								info_list_len,
-								data->gpu_group_node,
-								num_groups);
-		if (ret != 0) {
-			data->info_list = info_list;
-			return ret;
+	for (int group = 0; group < num_groups; ++group) {
+		nic_candidate_t *leader = NULL;
+		struct fi_info *tail = NULL;
+		int size = groups[group].size;
+
+		if (size == 0) continue;
+
+		/* Selection sort of group members by locality and bandwidth */
+		for (int member = 0; member < size; ++member) {
+			nic_candidate_t *next = NULL;
+			double next_factor = 0.0;
+
+			for (int nic = 0; nic < num_nics; ++nic) {
+				if (nics[nic].group != group || nics[nic].attached) continue;
+
+				double factor = factors[nic * num_groups + group];
+				if (!next || factor > next_factor ||
+				    (factor == next_factor && nics[nic].bw > next->bw)) {
+					next = &nics[nic];
+					next_factor = factor;
+				}
+			}
+			assert(next);
+
+			next->attached = true;
+			next->info->next = NULL;
+			if (!leader) {
+				leader = next;
+			} else {
+				tail->next = next->info;
+			}
+			tail = next->info;
 		}
+
+		data = (nccl_ofi_topo_data_t *)leader->node->userdata;
+		data->info_list = leader->info;
+		data->info_list_len = size;
+		data->gpu_group_node = groups[group].accel;
+
+		/* Track maximum group size */
+		topo->max_group_size = NCCL_OFI_MAX(topo->max_group_size, size);
+
+		struct hwloc_pcidev_attr_s *accel_attr = &groups[group].accel->attr->pcidev;
+		NCCL_OFI_TRACE(NCCL_INIT,
+			       "Assigned %d NICs with effective bandwidth %.2f GB/s to accelerator %04x:%02x:%02x.%01x",
+			       size, group_bw[group],
+			       accel_attr->domain, accel_attr->bus, accel_attr->dev, accel_attr->func);
 	}
 
 	return 0;
 }
 
+/*
+ * @brief	Split libfabric NIC info lists of topology nodes with 'num_groups' > 0
+ *		into groups, assign the groups to accelerators, and add
+ *		these lists to the corresponding topology nodes of
+ *		their leaders (first NIC of the list).
+ *
+ * Starting from the assignment by list order, NICs are reassigned
+ * such that the aggregate NIC bandwidth of the accelerators is
+ * balanced. The bandwidth of a NIC accounts towards an accelerator
+ * according to their locality, see get_locality_factor(). The number
+ * of groups and their sizes are preserved.
+ *
+ * @return	0, on success
+ * 		-errno code, on others
+ */
+static int create_groups_from_info_lists(nccl_ofi_topo_t *topo)
+{
+	int ret = 0;
+	int num_nics = 0;
+	int num_groups = 0;
+	nic_candidate_t *nics = NULL;
+	nic_group_t *groups = NULL;
+	double *factors = NULL;
+	double *group_bw = NULL;
+
+	/* Count NICs and groups */
+	ret = collect_nics_and_groups(topo, NULL, &num_nics, NULL, &num_groups);
+	if (ret != 0 || num_groups == 0) {
+		return ret;
+	}
+
+	nics = (nic_candidate_t *)calloc(num_nics, sizeof(nic_candidate_t));
+	groups = (nic_group_t *)calloc(num_groups, sizeof(nic_group_t));
+	factors = (double *)calloc((size_t)num_nics * num_groups, sizeof(double));
+	group_bw = (double *)calloc(num_groups, sizeof(double));
+	if (!nics || !groups || !factors || !group_bw) {
+		NCCL_OFI_WARN("Failed to allocate NIC assignment");
+		ret = -ENOMEM;
+		goto exit;
+	}
+
+	ret = collect_nics_and_groups(topo, nics, &num_nics, groups, &num_groups);
+	if (ret != 0) {
+		goto exit;
+	}
+
+	for (int nic = 0; nic < num_nics; ++nic) {
+		for (int group = 0; group < num_groups; ++group) {
+			factors[nic * num_groups + group] =
+				get_locality_factor(topo->topo, nics[nic].node, groups[group].accel);
+		}
+	}
+
+	optimize_assignment(nics, num_nics, groups, num_groups, factors, group_bw);
+
+	/* Log bandwidth balance of final assignment */
+	double min_bw, sum_bw;
+	eval_assignment(nics, num_nics, factors, num_groups, group_bw, &min_bw, &sum_bw);
+	NCCL_OFI_TRACE(NCCL_INIT,
+		       "Assigned %d NICs to %d accelerators with minimum effective bandwidth %.2f GB/s of %.2f GB/s in total",
+		       num_nics, num_groups, min_bw, sum_bw);
+
+	ret = attach_groups(topo, nics, num_nics, groups, num_groups, factors, group_bw);
+
+ exit:
+	free(group_bw);
+	free(factors);
+	free(groups);
+	free(nics);
+	return ret;
+}
+
 /*
  * @brief	Print libfabric NIC info lists stored in user data of topology nodes
  */
@@ -1012,7 +1473,8 @@ static hwloc_obj_t get_numa_mem_child(hwloc_obj_t node)
  *
  * This function reads first `MAX_DEV_PROPERTY_LENGTH` characters from
  * device property file
- * `/sys/bus/pci/devices/{domain}:{bus}:{dev}.{func}/{prop_name}`. Reading
+ * `/sys/bus/pci/devices/{domain}:{bus}:{dev}.{func}/{prop_name}`,
+ * see nccl_ofi_topo_set_pci_sysfs_path(). Reading
  * may stop after a newline character is read or if the file
  * ends.
  *
@@ -1039,11 +1501,11 @@ static int get_device_property(unsigned domain, unsigned bus,
 {
 	int ret = 0;
 	FILE *file;
-	char *path_format = "/sys/bus/pci/devices/%04x:%02x:%02x.%01x/%s";
+	char *path_format = "%s/%04x:%02x:%02x.%01x/%s";
 	size_t path_len;
 	char *path = NULL;
 
-        if ((path_len = snprintf(NULL, 0, path_format, domain, bus, dev, func, prop_name)) < 0) {
+        if ((path_len = snprintf(NULL, 0, path_format, pci_sysfs_path, domain, bus, dev, func, prop_name)) < 0) {
 		NCCL_OFI_WARN("Failed to determine device property path length of property %s. ERROR: %s",
 			      prop_name, strerror(errno));
 		ret = -errno;
@@ -1057,7 +1519,7 @@ static int get_device_property(unsigned domain, unsigned bus,
 	}
 
 	/* Create file path */
-	if (snprintf(path, path_len + 1, path_format, domain, bus, dev, func, prop_name) < 0) {
+	if (snprintf(path, path_len + 1, path_format, pci_sysfs_path, domain, bus, dev, func, prop_name) < 0) {
 		NCCL_OFI_WARN("Failed to create device property path for property %s. ERROR: %s",
 			      prop_name, strerror(errno));
 		ret = -errno;
@@ -1573,6 +2035,11 @@ int nccl_ofi_topo_write(nccl_ofi_topo_t *topo, FILE *file)
 	return ret;
 }
 
+void nccl_ofi_topo_set_pci_sysfs_path(const char *path)
+{
+	pci_sysfs_path = path ? path : "/sys/bus/pci/devices";
+}
+
 int nccl_ofi_topo_num_info_lists(nccl_ofi_topo_t *topo, int *num_lists)
 {
 	if (!topo || !topo->data_vec) {
@@ -0,0 +1,772 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "nccl_ofi_histogram.h"
+#include "nccl_ofi_log.h"
+#include "nccl_ofi_param.h"
+#include "nccl_ofi_signal.h"
+#include "nccl_ofi_tracer.h"
+
+int nccl_ofi_tracer_enabled = 0;
+
+/* Ring buffer of the events of a thread */
+typedef struct tracer_ring {
+	nccl_ofi_tracer_event_t *events;
+	/* Number of events recorded by the thread */
+	uint64_t head;
+	struct tracer_ring *next;
+} tracer_ring_t;
+
+/* Number of events of each ring buffer, a power of two */
+static size_t ring_size = 0;
+
+/* Ring buffer of the calling thread */
+static __thread tracer_ring_t *thread_ring = NULL;
+
+/* Set if the ring buffer of the calling thread could not be allocated */
+static __thread bool thread_ring_failed = false;
+
+/* Ring buffers of all threads, protected by rings_lock */
+static tracer_ring_t *rings = NULL;
+static pthread_mutex_t rings_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Trace file with the process ID substituted */
+static char trace_path[PATH_MAX];
+
+/* Serializes writers of the trace file */
+static pthread_mutex_t flush_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Trace signals handled by the progress path */
+static unsigned int trace_signals_handled = 0;
+
+static tracer_ring_t *create_ring(void)
+{
+	tracer_ring_t *ring = calloc(1, sizeof(*ring));
+	if (!ring) {
+		return NULL;
+	}
+
+	ring->events = malloc(ring_size * sizeof(nccl_ofi_tracer_event_t));
+	if (!ring->events) {
+		free(ring);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&rings_lock);
+	ring->next = rings;
+	rings = ring;
+	pthread_mutex_unlock(&rings_lock);
+
+	return ring;
+}
+
+void nccl_ofi_tracer_record(uint16_t type, int dev, int rail, const void *comm,
+			    uint32_t id, const void *request, uint64_t size)
+{
+	tracer_ring_t *ring = thread_ring;
+	nccl_ofi_tracer_event_t *event;
+	uint64_t head;
+
+	if (ring == NULL) {
+		if (thread_ring_failed) {
+			return;
+		}
+		ring = create_ring();
+		if (!ring) {
+			NCCL_OFI_WARN("Unable to allocate trace buffer of %zu events", ring_size);
+			thread_ring_failed = true;
+			return;
+		}
+		thread_ring = ring;
+	}
+
+	/* Only the owning thread writes the ring */
+	head = ring->head;
+	event = &ring->events[head & (ring_size - 1)];
+	event->ts = nccl_ofi_timestamp_ns();
+	event->comm = comm;
+	event->request = request;
+	event->size = size;
+	event->dev = dev;
+	event->rail = rail;
+	event->type = type;
+	event->id = id;
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+static int compare_events(const void *a, const void *b)
+{
+	const nccl_ofi_tracer_event_t *event_a = a;
+	const nccl_ofi_tracer_event_t *event_b = b;
+
+	if (event_a->ts != event_b->ts) {
+		return event_a->ts < event_b->ts ? -1 : 1;
+	}
+	return 0;
+}
+
+int nccl_ofi_tracer_snapshot(nccl_ofi_tracer_event_t **events, size_t *num_events)
+{
+	nccl_ofi_tracer_event_t *copy;
+	size_t capacity = 0;
+	size_t count = 0;
+
+	pthread_mutex_lock(&rings_lock);
+
+	for (tracer_ring_t *ring = rings; ring; ring = ring->next) {
+		capacity += ring_size;
+	}
+	copy = malloc((capacity ? capacity : 1) * sizeof(nccl_ofi_tracer_event_t));
+	if (!copy) {
+		pthread_mutex_unlock(&rings_lock);
+		return -ENOMEM;
+	}
+
+	for (tracer_ring_t *ring = rings; ring; ring = ring->next) {
+		uint64_t end = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		uint64_t begin = end > ring_size ? end - ring_size : 0;
+		uint64_t overwritten;
+		size_t first = count;
+
+		for (uint64_t i = begin; i < end; i++) {
+			copy[count++] = ring->events[i & (ring_size - 1)];
+		}
+
+		/* The owner may overwrite the oldest events during the
+		 * copy, including the one that it is writing now */
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		overwritten = __atomic_load_n(&ring->head, __ATOMIC_RELAXED) + 1;
+		overwritten = overwritten > ring_size ? overwritten - ring_size : 0;
+		if (overwritten > begin) {
+			size_t drop = overwritten - begin;
+			if (drop > end - begin) {
+				drop = end - begin;
+			}
+			memmove(&copy[first], &copy[first + drop],
+				(count - first - drop) * sizeof(nccl_ofi_tracer_event_t));
+			count -= drop;
+		}
+	}
+
+	pthread_mutex_unlock(&rings_lock);
+
+	qsort(copy, count, sizeof(nccl_ofi_tracer_event_t), compare_events);
+
+	*events = copy;
+	*num_events = count;
+	return 0;
+}
+
+/* Track of the trace: a communicator or a rail of a device */
+typedef struct trace_track {
+	int dev;
+	/* Rail of a rail track, or -1 for a communicator track */
+	int rail;
+	const void *comm;
+	/* Type of the first request of a communicator track */
+	uint16_t comm_type;
+	bool has_comm_id;
+	uint32_t comm_id;
+	/* End time of the last span of each lane */
+	uint64_t *lane_end;
+	int num_lanes;
+	/* Thread ID of the first lane in the trace */
+	int first_tid;
+} trace_track_t;
+
+/* Span from a start event to its completion */
+typedef struct trace_span {
+	uint64_t start;
+	uint64_t end;
+	int track;
+	int lane;
+	const char *name;
+	uint64_t size;
+	uint32_t id;
+} trace_span_t;
+
+/* Instant event */
+typedef struct trace_instant {
+	uint64_t ts;
+	int track;
+	const char *name;
+	uint64_t size;
+	uint32_t id;
+} trace_instant_t;
+
+typedef struct trace_builder {
+	trace_track_t *tracks;
+	int num_tracks;
+	int max_tracks;
+
+	trace_span_t *spans;
+	size_t num_spans;
+
+	trace_instant_t *instants;
+	size_t num_instants;
+
+	/* Open addressing map of (request, rail) to the index of the
+	 * start event of an open span, or SIZE_MAX once closed */
+	const void **open_requests;
+	int *open_rails;
+	size_t *open_events;
+	size_t open_size;
+} trace_builder_t;
+
+/*
+ * @brief	Find or create track
+ *
+ * @return	Index of track, or -1 on allocation failure
+ */
+static int get_track(trace_builder_t *builder, int dev, int rail, const void *comm)
+{
+	trace_track_t *track;
+
+	for (int i = 0; i < builder->num_tracks; i++) {
+		track = &builder->tracks[i];
+		if (track->dev == dev && track->rail == rail && track->comm == comm) {
+			return i;
+		}
+	}
+
+	if (builder->num_tracks == builder->max_tracks) {
+		int max_tracks = builder->max_tracks ? 2 * builder->max_tracks : 16;
+		trace_track_t *tracks = realloc(builder->tracks, max_tracks * sizeof(trace_track_t));
+		if (!tracks) {
+			return -1;
+		}
+		builder->tracks = tracks;
+		builder->max_tracks = max_tracks;
+	}
+
+	track = &builder->tracks[builder->num_tracks];
+	memset(track, 0, sizeof(*track));
+	track->dev = dev;
+	track->rail = rail;
+	track->comm = comm;
+	return builder->num_tracks++;
+}
+
+static int get_comm_track(trace_builder_t *builder, const nccl_ofi_tracer_event_t *event,
+			  uint16_t comm_type)
+{
+	int index = get_track(builder, event->dev, -1, event->comm);
+
+	if (index >= 0 && builder->tracks[index].comm_type == 0) {
+		builder->tracks[index].comm_type = comm_type;
+	}
+	return index;
+}
+
+static size_t find_open(trace_builder_t *builder, const void *request, int rail)
+{
+	size_t mask = builder->open_size - 1;
+	size_t slot = (((uintptr_t)request >> 3) * 31 + (size_t)(rail + 1)) & mask;
+
+	while (builder->open_requests[slot] != NULL &&
+	       (builder->open_requests[slot] != request || builder->open_rails[slot] != rail)) {
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+static void open_span(trace_builder_t *builder, const void *request, int rail, size_t event)
+{
+	size_t slot;
+
+	if (request == NULL) {
+		return;
+	}
+
+	slot = find_open(builder, request, rail);
+
+	builder->open_requests[slot] = request;
+	builder->open_rails[slot] = rail;
+	builder->open_events[slot] = event;
+}
+
+/*
+ * @brief	Look up the start event of an open span
+ *
+ * @return	Index of start event, or SIZE_MAX if there is none
+ */
+static size_t lookup_span(trace_builder_t *builder, const void *request, int rail)
+{
+	size_t slot = find_open(builder, request, rail);
+
+	return builder->open_requests[slot] ? builder->open_events[slot] : SIZE_MAX;
+}
+
+static size_t close_span(trace_builder_t *builder, const void *request, int rail)
+{
+	size_t slot = find_open(builder, request, rail);
+	size_t event = SIZE_MAX;
+
+	if (builder->open_requests[slot]) {
+		event = builder->open_events[slot];
+		builder->open_events[slot] = SIZE_MAX;
+	}
+	return event;
+}
+
+static void add_span(trace_builder_t *builder, const nccl_ofi_tracer_event_t *start,
+		     uint64_t end, int track, const char *name)
+{
+	trace_span_t *span;
+
+	if (track < 0) {
+		return;
+	}
+
+	span = &builder->spans[builder->num_spans++];
+	span->start = start->ts;
+	span->end = end;
+	span->track = track;
+	span->lane = 0;
+	span->name = name;
+	span->size = start->size;
+	span->id = start->id;
+}
+
+static void add_instant(trace_builder_t *builder, const nccl_ofi_tracer_event_t *event,
+			int track, const char *name)
+{
+	trace_instant_t *instant;
+
+	if (track < 0) {
+		return;
+	}
+
+	instant = &builder->instants[builder->num_instants++];
+	instant->ts = event->ts;
+	instant->track = track;
+	instant->name = name;
+	instant->size = event->size;
+	instant->id = event->id;
+}
+
+static const char *span_name(uint16_t type)
+{
+	switch (type) {
+	case NCCL_OFI_TRACER_SEND:
+		return "send";
+	case NCCL_OFI_TRACER_RECV:
+		return "recv";
+	case NCCL_OFI_TRACER_FLUSH:
+		return "flush";
+	default:
+		return "request";
+	}
+}
+
+/*
+ * @brief	Match start and completion events into spans
+ */
+static void build_trace(trace_builder_t *builder, const nccl_ofi_tracer_event_t *events,
+			size_t num_events)
+{
+	for (size_t i = 0; i < num_events; i++) {
+		const nccl_ofi_tracer_event_t *event = &events[i];
+		const nccl_ofi_tracer_event_t *start;
+		size_t start_index;
+		int track;
+
+		switch (event->type) {
+		case NCCL_OFI_TRACER_SEND:
+			get_comm_track(builder, event, NCCL_OFI_TRACER_SEND);
+			open_span(builder, event->request, -1, i);
+			break;
+		case NCCL_OFI_TRACER_RECV:
+			track = get_comm_track(builder, event, NCCL_OFI_TRACER_RECV);
+			if (track >= 0) {
+				builder->tracks[track].has_comm_id = true;
+				builder->tracks[track].comm_id = event->id;
+			}
+			open_span(builder, event->request, -1, i);
+			break;
+		case NCCL_OFI_TRACER_FLUSH:
+			get_comm_track(builder, event, NCCL_OFI_TRACER_RECV);
+			open_span(builder, event->request, -1, i);
+			break;
+		case NCCL_OFI_TRACER_COMPLETE:
+			start_index = close_span(builder, event->request, -1);
+			if (start_index == SIZE_MAX) {
+				/* Posted before the oldest recorded event */
+				break;
+			}
+			start = &events[start_index];
+			track = get_track(builder, start->dev, -1, start->comm);
+			add_span(builder, start, event->ts, track, span_name(start->type));
+			break;
+		case NCCL_OFI_TRACER_SEND_WRITE_SEG_START:
+			get_track(builder, event->dev, event->rail, NULL);
+			open_span(builder, event->request, event->rail, i);
+			break;
+		case NCCL_OFI_TRACER_SEND_WRITE_SEG_COMPLETE:
+			start_index = close_span(builder, event->request, event->rail);
+			if (start_index == SIZE_MAX) {
+				break;
+			}
+			start = &events[start_index];
+			track = get_track(builder, start->dev, start->rail, NULL);
+			add_span(builder, start, event->ts, track, "write");
+			break;
+		case NCCL_OFI_TRACER_SEND_CTRL_RECV:
+			track = get_comm_track(builder, event, NCCL_OFI_TRACER_SEND);
+			add_instant(builder, event, track, "ctrl recv");
+			break;
+		case NCCL_OFI_TRACER_RECV_CTRL_SEND_COMPLETE:
+			/* Only the request identifies the receive */
+			start_index = lookup_span(builder, event->request, -1);
+			if (start_index == SIZE_MAX) {
+				break;
+			}
+			start = &events[start_index];
+			track = get_track(builder, start->dev, -1, start->comm);
+			add_instant(builder, event, track, "ctrl sent");
+			break;
+		case NCCL_OFI_TRACER_RECV_SEGMENT_COMPLETE:
+			track = get_track(builder, event->dev, event->rail, NULL);
+			add_instant(builder, event, track, "recv segment");
+			break;
+		case NCCL_OFI_TRACER_EAGER_RECV:
+			track = get_track(builder, event->dev, event->rail, NULL);
+			add_instant(builder, event, track, "eager recv");
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+static int compare_spans(const void *a, const void *b)
+{
+	const trace_span_t *span_a = a;
+	const trace_span_t *span_b = b;
+
+	if (span_a->start != span_b->start) {
+		return span_a->start < span_b->start ? -1 : 1;
+	}
+	return 0;
+}
+
+/*
+ * @brief	Place each span on the first lane of its track that has no
+ *		overlapping span, since the spans of a thread of a Chrome
+ *		trace must nest
+ *
+ * @return	0, on success
+ *		-ENOMEM, on allocation failure
+ */
+static int assign_lanes(trace_builder_t *builder)
+{
+	int tid = 1;
+
+	qsort(builder->spans, builder->num_spans, sizeof(trace_span_t), compare_spans);
+
+	for (size_t i = 0; i < builder->num_spans; i++) {
+		trace_span_t *span = &builder->spans[i];
+		trace_track_t *track = &builder->tracks[span->track];
+		int lane;
+
+		for (lane = 0; lane < track->num_lanes; lane++) {
+			if (track->lane_end[lane] <= span->start) {
+				break;
+			}
+		}
+		if (lane == track->num_lanes) {
+			uint64_t *lane_end = realloc(track->lane_end,
+						     (track->num_lanes + 1) * sizeof(uint64_t));
+			if (!lane_end) {
+				return -ENOMEM;
+			}
+			track->lane_end = lane_end;
+			track->num_lanes++;
+		}
+		track->lane_end[lane] = span->end;
+		span->lane = lane;
+	}
+
+	for (int i = 0; i < builder->num_tracks; i++) {
+		trace_track_t *track = &builder->tracks[i];
+
+		/* Instant events use the first lane */
+		if (track->num_lanes == 0) {
+			track->num_lanes = 1;
+		}
+		track->first_tid = tid;
+		tid += track->num_lanes;
+	}
+
+	return 0;
+}
+
+static void write_ts(FILE *file, const char *key, uint64_t ns)
+{
+	fprintf(file, "\"%s\":%" PRIu64 ".%03" PRIu64, key, ns / 1000, ns % 1000);
+}
+
+static void write_track_names(FILE *file, const trace_builder_t *builder, int pid)
+{
+	for (int i = 0; i < builder->num_tracks; i++) {
+		const trace_track_t *track = &builder->tracks[i];
+		char name[64];
+
+		if (track->rail >= 0) {
+			snprintf(name, sizeof(name), "dev %d rail %d", track->dev, track->rail);
+		} else if (track->comm_type == NCCL_OFI_TRACER_RECV && track->has_comm_id) {
+			snprintf(name, sizeof(name), "dev %d recv comm %u", track->dev, track->comm_id);
+		} else {
+			snprintf(name, sizeof(name), "dev %d %s comm %p", track->dev,
+				 track->comm_type == NCCL_OFI_TRACER_SEND ? "send" : "recv",
+				 track->comm);
+		}
+
+		for (int lane = 0; lane < track->num_lanes; lane++) {
+			int tid = track->first_tid + lane;
+
+			fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+				"\"args\":{\"name\":\"%s", pid, tid, name);
+			if (lane > 0) {
+				fprintf(file, " (%d)", lane);
+			}
+			fprintf(file, "\"}}");
+			fprintf(file, ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+				"\"args\":{\"sort_index\":%d}}", pid, tid, tid);
+		}
+	}
+}
+
+int nccl_ofi_tracer_write_events(const nccl_ofi_tracer_event_t *events, size_t num_events,
+				 const char *path)
+{
+	trace_builder_t builder;
+	char tmp_path[PATH_MAX];
+	FILE *file = NULL;
+	int pid = (int)getpid();
+	int ret = 0;
+
+	memset(&builder, 0, sizeof(builder));
+
+	/* The map is kept at most half full */
+	builder.open_size = 16;
+	while (builder.open_size < 2 * num_events) {
+		builder.open_size *= 2;
+	}
+	builder.open_requests = calloc(builder.open_size, sizeof(*builder.open_requests));
+	builder.open_rails = calloc(builder.open_size, sizeof(*builder.open_rails));
+	builder.open_events = calloc(builder.open_size, sizeof(*builder.open_events));
+	builder.spans = malloc((num_events + 1) * sizeof(trace_span_t));
+	builder.instants = malloc((num_events + 1) * sizeof(trace_instant_t));
+	if (!builder.open_requests || !builder.open_rails || !builder.open_events ||
+	    !builder.spans || !builder.instants) {
+		ret = -ENOMEM;
+		goto exit;
+	}
+
+	build_trace(&builder, events, num_events);
+	ret = assign_lanes(&builder);
+	if (ret != 0) {
+		goto exit;
+	}
+
+	/* Replace the trace file atomically, so that readers never see a
+	 * partial trace */
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	file = fopen(tmp_path, "w");
+	if (!file) {
+		ret = -errno;
+		NCCL_OFI_WARN("Unable to open trace file %s: %s", tmp_path, strerror(-ret));
+		goto exit;
+	}
+
+	fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+		"\"args\":{\"name\":\"%s %d\"}}", pid, PACKAGE_NAME, pid);
+	write_track_names(file, &builder, pid);
+
+	for (size_t i = 0; i < builder.num_spans; i++) {
+		const trace_span_t *span = &builder.spans[i];
+		const trace_track_t *track = &builder.tracks[span->track];
+
+		fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"request\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,",
+			span->name, pid, track->first_tid + span->lane);
+		write_ts(file, "ts", span->start);
+		fprintf(file, ",");
+		write_ts(file, "dur", span->end - span->start);
+		fprintf(file, ",\"args\":{\"size\":%" PRIu64 ",\"id\":%u}}", span->size, span->id);
+	}
+
+	for (size_t i = 0; i < builder.num_instants; i++) {
+		const trace_instant_t *instant = &builder.instants[i];
+		const trace_track_t *track = &builder.tracks[instant->track];
+
+		fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"message\",\"ph\":\"i\",\"s\":\"t\","
+			"\"pid\":%d,\"tid\":%d,", instant->name, pid, track->first_tid);
+		write_ts(file, "ts", instant->ts);
+		fprintf(file, ",\"args\":{\"size\":%" PRIu64 ",\"id\":%u}}", instant->size, instant->id);
+	}
+
+	fprintf(file, "\n]}\n");
+
+	if (fclose(file) != 0) {
+		ret = -errno;
+		NCCL_OFI_WARN("Unable to write trace file %s: %s", tmp_path, strerror(-ret));
+		unlink(tmp_path);
+		goto exit;
+	}
+	if (rename(tmp_path, path) != 0) {
+		ret = -errno;
+		NCCL_OFI_WARN("Unable to rename trace file %s to %s: %s",
+			      tmp_path, path, strerror(-ret));
+		unlink(tmp_path);
+		goto exit;
+	}
+
+ exit:
+	for (int i = 0; i < builder.num_tracks; i++) {
+		free(builder.tracks[i].lane_end);
+	}
+	free(builder.tracks);
+	free(builder.spans);
+	free(builder.instants);
+	free(builder.open_requests);
+	free(builder.open_rails);
+	free(builder.open_events);
+	return ret;
+}
+
+int nccl_ofi_tracer_flush(void)
+{
+	nccl_ofi_tracer_event_t *events;
+	size_t num_events;
+	int ret;
+
+	if (!nccl_ofi_tracer_enabled) {
+		return 0;
+	}
+
+	pthread_mutex_lock(&flush_lock);
+
+	ret = nccl_ofi_tracer_snapshot(&events, &num_events);
+	if (ret != 0) {
+		NCCL_OFI_WARN("Unable to copy trace events");
+		goto exit;
+	}
+
+	ret = nccl_ofi_tracer_write_events(events, num_events, trace_path);
+	free(events);
+	if (ret == 0) {
+		NCCL_OFI_INFO(NCCL_NET, "Wrote %zu trace events to %s", num_events, trace_path);
+	}
+
+ exit:
+	pthread_mutex_unlock(&flush_lock);
+	return ret;
+}
+
+static void flush_at_exit(void)
+{
+	nccl_ofi_tracer_flush();
+}
+
+void nccl_ofi_tracer_check_signal(void)
+{
+	unsigned int signals = nccl_ofi_signal_count(NCCL_OFI_SIGNAL_TRACER);
+	unsigned int handled = __atomic_load_n(&trace_signals_handled, __ATOMIC_RELAXED);
+
+	if (signals == handled) {
+		return;
+	}
+
+	/* One thread writes the trace file for a signal */
+	if (__atomic_compare_exchange_n(&trace_signals_handled, &handled, signals, false,
+					__ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+		nccl_ofi_tracer_flush();
+	}
+}
+
+/*
+ * @brief	Copy trace file to trace_path, replacing "%p" with the
+ *		process ID
+ */
+static int expand_trace_path(const char *file)
+{
+	size_t len = 0;
+
+	for (const char *c = file; *c; c++) {
+		int written;
+
+		if (c[0] == '%' && c[1] == 'p') {
+			written = snprintf(&trace_path[len], sizeof(trace_path) - len, "%d",
+					   (int)getpid());
+			c++;
+		} else {
+			written = snprintf(&trace_path[len], sizeof(trace_path) - len, "%c", *c);
+		}
+		if (written < 0 || (size_t)written >= sizeof(trace_path) - len) {
+			return -ENAMETOOLONG;
+		}
+		len += written;
+	}
+
+	return 0;
+}
+
+int nccl_ofi_tracer_init(void)
+{
+	const char *file = ofi_nccl_trace_file();
+	int64_t buffer_events = ofi_nccl_trace_buffer_events();
+	int signum = (int)ofi_nccl_trace_signal();
+	int ret;
+
+	if (nccl_ofi_tracer_enabled || file == NULL || file[0] == '\0') {
+		return 0;
+	}
+
+	if (buffer_events <= 0 || buffer_events > (1LL << 30)) {
+		NCCL_OFI_WARN("Invalid trace buffer size of %" PRId64 " events", buffer_events);
+		return -EINVAL;
+	}
+
+	ret = expand_trace_path(file);
+	if (ret != 0) {
+		NCCL_OFI_WARN("Trace file name %s is too long", file);
+		return ret;
+	}
+
+	ring_size = 1;
+	while (ring_size < (size_t)buffer_events) {
+		ring_size *= 2;
+	}
+
+	if (signum != 0) {
+		ret = nccl_ofi_signal_register(signum, NCCL_OFI_SIGNAL_TRACER, NULL);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+
+	atexit(flush_at_exit);
+	__atomic_store_n(&nccl_ofi_tracer_enabled, 1, __ATOMIC_RELEASE);
+
+	NCCL_OFI_INFO(NCCL_INIT | NCCL_NET, "Tracing requests to %s, %zu events per thread",
+		      trace_path, ring_size);
+	if (signum != 0) {
+		NCCL_OFI_INFO(NCCL_INIT | NCCL_NET, "Trace file is written on signal %d", signum);
+	}
+
+	return 0;
+}
@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "nccl_ofi_log.h"
+#include "nccl_ofi_param.h"
+#include "nccl_ofi_traffic.h"
+
+/* Rows of the process. A row is allocated when its slot is first used
+ * and never freed. */
+static nccl_ofi_traffic_row_t *rows[NCCL_OFI_TRAFFIC_MAX_ROWS];
+
+/* Traffic matrix file with the process ID and host name substituted,
+ * empty if the traffic matrix is disabled */
+static char matrix_path[PATH_MAX];
+
+/* Environment variables of the rank of the process, by launcher */
+static const char *rank_env_vars[] = {
+	"OMPI_COMM_WORLD_RANK",
+	"PMIX_RANK",
+	"PMI_RANK",
+	"SLURM_PROCID",
+	"RANK",
+};
+
+nccl_ofi_traffic_row_t *nccl_ofi_traffic_alloc(int dev_id, const char *addr)
+{
+	nccl_ofi_traffic_row_t *row;
+
+	if (matrix_path[0] == '\0') {
+		return NULL;
+	}
+
+	row = calloc(1, sizeof(*row));
+	if (!row) {
+		NCCL_OFI_WARN("Unable to allocate traffic matrix row");
+		return NULL;
+	}
+	if (pthread_mutex_init(&row->lock, NULL) != 0) {
+		NCCL_OFI_WARN("Unable to initialize traffic matrix row lock");
+		free(row);
+		return NULL;
+	}
+	row->dev_id = dev_id;
+	snprintf(row->addr, sizeof(row->addr), "%s", addr);
+
+	for (int i = 0; i < NCCL_OFI_TRAFFIC_MAX_ROWS; i++) {
+		nccl_ofi_traffic_row_t *expected = NULL;
+
+		if (__atomic_compare_exchange_n(&rows[i], &expected, row, false,
+						__ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+			return row;
+		}
+	}
+
+	NCCL_OFI_INFO(NCCL_NET, "All %d traffic matrix rows are in use", NCCL_OFI_TRAFFIC_MAX_ROWS);
+	pthread_mutex_destroy(&row->lock);
+	free(row);
+	return NULL;
+}
+
+nccl_ofi_traffic_peer_t *nccl_ofi_traffic_get_peer(nccl_ofi_traffic_row_t *row,
+						   uint64_t fi_addr, const char *addr)
+{
+	nccl_ofi_traffic_peer_t *peer;
+
+	pthread_mutex_lock(&row->lock);
+
+	for (peer = row->peers; peer; peer = peer->next) {
+		if (peer->fi_addr == fi_addr) {
+			goto unlock;
+		}
+	}
+
+	peer = calloc(1, sizeof(*peer));
+	if (!peer) {
+		NCCL_OFI_WARN("Unable to allocate traffic matrix peer");
+		goto unlock;
+	}
+	peer->fi_addr = fi_addr;
+	snprintf(peer->addr, sizeof(peer->addr), "%s", addr);
+	peer->next = row->peers;
+	/* Publish the peer to writers of the matrix, which do not take
+	 * the lock */
+	__atomic_store_n(&row->peers, peer, __ATOMIC_RELEASE);
+
+ unlock:
+	pthread_mutex_unlock(&row->lock);
+	return peer;
+}
+
+/*
+ * @brief	Rank of the process from the environment, -1 if unknown
+ */
+static long get_rank(void)
+{
+	for (size_t i = 0; i < sizeof(rank_env_vars) / sizeof(rank_env_vars[0]); i++) {
+		const char *value = getenv(rank_env_vars[i]);
+		char *end;
+		long rank;
+
+		if (!value || value[0] == '\0') {
+			continue;
+		}
+		rank = strtol(value, &end, 10);
+		if (*end == '\0' && rank >= 0) {
+			return rank;
+		}
+	}
+
+	return -1;
+}
+
+int nccl_ofi_traffic_write(void)
+{
+	char tmp_path[PATH_MAX + 8];
+	char host[256];
+	long rank = get_rank();
+	FILE *file;
+	int ret;
+
+	if (matrix_path[0] == '\0') {
+		return 0;
+	}
+
+	if (gethostname(host, sizeof(host)) != 0) {
+		snprintf(host, sizeof(host), "unknown");
+	}
+	host[sizeof(host) - 1] = '\0';
+
+	/* Replace the file atomically, so that readers never see a
+	 * partial matrix */
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", matrix_path);
+	file = fopen(tmp_path, "w");
+	if (!file) {
+		ret = -errno;
+		NCCL_OFI_WARN("Unable to open traffic matrix %s: %s", tmp_path, strerror(-ret));
+		return ret;
+	}
+
+	fprintf(file, "# nccl-ofi traffic matrix version %d\n", NCCL_OFI_TRAFFIC_VERSION);
+	for (int i = 0; i < NCCL_OFI_TRAFFIC_MAX_ROWS; i++) {
+		nccl_ofi_traffic_row_t *row = __atomic_load_n(&rows[i], __ATOMIC_ACQUIRE);
+
+		if (!row) {
+			break;
+		}
+
+		fprintf(file, "endpoint addr=%s host=%s pid=%d rank=%ld dev=%d\n",
+			row->addr, host, (int)getpid(), rank, row->dev_id);
+		for (nccl_ofi_traffic_peer_t *peer = __atomic_load_n(&row->peers, __ATOMIC_ACQUIRE);
+		     peer; peer = peer->next) {
+			fprintf(file, "peer addr=%s fi_addr=%" PRIu64 " tx_bytes=%" PRIu64
+				" tx_msgs=%" PRIu64 " rx_bytes=%" PRIu64 " rx_msgs=%" PRIu64 "\n",
+				peer->addr, peer->fi_addr,
+				__atomic_load_n(&peer->tx_bytes, __ATOMIC_RELAXED),
+				__atomic_load_n(&peer->tx_msgs, __ATOMIC_RELAXED),
+				__atomic_load_n(&peer->rx_bytes, __ATOMIC_RELAXED),
+				__atomic_load_n(&peer->rx_msgs, __ATOMIC_RELAXED));
+		}
+	}
+
+	if (fclose(file) != 0) {
+		ret = -errno;
+		NCCL_OFI_WARN("Unable to write traffic matrix %s: %s", tmp_path, strerror(-ret));
+		unlink(tmp_path);
+		return ret;
+	}
+	if (rename(tmp_path, matrix_path) != 0) {
+		ret = -errno;
+		NCCL_OFI_WARN("Unable to rename traffic matrix %s to %s: %s",
+			      tmp_path, matrix_path, strerror(-ret));
+		unlink(tmp_path);
+		return ret;
+	}
+
+	return 0;
+}
+
+static void write_at_exit(void)
+{
+	nccl_ofi_traffic_write();
+}
+
+/*
+ * @brief	Copy traffic matrix file to matrix_path, replacing "%p" with
+ *		the process ID and "%h" with the host name
+ */
+static int expand_matrix_path(const char *file)
+{
+	char host[256];
+	size_t len = 0;
+
+	if (gethostname(host, sizeof(host)) != 0) {
+		snprintf(host, sizeof(host), "unknown");
+	}
+	host[sizeof(host) - 1] = '\0';
+
+	for (const char *c = file; *c; c++) {
+		int written;
+
+		if (c[0] == '%' && c[1] == 'p') {
+			written = snprintf(&matrix_path[len], sizeof(matrix_path) - len, "%d",
+					   (int)getpid());
+			c++;
+		} else if (c[0] == '%' && c[1] == 'h') {
+			written = snprintf(&matrix_path[len], sizeof(matrix_path) - len, "%s", host);
+			c++;
+		} else {
+			written = snprintf(&matrix_path[len], sizeof(matrix_path) - len, "%c", *c);
+		}
+		if (written < 0 || (size_t)written >= sizeof(matrix_path) - len) {
+			matrix_path[0] = '\0';
+			return -ENAMETOOLONG;
+		}
+		len += written;
+	}
+
+	return 0;
+}
+
+int nccl_ofi_traffic_init(void)
+{
+	const char *file = ofi_nccl_traffic_matrix_file();
+	int ret;
+
+	if (matrix_path[0] != '\0' || !file || file[0] == '\0') {
+		return 0;
+	}
+
+	ret = expand_matrix_path(file);
+	if (ret != 0) {
+		NCCL_OFI_WARN("Traffic matrix file name %s is too long", file);
+		return ret;
+	}
+
+	atexit(write_at_exit);
+
+	NCCL_OFI_INFO(NCCL_INIT | NCCL_NET, "Traffic matrix is written to %s at exit", matrix_path);
+
+	return 0;
+}
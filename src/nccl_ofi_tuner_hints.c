@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#include "nccl_ofi_math.h"
+#include "nccl_ofi_tuner_hints.h"
+
+static pthread_mutex_t hints_lock = PTHREAD_MUTEX_INITIALIZER;
+static nccl_ofi_tuner_hints_t hints;
+
+void nccl_ofi_tuner_hints_set_calibration(double bandwidth, double latency, double overhead)
+{
+	pthread_mutex_lock(&hints_lock);
+	hints.calibrated_bw = bandwidth;
+	hints.calibrated_latency = latency;
+	hints.calibrated_overhead = overhead;
+	pthread_mutex_unlock(&hints_lock);
+}
+
+void nccl_ofi_tuner_hints_set_link(int num_rails, double link_bw)
+{
+	pthread_mutex_lock(&hints_lock);
+	hints.num_rails = num_rails;
+	hints.link_bw = link_bw;
+	pthread_mutex_unlock(&hints_lock);
+}
+
+void nccl_ofi_tuner_hints_set_intranode(double bandwidth, double latency_ns)
+{
+	pthread_mutex_lock(&hints_lock);
+	hints.intranode_bw = bandwidth;
+	hints.intranode_latency_ns = latency_ns;
+	pthread_mutex_unlock(&hints_lock);
+}
+
+int nccl_ofi_tuner_hints_get(nccl_ofi_tuner_hints_t *copy, size_t size)
+{
+	memset(copy, 0, size);
+
+	pthread_mutex_lock(&hints_lock);
+	memcpy(copy, &hints, NCCL_OFI_MIN(size, sizeof(hints)));
+	pthread_mutex_unlock(&hints_lock);
+
+	return 0;
+}
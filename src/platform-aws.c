@@ -16,10 +16,69 @@
 #include <rdma/fi_ext.h>
 #endif
 #include <dlfcn.h>
+#include <fnmatch.h>
 
 #include "nccl_ofi.h"
+#include "nccl_ofi_ini.h"
 #include "nccl_ofi_log.h"
 #include "nccl_ofi_param.h"
+#include "nccl_ofi_tuner_hints.h"
+
+/*
+ * Plugin parameters for which a platform can provide a default
+ * value. A value set through the environment always takes precedence.
+ */
+enum platform_param {
+	PLATFORM_PARAM_EAGER_MAX_SIZE,
+	PLATFORM_PARAM_ROUND_ROBIN_THRESHOLD,
+	PLATFORM_PARAM_RDMA_MIN_POSTED_BOUNCE_BUFFERS,
+	PLATFORM_PARAM_RDMA_MAX_POSTED_BOUNCE_BUFFERS,
+	PLATFORM_PARAM_TUNER_INTRANODE_BW,
+	PLATFORM_PARAM_TUNER_INTRANODE_LATENCY_NS,
+	PLATFORM_PARAM_MAX,
+};
+
+static const struct {
+	/* Key in platform file */
+	const char *key;
+	/* Environment variable of plugin parameter */
+	const char *env;
+	/* Minimum valid value */
+	int64_t min;
+	/* Parameter of the tuner, provided as tuner hint */
+	bool tuner;
+} platform_params[PLATFORM_PARAM_MAX] = {
+	[PLATFORM_PARAM_EAGER_MAX_SIZE] = {
+		"eager_max_size", "OFI_NCCL_EAGER_MAX_SIZE", 0 },
+	[PLATFORM_PARAM_ROUND_ROBIN_THRESHOLD] = {
+		"round_robin_threshold", "OFI_NCCL_ROUND_ROBIN_THRESHOLD", 1 },
+	[PLATFORM_PARAM_RDMA_MIN_POSTED_BOUNCE_BUFFERS] = {
+		"rdma_min_posted_bounce_buffers", "OFI_NCCL_RDMA_MIN_POSTED_BOUNCE_BUFFERS", 1 },
+	[PLATFORM_PARAM_RDMA_MAX_POSTED_BOUNCE_BUFFERS] = {
+		"rdma_max_posted_bounce_buffers", "OFI_NCCL_RDMA_MAX_POSTED_BOUNCE_BUFFERS", 1 },
+	[PLATFORM_PARAM_TUNER_INTRANODE_BW] = {
+		"tuner_intranode_bw", "OFI_NCCL_TUNER_INTRANODE_BW", 1, true },
+	[PLATFORM_PARAM_TUNER_INTRANODE_LATENCY_NS] = {
+		"tuner_intranode_latency_ns", "OFI_NCCL_TUNER_INTRANODE_LATENCY_NS", 1, true },
+};
+
+/*
+ * Intranode bandwidth per channel in bytes per µsec and latency of a
+ * ring hop in nsecs for the tuner, as NCCL models them (SM80/SM90 NVLink
+ * and PCI bandwidths of 20GiB/s and 12GiB/s; NVLink and PCI Simple ring
+ * latencies of 3.4µs and 5.7µs).
+ */
+#define PLATFORM_TUNER_PARAMS(bw, lat_ns)					\
+	.params = {								\
+		[PLATFORM_PARAM_TUNER_INTRANODE_BW] = (bw),			\
+		[PLATFORM_PARAM_TUNER_INTRANODE_LATENCY_NS] = (lat_ns),		\
+	},									\
+	.params_set = {								\
+		[PLATFORM_PARAM_TUNER_INTRANODE_BW] = true,			\
+		[PLATFORM_PARAM_TUNER_INTRANODE_LATENCY_NS] = true,		\
+	}
+#define PLATFORM_TUNER_NVLINK	PLATFORM_TUNER_PARAMS(21475, 3400)
+#define PLATFORM_TUNER_PCI	PLATFORM_TUNER_PARAMS(12885, 5700)
 
 struct ec2_platform_data {
 	const char* name;
@@ -29,6 +88,8 @@ struct ec2_platform_data {
 	bool gdr_required;
 	bool net_flush_required;
 	const char *default_protocol;
+	int64_t params[PLATFORM_PARAM_MAX];
+	bool params_set[PLATFORM_PARAM_MAX];
 } platform_data_map[] = {
 	{
 		.name = "p4d.24xlarge",
@@ -38,6 +99,7 @@ struct ec2_platform_data {
 		.gdr_required = true,
 		.net_flush_required = true,
 		.default_protocol = "SENDRECV",
+		PLATFORM_TUNER_NVLINK,
 	},
 	{
 		.name = "p4de.24xlarge",
@@ -47,6 +109,7 @@ struct ec2_platform_data {
 		.gdr_required = true,
 		.net_flush_required = true,
 		.default_protocol = "SENDRECV",
+		PLATFORM_TUNER_NVLINK,
 	},
 	{
 		.name = "p3dn.24xlarge",
@@ -56,6 +119,7 @@ struct ec2_platform_data {
 		.gdr_required = false,
 		.net_flush_required = true,
 		.default_protocol = "SENDRECV",
+		PLATFORM_TUNER_NVLINK,
 	},
 	{
 		.name = "p5.48xlarge",
@@ -65,6 +129,7 @@ struct ec2_platform_data {
 		.gdr_required = true,
 		.net_flush_required = false,
 		.default_protocol = "RDMA",
+		PLATFORM_TUNER_NVLINK,
 	},
 	{
 		.name = "g5.48xlarge",
@@ -72,6 +137,7 @@ struct ec2_platform_data {
 		.gdr_required = false,
 		.net_flush_required = true,
 		.default_protocol = "SENDRECV",
+		PLATFORM_TUNER_PCI,
 	},
 };
 
@@ -151,9 +217,193 @@ exit:
 	return platform_type;
 }
 
+struct platform_file_ctx {
+	const char *path;
+	const char *platform_type;
+	/* Platform data with matching sections applied */
+	struct ec2_platform_data data;
+	/* True if built-in entry or any section matched */
+	bool found;
+};
+
+/*
+ * @brief	Validate and apply a key-value pair of the platform file
+ *
+ * Pairs of sections that do not match the platform type are validated,
+ * but not applied.
+ */
+static int platform_file_handler(void *ctx_, const char *section,
+				 const char *key, const char *value, int lineno)
+{
+	struct platform_file_ctx *ctx = ctx_;
+	struct ec2_platform_data scratch;
+	struct ec2_platform_data *data = &scratch;
+	bool match;
+	int64_t ival;
+	double dval;
+	bool bval;
+
+	if (section[0] == '\0') {
+		NCCL_OFI_WARN("%s:%d: Key %s outside of platform section",
+			      ctx->path, lineno, key);
+		return -EINVAL;
+	}
+
+	match = (fnmatch(section, ctx->platform_type, 0) == 0);
+	if (match) {
+		data = &ctx->data;
+		ctx->found = true;
+	}
+
+	if (strcmp(key, "topology") == 0) {
+		if (!match) {
+			return 0;
+		}
+		if (value[0] == '\0') {
+			data->topology = NULL;
+		} else {
+			data->topology = strdup(value);
+			if (!data->topology) {
+				NCCL_OFI_WARN("Unable to allocate topology file name");
+				return -ENOMEM;
+			}
+		}
+	} else if (strcmp(key, "default_protocol") == 0) {
+		if (strcasecmp(value, "SENDRECV") == 0) {
+			data->default_protocol = "SENDRECV";
+		} else if (strcasecmp(value, "RDMA") == 0) {
+			data->default_protocol = "RDMA";
+		} else {
+			goto invalid;
+		}
+	} else if (strcmp(key, "default_dup_conns") == 0) {
+		if (nccl_ofi_ini_parse_int(value, &ival) != 0 || ival < 0 || ival > INT_MAX) {
+			goto invalid;
+		}
+		data->default_dup_conns = (int)ival;
+	} else if (strcmp(key, "latency") == 0) {
+		if (nccl_ofi_ini_parse_double(value, &dval) != 0 || dval < 0.0) {
+			goto invalid;
+		}
+		data->latency = (float)dval;
+	} else if (strcmp(key, "gdr_required") == 0) {
+		if (nccl_ofi_ini_parse_bool(value, &bval) != 0) {
+			goto invalid;
+		}
+		data->gdr_required = bval;
+	} else if (strcmp(key, "net_flush_required") == 0) {
+		if (nccl_ofi_ini_parse_bool(value, &bval) != 0) {
+			goto invalid;
+		}
+		data->net_flush_required = bval;
+	} else {
+		int param;
+
+		for (param = 0; param < PLATFORM_PARAM_MAX; ++param) {
+			if (strcmp(key, platform_params[param].key) == 0) {
+				break;
+			}
+		}
+		if (param == PLATFORM_PARAM_MAX) {
+			NCCL_OFI_WARN("%s:%d: Unknown key %s", ctx->path, lineno, key);
+			return -EINVAL;
+		}
+		if (nccl_ofi_ini_parse_int(value, &ival) != 0 ||
+		    ival < platform_params[param].min) {
+			goto invalid;
+		}
+		data->params[param] = ival;
+		data->params_set[param] = true;
+	}
+
+	return 0;
+
+ invalid:
+	NCCL_OFI_WARN("%s:%d: Invalid value \"%s\" for key %s",
+		      ctx->path, lineno, value, key);
+	return -EINVAL;
+}
+
+/*
+ * @brief	Load platform file and apply matching sections
+ *
+ * Loads the first existing file of the colon-separated search path
+ * given by OFI_NCCL_PLATFORM_FILE, or PLATFORM_FILE_PATH by default.
+ * Sections are named by a shell wildcard pattern (see fnmatch(3))
+ * that is matched against the platform type. All matching sections
+ * are applied on top of the built-in platform data in file order, so
+ * that later sections override earlier ones. A file with any invalid
+ * section is ignored as a whole.
+ *
+ * @param	platform_type
+ *		Platform type
+ * @param	data
+ *		Built-in platform data on input, updated platform data
+ *		on output
+ * @param	found
+ *		True on input if built-in platform data exists. Set to
+ *		true if any section matched.
+ */
+static void load_platform_file(const char *platform_type,
+			       struct ec2_platform_data *data, bool *found)
+{
+	const char *search_path = ofi_nccl_platform_file();
+	char *paths = NULL;
+	char *saveptr = NULL;
+	int ret;
+
+	if (search_path == NULL) {
+		search_path = PLATFORM_FILE_PATH;
+	}
+
+	paths = strdup(search_path);
+	if (!paths) {
+		NCCL_OFI_WARN("Unable to allocate platform file search path");
+		return;
+	}
+
+	for (char *path = strtok_r(paths, ":", &saveptr); path;
+	     path = strtok_r(NULL, ":", &saveptr)) {
+		struct platform_file_ctx ctx = {
+			.path = path,
+			.platform_type = platform_type,
+			.data = *data,
+			.found = *found,
+		};
+
+		ret = nccl_ofi_ini_parse_file(path, platform_file_handler, &ctx);
+		if (ret == -ENOENT) {
+			NCCL_OFI_TRACE(NCCL_INIT | NCCL_NET, "Platform file %s not found", path);
+			continue;
+		} else if (ret != 0) {
+			NCCL_OFI_WARN("Ignoring platform file %s: %s", path, strerror(-ret));
+			break;
+		}
+
+		if (ctx.data.params_set[PLATFORM_PARAM_RDMA_MIN_POSTED_BOUNCE_BUFFERS] &&
+		    ctx.data.params_set[PLATFORM_PARAM_RDMA_MAX_POSTED_BOUNCE_BUFFERS] &&
+		    ctx.data.params[PLATFORM_PARAM_RDMA_MIN_POSTED_BOUNCE_BUFFERS] >
+		    ctx.data.params[PLATFORM_PARAM_RDMA_MAX_POSTED_BOUNCE_BUFFERS]) {
+			NCCL_OFI_WARN("Ignoring platform file %s: rdma_min_posted_bounce_buffers exceeds rdma_max_posted_bounce_buffers for platform %s",
+				      path, platform_type);
+			break;
+		}
+
+		NCCL_OFI_INFO(NCCL_INIT | NCCL_NET, "Loaded platform file %s", path);
+		*data = ctx.data;
+		*found = ctx.found;
+		break;
+	}
+
+	free(paths);
+}
+
 /*
  * @brief	Returns platform data for current platform type, if found
  *
+ * The built-in platform data is merged with the platform file, see
+ * load_platform_file().
+ *
  * @input	Platform type
  *
  * @return	NULL, if no topology found
@@ -164,8 +414,10 @@ struct ec2_platform_data *get_platform_data()
 	static bool init = false;
 	static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
 	static struct ec2_platform_data *platform_data = NULL;
+	static struct ec2_platform_data merged_data;
 	const size_t platform_n = sizeof(platform_data_map)/sizeof(platform_data_map[0]);
 	const char* platform_type = NULL;
+	bool found = false;
 
 	pthread_mutex_lock(&mutex);
 
@@ -182,8 +434,17 @@ struct ec2_platform_data *get_platform_data()
 	}
 
 	for (size_t idx = 0; idx < platform_n; idx++) {
-		if (strcmp(platform_type, platform_data_map[idx].name) == 0)
-			platform_data = &platform_data_map[idx];
+		if (strcmp(platform_type, platform_data_map[idx].name) == 0) {
+			merged_data = platform_data_map[idx];
+			found = true;
+		}
+	}
+
+	load_platform_file(platform_type, &merged_data, &found);
+
+	if (found) {
+		merged_data.name = platform_type;
+		platform_data = &merged_data;
 	}
 
 	pthread_mutex_unlock(&mutex);
@@ -191,6 +452,34 @@ struct ec2_platform_data *get_platform_data()
 	return platform_data;
 }
 
+/*
+ * @brief	Set default value of plugin parameter, unless the
+ *		environment variable is already set
+ */
+static int set_param_default(const char *env, int64_t value)
+{
+	char str[32];
+	int ret;
+
+	if (getenv(env)) {
+		NCCL_OFI_INFO(NCCL_INIT | NCCL_NET,
+			      "%s environment variable is already set to %s, ignoring platform value %" PRId64,
+			      env, getenv(env), value);
+		return 0;
+	}
+
+	snprintf(str, sizeof(str), "%" PRId64, value);
+	NCCL_OFI_INFO(NCCL_INIT | NCCL_NET, "Setting %s environment variable to platform value %s",
+		      env, str);
+	ret = setenv(env, str, 0);
+	if (ret != 0) {
+		NCCL_OFI_WARN("Unable to set %s", env);
+		return -errno;
+	}
+
+	return 0;
+}
+
 /*
  * validate that EFA is using RDMA write natively and not in an
  * emulated fasion.
@@ -479,8 +768,14 @@ int platform_init(const char **provider_filter)
 	} else if (platform_data && platform_data->topology) {
 		char topology_path[PATH_MAX];
 
-		ret = snprintf(topology_path, sizeof(topology_path), "%s/%s",
-			       XML_DIR, platform_data->topology);
+		/* Relative topology file names are looked up in XML_DIR */
+		if (platform_data->topology[0] == '/') {
+			ret = snprintf(topology_path, sizeof(topology_path), "%s",
+				       platform_data->topology);
+		} else {
+			ret = snprintf(topology_path, sizeof(topology_path), "%s/%s",
+				       XML_DIR, platform_data->topology);
+		}
 		if (ret < 0 || ret >= sizeof(topology_path)) {
 			NCCL_OFI_WARN("Error occurred while forming the complete topology XML file path. RC: %d, Buffer Size: %d, XML dir: %s, Topology file: %s",
 				      ret, PATH_MAX, XML_DIR, platform_data->topology);
@@ -504,6 +799,27 @@ int platform_init(const char **provider_filter)
 	if (nic_dup_conns == 0 && platform_data)
 		nic_dup_conns = platform_data->default_dup_conns;
 
+	for (int param = 0; platform_data && param < PLATFORM_PARAM_MAX; ++param) {
+		if (!platform_data->params_set[param] || platform_params[param].tuner) {
+			continue;
+		}
+		ret = set_param_default(platform_params[param].env,
+					platform_data->params[param]);
+		if (ret != 0) {
+			goto exit;
+		}
+	}
+
+	/* Parameters of the tuner are published as hints instead, which
+	 * the tuner overrides with its environment variables */
+	if (platform_data) {
+		nccl_ofi_tuner_hints_set_intranode(
+			platform_data->params_set[PLATFORM_PARAM_TUNER_INTRANODE_BW] ?
+			platform_data->params[PLATFORM_PARAM_TUNER_INTRANODE_BW] : 0,
+			platform_data->params_set[PLATFORM_PARAM_TUNER_INTRANODE_LATENCY_NS] ?
+			platform_data->params[PLATFORM_PARAM_TUNER_INTRANODE_LATENCY_NS] : 0);
+	}
+
 	if (ofi_nccl_net_latency() < 0) {
 		if (platform_data && platform_data->latency >= 0.0) {
 			net_latency = platform_data->latency;
@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "nccl-headers/nvidia/tuner.h"
+#include "nccl_ofi_tuner.h"
+#include "nccl_ofi_log.h"
+#include "nccl_ofi_math.h"
+
+/* Recorded throughputs are quantized to 1/16 of a power of two (~4%) */
+#define THROUGHPUT_STEPS_LOG2	(4)
+/* Recorded times of a choice needed before it can replace another */
+#define MIN_SAMPLES		(2)
+/* Explorations of a choice without recorded times, relative to the
+ * explorations with recorded times */
+#define MAX_EXPLORE_FACTOR	(4)
+
+struct feedback_choice {
+	struct nccl_ofi_tuner_decision decision;
+	/* Number of calls the choice was explored for */
+	uint32_t explored;
+	/* Number of recorded times */
+	uint32_t samples;
+	/* Sum of quantized log2 throughputs of recorded times */
+	int64_t log_throughput_sum;
+};
+
+struct feedback_bucket {
+	/* Number of getCollInfo calls */
+	uint64_t calls;
+	/* Choice used outside of exploration */
+	int current;
+	/* Alternative explored next */
+	int next_explore;
+	int num_choices;
+	struct feedback_choice choices[NCCL_OFI_TUNER_FEEDBACK_CHOICES];
+};
+
+struct nccl_ofi_tuner_feedback {
+	pthread_mutex_t lock;
+	uint64_t explore_period;
+	uint32_t explore_count;
+	struct feedback_bucket buckets[NCCL_NUM_FUNCTIONS][2][NCCL_OFI_TUNER_TABLE_SIZE_BUCKETS];
+};
+
+/*
+ * @brief	Fill choices of bucket with the modeled choice and the
+ *		alternatives within the margin of its cost
+ */
+static void init_bucket(struct nccl_ofi_tuner_context *ctx, ncclFunc_t func, int nvls_support,
+			int bucket_idx, double margin)
+{
+	struct feedback_bucket *bucket = &ctx->feedback->buckets[func][nvls_support][bucket_idx];
+	struct nccl_ofi_tuner_decision choices[NCCL_OFI_TUNER_FEEDBACK_CHOICES];
+	double costs[NCCL_OFI_TUNER_FEEDBACK_CHOICES];
+	const struct nccl_ofi_tuner_decision *modeled = &ctx->table[func][nvls_support][0][bucket_idx];
+	int num_choices;
+
+	if (modeled->algo == NCCL_ALGO_UNDEF) {
+		return;
+	}
+
+	/* The modeled choice comes first, so that it is used until
+	 * feedback shows that an alternative is faster */
+	bucket->choices[0].decision = *modeled;
+	bucket->num_choices = 1;
+	bucket->next_explore = 1;
+
+	num_choices = nccl_ofi_tuner_rank_choices(ctx, func, nvls_support, 1,
+						  nccl_ofi_tuner_bucket_size(bucket_idx),
+						  choices, costs, NCCL_OFI_TUNER_FEEDBACK_CHOICES);
+	for (int i = 0; i < num_choices && bucket->num_choices < NCCL_OFI_TUNER_FEEDBACK_CHOICES; i++) {
+		if (costs[i] > costs[0] * margin) {
+			break;
+		}
+		if (choices[i].algo == modeled->algo && choices[i].proto == modeled->proto) {
+			continue;
+		}
+		bucket->choices[bucket->num_choices++].decision = choices[i];
+	}
+}
+
+int nccl_ofi_tuner_feedback_init(struct nccl_ofi_tuner_context *ctx)
+{
+	double margin = 1.0 + NCCL_OFI_MAX(ofi_nccl_tuner_feedback_margin_pct(), 0) / 100.0;
+
+	ctx->feedback = NULL;
+	if (!ofi_nccl_tuner_feedback()) {
+		return 0;
+	}
+
+	ctx->feedback = calloc(1, sizeof(*ctx->feedback));
+	if (!ctx->feedback) {
+		NCCL_OFI_WARN("Feedback state allocation failed.");
+		return -ENOMEM;
+	}
+
+	if (pthread_mutex_init(&ctx->feedback->lock, NULL) != 0) {
+		NCCL_OFI_WARN("Feedback lock initialization failed.");
+		free(ctx->feedback);
+		ctx->feedback = NULL;
+		return -ENOMEM;
+	}
+	ctx->feedback->explore_period = NCCL_OFI_MAX(ofi_nccl_tuner_feedback_explore_period(), 1);
+	ctx->feedback->explore_count = NCCL_OFI_MAX(ofi_nccl_tuner_feedback_explore_count(), 0);
+
+	for (int func = 0; func < NCCL_NUM_FUNCTIONS; func++) {
+		for (int nvls_support = 0; nvls_support <= 1; nvls_support++) {
+			for (int bucket = 0; bucket < NCCL_OFI_TUNER_TABLE_SIZE_BUCKETS; bucket++) {
+				init_bucket(ctx, func, nvls_support, bucket, margin);
+			}
+		}
+	}
+
+	NCCL_OFI_INFO(NCCL_INIT | NCCL_TUNING,
+		      "Tuner feedback enabled: explore period %lu, %u explorations per choice, margin %.0f%%",
+		      ctx->feedback->explore_period, ctx->feedback->explore_count, (margin - 1.0) * 100);
+
+	return 0;
+}
+
+void nccl_ofi_tuner_feedback_fini(struct nccl_ofi_tuner_context *ctx)
+{
+	if (ctx->feedback) {
+		pthread_mutex_destroy(&ctx->feedback->lock);
+		free(ctx->feedback);
+		ctx->feedback = NULL;
+	}
+}
+
+static struct feedback_bucket *find_bucket(struct nccl_ofi_tuner_context *ctx, ncclFunc_t func,
+					   int nvls_support, int pipe_ops, size_t size)
+{
+	int bucket;
+
+	if (!ctx->feedback || func < 0 || func >= NCCL_NUM_FUNCTIONS || pipe_ops != 1) {
+		return NULL;
+	}
+
+	bucket = nccl_ofi_tuner_size_bucket(size);
+	if (bucket < 0 || ctx->feedback->buckets[func][nvls_support ? 1 : 0][bucket].num_choices == 0) {
+		return NULL;
+	}
+
+	return &ctx->feedback->buckets[func][nvls_support ? 1 : 0][bucket];
+}
+
+/*
+ * @brief	Choose the choice with the highest mean throughput among the
+ *		choices with enough recorded times
+ *
+ * The modeled choice is kept until it has enough recorded times itself.
+ * Means are compared exactly in integer arithmetic, and ties keep the
+ * lower index, i.e., the modeled choice.
+ */
+static int best_choice(const struct feedback_bucket *bucket)
+{
+	int best = 0;
+
+	if (bucket->choices[0].samples < MIN_SAMPLES) {
+		return 0;
+	}
+
+	for (int i = 1; i < bucket->num_choices; i++) {
+		const struct feedback_choice *choice = &bucket->choices[i];
+		const struct feedback_choice *current = &bucket->choices[best];
+
+		if (choice->samples < MIN_SAMPLES) {
+			continue;
+		}
+		if (choice->log_throughput_sum * (int64_t)current->samples >
+		    current->log_throughput_sum * (int64_t)choice->samples) {
+			best = i;
+		}
+	}
+
+	return best;
+}
+
+bool nccl_ofi_tuner_feedback_choose(struct nccl_ofi_tuner_context *ctx, ncclFunc_t func,
+				    int nvls_support, int pipe_ops, size_t size,
+				    int *algo, int *proto, int *channels)
+{
+	struct feedback_bucket *bucket = find_bucket(ctx, func, nvls_support, pipe_ops, size);
+	const struct nccl_ofi_tuner_decision *decision;
+
+	if (!bucket) {
+		return false;
+	}
+
+	pthread_mutex_lock(&ctx->feedback->lock);
+
+	decision = &bucket->choices[bucket->current].decision;
+	if (++bucket->calls % ctx->feedback->explore_period == 0) {
+		/* Revise the choice, and explore the next alternative
+		 * without enough recorded times. Exploration is bounded, in
+		 * case times of explored calls are not recorded. */
+		bucket->current = best_choice(bucket);
+		decision = &bucket->choices[bucket->current].decision;
+
+		for (int i = 1; i < bucket->num_choices; i++) {
+			struct feedback_choice *choice = &bucket->choices[bucket->next_explore];
+
+			bucket->next_explore = 1 + bucket->next_explore % (bucket->num_choices - 1);
+			if (choice != &bucket->choices[bucket->current] &&
+			    choice->samples < ctx->feedback->explore_count &&
+			    choice->explored < MAX_EXPLORE_FACTOR * ctx->feedback->explore_count) {
+				choice->explored++;
+				decision = &choice->decision;
+				break;
+			}
+		}
+	}
+
+	*algo = decision->algo;
+	*proto = decision->proto;
+	*channels = decision->channels;
+
+	pthread_mutex_unlock(&ctx->feedback->lock);
+
+	return true;
+}
+
+int nccl_ofi_tuner_record_feedback(void *context, ncclFunc_t func, size_t size,
+				   int nvls_support, int algo, int proto, int channels,
+				   double time)
+{
+	struct nccl_ofi_tuner_context *ctx = (struct nccl_ofi_tuner_context *)context;
+	struct feedback_bucket *bucket;
+	int64_t log_throughput;
+	int ret = -ENOENT;
+
+	if (!ctx || !(time > 0.0) || size == 0) {
+		return -EINVAL;
+	}
+
+	bucket = find_bucket(ctx, func, nvls_support, 1, size);
+	if (!bucket) {
+		return -ENOENT;
+	}
+
+	log_throughput = llround(log2((double)size / time) * (1 << THROUGHPUT_STEPS_LOG2));
+
+	pthread_mutex_lock(&ctx->feedback->lock);
+	for (int i = 0; i < bucket->num_choices; i++) {
+		struct feedback_choice *choice = &bucket->choices[i];
+
+		if (choice->decision.algo == algo && choice->decision.proto == proto &&
+		    choice->decision.channels == channels) {
+			choice->samples++;
+			choice->log_throughput_sum += log_throughput;
+			ret = 0;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&ctx->feedback->lock);
+
+	return ret;
+}
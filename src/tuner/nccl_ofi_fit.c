@@ -0,0 +1,577 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nccl-headers/nvidia/tuner.h"
+#include "nccl_ofi_tuner.h"
+#include "nccl_ofi_tuner_fit.h"
+#include "nccl_ofi_log.h"
+#include "nccl_ofi_math.h"
+
+/* Maximum length of a CSV line */
+#define FIT_MAX_LINE		(4096)
+/* Maximum number of columns of a CSV line */
+#define FIT_MAX_COLUMNS		(64)
+/* Maximum number of refinements of the bandwidth */
+#define FIT_MAX_ITERS		(32)
+/* Columns with a smaller norm after orthogonalization are dependent */
+#define FIT_RANK_TOLERANCE	(1e-8)
+/* Change of the bandwidth to find whether the network bounds a sample */
+#define FIT_BW_SCALE		(1.001f)
+
+enum csv_column {
+	CSV_COLLECTIVE,
+	CSV_ALGORITHM,
+	CSV_PROTOCOL,
+	CSV_RANKS,
+	CSV_NODES,
+	CSV_CHANNELS,
+	CSV_SIZE,
+	CSV_TIME,
+	CSV_MAX,
+};
+
+static const char *const csv_column_names[CSV_MAX] = {
+	"collective", "algorithm", "protocol", "ranks", "nodes", "channels", "size", "time"
+};
+
+/*
+ * @brief	Compare names ignoring case and underscores
+ */
+static bool name_equal(const char *a, const char *b)
+{
+	for (;;) {
+		while (*a == '_') a++;
+		while (*b == '_') b++;
+		if (tolower((unsigned char)*a) != tolower((unsigned char)*b)) {
+			return false;
+		}
+		if (*a == '\0') {
+			return true;
+		}
+		a++;
+		b++;
+	}
+}
+
+static int lookup_name(const char *const *names, int num_names, const char *name)
+{
+	for (int i = 0; i < num_names; i++) {
+		if (name_equal(names[i], name)) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/*
+ * @brief	Split CSV line in place into trimmed fields
+ *
+ * @return	Number of fields
+ */
+static int split_line(char *line, char **fields)
+{
+	int num_fields = 0;
+	char *saveptr = NULL;
+
+	line[strcspn(line, "\r\n")] = '\0';
+	for (char *field = strtok_r(line, ",", &saveptr);
+	     field && num_fields < FIT_MAX_COLUMNS;
+	     field = strtok_r(NULL, ",", &saveptr)) {
+		char *end;
+
+		while (isspace((unsigned char)*field)) field++;
+		end = field + strlen(field);
+		while (end > field && isspace((unsigned char)end[-1])) end--;
+		*end = '\0';
+		fields[num_fields++] = field;
+	}
+
+	return num_fields;
+}
+
+static int parse_sample(char **fields, const int *columns, nccl_ofi_tuner_sample_t *sample)
+{
+	char *end;
+	long long ival;
+
+	sample->func = lookup_name(nccl_ofi_tuner_func_names, NCCL_NUM_FUNCTIONS,
+				   fields[columns[CSV_COLLECTIVE]]);
+	sample->algo = lookup_name(nccl_ofi_tuner_algo_names, NCCL_NUM_ALGORITHMS,
+				   fields[columns[CSV_ALGORITHM]]);
+	sample->proto = lookup_name(nccl_ofi_tuner_proto_names, NCCL_NUM_PROTOCOLS,
+				    fields[columns[CSV_PROTOCOL]]);
+	if ((int)sample->func < 0 || sample->algo < 0 || sample->proto < 0) {
+		return -EINVAL;
+	}
+
+	for (int col = CSV_RANKS; col <= CSV_SIZE; col++) {
+		errno = 0;
+		ival = strtoll(fields[columns[col]], &end, 10);
+		if (errno || *end != '\0' || end == fields[columns[col]] || ival < 1) {
+			return -EINVAL;
+		}
+		switch (col) {
+		case CSV_RANKS: sample->num_ranks = (int)ival; break;
+		case CSV_NODES: sample->num_nodes = (int)ival; break;
+		case CSV_CHANNELS: sample->channels = (int)ival; break;
+		case CSV_SIZE: sample->size = (size_t)ival; break;
+		}
+	}
+
+	errno = 0;
+	sample->time = strtod(fields[columns[CSV_TIME]], &end);
+	if (errno || *end != '\0' || end == fields[columns[CSV_TIME]] || !(sample->time > 0.0)) {
+		return -EINVAL;
+	}
+
+	if (sample->num_nodes > sample->num_ranks) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int nccl_ofi_tuner_fit_read_csv(FILE *stream, const char *name,
+				nccl_ofi_tuner_sample_t **samples, size_t *num_samples)
+{
+	char line[FIT_MAX_LINE];
+	char *fields[FIT_MAX_COLUMNS];
+	int columns[CSV_MAX];
+	int num_columns = 0;
+	int lineno = 0;
+	size_t capacity = *num_samples;
+
+	while (fgets(line, sizeof(line), stream)) {
+		int num_fields;
+
+		lineno++;
+		if (line[0] == '#' || line[strspn(line, " \t\r\n")] == '\0') {
+			continue;
+		}
+
+		num_fields = split_line(line, fields);
+
+		/* Header */
+		if (num_columns == 0) {
+			for (int col = 0; col < CSV_MAX; col++) {
+				columns[col] = lookup_name((const char *const *)fields, num_fields,
+							   csv_column_names[col]);
+				if (columns[col] < 0) {
+					NCCL_OFI_WARN("%s:%d: Missing column %s", name, lineno,
+						      csv_column_names[col]);
+					return -EINVAL;
+				}
+			}
+			num_columns = num_fields;
+			continue;
+		}
+
+		if (num_fields != num_columns) {
+			NCCL_OFI_WARN("%s:%d: Expected %d columns, but got %d", name, lineno,
+				      num_columns, num_fields);
+			return -EINVAL;
+		}
+
+		if (*num_samples == capacity) {
+			nccl_ofi_tuner_sample_t *grown;
+
+			capacity = capacity ? 2 * capacity : 256;
+			grown = realloc(*samples, capacity * sizeof(**samples));
+			if (!grown) {
+				NCCL_OFI_WARN("Unable to allocate samples");
+				return -ENOMEM;
+			}
+			*samples = grown;
+		}
+
+		if (parse_sample(fields, columns, &(*samples)[*num_samples]) != 0) {
+			NCCL_OFI_WARN("%s:%d: Invalid sample", name, lineno);
+			return -EINVAL;
+		}
+		(*num_samples)++;
+	}
+
+	if (ferror(stream)) {
+		NCCL_OFI_WARN("%s: Read error", name);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+/*
+ * Linear least squares problem. Each sample contributes a row of
+ * features `x`, whose dot product with the unknown parameters predicts
+ * the measured time minus the known part `offset` of the model.
+ */
+struct fit_system {
+	size_t num_rows;
+	/* Column-major features, NCCL_OFI_TUNER_FIT_MAX columns */
+	double *x;
+	double *offset;
+	double *time;
+};
+
+/*
+ * @brief	Compute features of sample with current parameters
+ *
+ * The model is linear in all fitted parameters except the bandwidth.
+ * Its term is linear in the inverse bandwidth if the network bounds the
+ * bandwidth of the algorithm, i.e., the bandwidth of the algorithm
+ * follows a small change of the network bandwidth, and part of the known
+ * offset otherwise (channel or NVLink bound).
+ *
+ * @return	0, on success
+ *		-1, if the sample has no model
+ */
+static int sample_features(struct nccl_ofi_tuner_model_params *params,
+			   const nccl_ofi_tuner_sample_t *sample, double *x, double *offset)
+{
+	struct nccl_ofi_tuner_model_dims dims;
+	struct nccl_ofi_tuner_model_params scaled = *params;
+	struct nccl_ofi_tuner_shape shape, shape_scaled;
+	double bw_time;
+
+	nccl_ofi_tuner_init_dims(&dims, sample->num_ranks, sample->num_nodes, 0, 0);
+	if (nccl_ofi_tuner_compute_shape(params, &dims, sample->func, sample->algo, sample->proto,
+					 sample->channels, &shape) != 0) {
+		return -1;
+	}
+	scaled.internode_bw *= FIT_BW_SCALE;
+	if (nccl_ofi_tuner_compute_shape(&scaled, &dims, sample->func, sample->algo, sample->proto,
+					 sample->channels, &shape_scaled) != 0) {
+		return -1;
+	}
+
+	memset(x, 0, NCCL_OFI_TUNER_FIT_MAX * sizeof(*x));
+	x[NCCL_OFI_TUNER_FIT_NET_LATENCY] = shape.net_steps;
+	if (sample->proto == NCCL_PROTO_SIMPLE) {
+		x[NCCL_OFI_TUNER_FIT_NET_COMP_OVERHEAD] = shape.net_steps;
+	}
+	x[NCCL_OFI_TUNER_FIT_CHANNEL_OVERHEAD] = sample->channels;
+	x[NCCL_OFI_TUNER_FIT_BASE_LATENCY + sample->algo * NCCL_NUM_PROTOCOLS + sample->proto] = 1.0;
+
+	*offset = shape.p2p_latency;
+	bw_time = (double)sample->size * shape.data_ratio / shape.bw;
+	if (fabs(shape_scaled.bw - FIT_BW_SCALE * shape.bw) <= 1e-4 * shape.bw) {
+		x[NCCL_OFI_TUNER_FIT_INTERNODE_BW] = bw_time * params->internode_bw;
+	} else {
+		*offset += bw_time;
+	}
+
+	return 0;
+}
+
+static double dot(const double *a, const double *b, size_t n)
+{
+	double sum = 0.0;
+
+	for (size_t i = 0; i < n; i++) {
+		sum += a[i] * b[i];
+	}
+
+	return sum;
+}
+
+/*
+ * @brief	Solve least squares problem
+ *
+ * Minimizes the squared residuals relative to the measured times, so
+ * that the latencies are fitted to small messages as well as the
+ * bandwidth to large ones. Orthogonalizes the weighted columns in order
+ * with modified Gram-Schmidt. Columns that depend on earlier columns are
+ * not determined by the samples and keep their initial value in theta;
+ * the others are set to their least squares solution.
+ *
+ * @param	theta
+ *		Initial values on input, solution on output
+ * @return	0, on success
+ *		-ENOMEM, on allocation failure
+ */
+static int solve(const struct fit_system *sys, double *theta, bool *fitted)
+{
+	const size_t n = sys->num_rows;
+	const int k = NCCL_OFI_TUNER_FIT_MAX;
+	double *q = calloc((size_t)k * n, sizeof(double));
+	double *target = calloc(n, sizeof(double));
+	double r[NCCL_OFI_TUNER_FIT_MAX][NCCL_OFI_TUNER_FIT_MAX] = { { 0 } };
+	double norm[NCCL_OFI_TUNER_FIT_MAX];
+	double qt[NCCL_OFI_TUNER_FIT_MAX];
+	int accepted[NCCL_OFI_TUNER_FIT_MAX];
+	int num_accepted = 0;
+
+	if (!q || !target) {
+		free(q);
+		free(target);
+		return -ENOMEM;
+	}
+
+	for (int j = 0; j < k; j++) {
+		const double *col = &sys->x[(size_t)j * n];
+		double *v = &q[(size_t)num_accepted * n];
+
+		fitted[j] = false;
+		for (size_t i = 0; i < n; i++) {
+			v[i] = col[i] / sys->time[i];
+		}
+		norm[j] = sqrt(dot(v, v, n));
+		if (norm[j] == 0.0) {
+			continue;
+		}
+		for (size_t i = 0; i < n; i++) {
+			v[i] /= norm[j];
+		}
+
+		/* Orthogonalize twice for numerical stability */
+		for (int pass = 0; pass < 2; pass++) {
+			for (int a = 0; a < num_accepted; a++) {
+				const double *qa = &q[(size_t)a * n];
+				double proj = dot(qa, v, n);
+
+				r[a][num_accepted] += proj;
+				for (size_t i = 0; i < n; i++) {
+					v[i] -= proj * qa[i];
+				}
+			}
+		}
+
+		r[num_accepted][num_accepted] = sqrt(dot(v, v, n));
+		if (r[num_accepted][num_accepted] < FIT_RANK_TOLERANCE) {
+			for (int a = 0; a < num_accepted; a++) {
+				r[a][num_accepted] = 0.0;
+			}
+			continue;
+		}
+		for (size_t i = 0; i < n; i++) {
+			v[i] /= r[num_accepted][num_accepted];
+		}
+		fitted[j] = true;
+		accepted[num_accepted++] = j;
+	}
+
+	/* Columns not determined by the samples keep their initial value */
+	for (size_t i = 0; i < n; i++) {
+		target[i] = sys->time[i] - sys->offset[i];
+		for (int j = 0; j < k; j++) {
+			if (!fitted[j]) {
+				target[i] -= theta[j] * sys->x[(size_t)j * n + i];
+			}
+		}
+		target[i] /= sys->time[i];
+	}
+
+	/* Back substitution of R * theta = Q^T * target */
+	for (int a = 0; a < num_accepted; a++) {
+		qt[a] = dot(&q[(size_t)a * n], target, n);
+	}
+	for (int a = num_accepted - 1; a >= 0; a--) {
+		double sum = qt[a];
+
+		for (int b = a + 1; b < num_accepted; b++) {
+			sum -= r[a][b] * qt[b];
+		}
+		qt[a] = sum / r[a][a];
+		theta[accepted[a]] = qt[a] / norm[accepted[a]];
+	}
+
+	free(q);
+	free(target);
+	return 0;
+}
+
+static void params_to_theta(const struct nccl_ofi_tuner_model_params *params, double *theta)
+{
+	theta[NCCL_OFI_TUNER_FIT_NET_LATENCY] = params->net_lat;
+	theta[NCCL_OFI_TUNER_FIT_NET_COMP_OVERHEAD] = params->net_comp_overhead;
+	theta[NCCL_OFI_TUNER_FIT_INTERNODE_BW] = 1.0 / params->internode_bw;
+	theta[NCCL_OFI_TUNER_FIT_CHANNEL_OVERHEAD] = params->channel_overhead;
+	for (int algo = 0; algo < NCCL_NUM_ALGORITHMS; algo++) {
+		for (int proto = 0; proto < NCCL_NUM_PROTOCOLS; proto++) {
+			theta[NCCL_OFI_TUNER_FIT_BASE_LATENCY + algo * NCCL_NUM_PROTOCOLS + proto] =
+				params->base_lat[algo][proto];
+		}
+	}
+}
+
+/*
+ * @brief	Set parameters from solution
+ *
+ * Negative times are not meaningful for the tuner and are clamped to
+ * zero; a non-positive inverse bandwidth keeps the initial bandwidth.
+ */
+static void theta_to_params(const double *theta, bool *fitted,
+			    struct nccl_ofi_tuner_model_params *params)
+{
+	double clamped[NCCL_OFI_TUNER_FIT_MAX];
+
+	for (int j = 0; j < NCCL_OFI_TUNER_FIT_MAX; j++) {
+		clamped[j] = theta[j];
+		if (fitted[j] && theta[j] < 0.0) {
+			NCCL_OFI_WARN("Fitted parameter %d is negative (%g)", j, theta[j]);
+			clamped[j] = 0.0;
+		}
+	}
+
+	params->net_lat = clamped[NCCL_OFI_TUNER_FIT_NET_LATENCY];
+	params->net_comp_overhead = clamped[NCCL_OFI_TUNER_FIT_NET_COMP_OVERHEAD];
+	if (clamped[NCCL_OFI_TUNER_FIT_INTERNODE_BW] > 0.0) {
+		params->internode_bw = 1.0 / clamped[NCCL_OFI_TUNER_FIT_INTERNODE_BW];
+		params->loggp_G = clamped[NCCL_OFI_TUNER_FIT_INTERNODE_BW];
+	} else {
+		fitted[NCCL_OFI_TUNER_FIT_INTERNODE_BW] = false;
+	}
+	params->channel_overhead = clamped[NCCL_OFI_TUNER_FIT_CHANNEL_OVERHEAD];
+	for (int algo = 0; algo < NCCL_NUM_ALGORITHMS; algo++) {
+		for (int proto = 0; proto < NCCL_NUM_PROTOCOLS; proto++) {
+			params->base_lat[algo][proto] =
+				clamped[NCCL_OFI_TUNER_FIT_BASE_LATENCY + algo * NCCL_NUM_PROTOCOLS + proto];
+		}
+	}
+}
+
+/*
+ * @brief	Build least squares problem for current parameters
+ */
+static void build_system(struct nccl_ofi_tuner_model_params *params,
+			 const nccl_ofi_tuner_sample_t *samples, size_t num_samples,
+			 struct fit_system *sys)
+{
+	double x[NCCL_OFI_TUNER_FIT_MAX];
+	size_t row = 0;
+
+	for (size_t s = 0; s < num_samples; s++) {
+		if (sample_features(params, &samples[s], x, &sys->offset[row]) != 0) {
+			continue;
+		}
+		for (int j = 0; j < NCCL_OFI_TUNER_FIT_MAX; j++) {
+			sys->x[(size_t)j * num_samples + row] = x[j];
+		}
+		sys->time[row] = samples[s].time;
+		row++;
+	}
+
+	/* Compact columns to the number of rows with a model */
+	for (int j = 1; j < NCCL_OFI_TUNER_FIT_MAX; j++) {
+		memmove(&sys->x[(size_t)j * row], &sys->x[(size_t)j * num_samples],
+			row * sizeof(double));
+	}
+	sys->num_rows = row;
+}
+
+int nccl_ofi_tuner_fit(const nccl_ofi_tuner_sample_t *samples, size_t num_samples,
+		       const struct nccl_ofi_tuner_model_params *initial,
+		       nccl_ofi_tuner_fit_result_t *result)
+{
+	int ret = 0;
+	double theta[NCCL_OFI_TUNER_FIT_MAX];
+	struct fit_system sys = {
+		.x = calloc(NCCL_OFI_TUNER_FIT_MAX * NCCL_OFI_MAX(num_samples, 1), sizeof(double)),
+		.offset = calloc(NCCL_OFI_MAX(num_samples, 1), sizeof(double)),
+		.time = calloc(NCCL_OFI_MAX(num_samples, 1), sizeof(double)),
+	};
+
+	if (!sys.x || !sys.offset || !sys.time) {
+		ret = -ENOMEM;
+		goto exit;
+	}
+
+	memset(result, 0, sizeof(*result));
+	result->params = *initial;
+
+	/*
+	 * Whether the network bounds the bandwidth of a sample depends on
+	 * the bandwidth, so refine it until the bound of no sample changes.
+	 */
+	for (int iter = 0; iter < FIT_MAX_ITERS; iter++) {
+		float prev_bw = result->params.internode_bw;
+
+		build_system(&result->params, samples, num_samples, &sys);
+		if (sys.num_rows == 0) {
+			NCCL_OFI_WARN("No sample has a model");
+			ret = -EINVAL;
+			goto exit;
+		}
+
+		params_to_theta(initial, theta);
+		ret = solve(&sys, theta, result->fitted);
+		if (ret != 0) {
+			goto exit;
+		}
+		theta_to_params(theta, result->fitted, &result->params);
+
+		if (fabsf(result->params.internode_bw - prev_bw) <= 1e-6 * prev_bw) {
+			break;
+		}
+	}
+
+	/* Residuals of the fitted parameters */
+	build_system(&result->params, samples, num_samples, &sys);
+	params_to_theta(&result->params, theta);
+	result->num_samples = sys.num_rows;
+	for (size_t i = 0; i < sys.num_rows; i++) {
+		double predicted = sys.offset[i];
+		double residual;
+
+		for (int j = 0; j < NCCL_OFI_TUNER_FIT_MAX; j++) {
+			predicted += theta[j] * sys.x[(size_t)j * sys.num_rows + i];
+		}
+		residual = sys.time[i] - predicted;
+		result->rms_residual += residual * residual;
+		result->max_rel_residual = NCCL_OFI_MAX(result->max_rel_residual,
+							fabs(residual) / sys.time[i]);
+	}
+	result->rms_residual = sqrt(result->rms_residual / sys.num_rows);
+
+ exit:
+	free(sys.x);
+	free(sys.offset);
+	free(sys.time);
+	return ret;
+}
+
+int nccl_ofi_tuner_fit_write(FILE *stream, const nccl_ofi_tuner_fit_result_t *result)
+{
+	const struct nccl_ofi_tuner_model_params *params = &result->params;
+	const bool *fitted = result->fitted;
+	bool base_fitted = false;
+
+	fprintf(stream, "# Tuner parameters fitted to %zu samples\n", result->num_samples);
+	fprintf(stream, "# RMS residual %.3f us, largest relative residual %.1f%%\n",
+		result->rms_residual, 100.0 * result->max_rel_residual);
+
+	fprintf(stream, "[model]\n");
+	if (fitted[NCCL_OFI_TUNER_FIT_NET_LATENCY])
+		fprintf(stream, "net_latency = %.3f\n", params->net_lat);
+	if (fitted[NCCL_OFI_TUNER_FIT_NET_COMP_OVERHEAD])
+		fprintf(stream, "net_comp_overhead = %.3f\n", params->net_comp_overhead);
+	if (fitted[NCCL_OFI_TUNER_FIT_INTERNODE_BW])
+		fprintf(stream, "internode_bw = %.1f\n", params->internode_bw);
+	if (fitted[NCCL_OFI_TUNER_FIT_CHANNEL_OVERHEAD])
+		fprintf(stream, "channel_overhead = %.3f\n", params->channel_overhead);
+
+	for (int algo = 0; algo < NCCL_NUM_ALGORITHMS; algo++) {
+		for (int proto = 0; proto < NCCL_NUM_PROTOCOLS; proto++) {
+			if (!fitted[NCCL_OFI_TUNER_FIT_BASE_LATENCY + algo * NCCL_NUM_PROTOCOLS + proto]) {
+				continue;
+			}
+			if (!base_fitted) {
+				fprintf(stream, "\n[base_latency]\n");
+				base_fitted = true;
+			}
+			fprintf(stream, "%s.%s = %.3f\n", nccl_ofi_tuner_algo_names[algo],
+				nccl_ofi_tuner_proto_names[proto], params->base_lat[algo][proto]);
+		}
+	}
+
+	return ferror(stream) ? -EIO : 0;
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+
+#include "nccl-headers/nvidia/tuner.h"
+#include "nccl_ofi_tuner.h"
+#include "nccl_ofi_log.h"
+
+extern const ncclTuner_v2_t ncclTunerPlugin_v2;
+
+void nccl_ofi_tuner_map_write_header(FILE *stream)
+{
+	fprintf(stream, "collective,ranks,nodes,nvls,pipe_ops,size,algorithm,protocol,channels,cost\n");
+}
+
+int nccl_ofi_tuner_map_write(FILE *stream, void *context,
+			     const struct nccl_ofi_tuner_map_grid *grid)
+{
+	struct nccl_ofi_tuner_context *ctx = (struct nccl_ofi_tuner_context *)context;
+
+	for (int func = 0; func < NCCL_NUM_FUNCTIONS; func++) {
+		if (!(grid->funcs & (1U << func))) {
+			continue;
+		}
+
+		for (int nvls_support = 0; nvls_support <= (grid->nvls_support ? 1 : 0); nvls_support++) {
+			for (int pipe_ops = grid->min_pipe_ops; pipe_ops <= grid->max_pipe_ops; pipe_ops++) {
+				for (size_t size = grid->min_size; size <= grid->max_size && size != 0; size *= 2) {
+					int algo = NCCL_ALGO_UNDEF, proto = NCCL_PROTO_UNDEF, channels = 0;
+
+					fprintf(stream, "%s,%d,%d,%d,%d,%zu,", nccl_ofi_tuner_func_names[func],
+						ctx->dims.num_ranks, ctx->dims.num_nodes, nvls_support,
+						pipe_ops, size);
+
+					/* Query the plugin as NCCL does, including its fallbacks */
+					if (ncclTunerPlugin_v2.getCollInfo(context, func, size, 0, nvls_support,
+									   pipe_ops, &algo, &proto,
+									   &channels) != ncclSuccess ||
+					    algo == NCCL_ALGO_UNDEF) {
+						fprintf(stream, "nccl,,,\n");
+						continue;
+					}
+
+					fprintf(stream, "%s,%s,%d,%.3f\n", nccl_ofi_tuner_algo_names[algo],
+						nccl_ofi_tuner_proto_names[proto], channels,
+						ctx->model->compute_cost(&ctx->model_params, &ctx->dims, func,
+									 algo, proto, pipe_ops, channels,
+									 size));
+				}
+			}
+		}
+	}
+
+	return ferror(stream) ? -EIO : 0;
+}
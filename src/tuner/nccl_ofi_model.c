@@ -1,6 +1,10 @@
 #include "config.h"
 
+#include <errno.h>
+#include <float.h>
+#include <stdbool.h>
 #include <stdlib.h>
+#include <strings.h>
 #include <math.h>
 
 #include "nccl-headers/nvidia/tuner.h"
@@ -8,38 +12,80 @@
 #include "nccl_ofi_log.h"
 #include "nccl_ofi_math.h"
 
-float nccl_ofi_tuner_compute_base_cost(ncclFunc_t func, int algo, int proto)
+/*
+ * Bandwidth of `channels` channels on a link of bandwidth `link_bw`.
+ * Each channel drives at most NCCL_OFI_TUNER_CHANNEL_BW, and all
+ * channels together saturate the link:
+ *   bw(c) = min(c * channel_bw, link_bw)
+ */
+static inline float channel_bw(int channels, float link_bw)
 {
+	return NCCL_OFI_MIN(channels * NCCL_OFI_TUNER_CHANNEL_BW, link_bw);
+}
+
+/*
+ * Fraction of the bytes on the wire that is payload for each protocol.
+ * LL sends 8B lines with 4B data and 4B flags; LL128 sends 128B lines
+ * with 120B data and 8B flags.
+ */
+static const float proto_efficiency[NCCL_NUM_PROTOCOLS] = { 0.5, 0.9375, 1.0 };
+
+/*
+ * Payload bytes each channel sends per NCCL step, i.e., the size of the
+ * network messages of a large collective:
+ *   LL:     8 lines * 512 threads * 16B / 8 steps * 50% payload
+ *   LL128:  120 elems * 640 threads * 8B / 8 steps * 93.75% payload
+ *   Simple: 4MiB buffer / 8 steps
+ */
+static const float proto_chunk_size[NCCL_NUM_PROTOCOLS] = { 32768, 576000, 524288 };
+
+int nccl_ofi_tuner_init_dims(struct nccl_ofi_tuner_model_dims *dims, int num_ranks, int num_nodes,
+			     int max_local_ranks, int min_local_ranks)
+{
+	dims->num_ranks = num_ranks;
+	dims->num_nodes = num_nodes;
+	/* Most even placement */
+	dims->max_local_ranks = (num_ranks + num_nodes - 1) / num_nodes;
+	dims->min_local_ranks = num_ranks / num_nodes;
+
+	if (max_local_ranks == 0 && min_local_ranks == 0) {
+		return 0;
+	}
+
 	/*
-	 * Just passing up the NCCL base latencies for now. These costs could be
-	 * computed too, but that can come as a follow up.
+	 * One node with max_local_ranks and one with min_local_ranks, and
+	 * the others with any count in between, need to add up to the
+	 * communicator size.
 	 */
-	return nccl_base_lat[algo][proto];
+	if (min_local_ranks < 1 || max_local_ranks < min_local_ranks ||
+	    (num_nodes == 1 && max_local_ranks != min_local_ranks) ||
+	    max_local_ranks + (long)min_local_ranks * (num_nodes - 1) > num_ranks ||
+	    (long)max_local_ranks * (num_nodes - 1) + min_local_ranks < num_ranks) {
+		return -EINVAL;
+	}
+
+	dims->max_local_ranks = max_local_ranks;
+	dims->min_local_ranks = min_local_ranks;
+
+	return 0;
 }
 
-float nccl_ofi_tuner_compute_cost(struct nccl_ofi_tuner_model_params *params, struct nccl_ofi_tuner_model_dims *dims,
-                                  ncclFunc_t func, int algo, int proto, int pipe_ops, size_t size)
+/*
+ * The comments give the Hockney cost of each shape, where
+ * net_bw(c) = channel_bw(c, rail_bw * rails).
+ */
+int nccl_ofi_tuner_compute_shape(struct nccl_ofi_tuner_model_params *params, struct nccl_ofi_tuner_model_dims *dims,
+				 ncclFunc_t func, int algo, int proto, int channels,
+				 struct nccl_ofi_tuner_shape *shape)
 {
-	float cost = -1;
-	float latency = 0;
-	float bw = 0;
-	float p2p_lat = 0;
-	float net_lat = 0;
+	float p2p_lat = nccl_nvlink_lat[algo][proto] * params->intranode_lat_scale;
+	/* Bandwidth of the rails of a rank used by all channels */
+	float net_bw = channel_bw(channels, params->internode_bw * params->num_rails);
+	float net_time, nvlink_time;
 	int num_steps = 0;
 	int num_internode_steps = 0;
 
-	/*
-	 * There is more involved than the NET_COMP_OVERHEAD itself for the
-	 * simple protocol, including overheads from libfabric and NCCL's proxy
-	 * thread itself in processing a completion handed to the host by the
-	 * device. Costs associated with out-of-order completions that could
-	 * stall the pipeline should be captured here as well.
-	 */
-	net_lat = (proto == NCCL_PROTO_SIMPLE)
-		    ? params->net_lat + ofi_nccl_tuner_net_comp_overhead()
-		    : params->net_lat;
-
-	p2p_lat = nccl_nvlink_lat[algo][proto];
+	shape->data_ratio = 1.0;
 
 	switch(func) {
 	case ncclFuncAllReduce:
@@ -47,27 +93,119 @@ float nccl_ofi_tuner_compute_cost(struct nccl_ofi_tuner_model_params *params, st
 		case NCCL_ALGO_RING:
 			num_steps = 2 * (dims->num_ranks - 1);
 			num_internode_steps = 2 * dims->num_nodes;
-			latency = (num_internode_steps * net_lat)
-				  + (num_steps - num_internode_steps) * p2p_lat;
-			bw = params->internode_bw * params->num_rails * ofi_nccl_tuner_num_channels();
+			shape->net_steps = num_internode_steps;
+			shape->p2p_latency = (num_steps - num_internode_steps) * p2p_lat;
+			shape->bw = net_bw;
+			shape->net_pieces = num_steps;
 			break;
 
 		case NCCL_ALGO_NVLS_TREE:
-			latency = 2 * (p2p_lat + (log2(dims->num_nodes) * net_lat));
-			bw = NCCL_OFI_MIN(params->intranode_bw, (params->internode_bw * params->num_rails) / 2)
-			     * ofi_nccl_tuner_num_channels();
+			shape->net_steps = 2 * log2(dims->num_nodes);
+			shape->p2p_latency = 2 * p2p_lat;
+			shape->bw = NCCL_OFI_MIN(params->intranode_bw * channels, net_bw / 2);
+			shape->net_pieces = 1;
 			break;
 
 		case NCCL_ALGO_TREE:
-			latency = ((2 * ((dims->num_ranks / dims->num_nodes) - 1) * p2p_lat)
-				   + (2 * log2(dims->num_nodes) * net_lat));
-			bw = (params->internode_bw * params->num_rails * ofi_nccl_tuner_num_channels()) / 2;
+			shape->net_steps = 2 * log2(dims->num_nodes);
+			/* Chains through the ranks of the node with the most ranks */
+			shape->p2p_latency = 2 * (dims->max_local_ranks - 1) * p2p_lat;
+			shape->bw = net_bw / 2;
+			shape->net_pieces = 1;
+			break;
+
+		default:
+			NCCL_OFI_TRACE(NCCL_TUNING, "Algorithm %d for collective %d  without a model.", algo, func);
+			return -1;
+		}
+		shape->net_ratio = shape->data_ratio;
+		break;
+
+	case ncclFuncAllGather:
+	case ncclFuncReduceScatter:
+		/*
+		 * NCCL implements AllGather and ReduceScatter only with Ring,
+		 * NVLS and PAT. In all of them, each rank receives (AllGather)
+		 * or sends (ReduceScatter) the (n - 1) / n of the message that
+		 * belongs to the other ranks. PAT is newer than the vendored
+		 * NCCL headers and left to NCCL's own tuning.
+		 */
+		shape->data_ratio = (float)(dims->num_ranks - 1) / dims->num_ranks;
+		shape->net_ratio = shape->data_ratio;
+
+		switch(algo) {
+		case NCCL_ALGO_RING:
+			/*
+			 * Each chunk travels n - 1 hops around the ring, nodes - 1
+			 * of which cross the network:
+			 *   t = (nodes - 1) * net_lat + (n - nodes) * p2p_lat
+			 *       + ((n - 1) / n) * m / net_bw(c)
+			 */
+			num_steps = dims->num_ranks - 1;
+			num_internode_steps = dims->num_nodes - 1;
+			shape->net_steps = num_internode_steps;
+			shape->p2p_latency = (num_steps - num_internode_steps) * p2p_lat;
+			shape->bw = net_bw;
+			shape->net_pieces = num_steps;
+			break;
+
+		case NCCL_ALGO_NVLS:
+			/*
+			 * Ranks of a node combine their data with a single NVLink
+			 * SHARP multicast/reduction, and nodes exchange their data
+			 * in a ring over the network. Each of the l ranks of a node
+			 * moves its share (nodes - 1) / (nodes * l) of the message
+			 * over its rails, and receives (n - 1) / n of the message
+			 * over NVLink; the two stages are pipelined, so the slower
+			 * one bounds the bandwidth. The node with the fewest ranks
+			 * has the largest share per rank:
+			 *   t = p2p_lat + (nodes - 1) * net_lat
+			 *       + max(((nodes - 1) / (nodes * l_min)) * m / net_bw(c),
+			 *             ((n - 1) / n) * m / (nvlink_bw * c))
+			 */
+			if (proto != NCCL_PROTO_SIMPLE)
+				return -1;
+			shape->net_steps = dims->num_nodes - 1;
+			shape->p2p_latency = p2p_lat;
+			shape->net_ratio = (float)(dims->num_nodes - 1)
+					   / ((float)dims->num_nodes * dims->min_local_ranks);
+			net_time = shape->net_ratio / net_bw;
+			nvlink_time = shape->data_ratio / (params->intranode_bw * channels);
+			shape->bw = shape->data_ratio / NCCL_OFI_MAX(net_time, nvlink_time);
+			shape->net_pieces = dims->num_nodes - 1;
+			break;
+
+		default:
+			NCCL_OFI_TRACE(NCCL_TUNING, "Algorithm %d for collective %d  without a model.", algo, func);
+			return -1;
+		}
+		break;
+
+	case ncclFuncBroadcast:
+	case ncclFuncReduce:
+		/*
+		 * NCCL implements Broadcast and Reduce only with Ring, as a
+		 * pipelined chain from (Broadcast) or to (Reduce) the root.
+		 * Each rank forwards the whole message once, and the first
+		 * chunk takes n - 1 hops, nodes - 1 of which cross the network:
+		 *   t = (nodes - 1) * net_lat + (n - nodes) * p2p_lat
+		 *       + m / net_bw(c)
+		 */
+		switch(algo) {
+		case NCCL_ALGO_RING:
+			num_steps = dims->num_ranks - 1;
+			num_internode_steps = dims->num_nodes - 1;
+			shape->net_steps = num_internode_steps;
+			shape->p2p_latency = (num_steps - num_internode_steps) * p2p_lat;
+			shape->bw = net_bw;
+			shape->net_pieces = 1;
 			break;
 
 		default:
 			NCCL_OFI_TRACE(NCCL_TUNING, "Algorithm %d for collective %d  without a model.", algo, func);
 			return -1;
 		}
+		shape->net_ratio = shape->data_ratio;
 		break;
 
 	default:
@@ -76,39 +214,347 @@ float nccl_ofi_tuner_compute_cost(struct nccl_ofi_tuner_model_params *params, st
 	}
 
 	/* Penalize the low-latency protocol bandwidths for their overhead */
-	if (proto == NCCL_PROTO_LL)
-		/* 8B total with 4B data and 4B flags, so take a 50% hit */
-		bw *= 0.5;
-	else if (proto == NCCL_PROTO_LL128)
-		/* 120B data and 8B flags */
-		bw *= 0.9375;
+	shape->bw *= proto_efficiency[proto];
+
+	return 0;
+}
+
+/*
+ * Network latency of a hop in µsecs.
+ *
+ * There is more involved than the NET_COMP_OVERHEAD itself for the
+ * simple protocol, including overheads from libfabric and NCCL's proxy
+ * thread itself in processing a completion handed to the host by the
+ * device. Costs associated with out-of-order completions that could
+ * stall the pipeline should be captured here as well.
+ */
+static inline float hop_latency(struct nccl_ofi_tuner_model_params *params, int proto)
+{
+	return (proto == NCCL_PROTO_SIMPLE)
+		? params->net_lat + params->net_comp_overhead
+		: params->net_lat;
+}
+
+/*
+ * Costs of the channels: each channel adds a fixed overhead to every
+ * pipelined operation, and costs an SM that is not available to compute
+ * kernels for the duration of the collective.
+ */
+static inline double channel_cost(struct nccl_ofi_tuner_model_params *params, int pipe_ops,
+				  int channels)
+{
+	return (double)channels * params->channel_overhead * pipe_ops
+		+ (double)channels * params->sm_cost;
+}
+
+/*
+ * Simplest hockney based: t = (⍺ + βm), plus the base latency of the
+ * algorithm and protocol.
+ *
+ * The cost is evaluated in double precision; in single precision, the
+ * bandwidth term of small messages vanishes next to the latency term,
+ * which makes protocol choices flip between sizes.
+ */
+static double hockney_cost(struct nccl_ofi_tuner_model_params *params, struct nccl_ofi_tuner_model_dims *dims,
+			   ncclFunc_t func, int algo, int proto, int pipe_ops, int channels,
+			   size_t size)
+{
+	struct nccl_ofi_tuner_shape shape;
+	double latency;
+
+	if (nccl_ofi_tuner_compute_shape(params, dims, func, algo, proto, channels, &shape) != 0)
+		return -1;
+
+	latency = params->base_lat[algo][proto]
+		  + (double)shape.net_steps * hop_latency(params, proto) + shape.p2p_latency;
+
+	return latency * pipe_ops + channel_cost(params, pipe_ops, channels)
+		+ ((double)size * shape.data_ratio) / shape.bw;
+}
+
+/*
+ * LogGP: a message of k bytes on a rail takes L + 2o + (k - 1)G, and
+ * consecutive messages on a rail are at least max(g, o, kG) apart.
+ *
+ * Filling the pipeline takes L + 2o for each network hop of the critical
+ * path. Each channel then sends its network data in one message per
+ * algorithm step, split into messages of at most the protocol's chunk
+ * size, and the messages of all channels are spread over the rails the
+ * channels use, unless the algorithm's bandwidth (NVLink, channel
+ * limits) is the tighter bound:
+ *   k = net_ratio * m / max(pieces * c, net_ratio * m / chunk)
+ *   t = net_steps * (L + 2o) + p2p_latency
+ *       + max((net_ratio * m / k) / min(c, rails) * max(g, o, kG),
+ *             data_ratio * m / bw)
+ *
+ * Unlike Hockney, the per-message overhead and gap are paid for every
+ * message instead of once per hop, which dominates mid-size messages
+ * that are split into many small messages. Messages are not rounded to
+ * whole counts, so that the cost is continuous in the message size.
+ */
+static double loggp_cost(struct nccl_ofi_tuner_model_params *params, struct nccl_ofi_tuner_model_dims *dims,
+			 ncclFunc_t func, int algo, int proto, int pipe_ops, int channels,
+			 size_t size)
+{
+	struct nccl_ofi_tuner_shape shape;
+	double latency, net_bytes, num_msgs, gap, stream_time;
+	double byte_gap = params->loggp_G / proto_efficiency[proto];
+	int rails = NCCL_OFI_MIN(channels, params->num_rails);
+
+	if (nccl_ofi_tuner_compute_shape(params, dims, func, algo, proto, channels, &shape) != 0)
+		return -1;
+
+	latency = params->base_lat[algo][proto]
+		  + (double)shape.net_steps * (hop_latency(params, proto) + 2 * params->loggp_o)
+		  + shape.p2p_latency;
+
+	net_bytes = (double)size * shape.net_ratio;
+	num_msgs = NCCL_OFI_MAX((double)shape.net_pieces * channels,
+				net_bytes / proto_chunk_size[proto]);
+	gap = NCCL_OFI_MAX(NCCL_OFI_MAX(params->loggp_g, params->loggp_o),
+			   (net_bytes / num_msgs) * byte_gap);
+	stream_time = NCCL_OFI_MAX(num_msgs / rails * gap,
+				   ((double)size * shape.data_ratio) / shape.bw);
+
+	return latency * pipe_ops + channel_cost(params, pipe_ops, channels) + stream_time;
+}
+
+const struct nccl_ofi_tuner_model nccl_ofi_tuner_models[] = {
+	{ .name = "hockney", .compute_cost = hockney_cost },
+	{ .name = "loggp", .compute_cost = loggp_cost },
+	{ .name = NULL },
+};
+
+const struct nccl_ofi_tuner_model *nccl_ofi_tuner_find_model(const char *name)
+{
+	const struct nccl_ofi_tuner_model *model;
+
+	for (model = nccl_ofi_tuner_models; model->name != NULL; model++) {
+		if (strcasecmp(model->name, name) == 0)
+			return model;
+	}
+
+	return NULL;
+}
+
+
+/*
+ * Channel counts evaluated by the tuner are the powers of two below the
+ * maximum and the maximum itself.
+ */
+static inline int next_channels(int channels, int max_channels)
+{
+	if (channels < max_channels && channels * 2 > max_channels)
+		return max_channels;
+	return channels * 2;
+}
+
+
+/*
+ * Algorithms and protocols considered by the tuner for a collective.
+ */
+static bool choice_supported(ncclFunc_t func, int nvls_support, int algo, int proto)
+{
+	/* No CollNet on AWS today */
+	if (algo == NCCL_ALGO_COLLNET_DIRECT || algo == NCCL_ALGO_COLLNET_CHAIN)
+		return false;
 
 	/*
-	 * Simplest hockney based: t = (⍺ + βm).
-	 * When extending to LogGP or other models, implement separate cost
-	 * functions and pick with a model config env rather than overwriting
-	 * this one cost function.
+	 * NCCL_ALGO_NVLS is used for AllReduce only in single-node
+	 * jobs, but multi-node AllGather and ReduceScatter use it.
 	 */
-	cost = (latency * pipe_ops) + size / bw;
+	if (algo == NCCL_ALGO_NVLS && func == ncclFuncAllReduce)
+		return false;
+
+	if (!nvls_support && (algo == NCCL_ALGO_NVLS || algo == NCCL_ALGO_NVLS_TREE))
+		return false;
+
+	/* This is not a supported combination in NCCL */
+	if (algo == NCCL_ALGO_NVLS_TREE && proto != NCCL_PROTO_SIMPLE)
+		return false;
+
+	return true;
+}
+
+
+double nccl_ofi_tuner_compute_decision(struct nccl_ofi_tuner_context *ctx, ncclFunc_t func,
+				       int nvls_support, int pipe_ops, size_t size,
+				       int *algo_out, int *proto_out, int *channels_out)
+{
+	double cost = 0;
+	double lowest = DBL_MAX;
+	int algo, proto = 0, channels;
+	int max_channels = ctx->model_params.max_channels;
+
+	for (algo = 0; algo < NCCL_NUM_ALGORITHMS; algo++) {
+		for (proto = 0; proto < NCCL_NUM_PROTOCOLS; proto++) {
+			if (!choice_supported(func, nvls_support, algo, proto))
+				continue;
+
+			for (channels = 1; channels <= max_channels;
+			     channels = next_channels(channels, max_channels)) {
+				cost = ctx->model->compute_cost(&ctx->model_params, &ctx->dims,
+								func, algo, proto, pipe_ops, channels,
+								size);
+				if (cost < 0)
+					break;
+
+				NCCL_OFI_TRACE(NCCL_TUNING, "Computed cost for algo %d proto %d pipe %d channels %d: cost %.8f µsecs.",
+					       algo, proto, pipe_ops, channels, cost);
+				if (cost < lowest) {
+					*algo_out = algo;
+					*proto_out = proto;
+					*channels_out = channels;
+					lowest = cost;
+				}
+			}
+		}
+	}
+
+	return (lowest == DBL_MAX) ? -1 : lowest;
+}
+
+
+/*
+ * Lowest cost of an algorithm and protocol over the channel counts, or
+ * DBL_MAX if the combination has no model.
+ */
+static double lowest_channels_cost(struct nccl_ofi_tuner_context *ctx, ncclFunc_t func,
+				   int algo, int proto, int pipe_ops, size_t size,
+				   int *best_channels)
+{
+	double lowest = DBL_MAX;
+	int max_channels = ctx->model_params.max_channels;
 
-	return cost;
+	for (int channels = 1; channels <= max_channels;
+	     channels = next_channels(channels, max_channels)) {
+		double cost = ctx->model->compute_cost(&ctx->model_params, &ctx->dims,
+						       func, algo, proto, pipe_ops,
+						       channels, size);
+		if (cost < 0)
+			break;
+		if (cost < lowest) {
+			lowest = cost;
+			*best_channels = channels;
+		}
+	}
+
+	return lowest;
+}
+
+
+int nccl_ofi_tuner_rank_choices(struct nccl_ofi_tuner_context *ctx, ncclFunc_t func,
+				int nvls_support, int pipe_ops, size_t size,
+				struct nccl_ofi_tuner_decision *choices, double *costs,
+				int max_choices)
+{
+	int num_choices = 0;
+
+	for (int algo = 0; algo < NCCL_NUM_ALGORITHMS; algo++) {
+		for (int proto = 0; proto < NCCL_NUM_PROTOCOLS; proto++) {
+			double lowest;
+			int best_channels = 0;
+			int i;
+
+			if (!choice_supported(func, nvls_support, algo, proto))
+				continue;
+
+			lowest = lowest_channels_cost(ctx, func, algo, proto, pipe_ops, size,
+						      &best_channels);
+			if (lowest == DBL_MAX)
+				continue;
+
+			/* Insert into choices sorted by cost, dropping the most costly */
+			for (i = num_choices; i > 0 && costs[i - 1] > lowest; i--) {
+				if (i < max_choices) {
+					choices[i] = choices[i - 1];
+					costs[i] = costs[i - 1];
+				}
+			}
+			if (i < max_choices) {
+				choices[i].algo = algo;
+				choices[i].proto = proto;
+				choices[i].channels = best_channels;
+				costs[i] = lowest;
+				num_choices = NCCL_OFI_MIN(num_choices + 1, max_choices);
+			}
+		}
+	}
+
+	return num_choices;
 }
 
 
 /*
- * Compute the base costs for each of the algorithms at plugin initialization
- * time using only the comm size.
+ * Compute the decision of each size bucket, collective, NVLS support and
+ * pipelined operation count at plugin initialization time, so that
+ * getCollInfo is a table lookup.
  */
-void nccl_ofi_tuner_model_costs(struct nccl_ofi_tuner_context *ctx)
+void nccl_ofi_tuner_build_table(struct nccl_ofi_tuner_context *ctx)
 {
 	ncclFunc_t func;
-	int algo, proto = 0;
+	int nvls_support, pipe_ops, bucket;
+
 	for (func = 0; func < NCCL_NUM_FUNCTIONS; func++) {
-		for (algo = 0; algo < NCCL_NUM_ALGORITHMS; algo++) {
-			for(proto = 0; proto < NCCL_NUM_PROTOCOLS; proto++) {
-				ctx->base_costs[func][algo][proto] =
-					nccl_ofi_tuner_compute_base_cost(func, algo, proto);
+		for (nvls_support = 0; nvls_support <= 1; nvls_support++) {
+			for (pipe_ops = 1; pipe_ops <= NCCL_OFI_TUNER_TABLE_PIPE_OPS; pipe_ops++) {
+				for (bucket = 0; bucket < NCCL_OFI_TUNER_TABLE_SIZE_BUCKETS; bucket++) {
+					struct nccl_ofi_tuner_decision *decision =
+						&ctx->table[func][nvls_support][pipe_ops - 1][bucket];
+					size_t size = nccl_ofi_tuner_bucket_size(bucket);
+					int algo = NCCL_ALGO_UNDEF, proto = NCCL_PROTO_UNDEF, channels = 0;
+
+					nccl_ofi_tuner_compute_decision(ctx, func, nvls_support, pipe_ops,
+									size, &algo, &proto, &channels);
+					decision->algo = algo;
+					decision->proto = proto;
+					decision->channels = channels;
+				}
 			}
 		}
 	}
 }
+
+
+void nccl_ofi_tuner_compute_costs(struct nccl_ofi_tuner_context *ctx, ncclFunc_t func,
+				  int pipe_ops, size_t size, struct nccl_ofi_tuner_costs *costs)
+{
+	for (int algo = 0; algo < NCCL_NUM_ALGORITHMS; algo++) {
+		for (int proto = 0; proto < NCCL_NUM_PROTOCOLS; proto++) {
+			double lowest = DBL_MAX;
+			int best_channels = 0;
+
+			if (choice_supported(func, 1, algo, proto))
+				lowest = lowest_channels_cost(ctx, func, algo, proto, pipe_ops,
+							      size, &best_channels);
+
+			costs->cost[algo][proto] = (lowest == DBL_MAX) ? NCCL_ALGO_PROTO_IGNORE
+								       : lowest;
+			costs->channels[algo][proto] = best_channels;
+		}
+	}
+}
+
+
+/*
+ * Compute the costs of each size bucket and collective at plugin
+ * initialization time, for calls of the v3 tuner interface with a
+ * single pipelined operation.
+ */
+int nccl_ofi_tuner_build_cost_table(struct nccl_ofi_tuner_context *ctx)
+{
+	ctx->cost_table = calloc(NCCL_NUM_FUNCTIONS, sizeof(*ctx->cost_table));
+	if (!ctx->cost_table) {
+		NCCL_OFI_WARN("Cost table allocation failed.");
+		return -ENOMEM;
+	}
+
+	for (int func = 0; func < NCCL_NUM_FUNCTIONS; func++) {
+		for (int bucket = 0; bucket < NCCL_OFI_TUNER_TABLE_SIZE_BUCKETS; bucket++) {
+			nccl_ofi_tuner_compute_costs(ctx, func, 1, nccl_ofi_tuner_bucket_size(bucket),
+						     &ctx->cost_table[func][bucket]);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "nccl-headers/nvidia/tuner.h"
+#include "nccl_ofi_tuner.h"
+#include "nccl_ofi_ini.h"
+#include "nccl_ofi_log.h"
+
+const char *const nccl_ofi_tuner_func_names[NCCL_NUM_FUNCTIONS] = {
+	"broadcast", "reduce", "allgather", "reducescatter", "allreduce"
+};
+
+const char *const nccl_ofi_tuner_algo_names[NCCL_NUM_ALGORITHMS] = {
+	"tree", "ring", "collnet_direct", "collnet_chain", "nvls", "nvls_tree"
+};
+
+const char *const nccl_ofi_tuner_proto_names[NCCL_NUM_PROTOCOLS] = {
+	"ll", "ll128", "simple"
+};
+
+struct param_file_ctx {
+	const char *path;
+	struct nccl_ofi_tuner_model_params params;
+};
+
+/*
+ * Scalar parameters of section `model`. Times are in µsecs and
+ * bandwidths in bytes per µsec.
+ */
+static const struct {
+	const char *key;
+	size_t offset;
+} model_keys[] = {
+	{ "net_latency", offsetof(struct nccl_ofi_tuner_model_params, net_lat) },
+	{ "net_comp_overhead", offsetof(struct nccl_ofi_tuner_model_params, net_comp_overhead) },
+	{ "internode_bw", offsetof(struct nccl_ofi_tuner_model_params, internode_bw) },
+	{ "intranode_bw", offsetof(struct nccl_ofi_tuner_model_params, intranode_bw) },
+	{ "intranode_latency_scale", offsetof(struct nccl_ofi_tuner_model_params, intranode_lat_scale) },
+	{ "channel_overhead", offsetof(struct nccl_ofi_tuner_model_params, channel_overhead) },
+	{ "sm_cost", offsetof(struct nccl_ofi_tuner_model_params, sm_cost) },
+	{ "loggp_o", offsetof(struct nccl_ofi_tuner_model_params, loggp_o) },
+	{ "loggp_g", offsetof(struct nccl_ofi_tuner_model_params, loggp_g) },
+};
+
+/*
+ * @brief	Parse `<algorithm>.<protocol>` key of section `base_latency`
+ *
+ * @return	0, on success
+ *		-EINVAL, if key does not name an algorithm and protocol
+ */
+static int parse_algo_proto(const char *key, int *algo, int *proto)
+{
+	const char *dot = strchr(key, '.');
+
+	if (!dot) {
+		return -EINVAL;
+	}
+
+	for (*algo = 0; *algo < NCCL_NUM_ALGORITHMS; (*algo)++) {
+		if (strlen(nccl_ofi_tuner_algo_names[*algo]) == (size_t)(dot - key) &&
+		    strncasecmp(nccl_ofi_tuner_algo_names[*algo], key, dot - key) == 0) {
+			break;
+		}
+	}
+	for (*proto = 0; *proto < NCCL_NUM_PROTOCOLS; (*proto)++) {
+		if (strcasecmp(nccl_ofi_tuner_proto_names[*proto], dot + 1) == 0) {
+			break;
+		}
+	}
+
+	return (*algo < NCCL_NUM_ALGORITHMS && *proto < NCCL_NUM_PROTOCOLS) ? 0 : -EINVAL;
+}
+
+static int param_file_handler(void *ctx_, const char *section, const char *key,
+			      const char *value, int lineno)
+{
+	struct param_file_ctx *ctx = ctx_;
+	double dval;
+	int algo, proto;
+
+	if (nccl_ofi_ini_parse_double(value, &dval) != 0 || dval < 0.0) {
+		NCCL_OFI_WARN("%s:%d: Invalid value \"%s\" for key %s",
+			      ctx->path, lineno, value, key);
+		return -EINVAL;
+	}
+
+	if (strcmp(section, "model") == 0) {
+		for (size_t i = 0; i < sizeof(model_keys) / sizeof(model_keys[0]); i++) {
+			if (strcmp(key, model_keys[i].key) == 0) {
+				*(float *)((char *)&ctx->params + model_keys[i].offset) = (float)dval;
+				return 0;
+			}
+		}
+		if (strcmp(key, "num_rails") == 0 && dval >= 1.0) {
+			ctx->params.num_rails = (int)dval;
+			return 0;
+		}
+	} else if (strcmp(section, "base_latency") == 0) {
+		if (parse_algo_proto(key, &algo, &proto) == 0) {
+			ctx->params.base_lat[algo][proto] = (float)dval;
+			return 0;
+		}
+	}
+
+	NCCL_OFI_WARN("%s:%d: Unknown key %s in section [%s]", ctx->path, lineno, key, section);
+	return -EINVAL;
+}
+
+int nccl_ofi_tuner_load_params(const char *path, struct nccl_ofi_tuner_model_params *params)
+{
+	int ret;
+	struct param_file_ctx ctx = {
+		.path = path,
+		.params = *params,
+	};
+
+	ret = nccl_ofi_ini_parse_file(path, param_file_handler, &ctx);
+	if (ret != 0) {
+		return ret;
+	}
+
+	if (ctx.params.internode_bw <= 0.0 || ctx.params.intranode_bw <= 0.0) {
+		NCCL_OFI_WARN("%s: Bandwidths must be positive", path);
+		return -EINVAL;
+	}
+
+	/* The LogGP gap per byte follows the bandwidth */
+	ctx.params.loggp_G = 1.0 / ctx.params.internode_bw;
+
+	NCCL_OFI_INFO(NCCL_INIT | NCCL_TUNING, "Loaded tuner parameter file %s", path);
+	*params = ctx.params;
+
+	return 0;
+}
@@ -1,26 +1,141 @@
+#define _GNU_SOURCE
 #include "config.h"
 
+#include <dlfcn.h>
+#include <float.h>
+#include <link.h>
 #include <stdlib.h>
 #include <pthread.h>
 
 #include "nccl-headers/nvidia/tuner.h"
 #include "nccl_ofi_tuner.h"
+#include "nccl_ofi_tuner_hints.h"
 #include "nccl_ofi_log.h"
+#include "nccl_ofi_math.h"
 
 pthread_mutex_t nccl_ofi_tuner_ctx_lock = PTHREAD_MUTEX_INITIALIZER;
 ncclDebugLogger_t ofi_log_function = NULL;
 
+static int find_hints_get(struct dl_phdr_info *info, size_t size, void *data)
+{
+	nccl_ofi_tuner_hints_get_fn_t *hints_get = data;
+	void *handle;
+
+	if (info->dlpi_name == NULL || info->dlpi_name[0] == '\0')
+		return 0;
+
+	/* Objects that are loaded with local symbol scope, such as the
+	 * network plugin, are only found through their own handle */
+	handle = dlopen(info->dlpi_name, RTLD_LAZY | RTLD_NOLOAD);
+	if (!handle)
+		return 0;
+	*hints_get = (nccl_ofi_tuner_hints_get_fn_t)dlsym(handle, NCCL_OFI_TUNER_HINTS_GET_SYMBOL);
+	dlclose(handle);
+
+	return *hints_get != NULL;
+}
+
+/*
+ * @brief	Read hints of the network plugin, if it is loaded
+ *
+ * @return	Hints, unknown values are 0
+ */
+static nccl_ofi_tuner_hints_t get_hints(void)
+{
+	nccl_ofi_tuner_hints_t hints = { 0 };
+	nccl_ofi_tuner_hints_get_fn_t hints_get;
+
+	hints_get = (nccl_ofi_tuner_hints_get_fn_t)dlsym(RTLD_DEFAULT, NCCL_OFI_TUNER_HINTS_GET_SYMBOL);
+	if (!hints_get)
+		dl_iterate_phdr(find_hints_get, &hints_get);
+	if (hints_get)
+		hints_get(&hints, sizeof(hints));
+
+	return hints;
+}
+
+void nccl_ofi_tuner_default_params(struct nccl_ofi_tuner_model_params *params)
+{
+	nccl_ofi_tuner_hints_t hints = get_hints();
+	/* Environment variables take precedence over hints, and
+	 * calibration results over the link speed */
+	float internode_bw = ofi_nccl_tuner_internode_bw() > 0
+			     ? (float)ofi_nccl_tuner_internode_bw()
+			     : hints.calibrated_bw > 0.0
+			     ? (float)hints.calibrated_bw
+			     : hints.link_bw > 0.0
+			     ? (float)hints.link_bw
+			     : NCCL_OFI_TUNER_INTERNODE_BW;
+	double intranode_latency_ns = ofi_nccl_tuner_intranode_latency_ns() > 0
+				      ? (double)ofi_nccl_tuner_intranode_latency_ns()
+				      : hints.intranode_latency_ns;
+	/* Intranode latency is relative to NCCL's NVLink ring latency */
+	float intranode_lat_scale = intranode_latency_ns > 0.0
+				    ? intranode_latency_ns * 1e-3
+				      / nccl_nvlink_lat[NCCL_ALGO_RING][NCCL_PROTO_SIMPLE]
+				    : 1.0;
+
+	const struct nccl_ofi_tuner_model_params defaults = {
+		/* The calibrated one-way latency is the latency of a hop,
+		 * and the gap between small messages the cost of each
+		 * completion */
+		.net_lat = getenv("OFI_NCCL_TUNER_NET_LATENCY") == NULL &&
+			   hints.calibrated_latency > 0.0
+			   ? hints.calibrated_latency
+			   : ofi_nccl_tuner_net_latency(),
+		.net_comp_overhead = getenv("OFI_NCCL_TUNER_NET_COMP_OVERHEAD") == NULL &&
+				     hints.calibrated_overhead > 0.0
+				     ? hints.calibrated_overhead
+				     : ofi_nccl_tuner_net_comp_overhead(),
+		.internode_bw = internode_bw,
+		.intranode_bw = ofi_nccl_tuner_intranode_bw() > 0
+				? (float)ofi_nccl_tuner_intranode_bw()
+				: hints.intranode_bw > 0.0
+				? (float)hints.intranode_bw
+				: NCCL_OFI_TUNER_INTRANODE_BW,
+		.intranode_lat_scale = intranode_lat_scale,
+		.num_rails = ofi_nccl_tuner_num_rails() > 0
+			     ? ofi_nccl_tuner_num_rails()
+			     : hints.num_rails > 0
+			     ? hints.num_rails
+			     : NCCL_OFI_TUNER_NET_NUM_RAILS,
+		.channel_overhead = ofi_nccl_tuner_channel_overhead_ns() * 1e-3,
+		.sm_cost = ofi_nccl_tuner_sm_cost_ns() * 1e-3,
+		.max_channels = NCCL_OFI_MAX(1, NCCL_OFI_MIN(ofi_nccl_tuner_num_channels(),
+							     NCCL_OFI_TUNER_MAX_CHANNELS)),
+		.loggp_o = ofi_nccl_tuner_loggp_o_ns() * 1e-3,
+		.loggp_g = ofi_nccl_tuner_loggp_g_ns() * 1e-3,
+		.loggp_G = 1.0 / internode_bw
+	};
+
+	*params = defaults;
+}
+
 ncclResult_t nccl_ofi_tuner_init(size_t nRanks, size_t nNodes, ncclDebugLogger_t logFunction, void **context)
 {
 	ofi_log_function = logFunction;
 	struct nccl_ofi_tuner_context *nccl_ofi_tuner_ctx;
+	const struct nccl_ofi_tuner_model *model;
+	struct nccl_ofi_tuner_model_params params;
 
-	const struct nccl_ofi_tuner_model_params params = {
-		.net_lat = ofi_nccl_tuner_net_latency(),
-		.internode_bw = NCCL_OFI_TUNER_INTERNODE_BW,
-		.intranode_bw = NCCL_OFI_TUNER_INTRANODE_BW,
-		.num_rails = NCCL_OFI_TUNER_NET_NUM_RAILS
-	};
+	nccl_ofi_tuner_default_params(&params);
+
+	if (ofi_nccl_tuner_param_file() != NULL &&
+	    nccl_ofi_tuner_load_params(ofi_nccl_tuner_param_file(), &params) != 0) {
+		NCCL_OFI_WARN("Unable to load tuner parameter file %s.", ofi_nccl_tuner_param_file());
+		return ncclInvalidArgument;
+	}
+
+	model = nccl_ofi_tuner_find_model(ofi_nccl_tuner_model());
+	if (!model) {
+		NCCL_OFI_WARN("Unknown tuner model %s.", ofi_nccl_tuner_model());
+		return ncclInvalidArgument;
+	}
+
+	NCCL_OFI_INFO(NCCL_INIT | NCCL_TUNING,
+		      "Tuner model inputs: %s model, net latency %.1f+%.1f µs, %d rails of %.0f B/µs, intranode %.0f B/µs, intranode latency x%.2f, up to %d channels",
+		      model->name, params.net_lat, params.net_comp_overhead, params.num_rails, params.internode_bw,
+		      params.intranode_bw, params.intranode_lat_scale, params.max_channels);
 
 	/*
 	 * The tuner API is missing a mechanism to pass around context after
@@ -30,21 +145,37 @@ ncclResult_t nccl_ofi_tuner_init(size_t nRanks, size_t nNodes, ncclDebugLogger_t
 	nccl_ofi_tuner_ctx = calloc(1, sizeof(struct nccl_ofi_tuner_context));
 	if (!nccl_ofi_tuner_ctx) {
 		NCCL_OFI_WARN("Context allocation failed.");
+		pthread_mutex_unlock(&nccl_ofi_tuner_ctx_lock);
 		return ncclInternalError;
 	}
 
-	nccl_ofi_tuner_ctx->dims.num_ranks = nRanks;
-	nccl_ofi_tuner_ctx->dims.num_nodes = nNodes;
+	if (nccl_ofi_tuner_init_dims(&nccl_ofi_tuner_ctx->dims, nRanks, nNodes,
+				     ofi_nccl_tuner_max_local_ranks(),
+				     ofi_nccl_tuner_min_local_ranks()) != 0) {
+		NCCL_OFI_INFO(NCCL_INIT | NCCL_TUNING,
+			      "Local rank counts %ld..%ld do not fit comm with %ld ranks and %ld nodes, assuming even placement.",
+			      ofi_nccl_tuner_min_local_ranks(), ofi_nccl_tuner_max_local_ranks(), nRanks, nNodes);
+	}
 	nccl_ofi_tuner_ctx->model_params = params;
+	nccl_ofi_tuner_ctx->model = model;
 
 	/*
-	 * Build cost model to use from nccl_ofi_tuner_get_coll_info.
+	 * Build decision table to use from nccl_ofi_tuner_get_coll_info.
 	 */
-	nccl_ofi_tuner_model_costs(nccl_ofi_tuner_ctx);
+	nccl_ofi_tuner_build_table(nccl_ofi_tuner_ctx);
+
+	if (nccl_ofi_tuner_feedback_init(nccl_ofi_tuner_ctx) != 0) {
+		free(nccl_ofi_tuner_ctx);
+		nccl_ofi_tuner_ctx = NULL;
+		pthread_mutex_unlock(&nccl_ofi_tuner_ctx_lock);
+		return ncclInternalError;
+	}
 	*context = (void*)nccl_ofi_tuner_ctx;
 	pthread_mutex_unlock(&nccl_ofi_tuner_ctx_lock);
 
-	NCCL_OFI_TRACE(NCCL_TUNING, "Tuner init: comm with %ld ranks and %ld nodes.", nRanks, nNodes);
+	NCCL_OFI_TRACE(NCCL_TUNING, "Tuner init: comm with %ld ranks and %ld nodes (%d..%d local ranks), %s model.",
+		       nRanks, nNodes, nccl_ofi_tuner_ctx->dims.min_local_ranks,
+		       nccl_ofi_tuner_ctx->dims.max_local_ranks, model->name);
 	return ncclSuccess;
 }
 
@@ -52,53 +183,53 @@ ncclResult_t nccl_ofi_tuner_get_coll_info(void *context, ncclFunc_t collType, si
 				  int collNetSupport, int nvlsSupport, int numPipeOps,
 				  int *algorithm, int *protocol, int* nChannels)
 {
-	float cost = 0;
-	float lowest = FLT_MAX;
-	int algo, proto = 0;
+	double cost;
+	int algo = NCCL_ALGO_UNDEF, proto = NCCL_PROTO_UNDEF, channels = 0;
+	const struct nccl_ofi_tuner_decision *decision;
 	struct nccl_ofi_tuner_context *nccl_ofi_tuner_ctx = (struct nccl_ofi_tuner_context *)context;
 
 	/* Skip runs smaller than 2 nodes and fallback to NCCL's internal tunings */
 	if (nccl_ofi_tuner_ctx->dims.num_nodes <= 2)
 		return ncclSuccess;
 
+	/* Decisions refined with recorded feedback, if enabled */
+	if (nccl_ofi_tuner_feedback_choose(nccl_ofi_tuner_ctx, collType, nvlsSupport, numPipeOps,
+					   nBytes, algorithm, protocol, nChannels))
+		return ncclSuccess;
+
 	/*
-	 * Ideally, this should just be a lookup and not be in-flight math
-	 * We do not want divs in the hot path, but working with the API we've
-	 * got now. 
+	 * Look up the decision precomputed at initialization, so that there
+	 * is no in-flight math in the hot path. Messages outside of the
+	 * table are rare enough to compute their costs.
 	 */
-	for (algo = 0; algo < NCCL_NUM_ALGORITHMS; algo++) {
-		/* No CollNet on AWS today */
-		if (algo == NCCL_ALGO_COLLNET_DIRECT || algo == NCCL_ALGO_COLLNET_CHAIN)
-			continue;
-
-		/* Skip NCCL_ALGO_NVLS used only for single-node jobs */
-		if (algo == NCCL_ALGO_NVLS)
-			continue;
-
-		if (!nvlsSupport && (algo == NCCL_ALGO_NVLS_TREE))
-			continue;
-
-		for (proto = 0; proto < NCCL_NUM_PROTOCOLS; proto++) {
-			/* This is not a supported combination in NCCL */
-			if (algo == NCCL_ALGO_NVLS_TREE && proto != NCCL_PROTO_SIMPLE)
-				continue;
+	decision = nccl_ofi_tuner_lookup_decision(nccl_ofi_tuner_ctx, collType, nvlsSupport,
+						  numPipeOps, nBytes);
+	if (decision && !ofi_nccl_tuner_exact_cost()) {
+		if (decision->algo != NCCL_ALGO_UNDEF) {
+			*algorithm = decision->algo;
+			*protocol = decision->proto;
+			*nChannels = decision->channels;
+		}
+		return ncclSuccess;
+	}
 
-			cost = nccl_ofi_tuner_compute_cost(&nccl_ofi_tuner_ctx->model_params, &nccl_ofi_tuner_ctx->dims,
-							   collType, algo, proto, numPipeOps,  nBytes);
-			if (cost < 0)
-				continue;
+	cost = nccl_ofi_tuner_compute_decision(nccl_ofi_tuner_ctx, collType, nvlsSupport,
+					       numPipeOps, nBytes, &algo, &proto, &channels);
+	if (cost < 0)
+		return ncclSuccess;
 
-			NCCL_OFI_TRACE(NCCL_TUNING, "Computed cost for algo %d proto %d pipe %d: cost %.8f µsecs.", algo, proto, numPipeOps, cost);
-			if (cost < lowest) {
-				*algorithm = algo;
-				*protocol = proto;
-				lowest = cost;
-			}
-		}
+	if (decision && (decision->algo != algo || decision->proto != proto ||
+			 decision->channels != channels)) {
+		NCCL_OFI_INFO(NCCL_TUNING, "Decision table chose algo %d proto %d channels %d instead of algo %d proto %d channels %d for coll %d size %ld pipe %d.",
+			      decision->algo, decision->proto, decision->channels, algo, proto, channels,
+			      collType, nBytes, numPipeOps);
 	}
 
-	NCCL_OFI_INFO(NCCL_TUNING, "Choosing algo %d proto %d with cost %.8f µsecs for coll %d size %ld.",
-				    *algorithm, *protocol, lowest, collType, nBytes);
+	*algorithm = algo;
+	*protocol = proto;
+	*nChannels = channels;
+	NCCL_OFI_INFO(NCCL_TUNING, "Choosing algo %d proto %d channels %d with cost %.8f µsecs for coll %d size %ld.",
+				    *algorithm, *protocol, *nChannels, cost, collType, nBytes);
 	return ncclSuccess;
 }
 
@@ -106,6 +237,8 @@ ncclResult_t nccl_ofi_tuner_destroy(void *context)
 {
 	pthread_mutex_lock(&nccl_ofi_tuner_ctx_lock);
 	if (context != NULL) {
+		nccl_ofi_tuner_feedback_fini((struct nccl_ofi_tuner_context *)context);
+		free(((struct nccl_ofi_tuner_context *)context)->cost_table);
 		free(context);
 	}
 	pthread_mutex_unlock(&nccl_ofi_tuner_ctx_lock);
@@ -113,6 +246,124 @@ ncclResult_t nccl_ofi_tuner_destroy(void *context)
 	return ncclSuccess;
 }
 
+static ncclResult_t nccl_ofi_tuner_init_v3(size_t nRanks, size_t nNodes, ncclDebugLogger_t logFunction,
+					    void **context)
+{
+	ncclResult_t ret = nccl_ofi_tuner_init(nRanks, nNodes, logFunction, context);
+
+	if (ret != ncclSuccess)
+		return ret;
+
+	/*
+	 * The v3 interface reports the costs of all algorithms and
+	 * protocols, so precompute them in addition to the decisions.
+	 */
+	if (nccl_ofi_tuner_build_cost_table((struct nccl_ofi_tuner_context *)*context) != 0) {
+		nccl_ofi_tuner_destroy(*context);
+		*context = NULL;
+		return ncclInternalError;
+	}
+
+	return ncclSuccess;
+}
+
+/*
+ * NCCL fills the cost table with its own costs and marks the algorithms
+ * and protocols it rules out, e.g., unsupported by the communicator or
+ * excluded with NCCL_ALGO/NCCL_PROTO, with NCCL_ALGO_PROTO_IGNORE, and
+ * chooses the lowest cost of the table. The tuner replaces NCCL's costs
+ * with the costs of its model, and marks the combinations it does not
+ * model, so that costs of both are never compared. If the tuner models
+ * none of the remaining combinations, NCCL's costs are kept.
+ */
+static ncclResult_t nccl_ofi_tuner_get_coll_info_v3(void *context, ncclFunc_t collType, size_t nBytes,
+						    int numPipeOps, float **collCostTable, int numAlgo,
+						    int numProto, int *nChannels)
+{
+	struct nccl_ofi_tuner_context *nccl_ofi_tuner_ctx = (struct nccl_ofi_tuner_context *)context;
+	float *table = (float *)collCostTable;
+	const struct nccl_ofi_tuner_costs *costs = NULL;
+	struct nccl_ofi_tuner_costs exact;
+	int algo, proto, bucket;
+	int best_algo = NCCL_ALGO_UNDEF, best_proto = NCCL_PROTO_UNDEF;
+	int fb_algo = NCCL_ALGO_UNDEF, fb_proto = NCCL_PROTO_UNDEF, fb_channels = 0;
+	int nvls_support = 0;
+	float lowest = FLT_MAX;
+
+	/* Skip runs smaller than 2 nodes and fallback to NCCL's internal tunings */
+	if (nccl_ofi_tuner_ctx->dims.num_nodes <= 2 || collType < 0 || collType >= NCCL_NUM_FUNCTIONS)
+		return ncclSuccess;
+
+	/* Precomputed costs, or exact costs outside of the cost table */
+	bucket = nccl_ofi_tuner_size_bucket(nBytes);
+	if (nccl_ofi_tuner_ctx->cost_table && numPipeOps == 1 && bucket >= 0 &&
+	    !ofi_nccl_tuner_exact_cost()) {
+		costs = &nccl_ofi_tuner_ctx->cost_table[collType][bucket];
+	} else {
+		nccl_ofi_tuner_compute_costs(nccl_ofi_tuner_ctx, collType, numPipeOps, nBytes, &exact);
+		costs = &exact;
+	}
+
+	for (algo = 0; algo < NCCL_OFI_MIN(numAlgo, NCCL_NUM_ALGORITHMS); algo++) {
+		for (proto = 0; proto < NCCL_OFI_MIN(numProto, NCCL_NUM_PROTOCOLS); proto++) {
+			float cost = costs->cost[algo][proto];
+
+			if (table[algo * numProto + proto] == NCCL_ALGO_PROTO_IGNORE)
+				continue;
+			if (algo == NCCL_ALGO_NVLS || algo == NCCL_ALGO_NVLS_TREE)
+				nvls_support = 1;
+			if (cost != NCCL_ALGO_PROTO_IGNORE && cost < lowest) {
+				best_algo = algo;
+				best_proto = proto;
+				lowest = cost;
+			}
+		}
+	}
+	if (best_algo == NCCL_ALGO_UNDEF)
+		return ncclSuccess;
+
+	/*
+	 * Decisions refined with recorded feedback, if enabled, are the only
+	 * choice left to NCCL, unless NCCL rules them out.
+	 */
+	if (nccl_ofi_tuner_feedback_choose(nccl_ofi_tuner_ctx, collType, nvls_support, numPipeOps,
+					   nBytes, &fb_algo, &fb_proto, &fb_channels) &&
+	    fb_algo < numAlgo && fb_proto < numProto &&
+	    table[fb_algo * numProto + fb_proto] != NCCL_ALGO_PROTO_IGNORE &&
+	    costs->cost[fb_algo][fb_proto] != NCCL_ALGO_PROTO_IGNORE) {
+		best_algo = fb_algo;
+		best_proto = fb_proto;
+	} else {
+		fb_algo = NCCL_ALGO_UNDEF;
+	}
+
+	for (algo = 0; algo < numAlgo; algo++) {
+		for (proto = 0; proto < numProto; proto++) {
+			float *entry = &table[algo * numProto + proto];
+
+			if (algo >= NCCL_NUM_ALGORITHMS || proto >= NCCL_NUM_PROTOCOLS ||
+			    (fb_algo != NCCL_ALGO_UNDEF && (algo != fb_algo || proto != fb_proto)))
+				*entry = NCCL_ALGO_PROTO_IGNORE;
+			else if (*entry != NCCL_ALGO_PROTO_IGNORE)
+				*entry = costs->cost[algo][proto];
+		}
+	}
+	*nChannels = (fb_algo != NCCL_ALGO_UNDEF) ? fb_channels
+						  : costs->channels[best_algo][best_proto];
+
+	NCCL_OFI_TRACE(NCCL_TUNING, "Lowest cost algo %d proto %d channels %d with cost %.8f µsecs for coll %d size %ld pipe %d.",
+		       best_algo, best_proto, *nChannels, costs->cost[best_algo][best_proto],
+		       collType, nBytes, numPipeOps);
+	return ncclSuccess;
+}
+
+const ncclTuner_v3_t ncclTunerPlugin_v3 = {
+	.name = "nccl_ofi_tuner",
+	.init = nccl_ofi_tuner_init_v3,
+	.getCollInfo = nccl_ofi_tuner_get_coll_info_v3,
+	.destroy = nccl_ofi_tuner_destroy
+};
+
 const ncclTuner_v2_t ncclTunerPlugin_v2 = {
 	.name = "nccl_ofi_tuner",
 	.init = nccl_ofi_tuner_init,
@@ -163,7 +414,7 @@ static ncclResult_t nccl_ofi_tuner_get_coll_info_v1(ncclFunc_t collType, size_t
 						    int nvlsSupport, int numPipeOps, int *algorithm, int *protocol,
 						    int *nChannels)
 {
-	return nccl_ofi_tuner_get_coll_info(&nccl_ofi_tuner_ctx_internal, collType, nBytes,
+	return nccl_ofi_tuner_get_coll_info(nccl_ofi_tuner_ctx_internal, collType, nBytes,
 					    collNetSupport, nvlsSupport, numPipeOps, algorithm,
 					    protocol, nChannels);
 }
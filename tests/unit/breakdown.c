@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test-common.h"
+#include "nccl_ofi_breakdown.h"
+
+int main(int argc, char *argv[])
+{
+	nccl_ofi_breakdown_t breakdown;
+	nccl_ofi_breakdown_size_t *size_class;
+	char summary[160];
+
+	ofi_log_function = logger;
+
+	/* Each size falls into the smallest class that holds it */
+	for (size_t size = 0; size <= (64ULL << 20); size += (size < 8192 ? 1 : 4093)) {
+		int cls = nccl_ofi_breakdown_size_class(size);
+
+		if (cls < 0 || cls >= NCCL_OFI_BREAKDOWN_SIZES ||
+		    size > nccl_ofi_breakdown_size_class_max(cls) ||
+		    (cls > 0 && size <= nccl_ofi_breakdown_size_class_max(cls - 1))) {
+			NCCL_OFI_WARN("Size %zu in class %d with largest size %zu",
+				      size, cls, nccl_ofi_breakdown_size_class_max(cls));
+			return 1;
+		}
+	}
+	if (nccl_ofi_breakdown_size_class(1024) != 0 ||
+	    nccl_ofi_breakdown_size_class(1025) != 1 ||
+	    nccl_ofi_breakdown_size_class(4096) != 1 ||
+	    nccl_ofi_breakdown_size_class(16 << 20) != NCCL_OFI_BREAKDOWN_SIZES - 2 ||
+	    nccl_ofi_breakdown_size_class(SIZE_MAX) != NCCL_OFI_BREAKDOWN_SIZES - 1) {
+		NCCL_OFI_WARN("Unexpected size classes");
+		return 1;
+	}
+
+	memset(&breakdown, 0, sizeof(breakdown));
+	size_class = &breakdown.sizes[nccl_ofi_breakdown_size_class(65536)];
+
+	/* Send that waited 10 us for its control message, 5 us in the
+	 * pending queue, 20 us on the wire, and 1 us for its last rail */
+	nccl_ofi_breakdown_record(&breakdown, 65536,
+				  (uint64_t[]){ 1000, 11000, 16000, 36000, 37000 });
+	/* Receive without control message wait, pending time nor data
+	 * completion */
+	nccl_ofi_breakdown_record(&breakdown, 65536,
+				  (uint64_t[]){ 1000, 1000, 0, 0, 21000 });
+	/* Eager data that arrived before its receive was posted */
+	nccl_ofi_breakdown_record(&breakdown, 65536,
+				  (uint64_t[]){ 5000, 5000, 6000, 2000, 9000 });
+
+	if (size_class->count != 3 ||
+	    size_class->phase_ns[NCCL_OFI_PHASE_CTRL] != 10000 ||
+	    size_class->phase_ns[NCCL_OFI_PHASE_PENDING] != 5000 + 1000 ||
+	    size_class->phase_ns[NCCL_OFI_PHASE_WIRE] != 20000 ||
+	    size_class->phase_ns[NCCL_OFI_PHASE_LAST_RAIL] != 1000 + 20000 + 3000) {
+		NCCL_OFI_WARN("Unexpected breakdown: n=%lu ctrl=%lu pending=%lu wire=%lu last_rail=%lu",
+			      size_class->count, size_class->phase_ns[NCCL_OFI_PHASE_CTRL],
+			      size_class->phase_ns[NCCL_OFI_PHASE_PENDING],
+			      size_class->phase_ns[NCCL_OFI_PHASE_WIRE],
+			      size_class->phase_ns[NCCL_OFI_PHASE_LAST_RAIL]);
+		return 1;
+	}
+	for (int cls = 0; cls < NCCL_OFI_BREAKDOWN_SIZES; cls++) {
+		if (&breakdown.sizes[cls] != size_class && breakdown.sizes[cls].count != 0) {
+			NCCL_OFI_WARN("Requests recorded in size class %d", cls);
+			return 1;
+		}
+	}
+
+	if (nccl_ofi_breakdown_dominant(size_class) != NCCL_OFI_PHASE_LAST_RAIL) {
+		NCCL_OFI_WARN("Unexpected dominant phase %s",
+			      nccl_ofi_breakdown_phase_name(nccl_ofi_breakdown_dominant(size_class)));
+		return 1;
+	}
+
+	nccl_ofi_breakdown_format(size_class, summary, sizeof(summary));
+	if (strcmp(summary, "n=3 ctrl=3.3 pending=2.0 wire=6.7 last_rail=8.0 dominant=last_rail(40%)") != 0) {
+		NCCL_OFI_WARN("Unexpected summary %s", summary);
+		return 1;
+	}
+	nccl_ofi_breakdown_format(&breakdown.sizes[0], summary, sizeof(summary));
+	if (strcmp(summary, "n=0") != 0) {
+		NCCL_OFI_WARN("Unexpected summary of empty size class %s", summary);
+		return 1;
+	}
+
+	printf("Test completed successfully!\n");
+
+	return 0;
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "test-common.h"
+#include "nccl_ofi_calibrate.h"
+#include "nccl_ofi_tuner_hints.h"
+
+static int test_rr_threshold(void)
+{
+	const nccl_ofi_calibration_t rails[] = {
+		{ .latency = 5.0, .bandwidth = 10000.0, .overhead = 1.0 },
+		{ .latency = 5.0, .bandwidth = 12000.0, .overhead = 3.0 },
+	};
+	size_t threshold;
+
+	/* 2 rails * 2 us * 11000 bytes/us */
+	threshold = nccl_ofi_calibration_rr_threshold(rails, 2, 0);
+	if (threshold != 44000) {
+		NCCL_OFI_WARN("Unexpected threshold %zu", threshold);
+		return 1;
+	}
+
+	threshold = nccl_ofi_calibration_rr_threshold(rails, 2, 65536);
+	if (threshold != 65536) {
+		NCCL_OFI_WARN("Threshold %zu is below lower bound", threshold);
+		return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Rails with complete entries in the cache file must not be measured,
+ * which would fail without a domain. Later entries override earlier
+ * ones.
+ */
+static int test_cache(void)
+{
+	int ret = 0;
+	char dir[] = "/tmp/calibrate-test-XXXXXX";
+	char hostname[HOST_NAME_MAX + 1] = "";
+	char path[PATH_MAX];
+	FILE *file;
+	struct fi_fabric_attr fabric_attr = { .prov_name = "efa" };
+	struct fi_domain_attr domain_attr[2] = { { .name = "rdmap0" }, { .name = "rdmap1" } };
+	struct fi_info info[2] = {
+		{ .fabric_attr = &fabric_attr, .domain_attr = &domain_attr[0] },
+		{ .fabric_attr = &fabric_attr, .domain_attr = &domain_attr[1] },
+	};
+	struct fi_info *infos[2] = { &info[0], &info[1] };
+	struct fid_domain *domains[2] = { NULL, NULL };
+	nccl_ofi_calibration_t results[2];
+
+	if (!mkdtemp(dir) || gethostname(hostname, sizeof(hostname)) != 0) {
+		NCCL_OFI_WARN("Failed to set up cache directory");
+		return 1;
+	}
+	hostname[HOST_NAME_MAX] = '\0';
+	snprintf(path, sizeof(path), "%s/aws-ofi-nccl-calibration-%s.ini", dir, hostname);
+
+	file = fopen(path, "w");
+	if (!file) {
+		NCCL_OFI_WARN("Failed to create cache file %s", path);
+		rmdir(dir);
+		return 1;
+	}
+	fprintf(file,
+		"[efa:rdmap0]\nlatency = 9.0\nbandwidth = 1000.0\noverhead = 1.0\n"
+		"[efa:rdmap1]\nlatency = 4.0\nbandwidth = 12000.0\noverhead = 2.0\n"
+		"[efa:rdmap0]\nlatency = 3.5\n");
+	fclose(file);
+	/* Cache files writable by others are ignored */
+	chmod(path, 0600);
+
+	setenv("OFI_NCCL_CALIBRATION_DIR", dir, 1);
+
+	if (nccl_ofi_calibrate(infos, domains, 2, results) != 0) {
+		NCCL_OFI_WARN("Calibration from cache failed");
+		ret = 1;
+	} else if (results[0].latency != 3.5 || results[0].bandwidth != 1000.0 ||
+		   results[1].overhead != 2.0) {
+		NCCL_OFI_WARN("Unexpected cached results");
+		ret = 1;
+	}
+
+	/* Mean calibrated values are provided to the tuner as hints */
+	if (ret == 0) {
+		nccl_ofi_tuner_hints_t hints;
+
+		nccl_ofi_calibration_export(results, 2);
+		nccl_ofi_tuner_hints_get(&hints, sizeof(hints));
+		if (hints.calibrated_bw != 6500.0 || hints.calibrated_latency != 3.75 ||
+		    hints.calibrated_overhead != 1.5) {
+			NCCL_OFI_WARN("Unexpected tuner hints: bandwidth %f, latency %f, overhead %f",
+				      hints.calibrated_bw, hints.calibrated_latency,
+				      hints.calibrated_overhead);
+			ret = 1;
+		}
+	}
+
+	unlink(path);
+	rmdir(dir);
+	return ret;
+}
+
+/*
+ * Rail count and link speed of the slowest rail are provided to the
+ * tuner, and rails of unknown speed leave the bandwidth unknown.
+ */
+static int test_export_link(void)
+{
+	struct fi_link_attr link_attr[2] = { { .speed = 200000000000ULL }, { .speed = 100000000000ULL } };
+	struct fid_nic nic[2] = { { .link_attr = &link_attr[0] }, { .link_attr = &link_attr[1] } };
+	struct fi_info info[2] = { { .nic = &nic[0] }, { .nic = &nic[1] } };
+	struct fi_info *infos[2] = { &info[0], &info[1] };
+	nccl_ofi_tuner_hints_t hints;
+
+	nccl_ofi_calibration_export_link(infos, 2);
+	nccl_ofi_tuner_hints_get(&hints, sizeof(hints));
+	if (hints.num_rails != 2 || hints.link_bw != 12500.0) {
+		NCCL_OFI_WARN("Unexpected tuner hints from link speed: %d rails, %f B/us",
+			      hints.num_rails, hints.link_bw);
+		return 1;
+	}
+
+	info[1].nic = NULL;
+	nccl_ofi_calibration_export_link(infos, 2);
+	nccl_ofi_tuner_hints_get(&hints, sizeof(hints));
+	if (hints.num_rails != 2 || hints.link_bw != 0.0) {
+		NCCL_OFI_WARN("Unexpected tuner hints without link speed: %d rails, %f B/us",
+			      hints.num_rails, hints.link_bw);
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int ret = 0;
+
+	ofi_log_function = logger;
+
+	ret |= test_rr_threshold();
+	ret |= test_cache();
+	ret |= test_export_link();
+
+	if (ret) {
+		return ret;
+	}
+
+	printf("Test completed successfully!\n");
+
+	return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test-common.h"
+#include "nccl_ofi_capability.h"
+
+/* Capabilities of a provider that supports both protocols */
+static const nccl_ofi_capability_t rdma_caps = {
+	.prov_name = "efa",
+	.num_nics = 4,
+	.caps = FI_MSG | FI_TAGGED | FI_RMA | FI_READ | FI_WRITE | FI_HMEM,
+	.mr_mode = FI_MR_LOCAL | FI_MR_HMEM | FI_MR_VIRT_ADDR | FI_MR_ALLOCATED | FI_MR_PROV_KEY,
+	.inject_size = 32,
+	.max_msg_size = 1 << 30,
+	.cq_data_size = 4,
+	.mr_key_size = 4,
+	.ep_probed = true,
+};
+
+static int check_protocol(const nccl_ofi_capability_t *caps, const char *expected,
+			  const char *desc)
+{
+	const char *protocol = nccl_ofi_capability_select_protocol(caps);
+
+	if ((protocol == NULL) != (expected == NULL) ||
+	    (protocol && strcmp(protocol, expected) != 0)) {
+		NCCL_OFI_WARN("%s: selected protocol %s, expected %s", desc,
+			      protocol ? protocol : "none", expected ? expected : "none");
+		return 1;
+	}
+
+	return 0;
+}
+
+static int test_select_protocol(void)
+{
+	int ret = 0;
+	nccl_ofi_capability_t caps;
+
+	ret |= check_protocol(&rdma_caps, "RDMA", "full capabilities");
+
+	caps = rdma_caps;
+	caps.caps &= ~FI_HMEM;
+	ret |= check_protocol(&caps, "SENDRECV", "no FI_HMEM");
+
+	caps = rdma_caps;
+	caps.cq_data_size = 0;
+	ret |= check_protocol(&caps, "SENDRECV", "no immediate data");
+
+	caps = rdma_caps;
+	caps.mode = FI_CONTEXT;
+	ret |= check_protocol(&caps, "SENDRECV", "FI_CONTEXT mode");
+
+	caps = rdma_caps;
+	caps.mr_mode |= FI_MR_ENDPOINT;
+	ret |= check_protocol(&caps, "SENDRECV", "FI_MR_ENDPOINT");
+
+	caps = rdma_caps;
+	caps.emulated_write = true;
+	ret |= check_protocol(&caps, "SENDRECV", "emulated writes");
+
+	caps = rdma_caps;
+	caps.caps = FI_MSG | FI_RMA;
+	ret |= check_protocol(&caps, NULL, "no FI_TAGGED");
+
+	return ret;
+}
+
+static int test_apply_features(void)
+{
+	nccl_ofi_capability_t caps = rdma_caps;
+	const char *value;
+
+	/* Eager messages are limited by the maximum message size */
+	caps.max_msg_size = 4096;
+	unsetenv("OFI_NCCL_EAGER_MAX_SIZE");
+	if (nccl_ofi_capability_apply_features(&caps, "SENDRECV") != 0 ||
+	    getenv("OFI_NCCL_EAGER_MAX_SIZE") != NULL) {
+		NCCL_OFI_WARN("Eager rule applied to SENDRECV protocol");
+		return 1;
+	}
+	if (nccl_ofi_capability_apply_features(&caps, "RDMA") != 0) {
+		NCCL_OFI_WARN("Applying feature rules failed");
+		return 1;
+	}
+	value = getenv("OFI_NCCL_EAGER_MAX_SIZE");
+	if (value == NULL || strcmp(value, "4096") != 0) {
+		NCCL_OFI_WARN("Unexpected OFI_NCCL_EAGER_MAX_SIZE %s", value ? value : "(unset)");
+		return 1;
+	}
+
+	/* User settings take precedence */
+	setenv("OFI_NCCL_EAGER_MAX_SIZE", "1024", 1);
+	if (nccl_ofi_capability_apply_features(&caps, "RDMA") != 0 ||
+	    strcmp(getenv("OFI_NCCL_EAGER_MAX_SIZE"), "1024") != 0) {
+		NCCL_OFI_WARN("User setting of OFI_NCCL_EAGER_MAX_SIZE overridden");
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int ret = 0;
+
+	ofi_log_function = logger;
+
+	ret |= test_select_protocol();
+	ret |= test_apply_features();
+
+	if (ret) {
+		return ret;
+	}
+
+	printf("Test completed successfully!\n");
+
+	return 0;
+}
@@ -9,6 +9,21 @@
 #include "test-common.h"
 #include "nccl_ofi_deque.h"
 
+struct visit_t {
+	nccl_ofi_deque_elem_t *elems[16];
+	size_t num_elems;
+};
+
+static void visit(nccl_ofi_deque_elem_t *deque_elem, void *arg)
+{
+	struct visit_t *visited = arg;
+
+	if (visited->num_elems < 16) {
+		visited->elems[visited->num_elems] = deque_elem;
+	}
+	visited->num_elems++;
+}
+
 int main(int argc, char *argv[])
 {
 	const size_t num_elem = 11;
@@ -18,6 +33,7 @@ int main(int argc, char *argv[])
 	} elems[num_elem];
 
 	nccl_ofi_deque_elem_t *deque_elem;
+	struct visit_t visited = { .num_elems = 0 };
 	int ret;
 	size_t i;
 	for (i = 0; i < num_elem; ++i) {
@@ -47,6 +63,20 @@ int main(int argc, char *argv[])
 		exit(1);
 	}
 
+	/* Test for_each */
+	ret = nccl_ofi_deque_for_each(deque, visit, &visited);
+	if (ret || visited.num_elems != num_elem) {
+		NCCL_OFI_WARN("for_each visited %zu elements, expected %zu", visited.num_elems, num_elem);
+		exit(1);
+	}
+	for (i = 0; i < num_elem; ++i) {
+		nccl_ofi_deque_elem_t *expected = (i == 0 ? &elems[num_elem-1].de : &elems[i-1].de);
+		if (visited.elems[i] != expected) {
+			NCCL_OFI_WARN("for_each visited element %zu out of order", i);
+			exit(1);
+		}
+	}
+
 	/* Test remove_front */
 	for (i = 0; i < num_elem; ++i) {
 		int expected = (i == 0 ? elems[num_elem-1].v : elems[i-1].v);
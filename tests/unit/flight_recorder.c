@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "test-common.h"
+#include "nccl_ofi_flight_recorder.h"
+
+#define RING_EVENTS	(16)
+#define NUM_THREADS	(4)
+#define NUM_RECORDS	(10000)
+
+/* Target of links planted at the paths of the dump, which must never
+ * be created */
+#define VICTIM_PATH	"flight-recorder-victim"
+
+static nccl_ofi_flight_recorder_t *shared_ring;
+
+static void *record_events(void *arg)
+{
+	uint32_t thread = (uint32_t)(uintptr_t)arg;
+
+	for (int i = 0; i < NUM_RECORDS; i++) {
+		/* All fields of an event identify its writer */
+		nccl_ofi_flight_record(shared_ring, NCCL_OFI_FLIGHT_POST, thread, (void *)(uintptr_t)thread,
+				       thread, thread, thread, thread, thread);
+	}
+	return NULL;
+}
+
+/*
+ * @brief	Read dump file and check its rings
+ *
+ * @param	other_in_use
+ *		Expected in_use of the rings other than the shared ring
+ */
+static int check_dump(const char *path, int reason, uint32_t num_rings, uint64_t shared_head,
+		      uint32_t other_in_use)
+{
+	nccl_ofi_flight_dump_header_t header;
+	nccl_ofi_flight_dump_ring_t ring;
+	nccl_ofi_flight_event_t events[RING_EVENTS];
+	FILE *file = fopen(path, "rb");
+	uint64_t published = 0;
+	int ret = 1;
+
+	if (!file) {
+		NCCL_OFI_WARN("Dump file %s not written", path);
+		return 1;
+	}
+	if (fread(&header, sizeof(header), 1, file) != 1 ||
+	    header.magic != NCCL_OFI_FLIGHT_RECORDER_MAGIC ||
+	    header.event_size != sizeof(nccl_ofi_flight_event_t) ||
+	    header.pid != getpid() || header.reason != reason || header.num_rings != num_rings) {
+		NCCL_OFI_WARN("Unexpected dump header");
+		goto exit;
+	}
+
+	for (uint32_t i = 0; i < header.num_rings; i++) {
+		if (fread(&ring, sizeof(ring), 1, file) != 1 || ring.num_events != RING_EVENTS ||
+		    fread(events, sizeof(events[0]), RING_EVENTS, file) != RING_EVENTS) {
+			NCCL_OFI_WARN("Truncated ring %u", i);
+			goto exit;
+		}
+		if (ring.id != shared_ring->id) {
+			if (ring.in_use != other_in_use) {
+				NCCL_OFI_WARN("Ring %u in use %u, expected %u", ring.id, ring.in_use,
+					      other_in_use);
+				goto exit;
+			}
+			continue;
+		}
+		if (!ring.in_use) {
+			NCCL_OFI_WARN("Shared ring dumped as released");
+			goto exit;
+		}
+		if (ring.head != shared_head) {
+			NCCL_OFI_WARN("Ring head %lu, expected %lu", ring.head, shared_head);
+			goto exit;
+		}
+		for (uint64_t pos = ring.head - RING_EVENTS; pos < ring.head; pos++) {
+			nccl_ofi_flight_event_t *event = &events[pos % RING_EVENTS];
+			/* A writer that was preempted while the ring wrapped
+			 * around leaves a stale sequence number */
+			if (event->seq != pos + 1) {
+				continue;
+			}
+			published++;
+			if (event->rail != (int16_t)event->value ||
+			    event->request != (uint64_t)event->value || event->comm_id != (uint32_t)event->value ||
+			    event->msg_seq_num != event->value || event->arg != (uint64_t)event->value) {
+				NCCL_OFI_WARN("Torn event at position %lu", pos);
+				goto exit;
+			}
+		}
+		if (published == 0) {
+			NCCL_OFI_WARN("No published event in ring");
+			goto exit;
+		}
+	}
+
+	ret = 0;
+ exit:
+	fclose(file);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	nccl_ofi_flight_recorder_t *other_ring;
+	nccl_ofi_flight_recorder_t *empty_ring;
+	pthread_t threads[NUM_THREADS];
+	char cwd[PATH_MAX];
+	char path[PATH_MAX + 32];
+	char tmp_path[PATH_MAX + 64];
+	struct stat st;
+
+	ofi_log_function = logger;
+
+	setenv("OFI_NCCL_FLIGHT_RECORDER_EVENTS", "10", 1);
+	setenv("OFI_NCCL_FLIGHT_RECORDER_SIGNAL", "12", 1);
+	setenv("OFI_NCCL_FLIGHT_RECORDER_ABORT", "0", 1);
+	if (nccl_ofi_flight_recorder_init() != 0 || !nccl_ofi_flight_recorder_path()) {
+		NCCL_OFI_WARN("Flight recorder initialization failed");
+		return 1;
+	}
+	/* Dumps go to the working directory by default */
+	if (!getcwd(cwd, sizeof(cwd))) {
+		NCCL_OFI_WARN("Unable to get working directory");
+		return 1;
+	}
+	snprintf(path, sizeof(path), "%s/%s%d.bin", cwd, NCCL_OFI_FLIGHT_RECORDER_FILE_PREFIX,
+		 (int)getpid());
+	if (strcmp(path, nccl_ofi_flight_recorder_path()) != 0) {
+		NCCL_OFI_WARN("Unexpected dump file %s", nccl_ofi_flight_recorder_path());
+		return 1;
+	}
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+	/* Released rings are reused */
+	shared_ring = nccl_ofi_flight_recorder_alloc(0);
+	other_ring = nccl_ofi_flight_recorder_alloc(1);
+	if (!shared_ring || !other_ring || shared_ring == other_ring ||
+	    shared_ring->num_events != RING_EVENTS) {
+		NCCL_OFI_WARN("Ring allocation failed");
+		return 1;
+	}
+	nccl_ofi_flight_recorder_release(other_ring);
+	if (nccl_ofi_flight_recorder_alloc(2) != other_ring || other_ring->dev_id != 2) {
+		NCCL_OFI_WARN("Released ring not reused");
+		return 1;
+	}
+
+	/* Concurrent writers never publish torn events */
+	for (uintptr_t i = 0; i < NUM_THREADS; i++) {
+		if (pthread_create(&threads[i], NULL, record_events, (void *)(i + 1)) != 0) {
+			NCCL_OFI_WARN("Thread creation failed");
+			return 1;
+		}
+	}
+	for (int i = 0; i < NUM_THREADS; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	/* Links planted at the paths of the dump are replaced, not
+	 * written through */
+	if (symlink(VICTIM_PATH, path) != 0 || symlink(VICTIM_PATH, tmp_path) != 0) {
+		NCCL_OFI_WARN("Unable to plant symbolic links at %s", path);
+		return 1;
+	}
+	if (nccl_ofi_flight_recorder_dump(NCCL_OFI_FLIGHT_DUMP_ERROR) != 0 ||
+	    check_dump(path, NCCL_OFI_FLIGHT_DUMP_ERROR, 2, NUM_THREADS * NUM_RECORDS, 1)) {
+		unlink(path);
+		unlink(tmp_path);
+		return 1;
+	}
+	if (lstat(path, &st) != 0 || !S_ISREG(st.st_mode) || (st.st_mode & 0777) != 0600 ||
+	    access(tmp_path, F_OK) == 0 || access(VICTIM_PATH, F_OK) == 0) {
+		NCCL_OFI_WARN("Dump written through symbolic link or accessible by others");
+		unlink(path);
+		unlink(VICTIM_PATH);
+		return 1;
+	}
+
+	/* The signal dumps the rings in use and the released rings that
+	 * hold events */
+	nccl_ofi_flight_record(other_ring, NCCL_OFI_FLIGHT_POST, 0, NULL, 0, 0, 0, 0, 0);
+	nccl_ofi_flight_recorder_release(other_ring);
+	raise(SIGUSR2);
+	if (check_dump(path, SIGUSR2, 2, NUM_THREADS * NUM_RECORDS, 0)) {
+		unlink(path);
+		return 1;
+	}
+	unlink(path);
+
+	/* Empty released rings are not dumped */
+	if (nccl_ofi_flight_recorder_alloc(3) != other_ring) {
+		NCCL_OFI_WARN("Released ring not reused");
+		unlink(path);
+		return 1;
+	}
+	empty_ring = nccl_ofi_flight_recorder_alloc(4);
+	if (!empty_ring || empty_ring->head != 0) {
+		NCCL_OFI_WARN("Ring allocation failed");
+		unlink(path);
+		return 1;
+	}
+	nccl_ofi_flight_recorder_release(empty_ring);
+	if (nccl_ofi_flight_recorder_dump(NCCL_OFI_FLIGHT_DUMP_ERROR) != 0 ||
+	    check_dump(path, NCCL_OFI_FLIGHT_DUMP_ERROR, 2, NUM_THREADS * NUM_RECORDS, 1)) {
+		unlink(path);
+		return 1;
+	}
+	unlink(path);
+
+	printf("Test completed successfully!\n");
+
+	return 0;
+}
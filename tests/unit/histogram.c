@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test-common.h"
+#include "nccl_ofi_histogram.h"
+
+#define NUM_THREADS		(4)
+#define SAMPLES_PER_THREAD	(100000)
+
+static nccl_ofi_histogram_t shared_histogram;
+
+static void *record_samples(void *arg)
+{
+	for (uint64_t i = 0; i < SAMPLES_PER_THREAD; i++) {
+		nccl_ofi_histogram_record(&shared_histogram, 1000 + i % 1000);
+	}
+	return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+	nccl_ofi_histogram_t *histogram;
+	pthread_t threads[NUM_THREADS];
+	char summary[128];
+	int prev_bucket = -1;
+
+	ofi_log_function = logger;
+
+	/* Buckets grow with the latency and hold their smallest latency */
+	for (uint64_t value = 0; value < (1ULL << 20); value++) {
+		int bucket = nccl_ofi_histogram_bucket(value);
+
+		if (bucket < prev_bucket || bucket >= NCCL_OFI_HISTOGRAM_BUCKETS ||
+		    nccl_ofi_histogram_bucket_value(bucket) > value ||
+		    (bucket != prev_bucket && nccl_ofi_histogram_bucket_value(bucket) != value)) {
+			NCCL_OFI_WARN("Latency %lu in bucket %d with smallest latency %lu",
+				      value, bucket, nccl_ofi_histogram_bucket_value(bucket));
+			return 1;
+		}
+		prev_bucket = bucket;
+	}
+	if (nccl_ofi_histogram_bucket(UINT64_MAX) != NCCL_OFI_HISTOGRAM_BUCKETS - 1 ||
+	    nccl_ofi_histogram_bucket(1ULL << NCCL_OFI_HISTOGRAM_MAX_LOG2) != NCCL_OFI_HISTOGRAM_BUCKETS - NCCL_OFI_HISTOGRAM_STEPS) {
+		NCCL_OFI_WARN("Large latencies not in the last buckets");
+		return 1;
+	}
+
+	histogram = calloc(1, sizeof(*histogram));
+	if (!histogram) {
+		NCCL_OFI_WARN("Histogram allocation failed");
+		return 1;
+	}
+
+	/* Quantiles of an empty histogram */
+	if (nccl_ofi_histogram_quantile(histogram, 0.5) != 0 ||
+	    nccl_ofi_histogram_format(histogram, summary, sizeof(summary)) <= 0 ||
+	    strcmp(summary, "n=0") != 0) {
+		NCCL_OFI_WARN("Unexpected summary of empty histogram: %s", summary);
+		return 1;
+	}
+
+	/* 90 samples of 1 µs and 10 of 100 µs */
+	for (int i = 0; i < 100; i++) {
+		nccl_ofi_histogram_record(histogram, i < 90 ? 1000 : 100000);
+	}
+	if (nccl_ofi_histogram_count(histogram) != 100 ||
+	    nccl_ofi_histogram_quantile(histogram, 0.5) < 1000 ||
+	    nccl_ofi_histogram_quantile(histogram, 0.5) > 1000 * 5 / 4 ||
+	    nccl_ofi_histogram_quantile(histogram, 0.9) > 1000 * 5 / 4 ||
+	    nccl_ofi_histogram_quantile(histogram, 0.91) < 100000 ||
+	    nccl_ofi_histogram_quantile(histogram, 1.0) > 100000 * 5 / 4) {
+		NCCL_OFI_WARN("Unexpected quantiles p50 %lu p90 %lu p91 %lu max %lu",
+			      nccl_ofi_histogram_quantile(histogram, 0.5),
+			      nccl_ofi_histogram_quantile(histogram, 0.9),
+			      nccl_ofi_histogram_quantile(histogram, 0.91),
+			      nccl_ofi_histogram_quantile(histogram, 1.0));
+		return 1;
+	}
+	nccl_ofi_histogram_format(histogram, summary, sizeof(summary));
+	if (strncmp(summary, "n=100 mean=10.9 ", strlen("n=100 mean=10.9 ")) != 0) {
+		NCCL_OFI_WARN("Unexpected summary: %s", summary);
+		return 1;
+	}
+
+	/* Intervals ending before their start count as 0 ns */
+	memset(histogram, 0, sizeof(*histogram));
+	nccl_ofi_histogram_record_interval(histogram, 1000, 3000);
+	nccl_ofi_histogram_record_interval(histogram, 3000, 1000);
+	if (nccl_ofi_histogram_count(histogram) != 2 || histogram->sum != 2000 ||
+	    histogram->counts[0] != 1) {
+		NCCL_OFI_WARN("Unexpected intervals: %lu samples, sum %lu",
+			      nccl_ofi_histogram_count(histogram), histogram->sum);
+		return 1;
+	}
+	free(histogram);
+
+	/* Concurrent updates are not lost */
+	for (int i = 0; i < NUM_THREADS; i++) {
+		if (pthread_create(&threads[i], NULL, record_samples, NULL) != 0) {
+			NCCL_OFI_WARN("Thread creation failed");
+			return 1;
+		}
+	}
+	for (int i = 0; i < NUM_THREADS; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	if (nccl_ofi_histogram_count(&shared_histogram) != NUM_THREADS * SAMPLES_PER_THREAD ||
+	    shared_histogram.sum != NUM_THREADS * (SAMPLES_PER_THREAD / 1000) * (1000 * 1000 + 999 * 1000 / 2)) {
+		NCCL_OFI_WARN("Lost samples: %lu samples, sum %lu",
+			      nccl_ofi_histogram_count(&shared_histogram), shared_histogram.sum);
+		return 1;
+	}
+
+	printf("Test completed successfully!\n");
+
+	return 0;
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "test-common.h"
+#include "nccl_ofi_ini.h"
+
+struct parse_result {
+	char str[1024];
+	size_t len;
+	int abort_line;
+};
+
+static int record_handler(void *ctx, const char *section, const char *key,
+			  const char *value, int lineno)
+{
+	struct parse_result *result = ctx;
+
+	if (lineno == result->abort_line) {
+		return 1;
+	}
+
+	result->len += snprintf(result->str + result->len, sizeof(result->str) - result->len,
+				"%d:[%s]%s=%s;", lineno, section, key, value);
+	return 0;
+}
+
+static int parse(const char *input, struct parse_result *result)
+{
+	int ret;
+	FILE *stream = fmemopen((void *)input, strlen(input), "r");
+
+	if (!stream) {
+		NCCL_OFI_WARN("Failed to open memory stream");
+		return -EIO;
+	}
+
+	ret = nccl_ofi_ini_parse_stream(stream, "test", record_handler, result);
+	fclose(stream);
+	return ret;
+}
+
+static int test_parse(const char *input, int expected_ret, const char *expected)
+{
+	struct parse_result result = { .str = "", .len = 0, .abort_line = 0 };
+	int ret = parse(input, &result);
+
+	if (ret != expected_ret) {
+		NCCL_OFI_WARN("Parsing \"%s\" returned %d, expected %d", input, ret, expected_ret);
+		return 1;
+	}
+	if (strcmp(result.str, expected) != 0) {
+		NCCL_OFI_WARN("Parsing \"%s\" produced \"%s\", expected \"%s\"",
+			      input, result.str, expected);
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int ret = 0;
+	int64_t ival;
+	double dval;
+	bool bval;
+
+	ofi_log_function = logger;
+
+	/* Sections, comments and whitespace */
+	ret |= test_parse("", 0, "");
+	ret |= test_parse("a=1\n", 0, "1:[]a=1;");
+	ret |= test_parse("# comment\n; comment\n\n[ p5.* ]\n  key  =  value  \nempty=\n", 0,
+			  "5:[p5.*]key=value;6:[p5.*]empty=;");
+	ret |= test_parse("[a]\nx=1\n[b]\nx=2 = 3\n", 0, "2:[a]x=1;4:[b]x=2 = 3;");
+	ret |= test_parse("[a]\nlast=no newline", 0, "2:[a]last=no newline;");
+
+	/* Syntax errors */
+	ret |= test_parse("[a\nx=1\n", -EINVAL, "");
+	ret |= test_parse("[a] trailing\n", -EINVAL, "");
+	ret |= test_parse("[a]\nx=1\nnot a pair\n", -EINVAL, "2:[a]x=1;");
+	ret |= test_parse("[a]\n = 1\n", -EINVAL, "");
+
+	/* Handler aborts parsing */
+	{
+		struct parse_result result = { .str = "", .len = 0, .abort_line = 2 };
+		if (parse("x=1\ny=2\nz=3\n", &result) != -EINVAL || strcmp(result.str, "1:[]x=1;") != 0) {
+			NCCL_OFI_WARN("Handler failed to abort parsing");
+			ret = 1;
+		}
+	}
+
+	/* Missing file */
+	if (nccl_ofi_ini_parse_file("/nonexistent/platform.ini", record_handler, NULL) != -ENOENT) {
+		NCCL_OFI_WARN("Parsing missing file did not return -ENOENT");
+		ret = 1;
+	}
+
+	/* Value parsers */
+	if (nccl_ofi_ini_parse_int("0x10", &ival) != 0 || ival != 16 ||
+	    nccl_ofi_ini_parse_int("-5", &ival) != 0 || ival != -5 ||
+	    nccl_ofi_ini_parse_int("", &ival) != -EINVAL ||
+	    nccl_ofi_ini_parse_int("12k", &ival) != -EINVAL) {
+		NCCL_OFI_WARN("Integer parsing failed");
+		ret = 1;
+	}
+	if (nccl_ofi_ini_parse_double("75.5", &dval) != 0 || dval != 75.5 ||
+	    nccl_ofi_ini_parse_double("fast", &dval) != -EINVAL) {
+		NCCL_OFI_WARN("Floating point parsing failed");
+		ret = 1;
+	}
+	if (nccl_ofi_ini_parse_bool("Yes", &bval) != 0 || !bval ||
+	    nccl_ofi_ini_parse_bool("off", &bval) != 0 || bval ||
+	    nccl_ofi_ini_parse_bool("2", &bval) != -EINVAL) {
+		NCCL_OFI_WARN("Boolean parsing failed");
+		ret = 1;
+	}
+
+	if (ret) {
+		return ret;
+	}
+
+	printf("Test completed successfully!\n");
+
+	return 0;
+}
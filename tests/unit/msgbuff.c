@@ -10,6 +10,27 @@
 
 #include "test-common.h"
 
+struct visit_t {
+	uint16_t *buff_store;
+	uint16_t field_size;
+	uint16_t expected_index;
+	uint16_t num_visited;
+	bool error;
+};
+
+static void visit(uint16_t msg_index, nccl_ofi_msgbuff_status_t stat,
+		  nccl_ofi_msgbuff_elemtype_t type, void *elem, void *arg)
+{
+	struct visit_t *visit = arg;
+
+	if (msg_index != visit->expected_index || stat != NCCL_OFI_MSGBUFF_INPROGRESS ||
+	    elem != &visit->buff_store[visit->num_visited]) {
+		visit->error = true;
+	}
+	visit->expected_index = (msg_index + 1) % visit->field_size;
+	visit->num_visited++;
+}
+
 int main(int argc, char *argv[])
 {
 	ofi_log_function = logger;
@@ -91,6 +112,16 @@ int main(int argc, char *argv[])
 			return 1;
 		}
 
+		/** Test for_each **/
+		struct visit_t visited = { buff_store, field_size, msg_seq_num, 0, false };
+		uint16_t first, next;
+		if (nccl_ofi_msgbuff_for_each(msgbuff, visit, &visited, &first, &next) != NCCL_OFI_MSGBUFF_SUCCESS ||
+		    visited.error || visited.num_visited != max_inprogress || first != msg_seq_num ||
+		    next != (msg_seq_num + max_inprogress) % field_size) {
+			NCCL_OFI_WARN("nccl_ofi_msgbuff_for_each did not visit in-progress messages");
+			return 1;
+		}
+
 		/** Test complete **/
 		for (uint16_t i = 0; i < max_inprogress; ++i) {
 			if (nccl_ofi_msgbuff_complete(msgbuff, (msg_seq_num + i) % field_size, &stat) !=
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "test-common.h"
+#include "nccl_ofi_signal.h"
+
+static volatile sig_atomic_t prev_calls = 0;
+static volatile sig_atomic_t handler_calls = 0;
+
+static void prev_handler(int signum)
+{
+	prev_calls++;
+}
+
+static void consumer_handler(int signum)
+{
+	handler_calls++;
+}
+
+int main(int argc, char *argv[])
+{
+	struct sigaction action;
+
+	ofi_log_function = logger;
+
+	/* Action of the application before the plugin registers */
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = prev_handler;
+	sigemptyset(&action.sa_mask);
+	if (sigaction(SIGUSR1, &action, NULL) != 0) {
+		NCCL_OFI_WARN("Unable to install previous handler");
+		return 1;
+	}
+
+	if (nccl_ofi_signal_register(0, NCCL_OFI_SIGNAL_TRACER, NULL) != -EINVAL) {
+		NCCL_OFI_WARN("Invalid signal registered");
+		return 1;
+	}
+
+	/* Consumers share a signal, and the previous action still runs */
+	if (nccl_ofi_signal_register(SIGUSR1, NCCL_OFI_SIGNAL_HISTOGRAM, NULL) != 0 ||
+	    nccl_ofi_signal_register(SIGUSR1, NCCL_OFI_SIGNAL_TRACER, NULL) != 0 ||
+	    nccl_ofi_signal_register(SIGUSR1, NCCL_OFI_SIGNAL_FLIGHT_RECORDER,
+				     consumer_handler) != 0) {
+		NCCL_OFI_WARN("Registration failed");
+		return 1;
+	}
+	raise(SIGUSR1);
+	raise(SIGUSR1);
+	if (nccl_ofi_signal_count(NCCL_OFI_SIGNAL_HISTOGRAM) != 2 ||
+	    nccl_ofi_signal_count(NCCL_OFI_SIGNAL_TRACER) != 2 ||
+	    nccl_ofi_signal_count(NCCL_OFI_SIGNAL_FLIGHT_RECORDER) != 2 ||
+	    handler_calls != 2 || prev_calls != 2) {
+		NCCL_OFI_WARN("Signal not dispatched to all consumers and the previous handler");
+		return 1;
+	}
+
+	/* The default action of a dump signal does not terminate the
+	 * process, and only registered consumers are notified */
+	if (nccl_ofi_signal_register(SIGUSR2, NCCL_OFI_SIGNAL_TRACER, NULL) != 0) {
+		NCCL_OFI_WARN("Registration failed");
+		return 1;
+	}
+	raise(SIGUSR2);
+	if (nccl_ofi_signal_count(NCCL_OFI_SIGNAL_HISTOGRAM) != 2 ||
+	    nccl_ofi_signal_count(NCCL_OFI_SIGNAL_TRACER) != 3 ||
+	    handler_calls != 2 || prev_calls != 2) {
+		NCCL_OFI_WARN("Signal dispatched to unregistered consumers");
+		return 1;
+	}
+
+	printf("Test completed successfully!\n");
+
+	return 0;
+}
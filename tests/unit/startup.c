@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "test-common.h"
+#include "nccl_ofi_startup.h"
+
+#define NUM_THREADS	(4)
+#define NUM_CONNECTS	(100)
+
+static void *connect_peers(void *arg)
+{
+	for (int i = 0; i < NUM_CONNECTS; i++) {
+		uint64_t begin = nccl_ofi_startup_begin();
+		nccl_ofi_startup_end(NCCL_OFI_STARTUP_CONNECT_SEND, begin);
+	}
+	return NULL;
+}
+
+static char path[64];
+
+/* Registered before the profiler, so that it runs after the profile
+ * was written at exit */
+static void remove_profile(void)
+{
+	unlink(path);
+}
+
+int main(int argc, char *argv[])
+{
+	nccl_ofi_startup_stats_t stats[NCCL_OFI_STARTUP_NUM_PHASES];
+	pthread_t threads[NUM_THREADS];
+	char buffer[4096];
+	char connect_send[64];
+	uint64_t begin;
+	FILE *file;
+	size_t len;
+
+	ofi_log_function = logger;
+
+	snprintf(path, sizeof(path), "/tmp/nccl-ofi-startup-test-%d.json", (int)getpid());
+	atexit(remove_profile);
+
+	/* Phases are not recorded while the profiler is disabled */
+	nccl_ofi_startup_end(NCCL_OFI_STARTUP_DOMAIN, nccl_ofi_startup_begin());
+
+	setenv("OFI_NCCL_STARTUP_PROFILE", "1", 1);
+	setenv("OFI_NCCL_STARTUP_PROFILE_FILE", "/tmp/nccl-ofi-startup-test-%p.json", 1);
+	if (nccl_ofi_startup_init() != 0 || !nccl_ofi_startup_enabled) {
+		NCCL_OFI_WARN("Startup profiler initialization failed");
+		return 1;
+	}
+
+	/* Nested phases */
+	begin = nccl_ofi_startup_begin();
+	for (int i = 0; i < 3; i++) {
+		uint64_t mr_begin = nccl_ofi_startup_begin();
+		usleep(1000);
+		nccl_ofi_startup_end(NCCL_OFI_STARTUP_MR_REG, mr_begin);
+	}
+	nccl_ofi_startup_end(NCCL_OFI_STARTUP_PLUGIN_INIT, begin);
+
+	/* Concurrent phases */
+	for (int i = 0; i < NUM_THREADS; i++) {
+		if (pthread_create(&threads[i], NULL, connect_peers, NULL) != 0) {
+			NCCL_OFI_WARN("Thread creation failed");
+			return 1;
+		}
+	}
+	for (int i = 0; i < NUM_THREADS; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	nccl_ofi_startup_snapshot(stats);
+	if (stats[NCCL_OFI_STARTUP_DOMAIN].count != 0 ||
+	    stats[NCCL_OFI_STARTUP_PLUGIN_INIT].count != 1 ||
+	    stats[NCCL_OFI_STARTUP_MR_REG].count != 3 ||
+	    stats[NCCL_OFI_STARTUP_CONNECT_SEND].count != NUM_THREADS * NUM_CONNECTS) {
+		NCCL_OFI_WARN("Unexpected phase counts");
+		return 1;
+	}
+	if (stats[NCCL_OFI_STARTUP_MR_REG].total_ns < 3000000 ||
+	    stats[NCCL_OFI_STARTUP_MR_REG].max_ns > stats[NCCL_OFI_STARTUP_MR_REG].total_ns ||
+	    stats[NCCL_OFI_STARTUP_PLUGIN_INIT].total_ns < stats[NCCL_OFI_STARTUP_MR_REG].total_ns ||
+	    stats[NCCL_OFI_STARTUP_MR_REG].first_begin < stats[NCCL_OFI_STARTUP_PLUGIN_INIT].first_begin ||
+	    stats[NCCL_OFI_STARTUP_MR_REG].last_end > stats[NCCL_OFI_STARTUP_PLUGIN_INIT].last_end ||
+	    stats[NCCL_OFI_STARTUP_CONNECT_SEND].last_end < stats[NCCL_OFI_STARTUP_PLUGIN_INIT].last_end) {
+		NCCL_OFI_WARN("Unexpected phase times");
+		return 1;
+	}
+
+	if (nccl_ofi_startup_report() != 0) {
+		NCCL_OFI_WARN("Startup report failed");
+		return 1;
+	}
+	file = fopen(path, "r");
+	if (!file) {
+		NCCL_OFI_WARN("Startup profile %s not written", path);
+		return 1;
+	}
+	len = fread(buffer, 1, sizeof(buffer) - 1, file);
+	buffer[len] = '\0';
+	fclose(file);
+
+	snprintf(connect_send, sizeof(connect_send), "\"connect_send\":{\"count\":%d,",
+		 NUM_THREADS * NUM_CONNECTS);
+	if (!strstr(buffer, "\"plugin_init\":{\"count\":1,") ||
+	    !strstr(buffer, "\"mr_reg\":{\"count\":3,") ||
+	    !strstr(buffer, connect_send) ||
+	    strstr(buffer, "\"domain\"")) {
+		NCCL_OFI_WARN("Unexpected startup profile:\n%s", buffer);
+		return 1;
+	}
+
+	printf("Test completed successfully!\n");
+
+	return 0;
+}
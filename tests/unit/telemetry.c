@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "test-common.h"
+#include "nccl_ofi_telemetry.h"
+
+#define NUM_UPDATES	(100000)
+
+static nccl_ofi_telemetry_ep_t *shared_record;
+
+/*
+ * Update all gauges of the record to the same value, so that a reader
+ * that sees different values read a torn record
+ */
+static void *update_record(void *arg)
+{
+	for (uint64_t i = 1; i <= NUM_UPDATES; i++) {
+		if (!nccl_ofi_telemetry_write_begin(&shared_record->seq)) {
+			return (void *)1;
+		}
+		shared_record->pending_reqs = i;
+		for (int rail_id = 0; rail_id < NCCL_OFI_TELEMETRY_MAX_RAILS; rail_id++) {
+			shared_record->bounce_posted[rail_id] = i;
+		}
+		shared_record->bounce_fl_entries = i;
+		shared_record->bounce_reqs_fl_entries = i;
+		nccl_ofi_telemetry_write_end(&shared_record->seq);
+	}
+	return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+	nccl_ofi_telemetry_segment_t *segment;
+	nccl_ofi_telemetry_comm_t *comms[NCCL_OFI_TELEMETRY_MAX_COMMS];
+	nccl_ofi_telemetry_comm_t *comm;
+	char path[64];
+	char victim[64];
+	struct stat st;
+	FILE *file;
+	pthread_t writer;
+	void *writer_ret;
+	uint64_t last = 0;
+
+	ofi_log_function = logger;
+
+	if (nccl_ofi_telemetry_init(NCCL_OFI_TELEMETRY_MAX_DEVS + 1, 1) != -EINVAL ||
+	    nccl_ofi_telemetry_get() != NULL) {
+		NCCL_OFI_WARN("Segment created for too many devices");
+		return 1;
+	}
+
+	/* A file planted at the path of the segment is replaced, not written */
+	snprintf(path, sizeof(path), "%s%d", NCCL_OFI_TELEMETRY_PATH_PREFIX, (int)getpid());
+	snprintf(victim, sizeof(victim), "%s%d.victim", NCCL_OFI_TELEMETRY_PATH_PREFIX,
+		 (int)getpid());
+	file = fopen(victim, "w");
+	if (!file || fputs("victim", file) < 0 || fclose(file) != 0 || symlink(victim, path) != 0) {
+		NCCL_OFI_WARN("Unable to plant symbolic link at %s", path);
+		return 1;
+	}
+
+	if (nccl_ofi_telemetry_init(2, 4) != 0) {
+		NCCL_OFI_WARN("Segment creation failed");
+		return 1;
+	}
+
+	if (stat(victim, &st) != 0 || st.st_size != (off_t)strlen("victim") ||
+	    lstat(path, &st) != 0 || !S_ISREG(st.st_mode) || (st.st_mode & 0777) != 0600) {
+		NCCL_OFI_WARN("Segment written through symbolic link or accessible by others");
+		return 1;
+	}
+	unlink(victim);
+
+	segment = nccl_ofi_telemetry_get();
+	if (access(path, F_OK) != 0 || segment->magic != NCCL_OFI_TELEMETRY_MAGIC ||
+	    segment->version != NCCL_OFI_TELEMETRY_VERSION || segment->num_devs != 2 ||
+	    segment->num_rails != 4 || segment->pid != getpid()) {
+		NCCL_OFI_WARN("Unexpected segment header at %s", path);
+		return 1;
+	}
+
+	/* Records are reserved until released */
+	for (int i = 0; i < NCCL_OFI_TELEMETRY_MAX_COMMS; i++) {
+		comms[i] = nccl_ofi_telemetry_alloc_comm(1, NCCL_OFI_TELEMETRY_RECV_COMM, i);
+		if (!comms[i] || comms[i]->comm_id != i || comms[i]->dev_id != 1 ||
+		    (comms[i]->seq & 1)) {
+			NCCL_OFI_WARN("Reservation of communicator record %d failed", i);
+			return 1;
+		}
+	}
+	if (nccl_ofi_telemetry_alloc_comm(1, NCCL_OFI_TELEMETRY_RECV_COMM, 0) != NULL) {
+		NCCL_OFI_WARN("Reserved more communicator records than available");
+		return 1;
+	}
+	nccl_ofi_telemetry_release(&comms[3]->seq, &comms[3]->in_use);
+	comm = nccl_ofi_telemetry_alloc_comm(0, NCCL_OFI_TELEMETRY_SEND_COMM, 42);
+	if (comm != comms[3] || comm->comm_id != 42 || comm->type != NCCL_OFI_TELEMETRY_SEND_COMM) {
+		NCCL_OFI_WARN("Released communicator record not reused");
+		return 1;
+	}
+
+	/* Readers never see torn records */
+	shared_record = nccl_ofi_telemetry_alloc_ep(0);
+	if (!shared_record) {
+		NCCL_OFI_WARN("Reservation of endpoint record failed");
+		return 1;
+	}
+	if (pthread_create(&writer, NULL, update_record, NULL) != 0) {
+		NCCL_OFI_WARN("Thread creation failed");
+		return 1;
+	}
+	while (last != NUM_UPDATES) {
+		nccl_ofi_telemetry_ep_t copy;
+		uint64_t begin = nccl_ofi_telemetry_read_begin(&shared_record->seq);
+
+		memcpy(&copy, shared_record, sizeof(copy));
+		if (nccl_ofi_telemetry_read_retry(&shared_record->seq, begin)) {
+			continue;
+		}
+		for (int rail_id = 0; rail_id < NCCL_OFI_TELEMETRY_MAX_RAILS; rail_id++) {
+			if (copy.bounce_posted[rail_id] != copy.pending_reqs ||
+			    copy.bounce_fl_entries != copy.pending_reqs ||
+			    copy.bounce_reqs_fl_entries != copy.pending_reqs) {
+				NCCL_OFI_WARN("Torn record with gauges %lu and %lu", copy.pending_reqs,
+					      copy.bounce_posted[rail_id]);
+				return 1;
+			}
+		}
+		if (copy.pending_reqs < last) {
+			NCCL_OFI_WARN("Record went back from %lu to %lu", last, copy.pending_reqs);
+			return 1;
+		}
+		last = copy.pending_reqs;
+	}
+	pthread_join(writer, &writer_ret);
+	if (writer_ret != NULL) {
+		NCCL_OFI_WARN("Concurrent writer of record");
+		return 1;
+	}
+
+	printf("Test completed successfully!\n");
+
+	return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#ifndef TEST_TOPO_H_
+#define TEST_TOPO_H_
+
+#include <stdlib.h>
+#include <rdma/fabric.h>
+#include <rdma/fi_errno.h>
+
+#include "nccl_ofi_log.h"
+
+/*
+ * @brief	NIC handle of synthetic libfabric NIC info structs
+ *
+ * Libfabric duplicates and releases NIC handles via the FI_DUP
+ * control command and close operation of the handle.
+ */
+struct test_nic {
+	struct fid_nic nic;
+	struct fi_bus_attr bus_attr;
+};
+
+static struct fid_nic *test_nic_create(const struct fi_pci_attr *pci);
+
+static inline int test_nic_close(struct fid *fid)
+{
+	free(fid);
+	return 0;
+}
+
+static inline int test_nic_control(struct fid *fid, int command, void *arg)
+{
+	struct test_nic *nic = (struct test_nic *)fid;
+	struct fid_nic **dup = (struct fid_nic **)arg;
+
+	if (command != FI_DUP) return -FI_ENOSYS;
+
+	*dup = test_nic_create(&nic->bus_attr.attr.pci);
+	return *dup ? 0 : -FI_ENOMEM;
+}
+
+static struct fi_ops test_nic_ops = {
+	.size = sizeof(struct fi_ops),
+	.close = test_nic_close,
+	.control = test_nic_control,
+};
+
+static inline struct fid_nic *test_nic_create(const struct fi_pci_attr *pci)
+{
+	struct test_nic *nic = calloc(1, sizeof(struct test_nic));
+	if (!nic) return NULL;
+
+	nic->nic.fid.fclass = FI_CLASS_NIC;
+	nic->nic.fid.ops = &test_nic_ops;
+	nic->nic.bus_attr = &nic->bus_attr;
+	nic->bus_attr.bus_type = FI_BUS_PCI;
+	nic->bus_attr.attr.pci = *pci;
+
+	return &nic->nic;
+}
+
+/*
+ * @brief	Create list of libfabric NIC info structs from PCI addresses
+ *
+ * @return	Info list, on success
+ *		NULL, on error
+ */
+static inline struct fi_info *test_create_info_list(const struct fi_pci_attr *pci, int num_nics)
+{
+	struct fi_info *head = NULL;
+	struct fi_info *tail = NULL;
+
+	for (int i = 0; i < num_nics; ++i) {
+		struct fi_info *info = fi_allocinfo();
+		if (!info) goto error;
+
+		info->nic = test_nic_create(&pci[i]);
+		if (!info->nic) {
+			fi_freeinfo(info);
+			goto error;
+		}
+
+		if (tail) tail->next = info;
+		else head = info;
+		tail = info;
+	}
+
+	return head;
+
+ error:
+	NCCL_OFI_WARN("Failed to create libfabric NIC info list");
+	fi_freeinfo(head);
+	return NULL;
+}
+
+#endif // End TEST_TOPO_H_
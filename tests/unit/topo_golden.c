@@ -0,0 +1,688 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+/*
+ * End-to-end test of NIC grouping and NCCL topology file generation.
+ *
+ * Each test case is a compact description of a PCIe layout from which
+ * an hwloc XML topology, a libfabric NIC info list, and a fake sysfs
+ * tree providing PCIe link speeds and widths are generated. The NIC
+ * groups and the NCCL topology file produced by the plugin are
+ * compared against golden files in TOPO_GOLDEN_DIR.
+ *
+ * Set environment variable TOPO_GOLDEN_UPDATE to regenerate the
+ * golden files instead of comparing against them.
+ */
+
+#include "config.h"
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <ftw.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "test-common.h"
+#include "test-topo.h"
+#include "nccl_ofi_math.h"
+#include "nccl_ofi_topo.h"
+
+#ifndef TOPO_GOLDEN_DIR
+#define TOPO_GOLDEN_DIR "topo_golden"
+#endif
+
+#define MAX_SOCKETS 2
+#define MAX_SWITCHES 4
+#define MAX_SWITCH_DEVS 8
+#define MAX_NICS (MAX_SOCKETS * MAX_SWITCHES * MAX_SWITCH_DEVS)
+
+/* Number of randomized layouts compared against golden files */
+#define NUM_GOLDEN_RANDOM_LAYOUTS 8
+/* Number of randomized layouts checked for invariants only */
+#define NUM_RANDOM_LAYOUTS 256
+
+typedef enum test_dev_type {
+	TEST_ACCEL,
+	TEST_NIC,
+} test_dev_type_t;
+
+/*
+ * @brief	PCI device of a test layout
+ */
+typedef struct test_dev {
+	test_dev_type_t type;
+	unsigned bus;
+	unsigned dev;
+	/* PCIe generation, 1-6 */
+	int gen;
+	/* PCIe link width */
+	int width;
+} test_dev_t;
+
+/*
+ * @brief	PCIe switch of a test layout
+ */
+typedef struct test_switch {
+	/* Bus of the switch upstream port. If zero, devices are
+	 * attached to root ports directly. */
+	unsigned bus;
+	int num_devs;
+	test_dev_t devs[MAX_SWITCH_DEVS];
+} test_switch_t;
+
+/*
+ * @brief	Test layout
+ */
+typedef struct test_layout {
+	char name[32];
+	/* PCI device IDs of accelerators and NICs */
+	unsigned accel_device;
+	unsigned nic_device;
+	int num_sockets;
+	int num_switches[MAX_SOCKETS];
+	test_switch_t switches[MAX_SOCKETS][MAX_SWITCHES];
+} test_layout_t;
+
+#define ACC(bus, dev, gen, width) { TEST_ACCEL, bus, dev, gen, width }
+#define NIC(bus, dev, gen, width) { TEST_NIC, bus, dev, gen, width }
+
+/* Layouts modeled after the platforms in topology/ */
+static const test_layout_t platform_layouts[] = {
+	{
+		.name = "p4d-24xl",
+		.accel_device = 0x20b0,
+		.nic_device = 0xefa0,
+		.num_sockets = 2,
+		.num_switches = { 2, 2 },
+		.switches = {
+			{
+				{ 0x08, 3, { ACC(0x10, 0x1c, 3, 16), ACC(0x10, 0x1d, 3, 16), NIC(0x10, 0x1b, 3, 16) } },
+				{ 0x18, 3, { ACC(0x20, 0x1c, 3, 16), ACC(0x20, 0x1d, 3, 16), NIC(0x20, 0x1b, 3, 16) } },
+			},
+			{
+				{ 0x88, 3, { ACC(0x90, 0x1c, 3, 16), ACC(0x90, 0x1d, 3, 16), NIC(0x90, 0x1b, 3, 16) } },
+				{ 0x98, 3, { ACC(0xa0, 0x1c, 3, 16), ACC(0xa0, 0x1d, 3, 16), NIC(0xa0, 0x1b, 3, 16) } },
+			},
+		},
+	},
+	{
+		.name = "p4de-24xl",
+		.accel_device = 0x20b2,
+		.nic_device = 0xefa0,
+		.num_sockets = 2,
+		.num_switches = { 2, 2 },
+		.switches = {
+			{
+				{ 0x08, 3, { ACC(0x10, 0x1c, 3, 16), ACC(0x10, 0x1d, 3, 16), NIC(0x10, 0x1b, 3, 16) } },
+				{ 0x18, 3, { ACC(0x20, 0x1c, 3, 16), ACC(0x20, 0x1d, 3, 16), NIC(0x20, 0x1b, 3, 16) } },
+			},
+			{
+				{ 0x88, 3, { ACC(0x90, 0x1c, 3, 16), ACC(0x90, 0x1d, 3, 16), NIC(0x90, 0x1b, 3, 16) } },
+				{ 0x98, 3, { ACC(0xa0, 0x1c, 3, 16), ACC(0xa0, 0x1d, 3, 16), NIC(0xa0, 0x1b, 3, 16) } },
+			},
+		},
+	},
+	{
+		.name = "p5.48xl",
+		.accel_device = 0x2330,
+		.nic_device = 0xefa1,
+		.num_sockets = 2,
+		.num_switches = { 4, 4 },
+		.switches = {
+			{
+				{ 0x45, 5, { NIC(0x4f, 0, 5, 16), NIC(0x50, 0, 5, 16), NIC(0x51, 0, 5, 16), NIC(0x52, 0, 5, 16), ACC(0x53, 0, 5, 16) } },
+				{ 0x56, 5, { NIC(0x60, 0, 5, 16), NIC(0x61, 0, 5, 16), NIC(0x62, 0, 5, 16), NIC(0x63, 0, 5, 16), ACC(0x64, 0, 5, 16) } },
+				{ 0x67, 5, { NIC(0x71, 0, 5, 16), NIC(0x72, 0, 5, 16), NIC(0x73, 0, 5, 16), NIC(0x74, 0, 5, 16), ACC(0x75, 0, 5, 16) } },
+				{ 0x78, 5, { NIC(0x82, 0, 5, 16), NIC(0x83, 0, 5, 16), NIC(0x84, 0, 5, 16), NIC(0x85, 0, 5, 16), ACC(0x86, 0, 5, 16) } },
+			},
+			{
+				{ 0x89, 5, { NIC(0x93, 0, 5, 16), NIC(0x94, 0, 5, 16), NIC(0x95, 0, 5, 16), NIC(0x96, 0, 5, 16), ACC(0x97, 0, 5, 16) } },
+				{ 0x9a, 5, { NIC(0xa4, 0, 5, 16), NIC(0xa5, 0, 5, 16), NIC(0xa6, 0, 5, 16), NIC(0xa7, 0, 5, 16), ACC(0xa8, 0, 5, 16) } },
+				{ 0xab, 5, { NIC(0xb5, 0, 5, 16), NIC(0xb6, 0, 5, 16), NIC(0xb7, 0, 5, 16), NIC(0xb8, 0, 5, 16), ACC(0xb9, 0, 5, 16) } },
+				{ 0xbc, 5, { NIC(0xc6, 0, 5, 16), NIC(0xc7, 0, 5, 16), NIC(0xc8, 0, 5, 16), NIC(0xc9, 0, 5, 16), ACC(0xca, 0, 5, 16) } },
+			},
+		},
+	},
+	{
+		.name = "g5.48xl",
+		.accel_device = 0x2237,
+		.nic_device = 0xefa0,
+		.num_sockets = 2,
+		.num_switches = { 1, 1 },
+		.switches = {
+			{
+				{ 0, 5, { ACC(0x00, 0x16, 4, 16), ACC(0x00, 0x17, 4, 16), ACC(0x00, 0x18, 4, 16), ACC(0x00, 0x19, 4, 16), NIC(0x00, 0x1e, 3, 16) } },
+			},
+			{
+				{ 0, 4, { ACC(0x00, 0x1a, 4, 16), ACC(0x00, 0x1b, 4, 16), ACC(0x00, 0x1c, 4, 16), ACC(0x00, 0x1d, 4, 16) } },
+			},
+		},
+	},
+};
+
+/* Link speed strings as reported by sysfs, indexed by PCIe generation - 1 */
+static const char *sysfs_link_speed[] = {
+	"2.5 GT/s PCIe", "5.0 GT/s PCIe", "8.0 GT/s PCIe",
+	"16.0 GT/s PCIe", "32.0 GT/s PCIe", "64.0 GT/s PCIe"
+};
+
+/* Bandwidth of a PCIe lane in GB/s, indexed by PCIe generation - 1 */
+static const double lane_bw[] = { 0.25, 0.5, 0.984615, 1.969231, 3.938462, 7.876923 };
+
+/*
+ * @brief	State of xorshift pseudo random number generator
+ *
+ * A generator of its own keeps randomized layouts identical across
+ * C libraries, which is required to compare against golden files.
+ */
+static uint32_t rng_state;
+
+static uint32_t rng_next(void)
+{
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state;
+}
+
+static int rng_range(int min, int max)
+{
+	return min + (int)(rng_next() % (uint32_t)(max - min + 1));
+}
+
+/*
+ * @brief	Generate randomized layout
+ *
+ * Every socket is guaranteed to host at least one accelerator and the
+ * layout is guaranteed to host at least one NIC. Layouts are
+ * restricted to those where every NIC can be assigned to an
+ * accelerator.
+ */
+static void generate_random_layout(uint32_t seed, test_layout_t *layout)
+{
+	unsigned bus = 0x10;
+
+	memset(layout, 0, sizeof(*layout));
+	rng_state = seed ? seed : 1;
+
+	snprintf(layout->name, sizeof(layout->name), "random-%u", seed);
+	layout->accel_device = 0x20b0;
+	layout->nic_device = 0xefa1;
+	layout->num_sockets = rng_range(1, MAX_SOCKETS);
+
+	for (int socket = 0; socket < layout->num_sockets; ++socket) {
+		int num_accels = 0;
+
+		layout->num_switches[socket] = rng_range(1, 3);
+		for (int sw = 0; sw < layout->num_switches[socket]; ++sw) {
+			test_switch_t *s = &layout->switches[socket][sw];
+			int switch_accels = rng_range(0, 2);
+			int switch_nics = rng_range(0, 3);
+
+			s->bus = bus;
+			for (int i = 0; i < switch_accels + switch_nics; ++i) {
+				test_dev_t *dev = &s->devs[s->num_devs++];
+				dev->type = (i < switch_accels) ? TEST_ACCEL : TEST_NIC;
+				dev->bus = bus + 2 + i;
+				dev->gen = (dev->type == TEST_ACCEL) ? rng_range(3, 4) : rng_range(3, 5);
+				dev->width = (dev->type == TEST_ACCEL) ? 16 : 8 << rng_range(0, 1);
+			}
+			num_accels += switch_accels;
+			bus += 0x10;
+		}
+
+		/* Add accelerator to first switch of socket */
+		if (num_accels == 0) {
+			test_switch_t *s = &layout->switches[socket][0];
+			test_dev_t *dev = &s->devs[s->num_devs];
+			*dev = (test_dev_t)ACC(s->bus + 2 + s->num_devs, 0, 4, 16);
+			s->num_devs++;
+		}
+
+		/* NICs of switches without accelerator are lifted up to
+		 * the host bridge. Add a switch with an accelerator
+		 * only, such that the NICs can be grouped there. */
+		bool has_nic_only = false;
+		bool has_accel_only = false;
+		for (int sw = 0; sw < layout->num_switches[socket]; ++sw) {
+			test_switch_t *s = &layout->switches[socket][sw];
+			int switch_accels = 0;
+			for (int i = 0; i < s->num_devs; ++i) {
+				switch_accels += (s->devs[i].type == TEST_ACCEL);
+			}
+			has_nic_only |= switch_accels == 0 && s->num_devs > 0;
+			has_accel_only |= switch_accels > 0 && switch_accels == s->num_devs;
+		}
+		if (has_nic_only && !has_accel_only) {
+			test_switch_t *s = &layout->switches[socket][layout->num_switches[socket]++];
+			s->bus = bus;
+			s->num_devs = 1;
+			s->devs[0] = (test_dev_t)ACC(bus + 2, 0, 4, 16);
+			bus += 0x10;
+		}
+	}
+
+	/* Add NIC to first switch of first socket */
+	for (int socket = 0; socket < layout->num_sockets; ++socket) {
+		for (int sw = 0; sw < layout->num_switches[socket]; ++sw) {
+			test_switch_t *s = &layout->switches[socket][sw];
+			for (int i = 0; i < s->num_devs; ++i) {
+				if (s->devs[i].type == TEST_NIC) return;
+			}
+		}
+	}
+	test_switch_t *s = &layout->switches[0][0];
+	test_dev_t *dev = &s->devs[s->num_devs];
+	*dev = (test_dev_t)NIC(s->bus + 2 + s->num_devs, 0, 4, 16);
+	s->num_devs++;
+}
+
+/*
+ * @brief	Write link speed and width of a PCI device to fake sysfs tree
+ */
+static int write_sysfs_dev(const char *root, unsigned bus, unsigned dev, int gen, int width)
+{
+	char path[256];
+	FILE *file;
+
+	snprintf(path, sizeof(path), "%s/0000:%02x:%02x.0", root, bus, dev);
+	if (mkdir(path, 0700) != 0 && errno != EEXIST) {
+		NCCL_OFI_WARN("Failed to create directory %s: %s", path, strerror(errno));
+		return -errno;
+	}
+
+	snprintf(path, sizeof(path), "%s/0000:%02x:%02x.0/max_link_speed", root, bus, dev);
+	if (!(file = fopen(path, "w"))) return -errno;
+	fprintf(file, "%s\n", sysfs_link_speed[gen - 1]);
+	fclose(file);
+
+	snprintf(path, sizeof(path), "%s/0000:%02x:%02x.0/max_link_width", root, bus, dev);
+	if (!(file = fopen(path, "w"))) return -errno;
+	fprintf(file, "%d\n", width);
+	fclose(file);
+
+	return 0;
+}
+
+/*
+ * @brief	Write hwloc XML bridge opening tag
+ */
+static void write_xml_bridge(FILE *xml, int depth, unsigned bus, unsigned dev,
+			     unsigned first_bus, unsigned last_bus, int gen, int width)
+{
+	fprintf(xml,
+		"<object type=\"Bridge\" bridge_type=\"1-1\" depth=\"%d\" bridge_pci=\"0000:[%02x-%02x]\" "
+		"pci_busid=\"0000:%02x:%02x.0\" pci_type=\"0604 [1000:c010] [0000:0000] 00\" "
+		"pci_link_speed=\"%f\">\n",
+		depth, first_bus, last_bus, bus, dev, lane_bw[gen - 1] * width);
+}
+
+/*
+ * @brief	Write hwloc XML of PCI device
+ */
+static void write_xml_dev(FILE *xml, const test_layout_t *layout, const test_dev_t *dev)
+{
+	char pci_type[64];
+
+	if (dev->type == TEST_NIC) {
+		snprintf(pci_type, sizeof(pci_type), "0200 [1d0f:%04x] [0000:0000] 00", layout->nic_device);
+	} else {
+#if HAVE_CUDA
+		snprintf(pci_type, sizeof(pci_type), "0302 [10de:%04x] [10de:0000] a1", layout->accel_device);
+#else
+		snprintf(pci_type, sizeof(pci_type), "0880 [1d0f:7064] [0000:0000] 00");
+#endif
+	}
+
+	fprintf(xml,
+		"<object type=\"PCIDev\" pci_busid=\"0000:%02x:%02x.0\" pci_type=\"%s\" pci_link_speed=\"%f\"/>\n",
+		dev->bus, dev->dev, pci_type, lane_bw[dev->gen - 1] * dev->width);
+}
+
+/*
+ * @brief	Generate hwloc XML topology, fake sysfs tree, and NIC PCI
+ *		addresses of a layout
+ *
+ * Switches are represented by an upstream port below a root port,
+ * and one downstream port per device. Without switch, each device
+ * is attached to a root port of its own.
+ *
+ * @return	0, on success
+ *		non-zero, on error
+ */
+static int generate_layout(const test_layout_t *layout, const char *sysfs_root,
+			   char **xml_buf, struct fi_pci_attr *nics, int *num_nics)
+{
+	int ret = 0;
+	size_t xml_len = 0;
+	unsigned root_port = 1;
+	FILE *xml = open_memstream(xml_buf, &xml_len);
+	if (!xml) {
+		NCCL_OFI_WARN("Failed to open memory stream");
+		return -errno;
+	}
+
+	*num_nics = 0;
+	fprintf(xml,
+		"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<!DOCTYPE topology SYSTEM \"hwloc2.dtd\">\n"
+		"<topology version=\"2.0\">\n"
+		"<object type=\"Machine\" os_index=\"0\" cpuset=\"0x%x\" complete_cpuset=\"0x%x\" "
+		"allowed_cpuset=\"0x%x\" nodeset=\"0x%x\" complete_nodeset=\"0x%x\" allowed_nodeset=\"0x%x\">\n",
+		(1 << layout->num_sockets) - 1, (1 << layout->num_sockets) - 1,
+		(1 << layout->num_sockets) - 1, (1 << layout->num_sockets) - 1,
+		(1 << layout->num_sockets) - 1, (1 << layout->num_sockets) - 1);
+
+	for (int socket = 0; socket < layout->num_sockets; ++socket) {
+		unsigned set = 1 << socket;
+		fprintf(xml,
+			"<object type=\"Package\" os_index=\"%d\" cpuset=\"0x%x\" complete_cpuset=\"0x%x\" "
+			"nodeset=\"0x%x\" complete_nodeset=\"0x%x\">\n"
+			"<object type=\"NUMANode\" os_index=\"%d\" cpuset=\"0x%x\" complete_cpuset=\"0x%x\" "
+			"nodeset=\"0x%x\" complete_nodeset=\"0x%x\" local_memory=\"1000000\"/>\n"
+			"<object type=\"Core\" os_index=\"%d\" cpuset=\"0x%x\" complete_cpuset=\"0x%x\" "
+			"nodeset=\"0x%x\" complete_nodeset=\"0x%x\">\n"
+			"<object type=\"PU\" os_index=\"%d\" cpuset=\"0x%x\" complete_cpuset=\"0x%x\" "
+			"nodeset=\"0x%x\" complete_nodeset=\"0x%x\"/>\n"
+			"</object>\n"
+			"<object type=\"Bridge\" bridge_type=\"0-1\" depth=\"0\" bridge_pci=\"0000:[00-ff]\">\n",
+			socket, set, set, set, set,
+			socket, set, set, set, set,
+			socket, set, set, set, set,
+			socket, set, set, set, set);
+
+		for (int sw = 0; sw < layout->num_switches[socket]; ++sw) {
+			const test_switch_t *s = &layout->switches[socket][sw];
+			int max_gen = 1;
+			int max_width = 1;
+
+			for (int i = 0; i < s->num_devs; ++i) {
+				max_gen = NCCL_OFI_MAX(max_gen, s->devs[i].gen);
+				max_width = NCCL_OFI_MAX(max_width, s->devs[i].width);
+			}
+
+			if (s->bus) {
+				/* Root port and switch upstream port */
+				write_xml_bridge(xml, 1, 0, root_port, s->bus, s->bus + 0xf, max_gen, max_width);
+				write_xml_bridge(xml, 2, s->bus, 0, s->bus + 1, s->bus + 0xf, max_gen, max_width);
+				if ((ret = write_sysfs_dev(sysfs_root, 0, root_port, max_gen, max_width)) ||
+				    (ret = write_sysfs_dev(sysfs_root, s->bus, 0, max_gen, max_width))) {
+					goto exit;
+				}
+				++root_port;
+			}
+
+			for (int i = 0; i < s->num_devs; ++i) {
+				const test_dev_t *dev = &s->devs[i];
+
+				/* Switch downstream port or root port */
+				if (s->bus) {
+					write_xml_bridge(xml, 3, s->bus + 1, i, dev->bus, dev->bus,
+							 dev->gen, dev->width);
+					ret = write_sysfs_dev(sysfs_root, s->bus + 1, i, dev->gen, dev->width);
+				} else {
+					write_xml_bridge(xml, 1, 0, root_port, dev->bus, dev->bus,
+							 dev->gen, dev->width);
+					ret = write_sysfs_dev(sysfs_root, 0, root_port, dev->gen, dev->width);
+					++root_port;
+				}
+				if (ret != 0 ||
+				    (ret = write_sysfs_dev(sysfs_root, dev->bus, dev->dev, dev->gen, dev->width))) {
+					goto exit;
+				}
+
+				write_xml_dev(xml, layout, dev);
+				fprintf(xml, "</object>\n");
+
+				if (dev->type == TEST_NIC) {
+					nics[*num_nics] = (struct fi_pci_attr){
+						.domain_id = 0,
+						.bus_id = dev->bus,
+						.device_id = dev->dev,
+						.function_id = 0,
+					};
+					++(*num_nics);
+				}
+			}
+
+			if (s->bus) {
+				fprintf(xml, "</object>\n</object>\n");
+			}
+		}
+
+		/* Close host bridge and package */
+		fprintf(xml, "</object>\n</object>\n");
+	}
+
+	fprintf(xml, "</object>\n</topology>\n");
+
+ exit:
+	fclose(xml);
+	return ret;
+}
+
+static int remove_entry(const char *path, const struct stat *sb, int type, struct FTW *ftw)
+{
+	return remove(path);
+}
+
+/*
+ * @brief	Group NICs of layout and write NCCL topology
+ *
+ * Besides producing the output, verify that every NIC is member of
+ * exactly one group and that the maximum group size is tracked.
+ *
+ * @param	output
+ *		Output string, to be freed by caller
+ * @return	0, on success
+ *		non-zero, on error
+ */
+static int run_layout(const test_layout_t *layout, char **output)
+{
+	int ret = 0;
+	char sysfs_root[] = "/tmp/nccl_ofi_topo_golden.XXXXXX";
+	char *xml = NULL;
+	struct fi_pci_attr nics[MAX_NICS];
+	int num_nics = 0;
+	int nic_seen[MAX_NICS] = { 0 };
+	struct fi_info *info_list = NULL;
+	nccl_ofi_topo_t *topo = NULL;
+	nccl_ofi_topo_data_iterator_t iter;
+	struct fi_info *group;
+	int num_lists = 0;
+	int num_groups = 0;
+	int max_group_size = 0;
+	size_t output_len = 0;
+	FILE *out = NULL;
+
+	*output = NULL;
+
+	if (!mkdtemp(sysfs_root)) {
+		NCCL_OFI_WARN("Failed to create directory: %s", strerror(errno));
+		return 1;
+	}
+
+	if ((ret = generate_layout(layout, sysfs_root, &xml, nics, &num_nics))) {
+		NCCL_OFI_WARN("%s: Failed to generate layout", layout->name);
+		goto exit;
+	}
+
+	info_list = test_create_info_list(nics, num_nics);
+	if (!info_list) {
+		ret = 1;
+		goto exit;
+	}
+
+	nccl_ofi_topo_set_pci_sysfs_path(sysfs_root);
+
+	topo = nccl_ofi_topo_create_from_xml(info_list, xml);
+	if (!topo) {
+		NCCL_OFI_WARN("%s: Failed to create topology", layout->name);
+		ret = 1;
+		goto exit;
+	}
+
+	if ((ret = nccl_ofi_topo_group(topo))) {
+		NCCL_OFI_WARN("%s: Failed to group NICs", layout->name);
+		goto exit;
+	}
+
+	out = open_memstream(output, &output_len);
+	if (!out) {
+		ret = 1;
+		goto exit;
+	}
+
+	nccl_ofi_topo_set_to_begin(topo, &iter);
+	while ((group = nccl_ofi_topo_next_info_list(&iter))) {
+		int group_size = 0;
+
+		fprintf(out, "NIC group %d:", num_groups);
+		for (struct fi_info *info = group; info; info = info->next) {
+			struct fi_pci_attr *pci = &info->nic->bus_attr->attr.pci;
+			fprintf(out, " %04x:%02x:%02x.%01x",
+				pci->domain_id, pci->bus_id, pci->device_id, pci->function_id);
+
+			for (int i = 0; i < num_nics; ++i) {
+				if (nics[i].bus_id == pci->bus_id && nics[i].device_id == pci->device_id) {
+					nic_seen[i]++;
+				}
+			}
+			++group_size;
+		}
+		fprintf(out, "\n");
+
+		max_group_size = NCCL_OFI_MAX(max_group_size, group_size);
+		++num_groups;
+	}
+
+	if ((ret = nccl_ofi_topo_write(topo, out))) {
+		NCCL_OFI_WARN("%s: Failed to write NCCL topology", layout->name);
+		goto exit;
+	}
+	fprintf(out, "\n");
+
+	/* Verify invariants */
+	if ((ret = nccl_ofi_topo_num_info_lists(topo, &num_lists)) || num_lists != num_groups) {
+		NCCL_OFI_WARN("%s: Expected %d NIC groups, but got %d",
+			      layout->name, num_groups, num_lists);
+		ret = 1;
+	}
+	for (int i = 0; i < num_nics; ++i) {
+		if (nic_seen[i] != 1) {
+			NCCL_OFI_WARN("%s: NIC 0000:%02x:%02x.0 is member of %d groups",
+				      layout->name, nics[i].bus_id, nics[i].device_id, nic_seen[i]);
+			ret = 1;
+		}
+	}
+	if (max_group_size != topo->max_group_size) {
+		NCCL_OFI_WARN("%s: Expected maximum group size %d, but got %d",
+			      layout->name, max_group_size, topo->max_group_size);
+		ret = 1;
+	}
+
+ exit:
+	if (out) fclose(out);
+	if (ret) {
+		free(*output);
+		*output = NULL;
+	}
+	nccl_ofi_topo_set_pci_sysfs_path(NULL);
+	nccl_ofi_topo_free(topo);
+	fi_freeinfo(info_list);
+	free(xml);
+	nftw(sysfs_root, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+	return ret;
+}
+
+/*
+ * @brief	Compare output of layout against golden file, or update
+ *		golden file if requested
+ */
+static int check_golden(const test_layout_t *layout, const char *output)
+{
+	char path[256];
+	char *golden = NULL;
+	size_t golden_len = 0;
+	FILE *file;
+	int ret = 0;
+
+	snprintf(path, sizeof(path), "%s/%s.golden", TOPO_GOLDEN_DIR, layout->name);
+
+	if (getenv("TOPO_GOLDEN_UPDATE")) {
+		if (!(file = fopen(path, "w"))) {
+			NCCL_OFI_WARN("Failed to open %s: %s", path, strerror(errno));
+			return 1;
+		}
+		fputs(output, file);
+		fclose(file);
+		return 0;
+	}
+
+	if (!(file = fopen(path, "r"))) {
+		NCCL_OFI_WARN("Failed to open %s: %s", path, strerror(errno));
+		return 1;
+	}
+	if (getdelim(&golden, &golden_len, '\0', file) < 0) {
+		NCCL_OFI_WARN("Failed to read %s", path);
+		ret = 1;
+	} else if (strcmp(golden, output) != 0) {
+		NCCL_OFI_WARN("%s: Output does not match golden file %s. Output:\n%s",
+			      layout->name, path, output);
+		ret = 1;
+	}
+
+	free(golden);
+	fclose(file);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	int ret = 0;
+	char *output = NULL;
+	char *rerun = NULL;
+	test_layout_t layout;
+
+	ofi_log_function = logger;
+
+	for (size_t i = 0; i < sizeof(platform_layouts) / sizeof(platform_layouts[0]); ++i) {
+		if (run_layout(&platform_layouts[i], &output) || check_golden(&platform_layouts[i], output)) {
+			ret = 1;
+		}
+		free(output);
+	}
+
+	for (uint32_t seed = 1; seed <= NUM_RANDOM_LAYOUTS; ++seed) {
+		generate_random_layout(seed, &layout);
+		if (run_layout(&layout, &output)) {
+			ret = 1;
+			continue;
+		}
+
+		/* Output must be deterministic */
+		if (run_layout(&layout, &rerun) || strcmp(output, rerun) != 0) {
+			NCCL_OFI_WARN("%s: Output is not deterministic", layout.name);
+			ret = 1;
+		}
+
+		if (seed <= NUM_GOLDEN_RANDOM_LAYOUTS && check_golden(&layout, output)) {
+			ret = 1;
+		}
+
+		free(rerun);
+		free(output);
+	}
+
+	if (ret) {
+		return ret;
+	}
+
+	printf("Test completed successfully!\n");
+
+	return 0;
+}
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <rdma/fabric.h>
+
+#include "test-common.h"
+#include "test-topo.h"
+#include "nccl_ofi_topo.h"
+
+#if HAVE_CUDA
+#define ACCEL_PCI_TYPE "0302 [10de:20b0] [10de:134f] a1"
+#else
+#define ACCEL_PCI_TYPE "0880 [1d0f:7064] [0000:0000] 00"
+#endif
+#define NIC_PCI_TYPE "0200 [1d0f:efa1] [0000:0000] 00"
+#define SWITCH_PCI_TYPE "0604 [1000:c010] [0000:0000] 00"
+
+/* Link speeds in GB/s */
+#define FAST "31.5"
+#define SLOW "7.9"
+
+#define MACHINE_BEGIN \
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" \
+	"<!DOCTYPE topology SYSTEM \"hwloc2.dtd\">\n" \
+	"<topology version=\"2.0\">\n" \
+	"<object type=\"Machine\" os_index=\"0\" cpuset=\"0x3\" complete_cpuset=\"0x3\" " \
+	"allowed_cpuset=\"0x3\" nodeset=\"0x3\" complete_nodeset=\"0x3\" allowed_nodeset=\"0x3\">\n"
+#define MACHINE_END "</object>\n</topology>\n"
+#define PACKAGE_BEGIN(idx, set) \
+	"<object type=\"Package\" os_index=\"" #idx "\" cpuset=\"" set "\" complete_cpuset=\"" set "\" " \
+	"nodeset=\"" set "\" complete_nodeset=\"" set "\">\n" \
+	"<object type=\"NUMANode\" os_index=\"" #idx "\" cpuset=\"" set "\" complete_cpuset=\"" set "\" " \
+	"nodeset=\"" set "\" complete_nodeset=\"" set "\" local_memory=\"1000000\"/>\n" \
+	"<object type=\"Core\" os_index=\"" #idx "\" cpuset=\"" set "\" complete_cpuset=\"" set "\" " \
+	"nodeset=\"" set "\" complete_nodeset=\"" set "\">\n" \
+	"<object type=\"PU\" os_index=\"" #idx "\" cpuset=\"" set "\" complete_cpuset=\"" set "\" " \
+	"nodeset=\"" set "\" complete_nodeset=\"" set "\"/>\n" \
+	"</object>\n"
+#define HOSTBRIDGE_BEGIN(range) \
+	"<object type=\"Bridge\" bridge_type=\"0-1\" depth=\"0\" bridge_pci=\"0000:[" range "]\">\n"
+#define SWITCH_BEGIN(bus, range) \
+	"<object type=\"Bridge\" bridge_type=\"1-1\" depth=\"1\" bridge_pci=\"0000:[" range "]\" " \
+	"pci_busid=\"0000:" bus ":00.0\" pci_type=\"" SWITCH_PCI_TYPE "\" pci_link_speed=\"" FAST "\">\n"
+#define ACCEL(bus) \
+	"<object type=\"PCIDev\" pci_busid=\"0000:" bus ":00.0\" pci_type=\"" ACCEL_PCI_TYPE "\" " \
+	"pci_link_speed=\"" FAST "\"/>\n"
+#define NIC(bus, speed) \
+	"<object type=\"PCIDev\" pci_busid=\"0000:" bus ":00.0\" pci_type=\"" NIC_PCI_TYPE "\" " \
+	"pci_link_speed=\"" speed "\"/>\n"
+#define END "</object>\n"
+
+/*
+ * NICs of different bandwidth behind separate PCIe switches, shared
+ * by two accelerators behind two other PCIe switches. Each
+ * accelerator is expected to get one fast and one slow NIC.
+ */
+static const char *topo_bw_imbalance =
+	MACHINE_BEGIN
+	PACKAGE_BEGIN(0, "0x1")
+	HOSTBRIDGE_BEGIN("10-3f")
+	SWITCH_BEGIN("10", "11-11") ACCEL("11") END
+	SWITCH_BEGIN("20", "21-21") ACCEL("21") END
+	SWITCH_BEGIN("30", "31-32") NIC("31", FAST) NIC("32", FAST) END
+	SWITCH_BEGIN("38", "39-3a") NIC("39", SLOW) NIC("3a", SLOW) END
+	END
+	END
+	PACKAGE_BEGIN(1, "0x2")
+	END
+	MACHINE_END;
+
+/*
+ * Each accelerator shares a PCIe switch with two NICs, but one switch
+ * hosts fast NICs and the other hosts slow NICs. Crossing the PCIe
+ * switch pays off to balance bandwidth.
+ */
+static const char *topo_cross_switch =
+	MACHINE_BEGIN
+	PACKAGE_BEGIN(0, "0x1")
+	HOSTBRIDGE_BEGIN("10-2f")
+	SWITCH_BEGIN("10", "11-13") ACCEL("11") NIC("12", FAST) NIC("13", FAST) END
+	SWITCH_BEGIN("20", "21-23") ACCEL("21") NIC("22", SLOW) NIC("23", SLOW) END
+	END
+	END
+	PACKAGE_BEGIN(1, "0x2")
+	END
+	MACHINE_END;
+
+/*
+ * Same as `topo_cross_switch`, but the switches are attached to
+ * different sockets. Crossing sockets does not pay off.
+ */
+static const char *topo_cross_socket =
+	MACHINE_BEGIN
+	PACKAGE_BEGIN(0, "0x1")
+	HOSTBRIDGE_BEGIN("10-1f")
+	SWITCH_BEGIN("10", "11-13") ACCEL("11") NIC("12", FAST) NIC("13", FAST) END
+	END
+	END
+	PACKAGE_BEGIN(1, "0x2")
+	HOSTBRIDGE_BEGIN("20-2f")
+	SWITCH_BEGIN("20", "21-23") ACCEL("21") NIC("22", SLOW) NIC("23", SLOW) END
+	END
+	END
+	MACHINE_END;
+
+/*
+ * Two accelerators and one NIC per PCIe switch. Each NIC is expected
+ * to stay with the accelerators of its switch.
+ */
+static const char *topo_symmetric =
+	MACHINE_BEGIN
+	PACKAGE_BEGIN(0, "0x1")
+	HOSTBRIDGE_BEGIN("10-2f")
+	SWITCH_BEGIN("10", "11-13") ACCEL("11") ACCEL("12") NIC("13", FAST) END
+	SWITCH_BEGIN("20", "21-23") ACCEL("21") ACCEL("22") NIC("23", FAST) END
+	END
+	END
+	PACKAGE_BEGIN(1, "0x2")
+	END
+	MACHINE_END;
+
+/*
+ * @brief	Group NICs of topology and compare groups against expected groups
+ *
+ * @param	expected
+ *		Expected groups. Each group is a string of comma-separated PCI
+ *		bus numbers, leader first.
+ */
+static int test_grouping(const char *name, const char *xml,
+			 const unsigned *buses, int num_buses,
+			 const char **expected, int num_expected)
+{
+	int ret = 0;
+	int num_groups = 0;
+	int num_found = 0;
+	nccl_ofi_topo_t *topo = NULL;
+	nccl_ofi_topo_data_iterator_t iter;
+	struct fi_info *info_list = NULL;
+	struct fi_info *group;
+
+	struct fi_pci_attr pci[num_buses];
+	for (int i = 0; i < num_buses; ++i) {
+		pci[i] = (struct fi_pci_attr){ .bus_id = buses[i] };
+	}
+
+	info_list = test_create_info_list(pci, num_buses);
+	if (!info_list) {
+		return 1;
+	}
+
+	topo = nccl_ofi_topo_create_from_xml(info_list, xml);
+	if (!topo) {
+		NCCL_OFI_WARN("%s: Failed to create topology", name);
+		ret = 1;
+		goto exit;
+	}
+
+	if (nccl_ofi_topo_group(topo) != 0) {
+		NCCL_OFI_WARN("%s: Failed to group NICs", name);
+		ret = 1;
+		goto exit;
+	}
+
+	nccl_ofi_topo_set_to_begin(topo, &iter);
+	while ((group = nccl_ofi_topo_next_info_list(&iter))) {
+		char str[64] = "";
+		size_t len = 0;
+
+		for (struct fi_info *info = group; info; info = info->next) {
+			len += snprintf(str + len, sizeof(str) - len, "%s%02x",
+					len ? "," : "", info->nic->bus_attr->attr.pci.bus_id);
+		}
+
+		bool found = false;
+		for (int i = 0; i < num_expected; ++i) {
+			found = found || strcmp(str, expected[i]) == 0;
+		}
+		if (!found) {
+			NCCL_OFI_WARN("%s: Unexpected NIC group %s", name, str);
+			ret = 1;
+		} else {
+			++num_found;
+		}
+		++num_groups;
+	}
+
+	if (num_groups != num_expected || num_found != num_expected) {
+		NCCL_OFI_WARN("%s: Expected %d NIC groups, but got %d",
+			      name, num_expected, num_groups);
+		ret = 1;
+	}
+
+ exit:
+	nccl_ofi_topo_free(topo);
+	fi_freeinfo(info_list);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	int ret = 0;
+	ofi_log_function = logger;
+
+	{
+		const unsigned buses[] = {0x31, 0x32, 0x39, 0x3a};
+		const char *expected[] = {"31,3a", "32,39"};
+		ret |= test_grouping("bw_imbalance", topo_bw_imbalance, buses, 4, expected, 2);
+	}
+	{
+		const unsigned buses[] = {0x12, 0x13, 0x22, 0x23};
+		const char *expected[] = {"12,23", "22,13"};
+		ret |= test_grouping("cross_switch", topo_cross_switch, buses, 4, expected, 2);
+	}
+	{
+		const unsigned buses[] = {0x12, 0x13, 0x22, 0x23};
+		const char *expected[] = {"13,12", "23,22"};
+		ret |= test_grouping("cross_socket", topo_cross_socket, buses, 4, expected, 2);
+	}
+	{
+		const unsigned buses[] = {0x13, 0x23};
+		const char *expected[] = {"13", "23"};
+		ret |= test_grouping("symmetric", topo_symmetric, buses, 2, expected, 2);
+	}
+
+	if (ret) {
+		return ret;
+	}
+
+	printf("Test completed successfully!\n");
+
+	return 0;
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "test-common.h"
+#include "nccl_ofi_tracer.h"
+
+#define BUFFER_EVENTS	(64)
+#define NUM_EVENTS	(200)
+#define THREAD_DEV	(7)
+
+static void *record_events(void *arg)
+{
+	for (uint32_t i = 0; i < NUM_EVENTS; i++) {
+		NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_RECV_SEGMENT_COMPLETE, THREAD_DEV, 0,
+				       NULL, i, NULL, 1024);
+	}
+	return NULL;
+}
+
+static char path[64];
+
+/* Registered before the tracer, so that it runs after the tracer wrote
+ * the trace file at exit */
+static void remove_trace(void)
+{
+	unlink(path);
+}
+
+static int count_matches(const char *haystack, const char *needle)
+{
+	int count = 0;
+
+	for (const char *match = strstr(haystack, needle); match;
+	     match = strstr(match + 1, needle)) {
+		count++;
+	}
+	return count;
+}
+
+int main(int argc, char *argv[])
+{
+	int comm, send_a, send_b, recv;
+	nccl_ofi_tracer_event_t *events;
+	size_t num_events, thread_events = 0;
+	char buffer[BUFFER_EVENTS * 256];
+	pthread_t thread;
+	FILE *file;
+	size_t len;
+
+	ofi_log_function = logger;
+
+	snprintf(path, sizeof(path), "/tmp/nccl-ofi-tracer-test-%d.json", (int)getpid());
+	atexit(remove_trace);
+
+	setenv("OFI_NCCL_TRACE_FILE", "/tmp/nccl-ofi-tracer-test-%p.json", 1);
+	setenv("OFI_NCCL_TRACE_BUFFER_EVENTS", "50", 1);
+	if (nccl_ofi_tracer_init() != 0 || !nccl_ofi_tracer_enabled) {
+		NCCL_OFI_WARN("Tracer initialization failed");
+		return 1;
+	}
+
+	/* Two overlapping sends striped over two rails, and a receive */
+	NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_SEND, 0, -1, &comm, 1, &send_a, 4096);
+	NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_SEND, 0, -1, &comm, 2, &send_b, 4096);
+	NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_RECV, 0, -1, &recv, 5, &recv, 8192);
+	NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_SEND_CTRL_RECV, 0, 0, &comm, 1, NULL, 0);
+	for (int rail = 0; rail < 2; rail++) {
+		NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_SEND_WRITE_SEG_START, 0, rail, &comm, 1,
+				       &send_a, 2048);
+	}
+	NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_SEND_CTRL_RECV, 0, 0, &comm, 2, NULL, 0);
+	for (int rail = 0; rail < 2; rail++) {
+		NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_SEND_WRITE_SEG_START, 0, rail, &comm, 2,
+				       &send_b, 2048);
+	}
+	for (int rail = 0; rail < 2; rail++) {
+		NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_SEND_WRITE_SEG_COMPLETE, 0, rail, &comm, 1,
+				       &send_a, 0);
+		NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_SEND_WRITE_SEG_COMPLETE, 0, rail, &comm, 2,
+				       &send_b, 0);
+	}
+	NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_COMPLETE, -1, -1, NULL, 0, &send_a, 0);
+	NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_COMPLETE, -1, -1, NULL, 0, &send_b, 0);
+	NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_RECV_SEGMENT_COMPLETE, 0, 1, NULL, 0, &recv, 8192);
+	NCCL_OFI_TRACER_RECORD(NCCL_OFI_TRACER_COMPLETE, -1, -1, NULL, 0, &recv, 0);
+
+	if (nccl_ofi_tracer_flush() != 0) {
+		NCCL_OFI_WARN("Trace flush failed");
+		return 1;
+	}
+	file = fopen(path, "r");
+	if (!file) {
+		NCCL_OFI_WARN("Trace file %s not written", path);
+		return 1;
+	}
+	len = fread(buffer, 1, sizeof(buffer) - 1, file);
+	buffer[len] = '\0';
+	fclose(file);
+
+	if (count_matches(buffer, "\"name\":\"send\"") != 2 ||
+	    count_matches(buffer, "\"name\":\"recv\"") != 1 ||
+	    count_matches(buffer, "\"name\":\"write\"") != 4 ||
+	    count_matches(buffer, "\"name\":\"ctrl recv\"") != 2 ||
+	    count_matches(buffer, "\"name\":\"recv segment\"") != 1) {
+		NCCL_OFI_WARN("Unexpected events in trace:\n%s", buffer);
+		return 1;
+	}
+	/* Overlapping spans of a track are written to separate lanes */
+	if (!strstr(buffer, "\"name\":\"dev 0 rail 0\"") || !strstr(buffer, "\"name\":\"dev 0 rail 1 (1)\"") ||
+	    !strstr(buffer, "\"name\":\"dev 0 recv comm 5\"") || !strstr(buffer, " (1)\"") ||
+	    strstr(buffer, "rail 0 (2)")) {
+		NCCL_OFI_WARN("Unexpected tracks in trace:\n%s", buffer);
+		return 1;
+	}
+
+	/* A ring keeps the latest events of its thread */
+	if (pthread_create(&thread, NULL, record_events, NULL) != 0) {
+		NCCL_OFI_WARN("Thread creation failed");
+		return 1;
+	}
+	pthread_join(thread, NULL);
+	if (nccl_ofi_tracer_snapshot(&events, &num_events) != 0) {
+		NCCL_OFI_WARN("Trace snapshot failed");
+		return 1;
+	}
+	for (size_t i = 0; i < num_events; i++) {
+		if (i > 0 && events[i].ts < events[i - 1].ts) {
+			NCCL_OFI_WARN("Events not sorted by time");
+			return 1;
+		}
+		if (events[i].dev != THREAD_DEV) {
+			continue;
+		}
+		if (events[i].id < NUM_EVENTS - BUFFER_EVENTS) {
+			NCCL_OFI_WARN("Overwritten event %u in snapshot", events[i].id);
+			return 1;
+		}
+		thread_events++;
+	}
+	/* The buffer size is rounded up, and the oldest event may be
+	 * dropped as possibly overwritten */
+	if (thread_events < BUFFER_EVENTS - 1 || thread_events > BUFFER_EVENTS) {
+		NCCL_OFI_WARN("Snapshot has %zu events of the thread, expected %d",
+			      thread_events, BUFFER_EVENTS);
+		return 1;
+	}
+	free(events);
+
+	printf("Test completed successfully!\n");
+
+	return 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "test-common.h"
+#include "nccl_ofi_traffic.h"
+
+#define NUM_THREADS		(4)
+#define MSGS_PER_THREAD		(10000)
+
+static nccl_ofi_traffic_peer_t *shared_peer;
+
+static void *send_msgs(void *arg)
+{
+	for (int i = 0; i < MSGS_PER_THREAD; i++) {
+		nccl_ofi_traffic_record_tx(shared_peer, 100);
+	}
+	return NULL;
+}
+
+static char path[64];
+
+/* Registered before the traffic matrix, so that it runs after the
+ * matrix was written at exit */
+static void remove_matrix(void)
+{
+	unlink(path);
+}
+
+int main(int argc, char *argv[])
+{
+	nccl_ofi_traffic_row_t *row, *other_row;
+	nccl_ofi_traffic_peer_t *other_peer;
+	pthread_t threads[NUM_THREADS];
+	char buffer[4096];
+	char expected[256];
+	FILE *file;
+	size_t len;
+
+	ofi_log_function = logger;
+
+	snprintf(path, sizeof(path), "/tmp/nccl-ofi-traffic-test-%d.txt", (int)getpid());
+	atexit(remove_matrix);
+
+	/* No rows are allocated while the traffic matrix is disabled */
+	if (nccl_ofi_traffic_alloc(0, "disabled") != NULL) {
+		NCCL_OFI_WARN("Row allocated while the traffic matrix is disabled");
+		return 1;
+	}
+
+	setenv("OFI_NCCL_TRAFFIC_MATRIX_FILE", "/tmp/nccl-ofi-traffic-test-%p.txt", 1);
+	setenv("OMPI_COMM_WORLD_RANK", "3", 1);
+	if (nccl_ofi_traffic_init() != 0) {
+		NCCL_OFI_WARN("Traffic matrix initialization failed");
+		return 1;
+	}
+
+	row = nccl_ofi_traffic_alloc(0, "addr-0");
+	other_row = nccl_ofi_traffic_alloc(1, "addr-1");
+	if (!row || !other_row) {
+		NCCL_OFI_WARN("Row allocation failed");
+		return 1;
+	}
+
+	/* Communicators to the same peer share its entry */
+	shared_peer = nccl_ofi_traffic_get_peer(row, 5, "peer-5");
+	other_peer = nccl_ofi_traffic_get_peer(row, 7, "peer-7");
+	if (!shared_peer || !other_peer || shared_peer == other_peer ||
+	    nccl_ofi_traffic_get_peer(row, 5, "peer-5") != shared_peer) {
+		NCCL_OFI_WARN("Unexpected peers");
+		return 1;
+	}
+
+	for (int i = 0; i < NUM_THREADS; i++) {
+		if (pthread_create(&threads[i], NULL, send_msgs, NULL) != 0) {
+			NCCL_OFI_WARN("Thread creation failed");
+			return 1;
+		}
+	}
+	for (int i = 0; i < NUM_THREADS; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	nccl_ofi_traffic_record_rx(other_peer, 1 << 20);
+	nccl_ofi_traffic_record_rx(other_peer, 1 << 20);
+
+	if (nccl_ofi_traffic_write() != 0) {
+		NCCL_OFI_WARN("Traffic matrix write failed");
+		return 1;
+	}
+	file = fopen(path, "r");
+	if (!file) {
+		NCCL_OFI_WARN("Traffic matrix %s not written", path);
+		return 1;
+	}
+	len = fread(buffer, 1, sizeof(buffer) - 1, file);
+	buffer[len] = '\0';
+	fclose(file);
+
+	snprintf(expected, sizeof(expected),
+		 "peer addr=peer-5 fi_addr=5 tx_bytes=%d tx_msgs=%d rx_bytes=0 rx_msgs=0\n",
+		 NUM_THREADS * MSGS_PER_THREAD * 100, NUM_THREADS * MSGS_PER_THREAD);
+	if (strncmp(buffer, "# nccl-ofi traffic matrix version 1\nendpoint addr=addr-0 host=", 62) != 0 ||
+	    !strstr(buffer, " rank=3 dev=0\n") ||
+	    !strstr(buffer, expected) ||
+	    !strstr(buffer, "peer addr=peer-7 fi_addr=7 tx_bytes=0 tx_msgs=0 rx_bytes=2097152 rx_msgs=2\n") ||
+	    !strstr(buffer, "endpoint addr=addr-1 ") ||
+	    strstr(buffer, "disabled")) {
+		NCCL_OFI_WARN("Unexpected traffic matrix:\n%s", buffer);
+		return 1;
+	}
+
+	printf("Test completed successfully!\n");
+
+	return 0;
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "test-common.h"
+#include "nccl_ofi_tuner.h"
+
+extern const ncclTuner_v2_t ncclTunerPlugin_v2;
+
+/* Simulated ranks of a communicator */
+#define NUM_RANKS	(2)
+/* Calls of the size bucket */
+#define NUM_CALLS	(256)
+#define EXPLORE_PERIOD	4
+#define EXPLORE_COUNT	2
+/* Bound of explorations of the alternatives without recorded times */
+#define MAX_EXPLORED	((NCCL_OFI_TUNER_FEEDBACK_CHOICES - 1) * EXPLORE_COUNT * 4)
+
+#define SIZE		(1024 * 1024)
+
+#define STR_(x)		#x
+#define STR(x)		STR_(x)
+
+static bool same_choice(const struct nccl_ofi_tuner_decision *decision, int algo, int proto,
+			int channels)
+{
+	return decision->algo == algo && decision->proto == proto && decision->channels == channels;
+}
+
+/*
+ * Simulated time of a collective: the modeled cost, except for the
+ * fast choice, which is four times as fast as modeled.
+ */
+static double simulated_time(struct nccl_ofi_tuner_context *ctx,
+			     const struct nccl_ofi_tuner_decision *fast, int algo, int proto,
+			     int channels)
+{
+	double cost = ctx->model->compute_cost(&ctx->model_params, &ctx->dims, ncclFuncAllReduce,
+					       algo, proto, 1, channels, SIZE);
+
+	return same_choice(fast, algo, proto, channels) ? cost / 4 : cost;
+}
+
+/*
+ * Run calls on all ranks, recording the simulated times if requested,
+ * and check that all ranks choose the same. Returns the number of calls
+ * that explored a choice other than the modeled and the fast one.
+ */
+static int run_calls(void **contexts, const struct nccl_ofi_tuner_decision *modeled,
+		     const struct nccl_ofi_tuner_decision *fast, bool record,
+		     struct nccl_ofi_tuner_decision *last)
+{
+	int explored = 0;
+
+	for (int call = 0; call < NUM_CALLS; call++) {
+		int algo[NUM_RANKS], proto[NUM_RANKS], channels[NUM_RANKS];
+
+		for (int rank = 0; rank < NUM_RANKS; rank++) {
+			algo[rank] = NCCL_ALGO_UNDEF;
+			proto[rank] = NCCL_PROTO_UNDEF;
+			channels[rank] = 0;
+			ncclTunerPlugin_v2.getCollInfo(contexts[rank], ncclFuncAllReduce, SIZE, 0, 0, 1,
+						       &algo[rank], &proto[rank], &channels[rank]);
+			if (algo[rank] != algo[0] || proto[rank] != proto[0] ||
+			    channels[rank] != channels[0]) {
+				NCCL_OFI_WARN("Call %d: rank %d chose algo %d proto %d channels %d, rank 0 algo %d proto %d channels %d",
+					      call, rank, algo[rank], proto[rank], channels[rank],
+					      algo[0], proto[0], channels[0]);
+				return -1;
+			}
+		}
+
+		if (!same_choice(modeled, algo[0], proto[0], channels[0]) &&
+		    !same_choice(fast, algo[0], proto[0], channels[0])) {
+			explored++;
+		}
+
+		/* All ranks record the same time */
+		for (int rank = 0; record && rank < NUM_RANKS; rank++) {
+			double time = simulated_time(contexts[rank], fast, algo[0], proto[0], channels[0]);
+
+			if (nccl_ofi_tuner_record_feedback(contexts[rank], ncclFuncAllReduce, SIZE, 0,
+							   algo[0], proto[0], channels[0], time) != 0) {
+				NCCL_OFI_WARN("Unable to record feedback of call %d", call);
+				return -1;
+			}
+		}
+
+		last->algo = algo[0];
+		last->proto = proto[0];
+		last->channels = channels[0];
+	}
+
+	return explored;
+}
+
+int main(int argc, char *argv[])
+{
+	void *contexts[NUM_RANKS];
+	struct nccl_ofi_tuner_context *ctx;
+	struct nccl_ofi_tuner_decision choices[NCCL_OFI_TUNER_FEEDBACK_CHOICES];
+	double costs[NCCL_OFI_TUNER_FEEDBACK_CHOICES];
+	struct nccl_ofi_tuner_decision modeled, fast, last;
+	int num_choices, explored;
+	int ret = 0;
+
+	setenv("OFI_NCCL_TUNER_FEEDBACK", "1", 1);
+	setenv("OFI_NCCL_TUNER_FEEDBACK_EXPLORE_PERIOD", STR(EXPLORE_PERIOD), 1);
+	setenv("OFI_NCCL_TUNER_FEEDBACK_EXPLORE_COUNT", STR(EXPLORE_COUNT), 1);
+	setenv("OFI_NCCL_TUNER_FEEDBACK_MARGIN_PCT", "1000", 1);
+
+	for (int rank = 0; rank < NUM_RANKS; rank++) {
+		if (ncclTunerPlugin_v2.init(128, 16, logger, &contexts[rank]) != ncclSuccess) {
+			NCCL_OFI_WARN("Tuner initialization failed");
+			return 1;
+		}
+	}
+	ctx = contexts[0];
+
+	modeled = *nccl_ofi_tuner_lookup_decision(ctx, ncclFuncAllReduce, 0, 1, SIZE);
+	num_choices = nccl_ofi_tuner_rank_choices(ctx, ncclFuncAllReduce, 0, 1, SIZE, choices, costs,
+						  NCCL_OFI_TUNER_FEEDBACK_CHOICES);
+	if (num_choices < 2) {
+		NCCL_OFI_WARN("Expected alternatives, got %d choices", num_choices);
+		return 1;
+	}
+	fast = same_choice(&modeled, choices[0].algo, choices[0].proto, choices[0].channels)
+	       ? choices[1] : choices[0];
+
+	/* Choices not considered for the bucket and invalid times are rejected */
+	if (nccl_ofi_tuner_record_feedback(ctx, ncclFuncAllReduce, SIZE, 0, NCCL_ALGO_NVLS_TREE,
+					   NCCL_PROTO_SIMPLE, 1, 10.0) != -ENOENT ||
+	    nccl_ofi_tuner_record_feedback(ctx, ncclFuncAllReduce, SIZE, 0, modeled.algo,
+					   modeled.proto, modeled.channels, 0.0) != -EINVAL) {
+		NCCL_OFI_WARN("Invalid feedback accepted");
+		ret = 1;
+	}
+
+	/* Exploration is bounded without feedback, and the modeled choice is kept */
+	explored = run_calls(contexts, &modeled, &fast, false, &last);
+	if (explored < 0 || explored > MAX_EXPLORED) {
+		NCCL_OFI_WARN("Explored %d calls without feedback", explored);
+		ret = 1;
+	}
+	if (!same_choice(&modeled, last.algo, last.proto, last.channels)) {
+		NCCL_OFI_WARN("Choice changed without feedback");
+		ret = 1;
+	}
+
+	/* With feedback, the ranks of a new communicator move to the fast
+	 * choice together */
+	for (int rank = 0; rank < NUM_RANKS; rank++) {
+		ncclTunerPlugin_v2.destroy(contexts[rank]);
+		if (ncclTunerPlugin_v2.init(128, 16, logger, &contexts[rank]) != ncclSuccess) {
+			NCCL_OFI_WARN("Tuner initialization failed");
+			return 1;
+		}
+	}
+	explored = run_calls(contexts, &modeled, &fast, true, &last);
+	if (explored < 0) {
+		ret = 1;
+	}
+	if (!same_choice(&fast, last.algo, last.proto, last.channels)) {
+		NCCL_OFI_WARN("Fast choice algo %d proto %d channels %d not chosen, last algo %d proto %d channels %d",
+			      fast.algo, fast.proto, fast.channels, last.algo, last.proto, last.channels);
+		ret = 1;
+	}
+
+	for (int rank = 0; rank < NUM_RANKS; rank++) {
+		ncclTunerPlugin_v2.destroy(contexts[rank]);
+	}
+
+	if (ret) {
+		return ret;
+	}
+
+	printf("Test completed successfully!\n");
+
+	return 0;
+}
@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+/*
+ * Test of the offline tuner parameter fitting.
+ *
+ * The sample measurements in TUNER_FIT_DIR were generated from the
+ * Hockney model with known parameters and 1% noise. The fit must recover
+ * the parameters, write the parameter file in TUNER_FIT_DIR, and the
+ * tuner must load the same parameters from it.
+ *
+ * Set environment variable TUNER_FIT_UPDATE to regenerate the golden
+ * parameter file instead of comparing against it.
+ */
+
+#include "config.h"
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test-common.h"
+#include "nccl_ofi_tuner.h"
+#include "nccl_ofi_tuner_fit.h"
+
+#ifndef TUNER_FIT_DIR
+#define TUNER_FIT_DIR "tuner_fit"
+#endif
+
+/* Parameters from which the sample measurements were generated */
+#define TRUE_NET_LATENCY	(15.0)
+#define TRUE_NET_COMP_OVERHEAD	(4.0)
+#define TRUE_INTERNODE_BW	(10000.0)
+#define TRUE_CHANNEL_OVERHEAD	(0.3)
+
+static const float true_base_lat[][NCCL_NUM_PROTOCOLS] = {
+	[NCCL_ALGO_TREE] = { 2.0, 3.0, 6.0 },
+	[NCCL_ALGO_RING] = { 1.5, 2.5, 5.0 },
+};
+
+static int check_close(const char *name, double value, double expected, double tolerance)
+{
+	if (fabs(value - expected) > tolerance) {
+		NCCL_OFI_WARN("Fitted %s %f, expected %f +- %f", name, value, expected, tolerance);
+		return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * @brief	Check that fitted parameters are close to the true ones
+ */
+static int check_recovered(const nccl_ofi_tuner_fit_result_t *result)
+{
+	const struct nccl_ofi_tuner_model_params *params = &result->params;
+	int ret = 0;
+
+	for (int i = 0; i <= NCCL_OFI_TUNER_FIT_CHANNEL_OVERHEAD; i++) {
+		if (!result->fitted[i]) {
+			NCCL_OFI_WARN("Parameter %d not fitted", i);
+			ret = 1;
+		}
+	}
+
+	ret |= check_close("net_latency", params->net_lat, TRUE_NET_LATENCY, 1.0);
+	ret |= check_close("net_comp_overhead", params->net_comp_overhead, TRUE_NET_COMP_OVERHEAD, 1.0);
+	ret |= check_close("internode_bw", params->internode_bw, TRUE_INTERNODE_BW,
+			   0.01 * TRUE_INTERNODE_BW);
+	ret |= check_close("channel_overhead", params->channel_overhead, TRUE_CHANNEL_OVERHEAD, 0.3);
+	for (int algo = 0; algo < sizeof(true_base_lat) / sizeof(true_base_lat[0]); algo++) {
+		for (int proto = 0; proto < NCCL_NUM_PROTOCOLS; proto++) {
+			ret |= check_close(nccl_ofi_tuner_algo_names[algo], params->base_lat[algo][proto],
+					   true_base_lat[algo][proto], 2.0);
+		}
+	}
+
+	/* The samples have no other algorithm */
+	for (int i = NCCL_OFI_TUNER_FIT_BASE_LATENCY + NCCL_ALGO_COLLNET_DIRECT * NCCL_NUM_PROTOCOLS;
+	     i < NCCL_OFI_TUNER_FIT_MAX; i++) {
+		if (result->fitted[i]) {
+			NCCL_OFI_WARN("Parameter %d fitted without samples", i);
+			ret = 1;
+		}
+	}
+
+	if (result->max_rel_residual > 0.05) {
+		NCCL_OFI_WARN("Largest relative residual %f", result->max_rel_residual);
+		ret = 1;
+	}
+
+	return ret;
+}
+
+/*
+ * @brief	Compare parameter file against golden file, or update golden
+ *		file if requested
+ */
+static int check_golden(const char *output)
+{
+	const char *path = TUNER_FIT_DIR "/params.golden";
+	char *golden = NULL;
+	size_t golden_len = 0;
+	FILE *file;
+	int ret = 0;
+
+	if (getenv("TUNER_FIT_UPDATE")) {
+		if (!(file = fopen(path, "w"))) {
+			NCCL_OFI_WARN("Failed to open %s: %s", path, strerror(errno));
+			return 1;
+		}
+		fputs(output, file);
+		fclose(file);
+		return 0;
+	}
+
+	if (!(file = fopen(path, "r"))) {
+		NCCL_OFI_WARN("Failed to open %s: %s", path, strerror(errno));
+		return 1;
+	}
+	if (getdelim(&golden, &golden_len, '\0', file) < 0) {
+		NCCL_OFI_WARN("Failed to read %s", path);
+		ret = 1;
+	} else if (strcmp(golden, output) != 0) {
+		NCCL_OFI_WARN("Output does not match golden file %s. Output:\n%s", path, output);
+		ret = 1;
+	}
+
+	free(golden);
+	fclose(file);
+	return ret;
+}
+
+/*
+ * @brief	Check that the tuner loads the fitted parameters
+ */
+static int check_load(const nccl_ofi_tuner_fit_result_t *result,
+		      const struct nccl_ofi_tuner_model_params *initial)
+{
+	struct nccl_ofi_tuner_model_params loaded = *initial;
+	const struct nccl_ofi_tuner_model_params *fitted = &result->params;
+	int ret = 0;
+
+	if (nccl_ofi_tuner_load_params(TUNER_FIT_DIR "/params.golden", &loaded) != 0) {
+		NCCL_OFI_WARN("Failed to load golden parameter file");
+		return 1;
+	}
+
+	ret |= check_close("loaded net_latency", loaded.net_lat, fitted->net_lat, 1e-3);
+	ret |= check_close("loaded net_comp_overhead", loaded.net_comp_overhead,
+			   fitted->net_comp_overhead, 1e-3);
+	ret |= check_close("loaded internode_bw", loaded.internode_bw, fitted->internode_bw, 0.1);
+	ret |= check_close("loaded channel_overhead", loaded.channel_overhead,
+			   fitted->channel_overhead, 1e-3);
+	ret |= check_close("loaded loggp_G", loaded.loggp_G, 1.0 / fitted->internode_bw, 1e-9);
+	for (int algo = 0; algo < NCCL_NUM_ALGORITHMS; algo++) {
+		for (int proto = 0; proto < NCCL_NUM_PROTOCOLS; proto++) {
+			ret |= check_close("loaded base latency", loaded.base_lat[algo][proto],
+					   fitted->base_lat[algo][proto], 1e-3);
+		}
+	}
+
+	/* Parameters that are not fitted keep their value */
+	ret |= check_close("loaded intranode_bw", loaded.intranode_bw, initial->intranode_bw, 0.0);
+	ret |= check_close("loaded sm_cost", loaded.sm_cost, initial->sm_cost, 0.0);
+
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	int ret = 0;
+	const char *path = TUNER_FIT_DIR "/nccl-tests.csv";
+	FILE *file;
+	nccl_ofi_tuner_sample_t *samples = NULL;
+	size_t num_samples = 0;
+	struct nccl_ofi_tuner_model_params initial;
+	nccl_ofi_tuner_fit_result_t result;
+	char *output = NULL;
+	size_t output_len = 0;
+	FILE *out;
+
+	ofi_log_function = logger;
+
+	if (!(file = fopen(path, "r"))) {
+		NCCL_OFI_WARN("Failed to open %s: %s", path, strerror(errno));
+		return 1;
+	}
+	ret = nccl_ofi_tuner_fit_read_csv(file, path, &samples, &num_samples);
+	fclose(file);
+	if (ret != 0 || num_samples == 0) {
+		NCCL_OFI_WARN("Failed to read samples");
+		return 1;
+	}
+
+	nccl_ofi_tuner_default_params(&initial);
+	if (nccl_ofi_tuner_fit(samples, num_samples, &initial, &result) != 0) {
+		NCCL_OFI_WARN("Fit failed");
+		ret = 1;
+		goto exit;
+	}
+	if (result.num_samples != num_samples) {
+		NCCL_OFI_WARN("Fitted %zu of %zu samples", result.num_samples, num_samples);
+		ret = 1;
+	}
+	ret |= check_recovered(&result);
+
+	if (!(out = open_memstream(&output, &output_len))) {
+		ret = 1;
+		goto exit;
+	}
+	ret |= nccl_ofi_tuner_fit_write(out, &result) != 0;
+	fclose(out);
+
+	ret |= check_golden(output);
+	ret |= check_load(&result, &initial);
+
+ exit:
+	free(output);
+	free(samples);
+	if (ret) {
+		return ret;
+	}
+
+	printf("Test completed successfully!\n");
+
+	return 0;
+}
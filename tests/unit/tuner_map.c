@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+/*
+ * Regression test of the tuner's decisions.
+ *
+ * The decision maps of representative cluster shapes with the default
+ * model parameters are compared against golden files in TUNER_MAP_DIR,
+ * so that every change of a decision is visible in review.
+ *
+ * Set environment variable TUNER_MAP_UPDATE to regenerate the golden
+ * files instead of comparing against them.
+ */
+
+#include "config.h"
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test-common.h"
+#include "nccl_ofi_tuner.h"
+
+#ifndef TUNER_MAP_DIR
+#define TUNER_MAP_DIR "tuner_map"
+#endif
+
+extern const ncclTuner_v2_t ncclTunerPlugin_v2;
+
+static const struct {
+	const char *name;
+	size_t num_ranks;
+	size_t num_nodes;
+} shapes[] = {
+	/* Left to NCCL's selection */
+	{ "8x2", 16, 2 },
+	{ "8x4", 32, 4 },
+	{ "8x16", 128, 16 },
+	{ "8x128", 1024, 128 },
+	/* One rank per node */
+	{ "1x16", 16, 16 },
+};
+
+static const struct nccl_ofi_tuner_map_grid grid = {
+	.funcs = (1U << NCCL_NUM_FUNCTIONS) - 1,
+	.min_size = 1,
+	.max_size = (size_t)16 << 30,
+	.min_pipe_ops = 1,
+	.max_pipe_ops = 2,
+	.nvls_support = true,
+};
+
+/*
+ * @brief	Compare decision map against golden file, or update golden
+ *		file if requested
+ */
+static int check_golden(const char *name, const char *output)
+{
+	char path[256];
+	char *golden = NULL;
+	size_t golden_len = 0;
+	FILE *file;
+	int ret = 0;
+
+	snprintf(path, sizeof(path), "%s/%s.csv", TUNER_MAP_DIR, name);
+
+	if (getenv("TUNER_MAP_UPDATE")) {
+		if (!(file = fopen(path, "w"))) {
+			NCCL_OFI_WARN("Failed to open %s: %s", path, strerror(errno));
+			return 1;
+		}
+		fputs(output, file);
+		fclose(file);
+		return 0;
+	}
+
+	if (!(file = fopen(path, "r"))) {
+		NCCL_OFI_WARN("Failed to open %s: %s", path, strerror(errno));
+		return 1;
+	}
+	if (getdelim(&golden, &golden_len, '\0', file) < 0) {
+		NCCL_OFI_WARN("Failed to read %s", path);
+		ret = 1;
+	} else if (strcmp(golden, output) != 0) {
+		NCCL_OFI_WARN("%s: Decision map does not match golden file %s", name, path);
+		ret = 1;
+	}
+
+	free(golden);
+	fclose(file);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	int ret = 0;
+
+	for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); i++) {
+		void *context = NULL;
+		char *output = NULL;
+		size_t output_len = 0;
+		FILE *out;
+
+		if (ncclTunerPlugin_v2.init(shapes[i].num_ranks, shapes[i].num_nodes,
+					    logger, &context) != ncclSuccess) {
+			NCCL_OFI_WARN("Tuner initialization failed");
+			return 1;
+		}
+
+		if (!(out = open_memstream(&output, &output_len))) {
+			ncclTunerPlugin_v2.destroy(context);
+			return 1;
+		}
+		nccl_ofi_tuner_map_write_header(out);
+		if (nccl_ofi_tuner_map_write(out, context, &grid) != 0) {
+			NCCL_OFI_WARN("%s: Unable to write decision map", shapes[i].name);
+			ret = 1;
+		}
+		fclose(out);
+
+		ret |= check_golden(shapes[i].name, output);
+
+		free(output);
+		ncclTunerPlugin_v2.destroy(context);
+	}
+
+	if (ret) {
+		return ret;
+	}
+
+	printf("Test completed successfully!\n");
+
+	return 0;
+}
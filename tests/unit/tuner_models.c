@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "test-common.h"
+#include "nccl_ofi_tuner.h"
+
+extern const ncclTuner_v2_t ncclTunerPlugin_v2;
+
+/* Largest message size of the cost curves */
+#define MAX_SIZE	(1ULL << 34)
+
+/* Maximum number of models compared */
+#define MAX_MODELS	(8)
+
+static const char *func_names[] = {
+	"Broadcast", "Reduce", "AllGather", "ReduceScatter", "AllReduce"
+};
+
+/*
+ * Print the cost curves of all cost models for a collective as CSV
+ * (collective, size, then the lowest cost of each model in µsecs), and
+ * check that the lowest cost of each model is positive and does not
+ * decrease with the message size.
+ */
+static int print_curves(struct nccl_ofi_tuner_context *ctx, ncclFunc_t func)
+{
+	double prev[MAX_MODELS] = { 0 };
+	double costs[MAX_MODELS];
+	int num_models = 0;
+
+	while (nccl_ofi_tuner_models[num_models].name != NULL && num_models < MAX_MODELS)
+		num_models++;
+
+	for (size_t size = 1; size <= MAX_SIZE; size *= 2) {
+		for (int i = 0; i < num_models; i++) {
+			int algo = NCCL_ALGO_UNDEF, proto = NCCL_PROTO_UNDEF, channels = 0;
+
+			ctx->model = &nccl_ofi_tuner_models[i];
+			costs[i] = nccl_ofi_tuner_compute_decision(ctx, func, 1, 1, size,
+								   &algo, &proto, &channels);
+
+			if (costs[i] <= 0) {
+				NCCL_OFI_WARN("%s model: no cost for %s of size %zu",
+					      ctx->model->name, func_names[func], size);
+				return 1;
+			}
+			if (costs[i] < prev[i]) {
+				NCCL_OFI_WARN("%s model: cost of %s decreased from %.3f to %.3f at size %zu",
+					      ctx->model->name, func_names[func], prev[i], costs[i], size);
+				return 1;
+			}
+			prev[i] = costs[i];
+		}
+
+		printf("%s,%zu", func_names[func], size);
+		for (int i = 0; i < num_models; i++) {
+			printf(",%.3f", costs[i]);
+		}
+		printf("\n");
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int ret = 0;
+	void *context = NULL;
+	struct nccl_ofi_tuner_context *ctx;
+
+	if (!nccl_ofi_tuner_find_model("hockney") || !nccl_ofi_tuner_find_model("LogGP") ||
+	    nccl_ofi_tuner_find_model("unknown")) {
+		NCCL_OFI_WARN("Unexpected model lookup result");
+		return 1;
+	}
+
+	if (ncclTunerPlugin_v2.init(128, 16, logger, &context) != ncclSuccess) {
+		NCCL_OFI_WARN("Tuner initialization failed");
+		return 1;
+	}
+	ctx = context;
+
+	printf("collective,size");
+	for (int i = 0; nccl_ofi_tuner_models[i].name != NULL; i++) {
+		printf(",%s", nccl_ofi_tuner_models[i].name);
+	}
+	printf("\n");
+
+	for (int func = 0; func < NCCL_NUM_FUNCTIONS; func++) {
+		ret |= print_curves(ctx, func);
+	}
+
+	ncclTunerPlugin_v2.destroy(context);
+
+	if (ret) {
+		return ret;
+	}
+
+	printf("Test completed successfully!\n");
+
+	return 0;
+}
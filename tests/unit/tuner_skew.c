@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+/*
+ * Test of the tuner with ranks placed unevenly on the nodes.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "test-common.h"
+#include "nccl_ofi_tuner.h"
+
+extern const ncclTuner_v2_t ncclTunerPlugin_v2;
+
+/* Largest message size of the sweep */
+#define MAX_SIZE	(1ULL << 34)
+
+/* Local rank counts of the job, set through the environment */
+#define JOB_MAX_LOCAL_RANKS	16
+#define JOB_MIN_LOCAL_RANKS	4
+
+#define STR_(x)		#x
+#define STR(x)		STR_(x)
+
+static int check_dims(int num_ranks, int num_nodes, int max_local_ranks, int min_local_ranks,
+		      int expected_ret, int expected_max, int expected_min)
+{
+	struct nccl_ofi_tuner_model_dims dims;
+	int ret = nccl_ofi_tuner_init_dims(&dims, num_ranks, num_nodes, max_local_ranks,
+					   min_local_ranks);
+
+	if (ret != expected_ret || dims.num_ranks != num_ranks || dims.num_nodes != num_nodes ||
+	    dims.max_local_ranks != expected_max || dims.min_local_ranks != expected_min) {
+		NCCL_OFI_WARN("%d ranks on %d nodes with %d..%d local ranks: got %d, %d..%d, expected %d, %d..%d",
+			      num_ranks, num_nodes, min_local_ranks, max_local_ranks, ret,
+			      dims.min_local_ranks, dims.max_local_ranks, expected_ret,
+			      expected_min, expected_max);
+		return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * The worst-case node of a skewed placement must not be cheaper than
+ * the even placement of the same communicator.
+ */
+static int check_skewed_costs(void)
+{
+	struct nccl_ofi_tuner_model_params params;
+	struct nccl_ofi_tuner_model_dims even, skewed;
+	const struct nccl_ofi_tuner_model *model = nccl_ofi_tuner_find_model("hockney");
+	int ret = 0;
+
+	nccl_ofi_tuner_default_params(&params);
+	nccl_ofi_tuner_init_dims(&even, 128, 16, 0, 0);
+	nccl_ofi_tuner_init_dims(&skewed, 128, 16, 16, 4);
+
+	for (size_t size = 1; size <= MAX_SIZE; size *= 16) {
+		double tree_even = model->compute_cost(&params, &even, ncclFuncAllReduce, NCCL_ALGO_TREE,
+						       NCCL_PROTO_LL, 1, 4, size);
+		double tree_skewed = model->compute_cost(&params, &skewed, ncclFuncAllReduce, NCCL_ALGO_TREE,
+							 NCCL_PROTO_LL, 1, 4, size);
+		double nvls_even = model->compute_cost(&params, &even, ncclFuncAllGather, NCCL_ALGO_NVLS,
+						       NCCL_PROTO_SIMPLE, 1, 8, size);
+		double nvls_skewed = model->compute_cost(&params, &skewed, ncclFuncAllGather, NCCL_ALGO_NVLS,
+							 NCCL_PROTO_SIMPLE, 1, 8, size);
+
+		/* Longer intranode chains */
+		if (!(tree_skewed > tree_even)) {
+			NCCL_OFI_WARN("Tree cost %f of skewed placement not above %f for size %zu",
+				      tree_skewed, tree_even, size);
+			ret = 1;
+		}
+		/* Fewer ranks sharing the network traffic of a node */
+		if (nvls_skewed < nvls_even) {
+			NCCL_OFI_WARN("NVLS cost %f of skewed placement below %f for size %zu",
+				      nvls_skewed, nvls_even, size);
+			ret = 1;
+		}
+		if (size == MAX_SIZE && !(nvls_skewed > nvls_even)) {
+			NCCL_OFI_WARN("NVLS cost of skewed placement not bandwidth bound");
+			ret = 1;
+		}
+	}
+
+	return ret;
+}
+
+/*
+ * Decisions for skewed communicators must be complete and valid.
+ */
+static int check_decisions(size_t num_ranks, size_t num_nodes, int expected_max, int expected_min)
+{
+	void *context = NULL;
+	struct nccl_ofi_tuner_context *ctx;
+	int ret = 0;
+
+	if (ncclTunerPlugin_v2.init(num_ranks, num_nodes, logger, &context) != ncclSuccess) {
+		NCCL_OFI_WARN("Tuner initialization failed");
+		return 1;
+	}
+	ctx = context;
+
+	if (ctx->dims.max_local_ranks != expected_max || ctx->dims.min_local_ranks != expected_min) {
+		NCCL_OFI_WARN("%zu ranks on %zu nodes: %d..%d local ranks, expected %d..%d",
+			      num_ranks, num_nodes, ctx->dims.min_local_ranks, ctx->dims.max_local_ranks,
+			      expected_min, expected_max);
+		ret = 1;
+	}
+
+	for (int func = 0; func < NCCL_NUM_FUNCTIONS; func++) {
+		for (size_t size = 1; size <= MAX_SIZE; size *= 2) {
+			int algo = NCCL_ALGO_UNDEF, proto = NCCL_PROTO_UNDEF, channels = 0;
+
+			ncclTunerPlugin_v2.getCollInfo(context, func, size, 0, 1, 1,
+						       &algo, &proto, &channels);
+			if (algo == NCCL_ALGO_UNDEF || proto == NCCL_PROTO_UNDEF || channels < 1 ||
+			    channels > ofi_nccl_tuner_num_channels()) {
+				NCCL_OFI_WARN("%zu ranks on %zu nodes: coll %d size %zu: invalid choice algo %d proto %d channels %d",
+					      num_ranks, num_nodes, func, size, algo, proto, channels);
+				ret = 1;
+				break;
+			}
+		}
+	}
+
+	ncclTunerPlugin_v2.destroy(context);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	int ret = 0;
+
+	ofi_log_function = logger;
+
+	setenv("OFI_NCCL_TUNER_MAX_LOCAL_RANKS", STR(JOB_MAX_LOCAL_RANKS), 1);
+	setenv("OFI_NCCL_TUNER_MIN_LOCAL_RANKS", STR(JOB_MIN_LOCAL_RANKS), 1);
+
+	/* Most even placement */
+	ret |= check_dims(128, 16, 0, 0, 0, 8, 8);
+	ret |= check_dims(100, 16, 0, 0, 0, 7, 6);
+	ret |= check_dims(17, 16, 0, 0, 0, 2, 1);
+	ret |= check_dims(8, 1, 0, 0, 0, 8, 8);
+
+	/* Skewed placement */
+	ret |= check_dims(100, 16, 16, 4, 0, 16, 4);
+	ret |= check_dims(76, 16, 16, 4, 0, 16, 4);
+	ret |= check_dims(244, 16, 16, 4, 0, 16, 4);
+
+	/* Local rank counts that do not fit */
+	ret |= check_dims(75, 16, 16, 4, -EINVAL, 5, 4);
+	ret |= check_dims(245, 16, 16, 4, -EINVAL, 16, 15);
+	ret |= check_dims(100, 16, 4, 16, -EINVAL, 7, 6);
+	ret |= check_dims(100, 16, 16, 0, -EINVAL, 7, 6);
+	ret |= check_dims(8, 1, 8, 4, -EINVAL, 8, 8);
+
+	ret |= check_skewed_costs();
+
+	/* The job's local rank counts apply to communicators they fit */
+	ret |= check_decisions(128, 16, JOB_MAX_LOCAL_RANKS, JOB_MIN_LOCAL_RANKS);
+	ret |= check_decisions(1000, 128, JOB_MAX_LOCAL_RANKS, JOB_MIN_LOCAL_RANKS);
+	ret |= check_decisions(100, 16, JOB_MAX_LOCAL_RANKS, JOB_MIN_LOCAL_RANKS);
+	/* and communicators they do not fit use the most even placement */
+	ret |= check_decisions(100, 32, 4, 3);
+	ret |= check_decisions(17, 16, 2, 1);
+
+	if (ret) {
+		return ret;
+	}
+
+	printf("Test completed successfully!\n");
+
+	return 0;
+}
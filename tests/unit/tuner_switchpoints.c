@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "test-common.h"
+#include "nccl_ofi_tuner.h"
+
+extern const ncclTuner_v2_t ncclTunerPlugin_v2;
+
+/* Largest message size of the sweep */
+#define MAX_SIZE	(1ULL << 34)
+
+static const char *func_names[] = {
+	"Broadcast", "Reduce", "AllGather", "ReduceScatter", "AllReduce"
+};
+
+/*
+ * Sweep message sizes for a collective and check that every
+ * (algorithm, protocol) choice is made for a single contiguous range of
+ * sizes, i.e., once the tuner switches away from a choice at a switch
+ * point, it never switches back for larger messages. Within the range of
+ * a choice, the channel count must not decrease with the message size.
+ */
+static int check_switchpoints(void *context, ncclFunc_t func, size_t num_ranks,
+			      size_t num_nodes, int nvls_support)
+{
+	bool left[NCCL_NUM_ALGORITHMS][NCCL_NUM_PROTOCOLS] = { { false } };
+	int prev_algo = NCCL_ALGO_UNDEF, prev_proto = NCCL_PROTO_UNDEF, prev_channels = 0;
+
+	for (size_t size = 1; size <= MAX_SIZE; size *= 2) {
+		int algo = NCCL_ALGO_UNDEF, proto = NCCL_PROTO_UNDEF, channels = 0;
+
+		if (ncclTunerPlugin_v2.getCollInfo(context, func, size, 0, nvls_support, 1,
+						   &algo, &proto, &channels) != ncclSuccess) {
+			NCCL_OFI_WARN("getCollInfo failed");
+			return 1;
+		}
+
+		if (algo == NCCL_ALGO_UNDEF || proto == NCCL_PROTO_UNDEF) {
+			NCCL_OFI_WARN("%s with %zu ranks on %zu nodes not tuned for size %zu",
+				      func_names[func], num_ranks, num_nodes, size);
+			return 1;
+		}
+
+		if ((algo == NCCL_ALGO_NVLS || algo == NCCL_ALGO_NVLS_TREE) &&
+		    (!nvls_support || proto != NCCL_PROTO_SIMPLE)) {
+			NCCL_OFI_WARN("%s: invalid choice algo %d proto %d for size %zu",
+				      func_names[func], algo, proto, size);
+			return 1;
+		}
+
+		if (channels < 1 || channels > ofi_nccl_tuner_num_channels()) {
+			NCCL_OFI_WARN("%s: invalid channel count %d for size %zu",
+				      func_names[func], channels, size);
+			return 1;
+		}
+
+		if (algo == prev_algo && proto == prev_proto) {
+			if (channels < prev_channels) {
+				NCCL_OFI_WARN("%s: channel count decreased from %d to %d at size %zu",
+					      func_names[func], prev_channels, channels, size);
+				return 1;
+			}
+			prev_channels = channels;
+			continue;
+		}
+
+		if (left[algo][proto]) {
+			NCCL_OFI_WARN("%s with %zu ranks on %zu nodes: algo %d proto %d chosen again at size %zu",
+				      func_names[func], num_ranks, num_nodes, algo, proto, size);
+			return 1;
+		}
+
+		if (prev_algo != NCCL_ALGO_UNDEF) {
+			left[prev_algo][prev_proto] = true;
+			NCCL_OFI_INFO(NCCL_TUNING, "%s with %zu ranks on %zu nodes: switch to algo %d proto %d at size %zu",
+				      func_names[func], num_ranks, num_nodes, algo, proto, size);
+		}
+		prev_algo = algo;
+		prev_proto = proto;
+		prev_channels = channels;
+	}
+
+	/* Bandwidth-bound messages must use the Simple protocol */
+	if (prev_proto != NCCL_PROTO_SIMPLE) {
+		NCCL_OFI_WARN("%s: protocol %d chosen for largest size", func_names[func], prev_proto);
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int ret = 0;
+	static const struct {
+		size_t num_ranks;
+		size_t num_nodes;
+	} comms[] = {
+		{ 32, 4 },
+		{ 128, 16 },
+		{ 512, 64 },
+		{ 16, 16 },
+	};
+
+	for (size_t i = 0; i < sizeof(comms) / sizeof(comms[0]); i++) {
+		void *context = NULL;
+
+		if (ncclTunerPlugin_v2.init(comms[i].num_ranks, comms[i].num_nodes,
+					    logger, &context) != ncclSuccess) {
+			NCCL_OFI_WARN("Tuner initialization failed");
+			return 1;
+		}
+
+		for (int func = 0; func < NCCL_NUM_FUNCTIONS; func++) {
+			for (int nvls_support = 0; nvls_support <= 1; nvls_support++) {
+				ret |= check_switchpoints(context, func, comms[i].num_ranks,
+							  comms[i].num_nodes, nvls_support);
+			}
+		}
+
+		ncclTunerPlugin_v2.destroy(context);
+	}
+
+	if (ret) {
+		return ret;
+	}
+
+	printf("Test completed successfully!\n");
+
+	return 0;
+}
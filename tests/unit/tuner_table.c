@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "test-common.h"
+#include "nccl_ofi_tuner.h"
+
+extern const ncclTuner_v2_t ncclTunerPlugin_v2;
+
+/* Number of sizes tested in each size bucket */
+#define SIZES_PER_BUCKET	(16)
+
+static bool same_decision(const struct nccl_ofi_tuner_decision *decision, int algo, int proto,
+			  int channels)
+{
+	return decision->algo == algo &&
+		(algo == NCCL_ALGO_UNDEF ||
+		 (decision->proto == proto && decision->channels == channels));
+}
+
+/*
+ * The decision of a bucket is exact for the smallest size of the bucket,
+ * and may only differ from the exact decision within the bucket if the
+ * exact decision switches within the bucket.
+ */
+static int check_table(struct nccl_ofi_tuner_context *ctx, ncclFunc_t func,
+		       int nvls_support, int pipe_ops)
+{
+	for (int size_log2 = 0; size_log2 <= NCCL_OFI_TUNER_TABLE_MAX_SIZE_LOG2; size_log2++) {
+		for (int step = 0; step < NCCL_OFI_TUNER_TABLE_SIZE_STEPS; step++) {
+			size_t first = ((size_t)(NCCL_OFI_TUNER_TABLE_SIZE_STEPS + step) << size_log2)
+				       >> NCCL_OFI_TUNER_TABLE_SIZE_STEPS_LOG2;
+			size_t last = (((size_t)(NCCL_OFI_TUNER_TABLE_SIZE_STEPS + step + 1) << size_log2)
+				       >> NCCL_OFI_TUNER_TABLE_SIZE_STEPS_LOG2) - 1;
+			int first_algo = NCCL_ALGO_UNDEF, first_proto = NCCL_PROTO_UNDEF, first_channels = 0;
+			int last_algo = NCCL_ALGO_UNDEF, last_proto = NCCL_PROTO_UNDEF, last_channels = 0;
+			const struct nccl_ofi_tuner_decision *decision;
+
+			if (last < first) {
+				/* Empty bucket of sizes smaller than the number of steps */
+				continue;
+			}
+
+			decision = nccl_ofi_tuner_lookup_decision(ctx, func, nvls_support, pipe_ops, first);
+			if (!decision) {
+				NCCL_OFI_WARN("No decision for size %zu", first);
+				return 1;
+			}
+			if (decision != nccl_ofi_tuner_lookup_decision(ctx, func, nvls_support, pipe_ops, last)) {
+				NCCL_OFI_WARN("Sizes %zu and %zu not in the same bucket", first, last);
+				return 1;
+			}
+
+			nccl_ofi_tuner_compute_decision(ctx, func, nvls_support, pipe_ops, first,
+							&first_algo, &first_proto, &first_channels);
+			nccl_ofi_tuner_compute_decision(ctx, func, nvls_support, pipe_ops, last,
+							&last_algo, &last_proto, &last_channels);
+			if (!same_decision(decision, first_algo, first_proto, first_channels)) {
+				NCCL_OFI_WARN("Coll %d: table decision for size %zu is not exact", func, first);
+				return 1;
+			}
+			if (first_algo != last_algo || first_proto != last_proto ||
+			    first_channels != last_channels) {
+				/* Exact decision switches within bucket */
+				continue;
+			}
+
+			for (size_t i = 1; i < SIZES_PER_BUCKET; i++) {
+				size_t size = first + (last - first) * i / SIZES_PER_BUCKET;
+				int algo = NCCL_ALGO_UNDEF, proto = NCCL_PROTO_UNDEF, channels = 0;
+
+				nccl_ofi_tuner_compute_decision(ctx, func, nvls_support, pipe_ops, size,
+								&algo, &proto, &channels);
+				if (!same_decision(decision, algo, proto, channels)) {
+					NCCL_OFI_WARN("Coll %d: table decision for size %zu is not exact", func, size);
+					return 1;
+				}
+			}
+		}
+	}
+
+	/* Messages outside of the table are computed exactly */
+	if (nccl_ofi_tuner_lookup_decision(ctx, func, nvls_support, pipe_ops,
+					   (size_t)2 << NCCL_OFI_TUNER_TABLE_MAX_SIZE_LOG2) ||
+	    nccl_ofi_tuner_lookup_decision(ctx, func, nvls_support,
+					   NCCL_OFI_TUNER_TABLE_PIPE_OPS + 1, 1024)) {
+		NCCL_OFI_WARN("Lookup outside of table succeeded");
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int ret = 0;
+	void *context = NULL;
+
+	if (ncclTunerPlugin_v2.init(128, 16, logger, &context) != ncclSuccess) {
+		NCCL_OFI_WARN("Tuner initialization failed");
+		return 1;
+	}
+
+	for (int func = 0; func < NCCL_NUM_FUNCTIONS; func++) {
+		for (int nvls_support = 0; nvls_support <= 1; nvls_support++) {
+			for (int pipe_ops = 1; pipe_ops <= NCCL_OFI_TUNER_TABLE_PIPE_OPS; pipe_ops++) {
+				ret |= check_table(context, func, nvls_support, pipe_ops);
+			}
+		}
+	}
+
+	ncclTunerPlugin_v2.destroy(context);
+
+	if (ret) {
+		return ret;
+	}
+
+	printf("Test completed successfully!\n");
+
+	return 0;
+}
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+/*
+ * Test of the tuner's cost tables of the v3 tuner interface against the
+ * decisions of the v2 interface.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "test-common.h"
+#include "nccl_ofi_tuner.h"
+
+extern const ncclTuner_v3_t ncclTunerPlugin_v3;
+extern const ncclTuner_v2_t ncclTunerPlugin_v2;
+#if !defined(AWS_OFI_NCCL_MIN_TUNER_COMPAT) || (AWS_OFI_NCCL_MIN_TUNER_COMPAT <= 1)
+extern const ncclTuner_v1_t ncclTunerPlugin_v1;
+#endif
+
+/* Largest message size of the sweep, beyond the decision table */
+#define MAX_SIZE	(1ULL << 42)
+
+/* Cost NCCL reports for the combinations it does not rule out */
+#define NCCL_COST	(5.0f)
+
+/*
+ * @brief	Fill cost table as NCCL would, ruling out CollNet and the
+ *		protocol excluded_proto (if not NCCL_PROTO_UNDEF)
+ */
+static void init_table(float table[NCCL_NUM_ALGORITHMS][NCCL_NUM_PROTOCOLS], int excluded_proto)
+{
+	for (int algo = 0; algo < NCCL_NUM_ALGORITHMS; algo++) {
+		for (int proto = 0; proto < NCCL_NUM_PROTOCOLS; proto++) {
+			if (algo == NCCL_ALGO_COLLNET_DIRECT || algo == NCCL_ALGO_COLLNET_CHAIN ||
+			    proto == excluded_proto) {
+				table[algo][proto] = NCCL_ALGO_PROTO_IGNORE;
+			} else {
+				table[algo][proto] = NCCL_COST;
+			}
+		}
+	}
+}
+
+/*
+ * @brief	Find lowest cost of cost table
+ *
+ * @return	Lowest cost, or a negative value if all combinations are
+ *		ruled out
+ */
+static float lowest_cost(float table[NCCL_NUM_ALGORITHMS][NCCL_NUM_PROTOCOLS], int *algo_out,
+			 int *proto_out)
+{
+	float lowest = -1;
+
+	for (int algo = 0; algo < NCCL_NUM_ALGORITHMS; algo++) {
+		for (int proto = 0; proto < NCCL_NUM_PROTOCOLS; proto++) {
+			if (table[algo][proto] == NCCL_ALGO_PROTO_IGNORE)
+				continue;
+			if (lowest < 0 || table[algo][proto] < lowest) {
+				lowest = table[algo][proto];
+				*algo_out = algo;
+				*proto_out = proto;
+			}
+		}
+	}
+
+	return lowest;
+}
+
+/*
+ * The lowest cost of the v3 cost table is the cost of the decision of
+ * the v2 interface, and combinations ruled out by NCCL stay ruled out.
+ */
+static int check_costs(void *context_v3, void *context_v2, int excluded_proto)
+{
+	for (int func = 0; func < NCCL_NUM_FUNCTIONS; func++) {
+		for (int pipe_ops = 1; pipe_ops <= 2; pipe_ops++) {
+			for (size_t size = 1; size <= MAX_SIZE; size *= 2) {
+				float table[NCCL_NUM_ALGORITHMS][NCCL_NUM_PROTOCOLS];
+				int algo = NCCL_ALGO_UNDEF, proto = NCCL_PROTO_UNDEF, channels = 0;
+				int v2_algo = NCCL_ALGO_UNDEF, v2_proto = NCCL_PROTO_UNDEF, v2_channels = 0;
+				float lowest;
+
+				init_table(table, excluded_proto);
+				ncclTunerPlugin_v3.getCollInfo(context_v3, func, size, pipe_ops,
+							       (float **)table, NCCL_NUM_ALGORITHMS,
+							       NCCL_NUM_PROTOCOLS, &channels);
+				lowest = lowest_cost(table, &algo, &proto);
+				if (lowest < 0) {
+					NCCL_OFI_WARN("coll %d size %zu pipe %d: all combinations ruled out",
+						      func, size, pipe_ops);
+					return 1;
+				}
+
+				for (int a = 0; a < NCCL_NUM_ALGORITHMS; a++) {
+					for (int p = 0; p < NCCL_NUM_PROTOCOLS; p++) {
+						bool ruled_out = (a == NCCL_ALGO_COLLNET_DIRECT ||
+								  a == NCCL_ALGO_COLLNET_CHAIN ||
+								  p == excluded_proto);
+
+						if (table[a][p] == NCCL_COST ||
+						    (ruled_out && table[a][p] != NCCL_ALGO_PROTO_IGNORE)) {
+							NCCL_OFI_WARN("coll %d size %zu pipe %d: algo %d proto %d has cost %f",
+								      func, size, pipe_ops, a, p, table[a][p]);
+							return 1;
+						}
+					}
+				}
+
+				if (excluded_proto != NCCL_PROTO_UNDEF)
+					continue;
+
+				ncclTunerPlugin_v2.getCollInfo(context_v2, func, size, 0, 1, pipe_ops,
+							       &v2_algo, &v2_proto, &v2_channels);
+				if (v2_algo == NCCL_ALGO_UNDEF ||
+				    table[v2_algo][v2_proto] != lowest ||
+				    (algo == v2_algo && proto == v2_proto && channels != v2_channels)) {
+					NCCL_OFI_WARN("coll %d size %zu pipe %d: v3 chose algo %d proto %d channels %d, v2 algo %d proto %d channels %d",
+						      func, size, pipe_ops, algo, proto, channels,
+						      v2_algo, v2_proto, v2_channels);
+					return 1;
+				}
+			}
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * NCCL's costs are kept if the tuner models none of the combinations
+ * NCCL does not rule out.
+ */
+static int check_fallback(void *context)
+{
+	float table[NCCL_NUM_ALGORITHMS][NCCL_NUM_PROTOCOLS];
+	int channels = 0;
+
+	for (int algo = 0; algo < NCCL_NUM_ALGORITHMS; algo++) {
+		for (int proto = 0; proto < NCCL_NUM_PROTOCOLS; proto++) {
+			table[algo][proto] = (algo == NCCL_ALGO_COLLNET_DIRECT) ? NCCL_COST
+										: NCCL_ALGO_PROTO_IGNORE;
+		}
+	}
+
+	ncclTunerPlugin_v3.getCollInfo(context, ncclFuncAllReduce, 1 << 20, 1, (float **)table,
+				       NCCL_NUM_ALGORITHMS, NCCL_NUM_PROTOCOLS, &channels);
+	for (int proto = 0; proto < NCCL_NUM_PROTOCOLS; proto++) {
+		if (table[NCCL_ALGO_COLLNET_DIRECT][proto] != NCCL_COST || channels != 0) {
+			NCCL_OFI_WARN("NCCL's costs not kept");
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	void *context_v3 = NULL, *context_v2 = NULL, *context_small = NULL;
+	int ret = 0;
+
+	if (ncclTunerPlugin_v3.init(128, 16, logger, &context_v3) != ncclSuccess ||
+	    ncclTunerPlugin_v2.init(128, 16, logger, &context_v2) != ncclSuccess ||
+	    ncclTunerPlugin_v3.init(16, 2, logger, &context_small) != ncclSuccess) {
+		NCCL_OFI_WARN("Tuner initialization failed");
+		return 1;
+	}
+
+	ret |= check_costs(context_v3, context_v2, NCCL_PROTO_UNDEF);
+	/* As with NCCL_PROTO=^LL128 */
+	ret |= check_costs(context_v3, context_v2, NCCL_PROTO_LL128);
+	ret |= check_fallback(context_v3);
+	/* Runs with up to 2 nodes keep NCCL's costs */
+	ret |= check_fallback(context_small);
+
+#if !defined(AWS_OFI_NCCL_MIN_TUNER_COMPAT) || (AWS_OFI_NCCL_MIN_TUNER_COMPAT <= 1)
+	/* The v1 interface uses the context of its initialization */
+	if (ncclTunerPlugin_v1.init(128, 16, logger) != ncclSuccess) {
+		NCCL_OFI_WARN("Tuner initialization failed");
+		return 1;
+	}
+	for (size_t size = 1; size <= MAX_SIZE; size *= 2) {
+		int v1_algo = NCCL_ALGO_UNDEF, v1_proto = NCCL_PROTO_UNDEF, v1_channels = 0;
+		int v2_algo = NCCL_ALGO_UNDEF, v2_proto = NCCL_PROTO_UNDEF, v2_channels = 0;
+
+		ncclTunerPlugin_v1.getCollInfo(ncclFuncAllReduce, size, 0, 1, 1,
+					       &v1_algo, &v1_proto, &v1_channels);
+		ncclTunerPlugin_v2.getCollInfo(context_v2, ncclFuncAllReduce, size, 0, 1, 1,
+					       &v2_algo, &v2_proto, &v2_channels);
+		if (v1_algo != v2_algo || v1_proto != v2_proto || v1_channels != v2_channels) {
+			NCCL_OFI_WARN("size %zu: v1 chose algo %d proto %d channels %d, v2 algo %d proto %d channels %d",
+				      size, v1_algo, v1_proto, v1_channels, v2_algo, v2_proto, v2_channels);
+			ret = 1;
+			break;
+		}
+	}
+	ncclTunerPlugin_v1.destroy();
+#endif
+
+	ncclTunerPlugin_v3.destroy(context_small);
+	ncclTunerPlugin_v2.destroy(context_v2);
+	ncclTunerPlugin_v3.destroy(context_v3);
+
+	if (ret) {
+		return ret;
+	}
+
+	printf("Test completed successfully!\n");
+
+	return 0;
+}
@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+/*
+ * Decode the flight recorder dump of a process that runs the plugin:
+ *
+ *   nccl-ofi-flight-recorder [-v] [-d dir] pid|path
+ *
+ * The events of each endpoint are printed oldest first, with their time
+ * relative to the dump. A PID selects the dump file of the process in
+ * `dir` (default the current directory, see OFI_NCCL_FLIGHT_RECORDER_DIR).
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "nccl_ofi_flight_recorder.h"
+#include "nccl_ofi_rdma.h"
+#include "tools-common.h"
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [options] pid|path\n"
+		"  -d dir                Directory of the dump file of a PID (default .)\n"
+		"  -v                    Log informational messages\n",
+		prog);
+}
+
+static const char *event_type_str(uint16_t type)
+{
+	switch (type) {
+	case NCCL_OFI_FLIGHT_POST:
+		return "POST";
+	case NCCL_OFI_FLIGHT_COMPLETION:
+		return "COMPLETION";
+	case NCCL_OFI_FLIGHT_ERR_COMPLETION:
+		return "ERR_COMPLETION";
+	case NCCL_OFI_FLIGHT_STATE:
+		return "STATE";
+	}
+	return "UNKNOWN";
+}
+
+static const char *req_type_str(uint8_t type)
+{
+	switch ((nccl_net_ofi_rdma_req_type_t)type) {
+	case NCCL_OFI_RDMA_SEND_CONN:
+		return "SEND_CONN";
+	case NCCL_OFI_RDMA_SEND_CONN_RESP:
+		return "SEND_CONN_RESP";
+	case NCCL_OFI_RDMA_RECV_CONN:
+		return "RECV_CONN";
+	case NCCL_OFI_RDMA_RECV_CONN_RESP:
+		return "RECV_CONN_RESP";
+	case NCCL_OFI_RDMA_SEND:
+		return "SEND";
+	case NCCL_OFI_RDMA_RECV:
+		return "RECV";
+	case NCCL_OFI_RDMA_SEND_CTRL:
+		return "SEND_CTRL";
+	case NCCL_OFI_RDMA_RECV_SEGMS:
+		return "RECV_SEGMS";
+	case NCCL_OFI_RDMA_BOUNCE:
+		return "BOUNCE";
+	case NCCL_OFI_RDMA_FLUSH:
+		return "FLUSH";
+	case NCCL_OFI_RDMA_EAGER_COPY:
+		return "EAGER_COPY";
+	}
+	return "unknown";
+}
+
+static const char *req_state_str(int32_t state)
+{
+	switch ((nccl_net_ofi_rdma_req_state_t)state) {
+	case NCCL_OFI_RDMA_REQ_CREATED:
+		return "CREATED";
+	case NCCL_OFI_RDMA_REQ_PENDING:
+		return "PENDING";
+	case NCCL_OFI_RDMA_REQ_COMPLETED:
+		return "COMPLETED";
+	case NCCL_OFI_RDMA_REQ_ERROR:
+		return "ERROR";
+	}
+	return "unknown";
+}
+
+/*
+ * @brief	Print completion flags, e.g. "RECV|MSG"
+ */
+static void print_cq_flags(uint64_t flags)
+{
+	static const struct {
+		uint64_t flag;
+		const char *name;
+	} names[] = {
+		{ FI_SEND, "SEND" },
+		{ FI_RECV, "RECV" },
+		{ FI_READ, "READ" },
+		{ FI_WRITE, "WRITE" },
+		{ FI_REMOTE_WRITE, "REMOTE_WRITE" },
+		{ FI_MSG, "MSG" },
+		{ FI_RMA, "RMA" },
+		{ FI_REMOTE_CQ_DATA, "CQ_DATA" },
+	};
+	bool first = true;
+
+	for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+		if (flags & names[i].flag) {
+			printf("%s%s", first ? "" : "|", names[i].name);
+			first = false;
+		}
+	}
+	if (first) {
+		printf("0x%" PRIx64, flags);
+	}
+}
+
+static void print_event(const nccl_ofi_flight_event_t *event, uint64_t dump_ts)
+{
+	double ms = ((double)event->ts - (double)dump_ts) * 1e-6;
+
+	printf("  %12.6f ms  %-14s", ms, event_type_str(event->type));
+	if (event->rail >= 0) {
+		printf(" rail %d", event->rail);
+	}
+	if (event->request) {
+		printf(" req 0x%" PRIx64 " %s", event->request, req_type_str(event->req_type));
+		if (event->comm_id != UINT32_MAX) {
+			printf(" comm %u seq %u", event->comm_id, event->msg_seq_num);
+		}
+	}
+
+	switch (event->type) {
+	case NCCL_OFI_FLIGHT_POST:
+		printf(" size %" PRIu64 " rc %d", event->arg, event->value);
+		if (event->value == -FI_EAGAIN) {
+			printf(" (EAGAIN)");
+		}
+		break;
+	case NCCL_OFI_FLIGHT_COMPLETION:
+		printf(" len %d flags ", event->value);
+		print_cq_flags(event->arg);
+		break;
+	case NCCL_OFI_FLIGHT_ERR_COMPLETION:
+		printf(" err %d (%s) prov_errno %" PRIu64, event->value,
+		       fi_strerror(event->value), event->arg);
+		break;
+	case NCCL_OFI_FLIGHT_STATE:
+		printf(" %s", req_state_str(event->value));
+		break;
+	}
+	printf("\n");
+}
+
+/*
+ * @brief	Print events of ring, skipping entries that were incomplete
+ *		or overwritten when the ring was dumped
+ */
+static void print_ring(const nccl_ofi_flight_dump_ring_t *ring,
+		       const nccl_ofi_flight_event_t *events, uint64_t dump_ts)
+{
+	uint64_t begin = ring->head > ring->num_events ? ring->head - ring->num_events : 0;
+	uint64_t skipped = 0;
+
+	printf("Endpoint ring %u of device %d%s: %" PRIu64 " events recorded, last %" PRIu64 ":\n",
+	       ring->id, ring->dev_id, ring->in_use ? "" : " (released)", ring->head,
+	       ring->head - begin);
+
+	for (uint64_t i = begin; i < ring->head; i++) {
+		const nccl_ofi_flight_event_t *event = &events[i & (ring->num_events - 1)];
+
+		if (event->seq != i + 1) {
+			skipped++;
+			continue;
+		}
+		print_event(event, dump_ts);
+	}
+	if (skipped) {
+		printf("  (%" PRIu64 " events incomplete at the dump)\n", skipped);
+	}
+}
+
+static int decode(const char *path)
+{
+	nccl_ofi_flight_dump_header_t header;
+	nccl_ofi_flight_event_t *events = NULL;
+	int ret = 1;
+	FILE *file;
+
+	file = fopen(path, "rb");
+	if (!file) {
+		NCCL_OFI_WARN("Unable to open %s: %s", path, strerror(errno));
+		return 1;
+	}
+
+	if (fread(&header, sizeof(header), 1, file) != 1 ||
+	    header.magic != NCCL_OFI_FLIGHT_RECORDER_MAGIC) {
+		NCCL_OFI_WARN("%s is not a flight recorder dump", path);
+		goto exit;
+	}
+	if (header.version != NCCL_OFI_FLIGHT_RECORDER_VERSION ||
+	    header.event_size != sizeof(nccl_ofi_flight_event_t)) {
+		NCCL_OFI_WARN("%s is a flight recorder dump of version %u, expected %d",
+			      path, header.version, NCCL_OFI_FLIGHT_RECORDER_VERSION);
+		goto exit;
+	}
+
+	printf("Flight recorder of process %d, dumped on ", header.pid);
+	if (header.reason == NCCL_OFI_FLIGHT_DUMP_ERROR) {
+		printf("error\n");
+	} else {
+		printf("signal %d (%s)\n", header.reason, strsignal(header.reason));
+	}
+
+	for (uint32_t i = 0; i < header.num_rings; i++) {
+		nccl_ofi_flight_dump_ring_t ring;
+
+		if (fread(&ring, sizeof(ring), 1, file) != 1 || ring.num_events == 0 ||
+		    (ring.num_events & (ring.num_events - 1)) != 0) {
+			NCCL_OFI_WARN("Truncated ring %u in %s", i, path);
+			goto exit;
+		}
+
+		free(events);
+		events = malloc(ring.num_events * sizeof(nccl_ofi_flight_event_t));
+		if (!events) {
+			NCCL_OFI_WARN("Unable to allocate %u events", ring.num_events);
+			goto exit;
+		}
+		if (fread(events, sizeof(nccl_ofi_flight_event_t), ring.num_events, file) !=
+		    ring.num_events) {
+			NCCL_OFI_WARN("Truncated ring %u in %s", i, path);
+			goto exit;
+		}
+
+		print_ring(&ring, events, header.ts);
+	}
+
+	ret = 0;
+ exit:
+	free(events);
+	fclose(file);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	int opt;
+	const char *dir = ".";
+	char path[PATH_MAX];
+	char *end;
+
+	ofi_log_function = stderr_logger;
+
+	while ((opt = getopt(argc, argv, "d:vh")) != -1) {
+		switch (opt) {
+		case 'd':
+			dir = optarg;
+			break;
+		case 'v':
+			tools_verbose = 1;
+			break;
+		case 'h':
+			usage(argv[0]);
+			return 0;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (optind != argc - 1) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	/* A PID selects the dump file of the process */
+	strtol(argv[optind], &end, 10);
+	if (*end == '\0') {
+		snprintf(path, sizeof(path), "%s/%s%s.bin", dir, NCCL_OFI_FLIGHT_RECORDER_FILE_PREFIX,
+			 argv[optind]);
+	} else {
+		snprintf(path, sizeof(path), "%s", argv[optind]);
+	}
+	NCCL_OFI_INFO(NCCL_INIT, "Decoding %s", path);
+
+	return decode(path);
+}
@@ -0,0 +1,385 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+/*
+ * Print the telemetry segment of a process that runs the plugin with
+ * OFI_NCCL_TELEMETRY=1:
+ *
+ *   nccl-ofi-telemetry [-v] [-P] [-i seconds] [-o output] pid|path
+ *
+ * The segment is printed once, or every `seconds` with -i. With -P, it
+ * is printed in the Prometheus text exposition format, e.g., for the
+ * textfile collector of the node exporter.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "nccl_ofi_telemetry.h"
+#include "tools-common.h"
+
+/* Attempts to copy a record that is updated concurrently */
+#define MAX_READ_ATTEMPTS	(1000)
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [options] pid|path\n"
+		"  -P                    Print in Prometheus text format\n"
+		"  -i seconds            Print every `seconds` until the process exits\n"
+		"  -o output             Output file (default standard output), replaced\n"
+		"                        atomically on each print\n"
+		"  -v                    Log informational messages\n",
+		prog);
+}
+
+/*
+ * @brief	Copy record protected by sequence number at its start
+ *
+ * @return	0, on success
+ *		-EAGAIN, if the record was updated during all attempts
+ */
+static int read_record(const void *record, void *copy, size_t size)
+{
+	for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++) {
+		uint64_t begin = nccl_ofi_telemetry_read_begin((const uint64_t *)record);
+
+		memcpy(copy, record, size);
+		if (!nccl_ofi_telemetry_read_retry((const uint64_t *)record, begin)) {
+			return 0;
+		}
+	}
+
+	return -EAGAIN;
+}
+
+/*
+ * @brief	Map telemetry segment and validate its header
+ */
+static int attach(const char *path, const nccl_ofi_telemetry_segment_t **segment_p)
+{
+	struct stat st;
+	void *addr;
+	const nccl_ofi_telemetry_segment_t *segment;
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0) {
+		NCCL_OFI_WARN("Unable to open %s: %s", path, strerror(errno));
+		return -errno;
+	}
+
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(nccl_ofi_telemetry_segment_t)) {
+		NCCL_OFI_WARN("%s is not a telemetry segment of this version", path);
+		close(fd);
+		return -EINVAL;
+	}
+
+	addr = mmap(NULL, sizeof(nccl_ofi_telemetry_segment_t), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED) {
+		NCCL_OFI_WARN("Unable to map %s: %s", path, strerror(errno));
+		return -errno;
+	}
+
+	segment = addr;
+	if (__atomic_load_n(&segment->magic, __ATOMIC_ACQUIRE) != NCCL_OFI_TELEMETRY_MAGIC ||
+	    segment->version != NCCL_OFI_TELEMETRY_VERSION ||
+	    segment->size != sizeof(nccl_ofi_telemetry_segment_t) ||
+	    segment->num_devs > NCCL_OFI_TELEMETRY_MAX_DEVS ||
+	    segment->num_rails > NCCL_OFI_TELEMETRY_MAX_RAILS) {
+		NCCL_OFI_WARN("%s is not a telemetry segment of version %d", path,
+			      NCCL_OFI_TELEMETRY_VERSION);
+		munmap(addr, sizeof(nccl_ofi_telemetry_segment_t));
+		return -EINVAL;
+	}
+	NCCL_OFI_INFO(NCCL_INIT, "Attached to telemetry segment of process %d with %d devices of %d rails",
+		      segment->pid, segment->num_devs, segment->num_rails);
+
+	*segment_p = segment;
+	return 0;
+}
+
+static const char *comm_type_str(uint32_t type)
+{
+	return type == NCCL_OFI_TELEMETRY_SEND_COMM ? "send" : "recv";
+}
+
+/*
+ * @brief	Print histogram as Prometheus histogram in seconds, with the
+ *		non-empty buckets only
+ */
+static void print_prom_histogram(FILE *out, const char *name, const char *labels,
+				 const nccl_ofi_histogram_t *histogram)
+{
+	uint64_t cumulative = 0;
+
+	for (int bucket = 0; bucket < NCCL_OFI_HISTOGRAM_BUCKETS - 1; bucket++) {
+		if (histogram->counts[bucket] == 0) {
+			continue;
+		}
+		cumulative += histogram->counts[bucket];
+		fprintf(out, "%s_bucket{%s,le=\"%.9f\"} %" PRIu64 "\n", name, labels,
+			nccl_ofi_histogram_bucket_value(bucket + 1) * 1e-9, cumulative);
+	}
+	cumulative += histogram->counts[NCCL_OFI_HISTOGRAM_BUCKETS - 1];
+	fprintf(out, "%s_bucket{%s,le=\"+Inf\"} %" PRIu64 "\n", name, labels, cumulative);
+	fprintf(out, "%s_sum{%s} %.9f\n", name, labels, histogram->sum * 1e-9);
+	fprintf(out, "%s_count{%s} %" PRIu64 "\n", name, labels, cumulative);
+}
+
+static void print_rail(FILE *out, bool prom, int pid, int dev_id, int rail_id,
+		       const nccl_ofi_rail_counters_t *c)
+{
+	if (!prom) {
+		fprintf(out, "dev %d rail %d: tx %" PRIu64 " ops %" PRIu64 " B, rx %" PRIu64 " ops %" PRIu64 " B, "
+			"ctrl tx %" PRIu64 " rx %" PRIu64 ", eager tx %" PRIu64 " rx %" PRIu64 ", "
+			"eagain %" PRIu64 ", errors %" PRIu64 ", bounce reposts %" PRIu64 "\n",
+			dev_id, rail_id, c->tx_ops, c->tx_bytes, c->rx_ops, c->rx_bytes,
+			c->ctrl_sent, c->ctrl_recv, c->eager_sent, c->eager_recv, c->eagain,
+			c->err_completions, c->bounce_reposts);
+		return;
+	}
+
+#define PRINT_RAIL_COUNTER(field, type)							\
+	fprintf(out, "nccl_ofi_rail_" #field "%s{pid=\"%d\",dev=\"%d\",rail=\"%d\"} %" PRIu64 "\n",	\
+		type, pid, dev_id, rail_id, c->field)
+	PRINT_RAIL_COUNTER(tx_bytes, "_total");
+	PRINT_RAIL_COUNTER(tx_ops, "_total");
+	PRINT_RAIL_COUNTER(rx_bytes, "_total");
+	PRINT_RAIL_COUNTER(rx_ops, "_total");
+	PRINT_RAIL_COUNTER(eagain, "_total");
+	PRINT_RAIL_COUNTER(err_completions, "_total");
+	PRINT_RAIL_COUNTER(bounce_reposts, "_total");
+	PRINT_RAIL_COUNTER(ctrl_sent, "_total");
+	PRINT_RAIL_COUNTER(ctrl_recv, "_total");
+	PRINT_RAIL_COUNTER(eager_sent, "_total");
+	PRINT_RAIL_COUNTER(eager_recv, "_total");
+#undef PRINT_RAIL_COUNTER
+}
+
+static void print_ep(FILE *out, bool prom, int pid, int index, const nccl_ofi_telemetry_ep_t *ep)
+{
+	if (!prom) {
+		fprintf(out, "ep %d dev %d: pending %" PRIu64 " (max %" PRIu64 "), bounce fl entries %" PRIu64 ", "
+			"bounce req fl entries %" PRIu64 ", bounce posted",
+			index, ep->dev_id, ep->pending_reqs, ep->pending_max, ep->bounce_fl_entries,
+			ep->bounce_reqs_fl_entries);
+		for (int rail_id = 0; rail_id < ep->num_rails; rail_id++) {
+			fprintf(out, " %" PRIu64, ep->bounce_posted[rail_id]);
+		}
+		fprintf(out, "\n");
+		return;
+	}
+
+	fprintf(out, "nccl_ofi_ep_pending_reqs{pid=\"%d\",ep=\"%d\",dev=\"%d\"} %" PRIu64 "\n",
+		pid, index, ep->dev_id, ep->pending_reqs);
+	fprintf(out, "nccl_ofi_ep_pending_reqs_max{pid=\"%d\",ep=\"%d\",dev=\"%d\"} %" PRIu64 "\n",
+		pid, index, ep->dev_id, ep->pending_max);
+	fprintf(out, "nccl_ofi_ep_bounce_fl_entries{pid=\"%d\",ep=\"%d\",dev=\"%d\"} %" PRIu64 "\n",
+		pid, index, ep->dev_id, ep->bounce_fl_entries);
+	fprintf(out, "nccl_ofi_ep_bounce_reqs_fl_entries{pid=\"%d\",ep=\"%d\",dev=\"%d\"} %" PRIu64 "\n",
+		pid, index, ep->dev_id, ep->bounce_reqs_fl_entries);
+	for (int rail_id = 0; rail_id < ep->num_rails; rail_id++) {
+		fprintf(out, "nccl_ofi_ep_bounce_posted{pid=\"%d\",ep=\"%d\",dev=\"%d\",rail=\"%d\"} %" PRIu64 "\n",
+			pid, index, ep->dev_id, rail_id, ep->bounce_posted[rail_id]);
+	}
+}
+
+static void print_comm(FILE *out, bool prom, int pid, int num_rails,
+		       const nccl_ofi_telemetry_comm_t *comm)
+{
+	const char *req_name = comm->type == NCCL_OFI_TELEMETRY_SEND_COMM ? "send" : "recv";
+	const char *wait_name = comm->type == NCCL_OFI_TELEMETRY_SEND_COMM ? "ctrl" : "flush";
+	char labels[128];
+	char name[64];
+
+	if (!prom) {
+		char summary[128];
+
+		fprintf(out, "%s comm %u dev %d: inflight %" PRIu64 ", req fl entries %" PRIu64 "\n",
+			comm_type_str(comm->type), comm->comm_id, comm->dev_id,
+			comm->inflight_reqs, comm->reqs_fl_entries);
+		nccl_ofi_histogram_format(&comm->req_hist, summary, sizeof(summary));
+		fprintf(out, "  %s latency (us): %s\n", req_name, summary);
+		nccl_ofi_histogram_format(&comm->wait_hist, summary, sizeof(summary));
+		fprintf(out, "  %s latency (us): %s\n", wait_name, summary);
+		if (comm->type != NCCL_OFI_TELEMETRY_SEND_COMM) {
+			return;
+		}
+		for (int rail_id = 0; rail_id < num_rails; rail_id++) {
+			nccl_ofi_histogram_format(&comm->rail_hist[rail_id], summary, sizeof(summary));
+			fprintf(out, "  rail %d write latency (us): %s\n", rail_id, summary);
+		}
+		return;
+	}
+
+	snprintf(labels, sizeof(labels), "pid=\"%d\",dev=\"%d\",type=\"%s\",comm=\"%u\"",
+		 pid, comm->dev_id, comm_type_str(comm->type), comm->comm_id);
+	fprintf(out, "nccl_ofi_comm_inflight_reqs{%s} %" PRIu64 "\n", labels, comm->inflight_reqs);
+	fprintf(out, "nccl_ofi_comm_reqs_fl_entries{%s} %" PRIu64 "\n", labels, comm->reqs_fl_entries);
+	snprintf(name, sizeof(name), "nccl_ofi_comm_%s_latency_seconds", req_name);
+	print_prom_histogram(out, name, labels, &comm->req_hist);
+	snprintf(name, sizeof(name), "nccl_ofi_comm_%s_latency_seconds", wait_name);
+	print_prom_histogram(out, name, labels, &comm->wait_hist);
+	if (comm->type != NCCL_OFI_TELEMETRY_SEND_COMM) {
+		return;
+	}
+	for (int rail_id = 0; rail_id < num_rails; rail_id++) {
+		char rail_labels[160];
+
+		snprintf(rail_labels, sizeof(rail_labels), "%s,rail=\"%d\"", labels, rail_id);
+		print_prom_histogram(out, "nccl_ofi_comm_write_latency_seconds", rail_labels,
+				     &comm->rail_hist[rail_id]);
+	}
+}
+
+static void print_segment(FILE *out, bool prom, const nccl_ofi_telemetry_segment_t *segment)
+{
+	int pid = segment->pid;
+
+	if (prom) {
+		fprintf(out, "nccl_ofi_telemetry_update_ns{pid=\"%d\"} %" PRIu64 "\n", pid,
+			__atomic_load_n(&segment->update_ns, __ATOMIC_RELAXED));
+	} else {
+		fprintf(out, "process %d: %d devices of %d rails\n", pid, segment->num_devs,
+			segment->num_rails);
+	}
+
+	for (int dev_id = 0; dev_id < segment->num_devs; dev_id++) {
+		for (int rail_id = 0; rail_id < segment->num_rails; rail_id++) {
+			nccl_ofi_telemetry_rail_t rail;
+
+			if (read_record(&segment->rails[dev_id][rail_id], &rail, sizeof(rail)) == 0) {
+				print_rail(out, prom, pid, dev_id, rail_id, &rail.counters);
+			}
+		}
+	}
+
+	for (int i = 0; i < NCCL_OFI_TELEMETRY_MAX_EPS; i++) {
+		nccl_ofi_telemetry_ep_t ep;
+
+		if (read_record(&segment->eps[i], &ep, sizeof(ep)) == 0 && ep.in_use) {
+			print_ep(out, prom, pid, i, &ep);
+		}
+	}
+
+	for (int i = 0; i < NCCL_OFI_TELEMETRY_MAX_COMMS; i++) {
+		/* Too large for the stack of some agents' threads */
+		static nccl_ofi_telemetry_comm_t comm;
+
+		if (read_record(&segment->comms[i], &comm, sizeof(comm)) == 0 && comm.in_use) {
+			print_comm(out, prom, pid, segment->num_rails, &comm);
+		}
+	}
+}
+
+/*
+ * @brief	Print segment to output file, replacing it atomically so
+ *		that collectors never read a partial file
+ */
+static int print_to_file(const char *output, bool prom, const nccl_ofi_telemetry_segment_t *segment)
+{
+	char tmp_path[PATH_MAX];
+	FILE *out;
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", output);
+	out = fopen(tmp_path, "w");
+	if (!out) {
+		NCCL_OFI_WARN("Unable to open %s: %s", tmp_path, strerror(errno));
+		return -errno;
+	}
+	print_segment(out, prom, segment);
+	if (fclose(out) != 0 || rename(tmp_path, output) != 0) {
+		NCCL_OFI_WARN("Unable to write %s: %s", output, strerror(errno));
+		return -errno;
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int opt;
+	bool prom = false;
+	long interval = 0;
+	const char *output = NULL;
+	char path[PATH_MAX];
+	char *end;
+	const nccl_ofi_telemetry_segment_t *segment = NULL;
+
+	ofi_log_function = stderr_logger;
+
+	while ((opt = getopt(argc, argv, "Pi:o:vh")) != -1) {
+		switch (opt) {
+		case 'P':
+			prom = true;
+			break;
+		case 'i':
+			interval = strtol(optarg, &end, 10);
+			if (*end != '\0' || interval < 1) {
+				NCCL_OFI_WARN("Invalid interval %s", optarg);
+				return 1;
+			}
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		case 'v':
+			tools_verbose = 1;
+			break;
+		case 'h':
+			usage(argv[0]);
+			return 0;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (optind != argc - 1) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	/* A PID selects the segment of the process */
+	strtol(argv[optind], &end, 10);
+	if (*end == '\0') {
+		snprintf(path, sizeof(path), "%s%s", NCCL_OFI_TELEMETRY_PATH_PREFIX, argv[optind]);
+	} else {
+		snprintf(path, sizeof(path), "%s", argv[optind]);
+	}
+
+	if (attach(path, &segment) != 0) {
+		return 1;
+	}
+
+	do {
+		if (output) {
+			if (print_to_file(output, prom, segment) != 0) {
+				return 1;
+			}
+		} else {
+			print_segment(stdout, prom, segment);
+			fflush(stdout);
+		}
+
+		/* The segment is removed when the process exits */
+		if (interval && access(path, F_OK) != 0) {
+			NCCL_OFI_INFO(NCCL_INIT, "Process %d exited", segment->pid);
+			break;
+		}
+	} while (interval && sleep(interval) == 0);
+
+	return 0;
+}
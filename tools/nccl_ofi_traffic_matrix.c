@@ -0,0 +1,493 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+/*
+ * Merge the traffic matrix files of the ranks of a job (see
+ * OFI_NCCL_TRAFFIC_MATRIX_FILE) into the traffic matrix of the job:
+ *
+ *   nccl-ofi-traffic-matrix [-v] [-m metric] [-o heatmap.svg] file...
+ *
+ * The matrix is printed as CSV with one row per sending process and one
+ * column per receiving process, ordered by rank, or by the order of the
+ * files if ranks are unknown. The metric is one of tx_bytes (default),
+ * tx_msgs, rx_bytes and rx_msgs. With -o, the matrix is also drawn as a
+ * heatmap with a logarithmic color scale.
+ *
+ * Peers are matched to processes by the address of their endpoint, so
+ * that traffic to processes whose file is missing is reported as
+ * unmatched.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "nccl_ofi_traffic.h"
+#include "tools-common.h"
+
+#define NUM_METRICS	(4)
+
+static const char *metric_names[NUM_METRICS] = {
+	"tx_bytes",
+	"tx_msgs",
+	"rx_bytes",
+	"rx_msgs",
+};
+
+typedef struct process {
+	char host[256];
+	int pid;
+	long rank;
+	/* Order of the process in the input */
+	int index;
+} process_t;
+
+typedef struct endpoint {
+	char addr[NCCL_OFI_TRAFFIC_ADDR_LEN];
+	int process;
+} endpoint_t;
+
+typedef struct peer {
+	char addr[NCCL_OFI_TRAFFIC_ADDR_LEN];
+	/* Process of the endpoint that counted the traffic */
+	int process;
+	uint64_t metrics[NUM_METRICS];
+} peer_t;
+
+static process_t *processes;
+static int num_processes;
+static endpoint_t *endpoints;
+static int num_endpoints;
+static peer_t *peers;
+static int num_peers;
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [options] file...\n"
+		"  -m metric             tx_bytes, tx_msgs, rx_bytes or rx_msgs (default tx_bytes)\n"
+		"  -o path               Write heatmap of the matrix as SVG to path\n"
+		"  -v                    Log informational messages\n",
+		prog);
+}
+
+/*
+ * @brief	Grow array by one element
+ *
+ * @return	New element, zeroed, or NULL if the allocation failed
+ */
+static void *append(void **array, int *num, size_t size)
+{
+	char *grown = realloc(*array, (*num + 1) * size);
+
+	if (!grown) {
+		NCCL_OFI_WARN("Unable to allocate traffic matrix entry");
+		return NULL;
+	}
+	*array = grown;
+	memset(grown + *num * size, 0, size);
+	return grown + (*num)++ * size;
+}
+
+/*
+ * @brief	Value of field `key` of line, or NULL if not present
+ *
+ * The value is terminated in place, so that fields are looked up in
+ * the order they appear in the line.
+ */
+static char *get_field(char **line, const char *key)
+{
+	size_t key_len = strlen(key);
+	char *field;
+
+	while ((field = strsep(line, " \n")) != NULL) {
+		if (strncmp(field, key, key_len) == 0 && field[key_len] == '=') {
+			return &field[key_len + 1];
+		}
+	}
+	return NULL;
+}
+
+static int find_process(const char *host, int pid)
+{
+	for (int i = 0; i < num_processes; i++) {
+		if (processes[i].pid == pid && strcmp(processes[i].host, host) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static int parse_endpoint(char *line, int *process)
+{
+	char *addr = get_field(&line, "addr");
+	char *host = get_field(&line, "host");
+	char *pid = get_field(&line, "pid");
+	char *rank = get_field(&line, "rank");
+	endpoint_t *endpoint;
+
+	if (!addr || !host || !pid || !rank) {
+		return -EINVAL;
+	}
+
+	*process = find_process(host, atoi(pid));
+	if (*process < 0) {
+		process_t *new_process = append((void **)&processes, &num_processes,
+						 sizeof(*processes));
+		if (!new_process) {
+			return -ENOMEM;
+		}
+		snprintf(new_process->host, sizeof(new_process->host), "%s", host);
+		new_process->pid = atoi(pid);
+		new_process->rank = strtol(rank, NULL, 10);
+		new_process->index = num_processes - 1;
+		*process = num_processes - 1;
+	}
+
+	endpoint = append((void **)&endpoints, &num_endpoints, sizeof(*endpoints));
+	if (!endpoint) {
+		return -ENOMEM;
+	}
+	snprintf(endpoint->addr, sizeof(endpoint->addr), "%s", addr);
+	endpoint->process = *process;
+
+	return 0;
+}
+
+static int parse_peer(char *line, int process)
+{
+	char *addr = get_field(&line, "addr");
+	peer_t *peer;
+
+	if (!addr || process < 0) {
+		return -EINVAL;
+	}
+
+	peer = append((void **)&peers, &num_peers, sizeof(*peers));
+	if (!peer) {
+		return -ENOMEM;
+	}
+	snprintf(peer->addr, sizeof(peer->addr), "%s", addr);
+	peer->process = process;
+	for (int i = 0; i < NUM_METRICS; i++) {
+		char *value = get_field(&line, metric_names[i]);
+
+		if (!value) {
+			num_peers--;
+			return -EINVAL;
+		}
+		peer->metrics[i] = strtoull(value, NULL, 10);
+	}
+
+	return 0;
+}
+
+static int parse_file(const char *path)
+{
+	char line[1024];
+	int version = 0;
+	int process = -1;
+	int line_num = 0;
+	int ret = 0;
+	FILE *file;
+
+	file = fopen(path, "r");
+	if (!file) {
+		NCCL_OFI_WARN("Unable to open %s: %s", path, strerror(errno));
+		return -errno;
+	}
+
+	while (fgets(line, sizeof(line), file)) {
+		line_num++;
+		if (sscanf(line, "# nccl-ofi traffic matrix version %d", &version) == 1) {
+			continue;
+		}
+		if (version != NCCL_OFI_TRAFFIC_VERSION) {
+			NCCL_OFI_WARN("%s is not a traffic matrix of version %d", path,
+				      NCCL_OFI_TRAFFIC_VERSION);
+			ret = -EINVAL;
+			break;
+		}
+
+		if (strncmp(line, "endpoint ", 9) == 0) {
+			ret = parse_endpoint(&line[9], &process);
+		} else if (strncmp(line, "peer ", 5) == 0) {
+			ret = parse_peer(&line[5], process);
+		}
+		if (ret != 0) {
+			NCCL_OFI_WARN("Invalid line %d of %s", line_num, path);
+			break;
+		}
+	}
+
+	fclose(file);
+	NCCL_OFI_INFO(NCCL_INIT, "Read %s", path);
+	return ret;
+}
+
+static int compare_processes(const void *a, const void *b)
+{
+	const process_t *pa = a;
+	const process_t *pb = b;
+
+	if (pa->rank != pb->rank) {
+		return pa->rank < pb->rank ? -1 : 1;
+	}
+	return pa->index - pb->index;
+}
+
+/*
+ * @brief	Order processes by rank, or by input order if any rank is
+ *		unknown, and renumber the endpoints and peers accordingly
+ */
+static int sort_processes(void)
+{
+	int *order;
+	bool ranked = true;
+
+	for (int i = 0; i < num_processes; i++) {
+		if (processes[i].rank < 0) {
+			ranked = false;
+		}
+	}
+	if (!ranked) {
+		NCCL_OFI_INFO(NCCL_INIT, "Ranks unknown, processes are ordered by input");
+		return 0;
+	}
+
+	qsort(processes, num_processes, sizeof(*processes), compare_processes);
+
+	order = malloc(num_processes * sizeof(*order));
+	if (!order) {
+		NCCL_OFI_WARN("Unable to allocate process order");
+		return -ENOMEM;
+	}
+	for (int i = 0; i < num_processes; i++) {
+		order[processes[i].index] = i;
+	}
+	for (int i = 0; i < num_endpoints; i++) {
+		endpoints[i].process = order[endpoints[i].process];
+	}
+	for (int i = 0; i < num_peers; i++) {
+		peers[i].process = order[peers[i].process];
+	}
+	free(order);
+
+	return 0;
+}
+
+static int find_endpoint_process(const char *addr)
+{
+	for (int i = 0; i < num_endpoints; i++) {
+		if (strcmp(endpoints[i].addr, addr) == 0) {
+			return endpoints[i].process;
+		}
+	}
+	return -1;
+}
+
+/*
+ * @brief	Fill matrix of metric, indexed by sender and then receiver
+ */
+static void fill_matrix(uint64_t *matrix, int metric)
+{
+	/* Received traffic was counted by the receiver */
+	bool rx = (metric >= 2);
+	uint64_t unmatched = 0;
+
+	for (int i = 0; i < num_peers; i++) {
+		int peer_process = find_endpoint_process(peers[i].addr);
+		int src, dst;
+
+		if (peer_process < 0) {
+			unmatched += peers[i].metrics[metric];
+			continue;
+		}
+		src = rx ? peer_process : peers[i].process;
+		dst = rx ? peers[i].process : peer_process;
+		matrix[src * num_processes + dst] += peers[i].metrics[metric];
+	}
+
+	if (unmatched) {
+		NCCL_OFI_WARN("%" PRIu64 " %s to or from peers without traffic matrix file",
+			      unmatched, metric_names[metric]);
+	}
+}
+
+static void process_label(const process_t *process, char *buf, size_t len)
+{
+	if (process->rank >= 0) {
+		snprintf(buf, len, "%ld", process->rank);
+	} else {
+		snprintf(buf, len, "%s:%d", process->host, process->pid);
+	}
+}
+
+static void print_csv(const uint64_t *matrix)
+{
+	char label[300];
+
+	printf("src\\dst");
+	for (int dst = 0; dst < num_processes; dst++) {
+		process_label(&processes[dst], label, sizeof(label));
+		printf(",%s", label);
+	}
+	printf("\n");
+
+	for (int src = 0; src < num_processes; src++) {
+		process_label(&processes[src], label, sizeof(label));
+		printf("%s", label);
+		for (int dst = 0; dst < num_processes; dst++) {
+			printf(",%" PRIu64, matrix[src * num_processes + dst]);
+		}
+		printf("\n");
+	}
+}
+
+static int write_svg(const char *path, const uint64_t *matrix, int metric)
+{
+	const int cell = 12;
+	const int margin = 60;
+	int size = margin + num_processes * cell;
+	double log_max = 0.0;
+	char label[300], dst_label[300];
+	FILE *file;
+
+	for (int i = 0; i < num_processes * num_processes; i++) {
+		if (log10(1.0 + matrix[i]) > log_max) {
+			log_max = log10(1.0 + matrix[i]);
+		}
+	}
+
+	file = fopen(path, "w");
+	if (!file) {
+		NCCL_OFI_WARN("Unable to open %s: %s", path, strerror(errno));
+		return -errno;
+	}
+
+	fprintf(file, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" "
+		"font-family=\"sans-serif\" font-size=\"8\">\n", size + cell, size + cell);
+	fprintf(file, "<text x=\"2\" y=\"10\">%s (log scale), src down, dst across</text>\n",
+		metric_names[metric]);
+
+	for (int i = 0; i < num_processes; i++) {
+		process_label(&processes[i], label, sizeof(label));
+		fprintf(file, "<text x=\"%d\" y=\"%d\" transform=\"rotate(-90 %d %d)\">%s</text>\n",
+			margin + i * cell + cell - 2, margin - 2, margin + i * cell + cell - 2,
+			margin - 2, label);
+		fprintf(file, "<text x=\"%d\" y=\"%d\" text-anchor=\"end\">%s</text>\n",
+			margin - 2, margin + i * cell + cell - 2, label);
+	}
+
+	for (int src = 0; src < num_processes; src++) {
+		process_label(&processes[src], label, sizeof(label));
+		for (int dst = 0; dst < num_processes; dst++) {
+			uint64_t value = matrix[src * num_processes + dst];
+			/* Share of the largest value on a logarithmic scale,
+			 * from white to dark red */
+			double share = log_max > 0.0 ? log10(1.0 + value) / log_max : 0.0;
+			int shade = 255 - (int)(share * 255.0);
+
+			process_label(&processes[dst], dst_label, sizeof(dst_label));
+
+			fprintf(file, "<rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\" "
+				"fill=\"rgb(%d,%d,%d)\" stroke=\"#ccc\" stroke-width=\"0.5\">"
+				"<title>%s -> %s: %" PRIu64 "</title></rect>\n",
+				margin + dst * cell, margin + src * cell, cell, cell,
+				255 - (int)(share * 115.0), shade, shade, label, dst_label, value);
+		}
+	}
+	fprintf(file, "</svg>\n");
+
+	if (fclose(file) != 0) {
+		NCCL_OFI_WARN("Unable to write %s: %s", path, strerror(errno));
+		return -errno;
+	}
+	NCCL_OFI_INFO(NCCL_INIT, "Heatmap written to %s", path);
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int opt;
+	int metric = 0;
+	const char *svg_path = NULL;
+	uint64_t *matrix;
+	int ret = 0;
+
+	ofi_log_function = stderr_logger;
+
+	while ((opt = getopt(argc, argv, "m:o:vh")) != -1) {
+		switch (opt) {
+		case 'm':
+			for (metric = 0; metric < NUM_METRICS; metric++) {
+				if (strcmp(optarg, metric_names[metric]) == 0) {
+					break;
+				}
+			}
+			if (metric == NUM_METRICS) {
+				NCCL_OFI_WARN("Unknown metric %s", optarg);
+				usage(argv[0]);
+				return 1;
+			}
+			break;
+		case 'o':
+			svg_path = optarg;
+			break;
+		case 'v':
+			tools_verbose = 1;
+			break;
+		case 'h':
+			usage(argv[0]);
+			return 0;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (optind == argc) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	for (int i = optind; i < argc; i++) {
+		if (parse_file(argv[i]) != 0) {
+			return 1;
+		}
+	}
+	if (num_processes == 0) {
+		NCCL_OFI_WARN("No endpoints in traffic matrix files");
+		return 1;
+	}
+	if (sort_processes() != 0) {
+		return 1;
+	}
+
+	matrix = calloc((size_t)num_processes * num_processes, sizeof(*matrix));
+	if (!matrix) {
+		NCCL_OFI_WARN("Unable to allocate matrix of %d processes", num_processes);
+		return 1;
+	}
+	fill_matrix(matrix, metric);
+
+	print_csv(matrix);
+	if (svg_path && write_svg(svg_path, matrix, metric) != 0) {
+		ret = 1;
+	}
+
+	free(matrix);
+	free(processes);
+	free(endpoints);
+	free(peers);
+	return ret;
+}
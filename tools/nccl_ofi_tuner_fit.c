@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+/*
+ * Fit the tuner's model parameters to nccl-tests measurements:
+ *
+ *   nccl-ofi-tuner-fit [-v] [-o params.ini] measurements.csv...
+ *
+ * The parameter file is written to standard output unless -o is given,
+ * and can be loaded by the tuner with OFI_NCCL_TUNER_PARAM_FILE. The
+ * OFI_NCCL_TUNER_* environment variables set the parameters that are
+ * not fitted and the initial values of the fitted ones.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "nccl_ofi_tuner.h"
+#include "nccl_ofi_tuner_fit.h"
+#include "tools-common.h"
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-v] [-o output] measurements.csv...\n", prog);
+}
+
+int main(int argc, char *argv[])
+{
+	int ret = 0;
+	int opt;
+	const char *output = NULL;
+	FILE *out = stdout;
+	nccl_ofi_tuner_sample_t *samples = NULL;
+	size_t num_samples = 0;
+	struct nccl_ofi_tuner_model_params initial;
+	nccl_ofi_tuner_fit_result_t result;
+
+	ofi_log_function = stderr_logger;
+
+	while ((opt = getopt(argc, argv, "o:vh")) != -1) {
+		switch (opt) {
+		case 'o':
+			output = optarg;
+			break;
+		case 'v':
+			tools_verbose = 1;
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (optind == argc) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	for (int i = optind; i < argc; i++) {
+		FILE *in = fopen(argv[i], "r");
+
+		if (!in) {
+			NCCL_OFI_WARN("Unable to open %s: %s", argv[i], strerror(errno));
+			ret = 1;
+			goto exit;
+		}
+		ret = nccl_ofi_tuner_fit_read_csv(in, argv[i], &samples, &num_samples);
+		fclose(in);
+		if (ret != 0) {
+			ret = 1;
+			goto exit;
+		}
+	}
+
+	nccl_ofi_tuner_default_params(&initial);
+	if (nccl_ofi_tuner_fit(samples, num_samples, &initial, &result) != 0) {
+		ret = 1;
+		goto exit;
+	}
+
+	if (output) {
+		out = fopen(output, "w");
+		if (!out) {
+			NCCL_OFI_WARN("Unable to open %s: %s", output, strerror(errno));
+			ret = 1;
+			goto exit;
+		}
+	}
+	ret = nccl_ofi_tuner_fit_write(out, &result);
+	if (output && fclose(out) != 0) {
+		ret = -EIO;
+	}
+	if (ret != 0) {
+		NCCL_OFI_WARN("Unable to write parameters");
+		ret = 1;
+		goto exit;
+	}
+
+	fprintf(stderr, "Fitted %zu of %zu samples: RMS residual %.3f us, largest relative residual %.1f%%\n",
+		result.num_samples, num_samples, result.rms_residual, 100.0 * result.max_rel_residual);
+
+ exit:
+	free(samples);
+	return ret;
+}
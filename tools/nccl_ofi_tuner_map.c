@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+/*
+ * Print the decisions of the tuner over a grid of calls as CSV:
+ *
+ *   nccl-ofi-tuner-map [-v] [-V] [-o map.csv] [-n nodes,...] [-g ranks_per_node]
+ *                      [-c collective,...] [-s min:max] [-p min:max]
+ *
+ * The tuner is initialized for each node count as NCCL would initialize
+ * it for a communicator, so that the OFI_NCCL_TUNER_* environment
+ * variables and OFI_NCCL_TUNER_PARAM_FILE apply as in a job.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#include "nccl_ofi_tuner.h"
+#include "tools-common.h"
+
+extern const ncclTuner_v2_t ncclTunerPlugin_v2;
+
+/* Maximum number of node counts of a map */
+#define MAX_NODE_COUNTS	(64)
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -n nodes,...          Node counts (default 4,16,64)\n"
+		"  -g ranks_per_node     Ranks per node (default 8)\n"
+		"  -c collective,...     Collectives (default all)\n"
+		"  -s min:max            Message sizes, powers of two with optional K, M or G\n"
+		"                        suffix (default 1:16G)\n"
+		"  -p min:max            Pipelined operations (default 1:1)\n"
+		"  -V                    List calls with NVLS support as well\n"
+		"  -o output             Output file (default standard output)\n"
+		"  -v                    Log informational messages\n",
+		prog);
+}
+
+/*
+ * @brief	Parse size with optional K, M or G suffix
+ */
+static int parse_size(const char *str, size_t *size)
+{
+	char *end;
+	unsigned long long value;
+
+	errno = 0;
+	value = strtoull(str, &end, 10);
+	if (errno || end == str) {
+		return -EINVAL;
+	}
+
+	switch (*end) {
+	case 'G': value <<= 10; /* fall through */
+	case 'M': value <<= 10; /* fall through */
+	case 'K': value <<= 10; end++; break;
+	default: break;
+	}
+
+	if (*end != '\0' || value == 0) {
+		return -EINVAL;
+	}
+	*size = value;
+
+	return 0;
+}
+
+/*
+ * @brief	Parse range `min:max`, or a single value
+ */
+static int parse_size_range(char *str, size_t *min, size_t *max)
+{
+	char *sep = strchr(str, ':');
+
+	if (sep) {
+		*sep = '\0';
+		if (parse_size(str, min) != 0 || parse_size(sep + 1, max) != 0) {
+			return -EINVAL;
+		}
+	} else if (parse_size(str, min) != 0) {
+		return -EINVAL;
+	} else {
+		*max = *min;
+	}
+
+	return *min <= *max ? 0 : -EINVAL;
+}
+
+static int parse_funcs(char *str, unsigned int *funcs)
+{
+	char *saveptr = NULL;
+
+	*funcs = 0;
+	for (char *name = strtok_r(str, ",", &saveptr); name; name = strtok_r(NULL, ",", &saveptr)) {
+		int func;
+
+		for (func = 0; func < NCCL_NUM_FUNCTIONS; func++) {
+			if (strcasecmp(name, nccl_ofi_tuner_func_names[func]) == 0) {
+				break;
+			}
+		}
+		if (func == NCCL_NUM_FUNCTIONS) {
+			return -EINVAL;
+		}
+		*funcs |= 1U << func;
+	}
+
+	return *funcs ? 0 : -EINVAL;
+}
+
+static int parse_node_counts(char *str, int *node_counts, int *num_node_counts)
+{
+	char *saveptr = NULL;
+
+	*num_node_counts = 0;
+	for (char *tok = strtok_r(str, ",", &saveptr); tok; tok = strtok_r(NULL, ",", &saveptr)) {
+		char *end;
+		long nodes = strtol(tok, &end, 10);
+
+		if (*end != '\0' || nodes < 1 || *num_node_counts == MAX_NODE_COUNTS) {
+			return -EINVAL;
+		}
+		node_counts[(*num_node_counts)++] = nodes;
+	}
+
+	return *num_node_counts ? 0 : -EINVAL;
+}
+
+int main(int argc, char *argv[])
+{
+	int ret = 0;
+	int opt;
+	const char *output = NULL;
+	FILE *out = stdout;
+	char default_nodes[] = "4,16,64";
+	int node_counts[MAX_NODE_COUNTS];
+	int num_node_counts = 0;
+	long ranks_per_node = 8;
+	size_t min_pipe_ops = 1, max_pipe_ops = 1;
+	struct nccl_ofi_tuner_map_grid grid = {
+		.funcs = (1U << NCCL_NUM_FUNCTIONS) - 1,
+		.min_size = 1,
+		.max_size = (size_t)16 << 30,
+		.nvls_support = false,
+	};
+
+	ofi_log_function = stderr_logger;
+
+	parse_node_counts(default_nodes, node_counts, &num_node_counts);
+
+	while ((opt = getopt(argc, argv, "n:g:c:s:p:Vo:vh")) != -1) {
+		char *end;
+
+		switch (opt) {
+		case 'n':
+			if (parse_node_counts(optarg, node_counts, &num_node_counts) != 0) {
+				NCCL_OFI_WARN("Invalid node counts");
+				return 1;
+			}
+			break;
+		case 'g':
+			ranks_per_node = strtol(optarg, &end, 10);
+			if (*end != '\0' || ranks_per_node < 1) {
+				NCCL_OFI_WARN("Invalid ranks per node %s", optarg);
+				return 1;
+			}
+			break;
+		case 'c':
+			if (parse_funcs(optarg, &grid.funcs) != 0) {
+				NCCL_OFI_WARN("Invalid collectives");
+				return 1;
+			}
+			break;
+		case 's':
+			if (parse_size_range(optarg, &grid.min_size, &grid.max_size) != 0) {
+				NCCL_OFI_WARN("Invalid size range");
+				return 1;
+			}
+			break;
+		case 'p':
+			if (parse_size_range(optarg, &min_pipe_ops, &max_pipe_ops) != 0 ||
+			    max_pipe_ops > 1024) {
+				NCCL_OFI_WARN("Invalid pipelined operations range");
+				return 1;
+			}
+			break;
+		case 'V':
+			grid.nvls_support = true;
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		case 'v':
+			tools_verbose = 1;
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (optind != argc) {
+		usage(argv[0]);
+		return 1;
+	}
+	grid.min_pipe_ops = min_pipe_ops;
+	grid.max_pipe_ops = max_pipe_ops;
+
+	if (output && !(out = fopen(output, "w"))) {
+		NCCL_OFI_WARN("Unable to open %s: %s", output, strerror(errno));
+		return 1;
+	}
+
+	nccl_ofi_tuner_map_write_header(out);
+	for (int i = 0; i < num_node_counts && ret == 0; i++) {
+		void *context = NULL;
+
+		if (ncclTunerPlugin_v2.init(node_counts[i] * ranks_per_node, node_counts[i],
+					    stderr_logger, &context) != ncclSuccess) {
+			NCCL_OFI_WARN("Tuner initialization failed");
+			ret = 1;
+			break;
+		}
+		if (nccl_ofi_tuner_map_write(out, context, &grid) != 0) {
+			NCCL_OFI_WARN("Unable to write decision map");
+			ret = 1;
+		}
+		ncclTunerPlugin_v2.destroy(context);
+	}
+
+	if (output && fclose(out) != 0) {
+		NCCL_OFI_WARN("Unable to write %s", output);
+		ret = 1;
+	}
+
+	return ret;
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2024 Amazon.com, Inc. or its affiliates. All rights reserved.
+ */
+
+#ifndef TOOLS_COMMON_H_
+#define TOOLS_COMMON_H_
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "nccl_ofi_log.h"
+
+/* Log informational messages as well as warnings */
+static int tools_verbose = 0;
+
+/*
+ * Logger of the host-only tools: messages go to standard error, so that
+ * the tools' output can be redirected.
+ */
+static inline void stderr_logger(ncclDebugLogLevel level, unsigned long flags, const char *filefunc,
+				 int line, const char *fmt, ...)
+{
+	va_list vargs;
+
+	if (level == NCCL_LOG_WARN) {
+		fprintf(stderr, "WARN: ");
+	} else if (level == NCCL_LOG_INFO && tools_verbose) {
+		fprintf(stderr, "INFO: ");
+	} else {
+		return;
+	}
+
+	va_start(vargs, fmt);
+	vfprintf(stderr, fmt, vargs);
+	fprintf(stderr, "\n");
+	va_end(vargs);
+}
+
+#endif // End TOOLS_COMMON_H_